@@ -21,7 +21,7 @@ FRenderData FRenderMeshFactory::CreateTriangle()
               .normal = { 0.0f, 0.0f, 1.0f } },
       },
       .indices = { 0, 1, 2 },
-      .materialIndices = { 0, 0, 0 },
+      .submeshes = { FRenderSubmesh{ .indicesCount = 3, .verticesCount = 3, .materialIndex = 0 } },
       .transform = math::Identity<f32>()
   };
   rtn.materials = { FRenderMaterialData{ .diffuse = { 0.2f, 0.5f, 0.2f } } };
@@ -29,74 +29,110 @@ FRenderData FRenderMeshFactory::CreateTriangle()
 }
 
 
-FRenderData FRenderMeshFactory::ConvertAssetToOneRenderData(const FMeshAsset* pMeshAsset, math::Matrix4x4f transform)
+// Appends meshes one after another, indices stay relative to first vertex of their submesh, so merging is
+// just copying...
+static void MergeMeshes(std::span<const FMeshAssetData> meshes, FRenderVertex* pVertices, u32* pIndices,
+                        FRenderSubmesh* pSubmeshes)
 {
-  FRenderData rtnRenderData{};
-
+  u32 firstVertex = 0;
+  u32 firstIndex = 0;
+  for (const FMeshAssetData& data : meshes)
   {
-    FRenderMeshData& meshData = rtnRenderData.mesh;
-    meshData.transform = transform;
-
-    // Reserve needed memory...
-    meshData.materialIndices.reserve(pMeshAsset->GetMeshes().size());
-
-    u32 verticesReserveCount = 0;
-    u32 indicesReserveCount = 0;
-    for (const FMeshAssetData& data : pMeshAsset->GetMeshes())
-    {
-      verticesReserveCount += data.vertices.size();
-      indicesReserveCount += data.indices.size();
-    }
-    meshData.vertices.reserve(verticesReserveCount);
-    meshData.indices.reserve(indicesReserveCount);
-
-    // for every mesh process vertices and indices...
-    for (const FMeshAssetData& data : pMeshAsset->GetMeshes())
-    {
-      for (const FVertex& vertex : data.vertices)
-      {
-        meshData.vertices.push_back({
-          .position = vertex.position,
-          .normal = vertex.normal
-        });
-      }
-
-      auto it = std::max_element(std::begin(meshData.indices), std::end(meshData.indices));
-      u32 maxElem = it != meshData.indices.end() ? *it + 1 : 0;
-      for (u32 ind : data.indices)
-      {
-        meshData.indices.push_back(maxElem + ind);
-      }
-
-      for (u32 i = 0; i < data.indices.size(); i += 3)
-      {
-        meshData.materialIndices.push_back(data.materialIndex);
-      }
-    }
+    *pSubmeshes++ = FRenderSubmesh{
+      .firstIndex = firstIndex,
+      .indicesCount = (u32)data.indices.size(),
+      .firstVertex = firstVertex,
+      .verticesCount = (u32)data.vertices.size(),
+      .materialIndex = data.materialIndex
+    };
+    pVertices = std::copy(data.vertices.begin(), data.vertices.end(), pVertices);
+    pIndices = std::copy(data.indices.begin(), data.indices.end(), pIndices);
+    firstVertex += data.vertices.size();
+    firstIndex += data.indices.size();
   }
+}
+
+
+static void CountMeshes(std::span<const FMeshAssetData> meshes, u64* pVerticesCount, u64* pIndicesCount)
+{
+  *pVerticesCount = 0;
+  *pIndicesCount = 0;
+  for (const FMeshAssetData& data : meshes)
   {
-    rtnRenderData.materials.reserve(pMeshAsset->GetMaterials().size());
-
-    for (const FMaterialData& data : pMeshAsset->GetMaterials())
-    {
-      rtnRenderData.materials.emplace_back(FRenderMaterialData{
-        .ambient = data.ambient,
-        .diffuse = data.diffuse,
-        .specular = data.specular,
-        .emissive = data.emissive,
-        .transparent = data.transparent,
-        .shininess = data.shininess,
-        .opacity = data.opacity,
-        .indexOfRefraction = data.indexOfRefraction,
-        .illuminationModel = data.illuminationModel
-      });
-    }
+    *pVerticesCount += data.vertices.size();
+    *pIndicesCount += data.indices.size();
   }
+}
+
+
+FRenderData FRenderMeshFactory::ConvertAssetToOneRenderData(const FMeshAsset* pMeshAsset, math::Matrix4x4f transform,
+                                                            std::pmr::memory_resource* pMemory)
+{
+  std::span<const FMeshAssetData> meshes = pMeshAsset->GetMeshes();
+  u64 verticesCount;
+  u64 indicesCount;
+  CountMeshes(meshes, &verticesCount, &indicesCount);
+
+  FRenderData rtnRenderData{
+    .mesh = {
+      .vertices = std::pmr::vector<FRenderVertex>(verticesCount, pMemory),
+      .indices = std::pmr::vector<u32>(indicesCount, pMemory),
+      .submeshes = std::pmr::vector<FRenderSubmesh>(meshes.size(), pMemory),
+      .transform = transform
+    },
+    .materials = std::pmr::vector<FRenderMaterialData>(pMeshAsset->GetMaterials().begin(),
+                                                       pMeshAsset->GetMaterials().end(), pMemory)
+  };
 
+  FRenderMeshData& meshData = rtnRenderData.mesh;
+  MergeMeshes(meshes, meshData.vertices.data(), meshData.indices.data(), meshData.submeshes.data());
   return rtnRenderData;
 }
 
 
+FRenderDataView FRenderMeshFactory::ConvertAssetToOneRenderView(const FMeshAsset* pMeshAsset,
+                                                                math::Matrix4x4f transform,
+                                                                std::pmr::memory_resource* pMemory)
+{
+  std::span<const FMeshAssetData> meshes = pMeshAsset->GetMeshes();
+  u64 verticesCount;
+  u64 indicesCount;
+  CountMeshes(meshes, &verticesCount, &indicesCount);
+
+  auto* pSubmeshes = static_cast<FRenderSubmesh*>(pMemory->allocate(meshes.size() * sizeof(FRenderSubmesh),
+                                                                    alignof(FRenderSubmesh)));
+  FRenderDataView rtnView{
+    .mesh = {
+      .submeshes = { pSubmeshes, meshes.size() },
+      .transform = transform
+    },
+    .materials = pMeshAsset->GetMaterials()
+  };
+
+  if (meshes.size() == 1)
+  {
+    rtnView.mesh.vertices = meshes[0].vertices;
+    rtnView.mesh.indices = meshes[0].indices;
+    *pSubmeshes = FRenderSubmesh{
+      .firstIndex = 0,
+      .indicesCount = (u32)indicesCount,
+      .firstVertex = 0,
+      .verticesCount = (u32)verticesCount,
+      .materialIndex = meshes[0].materialIndex
+    };
+    return rtnView;
+  }
+
+  auto* pVertices = static_cast<FRenderVertex*>(pMemory->allocate(verticesCount * sizeof(FRenderVertex),
+                                                                   alignof(FRenderVertex)));
+  auto* pIndices = static_cast<u32*>(pMemory->allocate(indicesCount * sizeof(u32), alignof(u32)));
+  MergeMeshes(meshes, pVertices, pIndices, pSubmeshes);
+  rtnView.mesh.vertices = { pVertices, verticesCount };
+  rtnView.mesh.indices = { pIndices, indicesCount };
+  return rtnView;
+}
+
+
 std::vector<FRenderData> FRenderMeshFactory::ConvertAssetToVectorRenderData(const FMeshAsset* pMeshAsset,
                                                                             math::Matrix4x4f transform)
 {
@@ -108,35 +144,16 @@ std::vector<FRenderData> FRenderMeshFactory::ConvertAssetToVectorRenderData(cons
     FRenderMeshData &meshData = renderData.mesh;
     meshData.transform = transform;
 
-    // Reserve needed memory...
-    meshData.vertices.reserve(assetData.vertices.size());
-    meshData.indices.reserve(assetData.indices.size());
-    meshData.materialIndices.reserve(pMeshAsset->GetMeshes().size());
-
-    for (const FVertex& vertex : assetData.vertices)
-    {
-      meshData.vertices.push_back({ .position = vertex.position, .normal = vertex.normal });
-    }
-
+    meshData.vertices.assign(assetData.vertices.begin(), assetData.vertices.end());
     meshData.indices.assign(assetData.indices.begin(), assetData.indices.end());
-    meshData.materialIndices.assign(meshData.indices.size(), assetData.materialIndex);
-
-    renderData.materials.reserve(pMeshAsset->GetMaterials().size());
-
-    for (const FMaterialData& data : pMeshAsset->GetMaterials())
-    {
-      renderData.materials.emplace_back(FRenderMaterialData{
-        .ambient = data.ambient,
-        .diffuse = data.diffuse,
-        .specular = data.specular,
-        .emissive = data.emissive,
-        .transparent = data.transparent,
-        .shininess = data.shininess,
-        .opacity = data.opacity,
-        .indexOfRefraction = data.indexOfRefraction,
-        .illuminationModel = data.illuminationModel
-      });
-    }
+    meshData.submeshes.push_back(FRenderSubmesh{
+      .firstIndex = 0,
+      .indicesCount = (u32)assetData.indices.size(),
+      .firstVertex = 0,
+      .verticesCount = (u32)assetData.vertices.size(),
+      .materialIndex = assetData.materialIndex
+    });
+    renderData.materials.assign(pMeshAsset->GetMaterials().begin(), pMeshAsset->GetMaterials().end());
   }
 
   return rtnVector;
@@ -4,7 +4,10 @@
 
 
 #include "UTools/UTypes.h"
+#include "UTools/Assets/MeshAsset.h"
 #include "UMath/Matrix4x4.h"
+#include <memory_resource>
+#include <span>
 #include <vector>
 
 
@@ -12,43 +15,67 @@ namespace uncanny
 {
 
 
-class FMeshAsset;
+// Render layer shares vertex and material layout with asset layer, so asset memory can be uploaded as it is...
+typedef FVertex FRenderVertex;
+typedef FMaterialData FRenderMaterialData;
 
 
-struct FRenderVertex
+/// @brief FRenderSubmesh is a range of render mesh with single material, every submesh is built as separate
+/// geometry of bottom level structure, so hit shaders find material by geometry index instead of per triangle data.
+/// Indices of submesh are relative to its first vertex.
+struct FRenderSubmesh
 {
-  math::Vector3f position{};
-  math::Vector3f normal{};
+  u32 firstIndex{ 0 };
+  u32 indicesCount{ 0 };
+  u32 firstVertex{ 0 };
+  u32 verticesCount{ 0 };
+  u32 materialIndex{ 0 };
 };
 
 
-struct FRenderMaterialData
+/// @brief FRenderMeshView is non-owning view of geometry used for building GPU resources, it can point directly
+/// into asset memory or into arena, see FRenderMeshFactory::ConvertAssetToOneRenderView().
+struct FRenderMeshView
 {
-  math::Vector3f ambient{};
-  math::Vector3f diffuse{};
-  math::Vector3f specular{};
-  math::Vector3f emissive{};
-  math::Vector3f transparent{};
-  f32 shininess{ 0.f };
-  f32 opacity{ 0.f };
-  f32 indexOfRefraction{ 0.f };
-  i32 illuminationModel{ 0 };
+  std::span<const FRenderVertex> vertices{};
+  std::span<const u32> indices{};
+  std::span<const FRenderSubmesh> submeshes{};
+  math::Matrix4x4f transform{};
 };
 
 
+/// @brief FRenderMeshData is transient data used only for building GPU resources, its arrays can live in arena
+/// (e.g. FLinearAllocator reset at level or frame boundary), see FRenderMeshFactory.
 struct FRenderMeshData
 {
-  std::vector<FRenderVertex> vertices{};
-  std::vector<u32> indices{};
-  std::vector<u32> materialIndices{};
+  std::pmr::vector<FRenderVertex> vertices{};
+  std::pmr::vector<u32> indices{};
+  std::pmr::vector<FRenderSubmesh> submeshes{};
   math::Matrix4x4f transform{};
+
+  operator FRenderMeshView() const
+  {
+    return FRenderMeshView{
+      .vertices = vertices,
+      .indices = indices,
+      .submeshes = submeshes,
+      .transform = transform
+    };
+  }
 };
 
 
 struct FRenderData
 {
   FRenderMeshData mesh{};
-  std::vector<FRenderMaterialData> materials{};
+  std::pmr::vector<FRenderMaterialData> materials{};
+};
+
+
+struct FRenderDataView
+{
+  FRenderMeshView mesh{};
+  std::span<const FRenderMaterialData> materials{};
 };
 
 
@@ -58,7 +85,16 @@ public:
 
   static FRenderData CreateTriangle();
 
-  static FRenderData ConvertAssetToOneRenderData(const FMeshAsset* pMeshAsset, math::Matrix4x4f transform);
+  /// @brief Converts all meshes of asset into one render data, its arrays are allocated from pMemory
+  static FRenderData ConvertAssetToOneRenderData(const FMeshAsset* pMeshAsset, math::Matrix4x4f transform,
+                                                 std::pmr::memory_resource* pMemory = std::pmr::get_default_resource());
+
+  /// @brief Creates view of all meshes of asset without copying whenever possible. Vertices and indices of single
+  /// mesh asset and all materials are viewed in place, so asset must outlive the view. Meshes of multi mesh asset
+  /// are concatenated and submesh ranges are written into pMemory, view never deallocates them, so pMemory should
+  /// be arena (e.g. FLinearAllocator) that is reset once view is not needed.
+  static FRenderDataView ConvertAssetToOneRenderView(const FMeshAsset* pMeshAsset, math::Matrix4x4f transform,
+                                                     std::pmr::memory_resource* pMemory);
 
   static std::vector<FRenderData> ConvertAssetToVectorRenderData(const FMeshAsset* pMeshAsset,
                                                                  math::Matrix4x4f transform);
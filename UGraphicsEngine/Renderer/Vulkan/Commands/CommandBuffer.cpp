@@ -3,6 +3,7 @@
 #include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/RayTracingPipeline.h"
 #include "UTools/Logger/Log.h"
+#include <vector>
 #undef MemoryBarrier
 
 
@@ -131,6 +132,40 @@ void FCommandBuffer::ImageMemoryBarrier(VkImage image, VkAccessFlags srcFlags, V
 }
 
 
+void FCommandBuffer::BufferOwnershipBarrier(std::span<const VkBuffer> buffers, VkAccessFlags srcAccess,
+                                            VkAccessFlags dstAccess, VkPipelineStageFlags srcStage,
+                                            VkPipelineStageFlags dstStage, FQueueFamilyIndex srcFamilyIndex,
+                                            FQueueFamilyIndex dstFamilyIndex)
+{
+  if (buffers.empty())
+  {
+    return;
+  }
+
+  std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers{};
+  bufferMemoryBarriers.reserve(buffers.size());
+  for (VkBuffer buffer : buffers)
+  {
+    bufferMemoryBarriers.push_back(VkBufferMemoryBarrier{
+      .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      .pNext = nullptr,
+      .srcAccessMask = srcAccess,
+      .dstAccessMask = dstAccess,
+      .srcQueueFamilyIndex = srcFamilyIndex,
+      .dstQueueFamilyIndex = dstFamilyIndex,
+      .buffer = buffer,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE
+    });
+  }
+
+  vkCmdPipelineBarrier(m_CommandBuffer, srcStage, dstStage, VkDependencyFlags{ 0 },
+                       0, nullptr, (u32)bufferMemoryBarriers.size(), bufferMemoryBarriers.data(), 0, nullptr);
+
+  m_LastWaitStageFlag = dstStage;
+}
+
+
 void FCommandBuffer::ClearColorImage(VkImage image, VkClearColorValue clearValue,
                                      VkImageSubresourceRange subresourceRange)
 {
@@ -187,6 +222,72 @@ void FCommandBuffer::BuildAccelerationStructure(
 }
 
 
+void FCommandBuffer::BuildAccelerationStructures(
+    std::span<const VkAccelerationStructureBuildGeometryInfoKHR> buildGeometryInfos,
+    const VkAccelerationStructureBuildRangeInfoKHR* const* ppBuildRangeInfos)
+{
+  vkCmdBuildAccelerationStructuresKHR(m_CommandBuffer, buildGeometryInfos.size(), buildGeometryInfos.data(),
+                                      ppBuildRangeInfos);
+}
+
+
+void FCommandBuffer::CopyAccelerationStructure(VkAccelerationStructureKHR src, VkAccelerationStructureKHR dst,
+                                               VkCopyAccelerationStructureModeKHR mode)
+{
+  VkCopyAccelerationStructureInfoKHR copyInfo{
+      .sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR,
+      .pNext = nullptr,
+      .src = src,
+      .dst = dst,
+      .mode = mode
+  };
+  vkCmdCopyAccelerationStructureKHR(m_CommandBuffer, &copyInfo);
+}
+
+
+void FCommandBuffer::CopyAccelerationStructureToMemory(VkAccelerationStructureKHR src, u64 dstDeviceAddress,
+                                                       VkCopyAccelerationStructureModeKHR mode)
+{
+  VkCopyAccelerationStructureToMemoryInfoKHR copyInfo{
+      .sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_TO_MEMORY_INFO_KHR,
+      .pNext = nullptr,
+      .src = src,
+      .dst = { .deviceAddress = dstDeviceAddress },
+      .mode = mode
+  };
+  vkCmdCopyAccelerationStructureToMemoryKHR(m_CommandBuffer, &copyInfo);
+}
+
+
+void FCommandBuffer::CopyMemoryToAccelerationStructure(u64 srcDeviceAddress, VkAccelerationStructureKHR dst,
+                                                       VkCopyAccelerationStructureModeKHR mode)
+{
+  VkCopyMemoryToAccelerationStructureInfoKHR copyInfo{
+      .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_ACCELERATION_STRUCTURE_INFO_KHR,
+      .pNext = nullptr,
+      .src = { .deviceAddress = srcDeviceAddress },
+      .dst = dst,
+      .mode = mode
+  };
+  vkCmdCopyMemoryToAccelerationStructureKHR(m_CommandBuffer, &copyInfo);
+}
+
+
+void FCommandBuffer::WriteAccelerationStructuresProperties(
+    std::span<const VkAccelerationStructureKHR> accelerationStructures, VkQueryType queryType, VkQueryPool queryPool,
+    u32 firstQuery)
+{
+  vkCmdWriteAccelerationStructuresPropertiesKHR(m_CommandBuffer, accelerationStructures.size(),
+                                                accelerationStructures.data(), queryType, queryPool, firstQuery);
+}
+
+
+void FCommandBuffer::ResetQueryPool(VkQueryPool queryPool, u32 firstQuery, u32 queryCount)
+{
+  vkCmdResetQueryPool(m_CommandBuffer, queryPool, firstQuery, queryCount);
+}
+
+
 void FCommandBuffer::BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
 {
   vkCmdBindPipeline(m_CommandBuffer, bindPoint, pipeline);
@@ -202,14 +303,13 @@ void FCommandBuffer::BindDescriptorSet(VkPipelineBindPoint bindPoint, VkPipeline
 
 
 void FCommandBuffer::BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
-                                        std::span<VkDescriptorSet> descriptorSets)
+                                        std::span<VkDescriptorSet> descriptorSets,
+                                        std::span<const u32> dynamicOffsets)
 {
   constexpr u32 firstSet = 0;
-  constexpr u32 dynamicOffsetCount = 0;
-  constexpr u32* pDynamicOffsets = nullptr;
   vkCmdBindDescriptorSets(m_CommandBuffer, bindPoint, pipelineLayout,
                           firstSet, descriptorSets.size(), descriptorSets.data(),
-                          dynamicOffsetCount, pDynamicOffsets);
+                          dynamicOffsets.size(), dynamicOffsets.data());
 }
 
 
@@ -6,6 +6,7 @@
 #include <volk.h>
 #include <span>
 #include "UTools/UTypes.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Context/Typedefs.h"
 #undef MemoryBarrier
 
 
@@ -45,6 +46,11 @@ public:
   void ImageMemoryBarrier(VkImage image, VkAccessFlags srcFlags, VkAccessFlags dstFlags, VkImageLayout oldLayout,
                           VkImageLayout newLayout, VkImageSubresourceRange subresourceRange,
                           VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
+  /// @brief Releases (dstAccess is ignored) or acquires (srcAccess is ignored) buffers between queue families,
+  /// the same barrier must be recorded on both queues
+  void BufferOwnershipBarrier(std::span<const VkBuffer> buffers, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                              VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+                              FQueueFamilyIndex srcFamilyIndex, FQueueFamilyIndex dstFamilyIndex);
   void ClearColorImage(VkImage image, VkClearColorValue clearValue, VkImageSubresourceRange subresourceRange);
 
   void CopyImage(VkImage srcImage, VkImage dstImage, VkImageSubresourceLayers subresourceLayers, VkExtent2D extent);
@@ -53,12 +59,23 @@ public:
 
   void BuildAccelerationStructure(const VkAccelerationStructureBuildGeometryInfoKHR* pBuildGeometryInfo,
                                   const VkAccelerationStructureBuildRangeInfoKHR* const* ppBuildRangeInfos);
+  void BuildAccelerationStructures(std::span<const VkAccelerationStructureBuildGeometryInfoKHR> buildGeometryInfos,
+                                   const VkAccelerationStructureBuildRangeInfoKHR* const* ppBuildRangeInfos);
+  void CopyAccelerationStructure(VkAccelerationStructureKHR src, VkAccelerationStructureKHR dst,
+                                 VkCopyAccelerationStructureModeKHR mode);
+  void CopyAccelerationStructureToMemory(VkAccelerationStructureKHR src, u64 dstDeviceAddress,
+                                         VkCopyAccelerationStructureModeKHR mode);
+  void CopyMemoryToAccelerationStructure(u64 srcDeviceAddress, VkAccelerationStructureKHR dst,
+                                         VkCopyAccelerationStructureModeKHR mode);
+  void WriteAccelerationStructuresProperties(std::span<const VkAccelerationStructureKHR> accelerationStructures,
+                                             VkQueryType queryType, VkQueryPool queryPool, u32 firstQuery);
+  void ResetQueryPool(VkQueryPool queryPool, u32 firstQuery, u32 queryCount);
 
   void BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
 
   void BindDescriptorSet(VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, VkDescriptorSet descriptorSet);
   void BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
-                          std::span<VkDescriptorSet> descriptorSets);
+                          std::span<VkDescriptorSet> descriptorSets, std::span<const u32> dynamicOffsets = {});
 
   void BindVertexBuffers(std::span<VkBuffer> vertexBuffers);
   void BindIndexBuffer(VkBuffer indexBuffer, VkIndexType indexType);
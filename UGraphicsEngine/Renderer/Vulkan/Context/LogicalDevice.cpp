@@ -64,6 +64,9 @@ void FLogicalDevice::Create(const FLogicalDeviceAttributes& attributes, VkPhysic
   AssertVkAndThrow(result);
 
   InitializeQueues();
+
+  // Every buffer and image of device is sub-allocated from memory blocks of this allocator...
+  m_MemoryAllocator.Create(m_Device, vkPhysicalDevice, m_Attributes.IsBufferDeviceAddressEnabled());
 }
 
 
@@ -71,6 +74,7 @@ void FLogicalDevice::Destroy()
 {
   if (m_Device != VK_NULL_HANDLE)
   {
+    m_MemoryAllocator.Destroy();
     vkDestroyDevice(m_Device, nullptr);
   }
 }
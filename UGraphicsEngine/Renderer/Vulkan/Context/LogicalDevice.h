@@ -6,6 +6,7 @@
 #include <volk.h>
 #include "LogicalDeviceAttributes.h"
 #include "Queue.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/DeviceMemoryAllocator.h"
 
 
 namespace uncanny::vulkan
@@ -44,11 +45,19 @@ public:
   [[nodiscard]] const FQueue& GetTransferQueue() const { return m_TransferQueue; }
   [[nodiscard]] const FQueue& GetComputeQueue() const { return m_ComputeQueue; }
 
+  [[nodiscard]] const FDeviceMemoryAllocator& GetMemoryAllocator() const { return m_MemoryAllocator; }
+
   [[nodiscard]] FQueueFamilyIndex GetGraphicsFamilyIndex() const { return m_Attributes.GetGraphicsFamilyIndex(); }
   [[nodiscard]] FQueueFamilyIndex GetPresentFamilyIndex() const { return m_Attributes.GetPresentFamilyIndex(); }
   [[nodiscard]] FQueueFamilyIndex GetTransferFamilyIndex() const { return m_Attributes.GetTransferFamilyIndex(); }
   [[nodiscard]] FQueueFamilyIndex GetComputeFamilyIndex() const { return m_Attributes.GetComputeFamilyIndex(); }
 
+  /// @brief Transfer and compute queues fall back to graphics queue (the same VkQueue) when device has no dedicated
+  /// family for them. Otherwise their work runs concurrently with graphics queue, but buffers used by several
+  /// families must be transferred between them with release and acquire barriers (see FUploadManager).
+  [[nodiscard]] b32 HasDedicatedTransferQueue() const { return GetTransferFamilyIndex() != GetGraphicsFamilyIndex(); }
+  [[nodiscard]] b32 HasAsyncComputeQueue() const { return GetComputeFamilyIndex() != GetGraphicsFamilyIndex(); }
+
 private:
 
   void Create(const FLogicalDeviceAttributes& attributes, VkPhysicalDevice vkPhysicalDevice);
@@ -61,6 +70,7 @@ private:
   FQueue m_PresentQueue{};
   FQueue m_TransferQueue{};
   FQueue m_ComputeQueue{};
+  FDeviceMemoryAllocator m_MemoryAllocator{};
   VkDevice m_Device{ VK_NULL_HANDLE };
 
 };
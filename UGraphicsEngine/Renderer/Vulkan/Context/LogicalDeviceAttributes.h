@@ -64,6 +64,18 @@ public:
     return m_RayTracingPipelineProperties;
   }
 
+  [[nodiscard]] const VkPhysicalDeviceAccelerationStructurePropertiesKHR& GetAccelerationStructureProperties() const
+  {
+    return m_AccelerationStructureProperties;
+  }
+
+  [[nodiscard]] b8 IsBufferDeviceAddressEnabled() const { return m_Vulkan12Features.bufferDeviceAddress; }
+
+  [[nodiscard]] const VkPhysicalDeviceAccelerationStructureFeaturesKHR& GetAccelerationStructureFeatures() const
+  {
+    return m_AccelerationStructureFeatures;
+  }
+
 private:
 
   // required extensions...
@@ -1,6 +1,8 @@
 
 #include "PhysicalDeviceAttributes.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
+#include <algorithm>
+#include <cstring>
 
 
 namespace uncanny::vulkan
@@ -28,6 +30,24 @@ void FPhysicalDeviceAttributes::Initialize(VkPhysicalDevice vkPhysicalDevice)
 
   vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &m_Features);
 
+  // Alignments of ray tracing buffers are queried only when device has extensions defining them...
+  if (IsExtensionPresent(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME))
+  {
+    VkPhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingProperties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR
+    };
+    QueryProperties2(&rayTracingProperties);
+    m_ShaderGroupBaseAlignment = std::max<VkDeviceSize>(rayTracingProperties.shaderGroupBaseAlignment, 1);
+  }
+  if (IsExtensionPresent(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME))
+  {
+    VkPhysicalDeviceAccelerationStructurePropertiesKHR accelerationStructureProperties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR
+    };
+    QueryProperties2(&accelerationStructureProperties);
+    m_ScratchOffsetAlignment =
+        std::max<VkDeviceSize>(accelerationStructureProperties.minAccelerationStructureScratchOffsetAlignment, 1);
+  }
 }
 
 
@@ -46,6 +66,24 @@ b8 FPhysicalDeviceAttributes::IsExtensionPresent(const char* extensionName) cons
 }
 
 
+VkDeviceSize FPhysicalDeviceAttributes::GetMinBufferAlignment(VkBufferUsageFlags usage) const
+{
+  VkDeviceSize alignment{ 1 };
+  if (usage & VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR)
+  {
+    alignment = std::max(alignment, m_ShaderGroupBaseAlignment);
+  }
+  // Scratch buffers are storage buffers accessed by device address, their usage cannot be told apart any better...
+  constexpr VkBufferUsageFlags scratchUsage =
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+  if ((usage & scratchUsage) == scratchUsage)
+  {
+    alignment = std::max(alignment, m_ScratchOffsetAlignment);
+  }
+  return alignment;
+}
+
+
 VkPhysicalDeviceMemoryProperties FPhysicalDeviceAttributes::GetMemoryProperties() const
 {
   VkPhysicalDeviceMemoryProperties properties{};
@@ -36,6 +36,12 @@ public:
   [[nodiscard]] const std::vector<VkExtensionProperties>& GetExtensionProperties() const { return m_ExtensionProperties; }
   [[nodiscard]] const std::vector<VkQueueFamilyProperties>& GetQueueFamilyProperties() const { return m_QueueFamilyProperties; }
 
+  /// @brief Some buffers must start at address aligned more than their memory requirements say, e.g. shader
+  /// binding table (shaderGroupBaseAlignment) or acceleration structure scratch
+  /// (minAccelerationStructureScratchOffsetAlignment)
+  /// @returns minimal alignment of memory for buffer with given usage, 1 when there is no extra requirement
+  [[nodiscard]] VkDeviceSize GetMinBufferAlignment(VkBufferUsageFlags usage) const;
+
   /// @brief Queries specific properties like VkPhysicalDeviceRayTracingPipelinePropertiesKHR
   /// @tparam TProperties queried Vulkan structure
   /// @param pProperties pointer to queried vulkan structure, where result will be stored
@@ -67,6 +73,8 @@ private:
   VkPhysicalDeviceFeatures m_Features{};
   std::vector<VkExtensionProperties> m_ExtensionProperties{};
   std::vector<VkQueueFamilyProperties> m_QueueFamilyProperties{};
+  VkDeviceSize m_ShaderGroupBaseAlignment{ 1 };
+  VkDeviceSize m_ScratchOffsetAlignment{ 1 };
 
 };
 
@@ -38,6 +38,39 @@ void FQueue::Submit(std::span<VkSemaphore> waitVkSemaphores, std::span<VkPipelin
 }
 
 
+void FQueue::Submit(std::span<VkSemaphore> waitVkSemaphores, std::span<VkPipelineStageFlags> waitStageFlags,
+                    std::span<const u64> waitValues, const FCommandBuffer& commandBuffer,
+                    std::span<VkSemaphore> signalVkSemaphores, std::span<const u64> signalValues,
+                    VkFence vkFence) const
+{
+  VkCommandBuffer vkCmdBuf = commandBuffer.GetHandle();
+
+  VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{
+    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+    .pNext = nullptr,
+    .waitSemaphoreValueCount = static_cast<u32>(waitValues.size()),
+    .pWaitSemaphoreValues = waitValues.data(),
+    .signalSemaphoreValueCount = static_cast<u32>(signalValues.size()),
+    .pSignalSemaphoreValues = signalValues.data()
+  };
+
+  VkSubmitInfo submitInfo{
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .pNext = &timelineSubmitInfo,
+    .waitSemaphoreCount = static_cast<u32>(waitVkSemaphores.size()),
+    .pWaitSemaphores = waitVkSemaphores.data(),
+    .pWaitDstStageMask = waitStageFlags.data(),
+    .commandBufferCount = 1,
+    .pCommandBuffers = &vkCmdBuf,
+    .signalSemaphoreCount = static_cast<u32>(signalVkSemaphores.size()),
+    .pSignalSemaphores = signalVkSemaphores.data()
+  };
+
+  VkResult result = vkQueueSubmit(m_Queue, 1, &submitInfo, vkFence);
+  AssertVkAndThrow(result);
+}
+
+
 void FQueue::WaitIdle() const
 {
   vkQueueWaitIdle(m_Queue);
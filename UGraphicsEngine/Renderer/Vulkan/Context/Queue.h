@@ -25,6 +25,12 @@ public:
   void Submit(std::span<VkSemaphore> waitVkSemaphores, std::span<VkPipelineStageFlags> waitStageFlags,
               const FCommandBuffer& commandBuffer, std::span<VkSemaphore> signalVkSemaphores, VkFence vkFence) const;
 
+  /// @brief Submit with values of timeline semaphores, every semaphore has its value at the same index (value of
+  /// binary semaphore is ignored)
+  void Submit(std::span<VkSemaphore> waitVkSemaphores, std::span<VkPipelineStageFlags> waitStageFlags,
+              std::span<const u64> waitValues, const FCommandBuffer& commandBuffer,
+              std::span<VkSemaphore> signalVkSemaphores, std::span<const u64> signalValues, VkFence vkFence) const;
+
   void WaitIdle() const;
 
   [[nodiscard]] VkQueue GetHandle() const { return m_Queue; }
@@ -42,6 +42,7 @@ public:
       std::span<const VkQueueFamilyProperties> properties, VkInstance vkInstance, VkPhysicalDevice vkPhysicalDevice);
 
   /// @brief Calculates score for every properties and chooses best score for transfer queue family.
+  /// @details Transfer-only family (DMA engine) is preferred, otherwise family with the least other capabilities.
   /// @param properties all queue family properties
   /// @param vkInstance VkInstance handle (used for vkGetInstanceProcAddr)
   /// @param vkPhysicalDevice VkPhysicalDevice handle (used for support validation)
@@ -50,6 +51,7 @@ public:
       std::span<const VkQueueFamilyProperties> properties, VkInstance vkInstance, VkPhysicalDevice vkPhysicalDevice);
 
   /// @brief Calculates score for every properties and chooses best score for compute queue family.
+  /// @details Family without graphics (async compute) is preferred, otherwise graphics family is used.
   /// @param properties all queue family properties
   /// @param vkInstance VkInstance handle (used for vkGetInstanceProcAddr)
   /// @param vkPhysicalDevice VkPhysicalDevice handle (used for support validation)
@@ -20,7 +20,10 @@ void FGraphicsPipeline::Create(const FGraphicsPipelineSpecification& specificati
 {
   m_Device = specification.vkDevice;
 
-  CreateCache();
+  if (specification.vkPipelineCache == VK_NULL_HANDLE)
+  {
+    CreateCache();
+  }
   CreatePipeline(specification);
 }
 
@@ -218,7 +221,9 @@ void FGraphicsPipeline::CreatePipeline(const FGraphicsPipelineSpecification& spe
     .basePipelineIndex = 0
   };
 
-  VkResult result = vkCreateGraphicsPipelines(m_Device, m_PipelineCache, 1, &createInfo, nullptr, &m_Pipeline);
+  VkPipelineCache vkPipelineCache =
+      specification.vkPipelineCache != VK_NULL_HANDLE ? specification.vkPipelineCache : m_PipelineCache;
+  VkResult result = vkCreateGraphicsPipelines(m_Device, vkPipelineCache, 1, &createInfo, nullptr, &m_Pipeline);
   AssertVkAndThrow(result);
 }
 
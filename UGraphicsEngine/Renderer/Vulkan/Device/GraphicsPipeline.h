@@ -22,6 +22,8 @@ struct FGraphicsPipelineSpecification
   VkRenderPass renderPass{ VK_NULL_HANDLE };
   VkDevice vkDevice{ VK_NULL_HANDLE };
   u32 targetVulkanVersion{ UUNUSED };
+  /// Optional shared cache (see FPipelineCache), own empty cache is created when it is not given
+  VkPipelineCache vkPipelineCache{ VK_NULL_HANDLE };
 };
 
 
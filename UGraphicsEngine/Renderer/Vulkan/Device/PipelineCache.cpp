@@ -0,0 +1,171 @@
+
+#include "PipelineCache.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Context/PhysicalDeviceAttributes.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
+#include "UTools/Logger/Log.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+
+namespace uncanny::vulkan
+{
+
+
+static constexpr u32 g_PipelineCacheMagic{ 0x50434655 }; // "UFCP"
+
+
+FPipelineCache::~FPipelineCache()
+{
+  Destroy();
+}
+
+
+void FPipelineCache::Create(std::string filePath, const FPhysicalDeviceAttributes& physicalDeviceAttributes,
+                            VkDevice vkDevice)
+{
+  m_FilePath = std::move(filePath);
+  m_Device = vkDevice;
+
+  const VkPhysicalDeviceProperties& properties = physicalDeviceAttributes.GetDeviceProperties();
+  VkPhysicalDeviceIDProperties idProperties{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES
+  };
+  physicalDeviceAttributes.QueryProperties2(&idProperties);
+
+  m_Header = FHeader{
+      .magic = g_PipelineCacheMagic,
+      .driverVersion = properties.driverVersion,
+      .vendorID = properties.vendorID,
+      .deviceID = properties.deviceID
+  };
+  memcpy(m_Header.deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+
+  std::error_code errorCode{};
+  std::filesystem::create_directories(std::filesystem::path(m_FilePath).parent_path(), errorCode);
+  if (errorCode)
+  {
+    UERROR("Cannot create pipeline cache directory for {}", m_FilePath);
+  }
+
+  // Loading data of previous run, it is used only when it was written by the same device and driver...
+  std::vector<char> data{};
+  std::ifstream fileStream{ m_FilePath, std::ios::binary | std::ios::ate };
+  if (fileStream and (u64)fileStream.tellg() >= sizeof(FHeader))
+  {
+    const u64 fileSize = fileStream.tellg();
+    FHeader fileHeader{};
+    fileStream.seekg(0);
+    fileStream.read(reinterpret_cast<char*>(&fileHeader), sizeof(FHeader));
+
+    const b8 sameDevice = fileHeader.magic == m_Header.magic and fileHeader.driverVersion == m_Header.driverVersion and
+                          fileHeader.vendorID == m_Header.vendorID and fileHeader.deviceID == m_Header.deviceID and
+                          memcmp(fileHeader.deviceUUID, m_Header.deviceUUID, VK_UUID_SIZE) == 0;
+    if (sameDevice and fileHeader.dataSize == fileSize - sizeof(FHeader))
+    {
+      data.resize(fileHeader.dataSize);
+      fileStream.read(data.data(), data.size());
+      if (not fileStream)
+      {
+        data.clear();
+      }
+    }
+    else
+    {
+      UWARN("Pipeline cache {} was written by other device or driver, pipelines will be compiled again", m_FilePath);
+    }
+  }
+
+  // Vulkan header of data is checked too, as some drivers do not reject foreign data on their own...
+  VkPipelineCacheHeaderVersionOne vulkanHeader{};
+  if (data.size() >= sizeof(vulkanHeader))
+  {
+    memcpy(&vulkanHeader, data.data(), sizeof(vulkanHeader));
+    if (vulkanHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE or
+        vulkanHeader.vendorID != properties.vendorID or vulkanHeader.deviceID != properties.deviceID or
+        memcmp(vulkanHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+      UWARN("Pipeline cache {} does not match pipeline cache UUID, pipelines will be compiled again", m_FilePath);
+      data.clear();
+    }
+  }
+  else
+  {
+    data.clear();
+  }
+
+  VkPipelineCacheCreateInfo createInfo{
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    .pNext = nullptr,
+    .flags = 0,
+    .initialDataSize = data.size(),
+    .pInitialData = data.empty() ? nullptr : data.data()
+  };
+  VkResult result = vkCreatePipelineCache(m_Device, &createInfo, nullptr, &m_PipelineCache);
+  AssertVkAndThrow(result);
+
+  m_LoadedSize = data.size();
+  m_LoadedFromDisk = not data.empty();
+  UINFO("Pipeline cache {} is {} ({} bytes)", m_FilePath, m_LoadedFromDisk ? "warm" : "cold", m_LoadedSize);
+}
+
+
+void FPipelineCache::Destroy()
+{
+  if (m_PipelineCache != VK_NULL_HANDLE)
+  {
+    vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+    m_PipelineCache = VK_NULL_HANDLE;
+  }
+  m_LoadedSize = 0;
+  m_LoadedFromDisk = UFALSE;
+}
+
+
+void FPipelineCache::Save() const
+{
+  if (m_PipelineCache == VK_NULL_HANDLE)
+  {
+    return;
+  }
+
+  size_t dataSize{ 0 };
+  VkResult result = vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr);
+  AssertVkAndThrow(result);
+  std::vector<char> data(dataSize);
+  result = vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, data.data());
+  AssertVkAndThrow(result);
+  data.resize(dataSize);
+
+  FHeader header = m_Header;
+  header.dataSize = data.size();
+
+  // Data is written into temporary file first, so that cache file is always complete...
+  const std::string temporaryPath = m_FilePath + ".tmp";
+  {
+    std::ofstream fileStream{ temporaryPath, std::ios::binary | std::ios::trunc };
+    if (not fileStream)
+    {
+      UERROR("Cannot write pipeline cache file {}", temporaryPath);
+      return;
+    }
+    fileStream.write(reinterpret_cast<const char*>(&header), sizeof(FHeader));
+    fileStream.write(data.data(), data.size());
+    if (not fileStream)
+    {
+      UERROR("Cannot write pipeline cache file {}", temporaryPath);
+      return;
+    }
+  }
+
+  std::error_code errorCode{};
+  std::filesystem::rename(temporaryPath, m_FilePath, errorCode);
+  if (errorCode)
+  {
+    UERROR("Cannot replace pipeline cache file {}", m_FilePath);
+  }
+}
+
+
+}
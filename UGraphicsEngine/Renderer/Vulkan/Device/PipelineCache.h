@@ -0,0 +1,77 @@
+
+#ifndef UNCANNYENGINE_PIPELINECACHE_H
+#define UNCANNYENGINE_PIPELINECACHE_H
+
+
+#include <volk.h>
+#include "UTools/UTypes.h"
+#include <string>
+
+
+namespace uncanny::vulkan
+{
+
+
+class FPhysicalDeviceAttributes;
+
+
+/// @brief FPipelineCache keeps VkPipelineCache on disk, so that pipelines compiled in previous runs are not
+/// compiled again at startup.
+/// @details Cache data is stored with own header (device UUID, driver version, vendor and device IDs), because
+/// data is valid only for the same device and driver and Vulkan header does not contain driver version. Data
+/// written by other device or driver is ignored and cache starts empty (cold). It should be passed to every
+/// vkCreate*Pipelines call and saved after pipelines are created. File is replaced atomically, so that broken
+/// cache is never left behind when app is killed while saving.
+class FPipelineCache
+{
+public:
+
+  FPipelineCache() = default;
+  FPipelineCache(const FPipelineCache&) = delete;
+  FPipelineCache& operator=(const FPipelineCache&) = delete;
+
+  ~FPipelineCache();
+
+  /// @param filePath - cache file, its directory is created if it does not exist
+  void Create(std::string filePath, const FPhysicalDeviceAttributes& physicalDeviceAttributes, VkDevice vkDevice);
+  void Destroy();
+
+  /// @brief Writes current cache data (with pipelines created since Create()) to disk
+  void Save() const;
+
+  [[nodiscard]] VkPipelineCache GetHandle() const { return m_PipelineCache; }
+
+  /// @returns whether valid data from previous run was loaded (warm start)
+  [[nodiscard]] b32 IsLoadedFromDisk() const { return m_LoadedFromDisk; }
+
+  /// @returns size of data loaded at creation, 0 for cold start
+  [[nodiscard]] u64 GetLoadedSize() const { return m_LoadedSize; }
+
+private:
+
+  struct FHeader
+  {
+    u32 magic{ 0 };
+    u32 driverVersion{ 0 };
+    u32 vendorID{ 0 };
+    u32 deviceID{ 0 };
+    u8 deviceUUID[VK_UUID_SIZE]{};
+    u64 dataSize{ 0 };
+  };
+
+private:
+
+  std::string m_FilePath{};
+  FHeader m_Header{};
+  VkDevice m_Device{ VK_NULL_HANDLE };
+  VkPipelineCache m_PipelineCache{ VK_NULL_HANDLE };
+  u64 m_LoadedSize{ 0 };
+  b32 m_LoadedFromDisk{ UFALSE };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_PIPELINECACHE_H
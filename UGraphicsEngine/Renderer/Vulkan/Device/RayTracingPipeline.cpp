@@ -143,8 +143,8 @@ void FRayTracingPipeline::CreatePipeline(const FRayTracingPipelineSpecification&
       .basePipelineIndex = 0
   };
 
-  VkResult result = vkCreateRayTracingPipelinesKHR(m_Device, nullptr, nullptr, 1, &createInfo,
-                                                   nullptr, &m_Pipeline);
+  VkResult result = vkCreateRayTracingPipelinesKHR(m_Device, VK_NULL_HANDLE, specification.vkPipelineCache, 1,
+                                                   &createInfo, nullptr, &m_Pipeline);
   AssertVkAndThrow(result);
 }
 
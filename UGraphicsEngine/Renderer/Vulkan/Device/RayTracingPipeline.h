@@ -27,6 +27,8 @@ struct FRayTracingPipelineSpecification
   const VkPhysicalDeviceRayTracingPipelinePropertiesKHR* pProperties{ nullptr };
   VkDevice vkDevice{ VK_NULL_HANDLE };
   const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes{ nullptr };
+  /// Optional cache (see FPipelineCache), shared by all pipelines so that compiled shaders are reused
+  VkPipelineCache vkPipelineCache{ VK_NULL_HANDLE };
 };
 
 
@@ -2,8 +2,10 @@
 #include "Swapchain.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Context/LogicalDevice.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Context/WindowSurface.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/DeletionQueue.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
 #include "UTools/Logger/Log.h"
+#include <memory>
 // remove stupid MSVC min/max macro definitions
 #ifdef WIN32
   #undef min
@@ -69,6 +71,7 @@ void FSwapchain::Create(u32 backBufferCount, VkDevice vkDevice, const FQueue* pQ
     m_ImageAvailableSemaphores[i].Create(m_Device);
     m_PresentableImagesReadySemaphores[i].Create(m_Device);
   }
+  CreateImageRenderedSemaphores();
 }
 
 
@@ -128,6 +131,27 @@ void FSwapchain::RetrieveNewlyCreatedImages()
 }
 
 
+void FSwapchain::CreateImageRenderedSemaphores()
+{
+  // Semaphores are kept when recreated swapchain has the same count of images...
+  if (m_ImageRenderedSemaphores.size() == m_Images.size())
+  {
+    return;
+  }
+
+  for (FSemaphore& semaphore : m_ImageRenderedSemaphores)
+  {
+    semaphore.Destroy();
+  }
+  m_ImageRenderedSemaphores.clear();
+  m_ImageRenderedSemaphores.resize(m_Images.size());
+  for (FSemaphore& semaphore : m_ImageRenderedSemaphores)
+  {
+    semaphore.Create(m_Device);
+  }
+}
+
+
 void FSwapchain::CreateViews()
 {
   m_ImageViews.reserve(m_Images.size());
@@ -212,6 +236,10 @@ void FSwapchain::Destroy()
     m_ImageAvailableSemaphores[i].Destroy();
     m_PresentableImagesReadySemaphores[i].Destroy();
   }
+  for (FSemaphore& semaphore : m_ImageRenderedSemaphores)
+  {
+    semaphore.Destroy();
+  }
 }
 
 
@@ -268,40 +296,97 @@ void FSwapchain::Recreate()
   CreateOnlySwapchain(oldSwapchain);
 
   vkDestroySwapchainKHR(m_Device, oldSwapchain, nullptr);
+
+  CreateImageRenderedSemaphores();
+}
+
+
+void FSwapchain::Recreate(FDeletionQueue& deletionQueue, u64 lastUseValue)
+{
+  VkSwapchainKHR oldSwapchain = m_Swapchain;
+  m_Swapchain = VK_NULL_HANDLE;
+
+  // Pending present of old image may still wait for its semaphore, so fresh semaphores are always created...
+  auto pOldSemaphores = std::make_shared<std::vector<FSemaphore>>();
+  pOldSemaphores->swap(m_ImageRenderedSemaphores);
+  deletionQueue.Push(lastUseValue, [vkDevice = m_Device, oldSwapchain, oldFramebuffers = std::move(m_Framebuffers),
+                                    oldViews = std::move(m_ImageViews), pOldSemaphores]()
+  {
+    for (VkFramebuffer vkFramebuffer : oldFramebuffers)
+    {
+      vkDestroyFramebuffer(vkDevice, vkFramebuffer, nullptr);
+    }
+    for (VkImageView vkImageView : oldViews)
+    {
+      vkDestroyImageView(vkDevice, vkImageView, nullptr);
+    }
+    vkDestroySwapchainKHR(vkDevice, oldSwapchain, nullptr);
+    pOldSemaphores->clear();
+  });
+  m_Framebuffers.clear();
+  m_ImageViews.clear();
+  m_Images.clear();
+
+  CreateOnlySwapchain(oldSwapchain);
+  CreateImageRenderedSemaphores();
 }
 
 
 void FSwapchain::WaitForNextImage()
 {
   m_Fences[m_CurrentFrame].WaitAndReset();
+  AcquireNextImage(m_ImageAvailableSemaphores[m_CurrentFrame].GetHandle());
+}
+
+
+void FSwapchain::Present()
+{
+  QueuePresent(m_PresentableImagesReadySemaphores[m_CurrentFrame].GetHandle());
+
+  m_CurrentFrame++;
+  if (m_CurrentFrame >= m_BackBufferCount)
+  {
+    m_CurrentFrame = 0;
+  }
+}
+
 
+b32 FSwapchain::AcquireNextImage(VkSemaphore imageAvailableSemaphore)
+{
   u64 timeout = std::numeric_limits<u64>::max();
-  VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain, timeout,
-                                          m_ImageAvailableSemaphores[m_CurrentFrame].GetHandle(),
-                                          VK_NULL_HANDLE, &m_ImageIndex);
+  VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain, timeout, imageAvailableSemaphore, VK_NULL_HANDLE,
+                                          &m_ImageIndex);
   switch(result)
   {
     case VK_SUCCESS:
-      break;
+      return UTRUE;
     case VK_SUBOPTIMAL_KHR:
-      [[fallthrough]];
+      // Image is acquired and semaphore will be signaled, so frame can still be presented...
+      m_OutOfDate = UTRUE;
+      return UTRUE;
     case VK_ERROR_OUT_OF_DATE_KHR:
       m_OutOfDate = UTRUE;
-      break;
+      return UFALSE;
     default:
       AssertVkAndThrow(result);
+      return UFALSE;
   }
 }
 
 
-void FSwapchain::Present()
+void FSwapchain::PresentImage()
+{
+  QueuePresent(m_ImageRenderedSemaphores[m_ImageIndex].GetHandle());
+}
+
+
+void FSwapchain::QueuePresent(VkSemaphore waitSemaphore)
 {
-  VkSemaphore waitSemaphores[]{ m_PresentableImagesReadySemaphores[m_CurrentFrame].GetHandle() };
   VkPresentInfoKHR presentInfo{
     .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
     .pNext = nullptr,
     .waitSemaphoreCount = 1,
-    .pWaitSemaphores = waitSemaphores,
+    .pWaitSemaphores = &waitSemaphore,
     .swapchainCount = 1,
     .pSwapchains = &m_Swapchain,
     .pImageIndices = &m_ImageIndex,
@@ -321,11 +406,6 @@ void FSwapchain::Present()
       AssertVkAndThrow(result);
   }
 
-  m_CurrentFrame++;
-  if (m_CurrentFrame >= m_BackBufferCount)
-  {
-    m_CurrentFrame = 0;
-  }
   m_CurrentExtent = m_pWindowSurface->QueryCapabilities().currentExtent;
 }
 
@@ -18,6 +18,7 @@ namespace uncanny::vulkan
 class FLogicalDevice;
 class FWindowSurface;
 class FQueue;
+class FDeletionQueue;
 
 
 class FSwapchain
@@ -33,16 +34,29 @@ public:
 
   [[nodiscard]] b8 IsRecreatePossible() const;
   void Recreate();
+  /// @brief Recreates swapchain without waiting for device idle, old swapchain, its views, framebuffers and image
+  /// rendered semaphores are handed over to deletion queue. Views and framebuffers must be created again.
+  /// @param lastUseValue - timeline value, after which old images are no longer rendered to or presented
+  void Recreate(FDeletionQueue& deletionQueue, u64 lastUseValue);
 
   void WaitForNextImage();
   void Present();
 
+  /// @brief Acquires next image, it does not wait for any fence, so that caller paces frames in flight on its own
+  /// (e.g. with timeline semaphore) independently of swapchain images count
+  /// @returns false when no image was acquired (swapchain is out of date), semaphore is not signaled then, so frame
+  /// must be skipped without submitting and swapchain recreated before acquiring again
+  b32 AcquireNextImage(VkSemaphore imageAvailableSemaphore);
+  /// @brief Presents acquired image, when GetImageRenderedSemaphore() is signaled
+  void PresentImage();
+
   [[nodiscard]] b8 IsOutOfDate() const { return m_OutOfDate; }
   [[nodiscard]] std::span<const VkImage> GetImages() const { return m_Images; }
   [[nodiscard]] std::span<const VkImageView> GetViews() const { return m_ImageViews; }
   [[nodiscard]] std::span<const VkFramebuffer> GetFramebuffers() const { return m_Framebuffers; }
   [[nodiscard]] u32 GetBackBufferCount() const { return m_BackBufferCount; }
   [[nodiscard]] u32 GetCurrentFrameIndex() const { return m_CurrentFrame; }
+  [[nodiscard]] u32 GetCurrentImageIndex() const { return m_ImageIndex; }
   [[nodiscard]] VkExtent2D GetCurrentExtent() const { return m_CurrentExtent; }
   [[nodiscard]] f32 GetCurrentAspectRatio() const { return (f32)m_CurrentExtent.width / (f32)m_CurrentExtent.height; }
   [[nodiscard]] VkFormat GetFormat() const { return m_Format; }
@@ -56,11 +70,16 @@ public:
   {
     return m_PresentableImagesReadySemaphores[m_CurrentFrame];
   }
+  /// @returns semaphore of acquired image, which must be signaled by its last submit. There is one per image, as
+  /// semaphore waited for by present can be signaled again only after its image is acquired again...
+  [[nodiscard]] const FSemaphore& GetImageRenderedSemaphore() const { return m_ImageRenderedSemaphores[m_ImageIndex]; }
 
 private:
 
   void CreateOnlySwapchain(VkSwapchainKHR oldSwapchain);
   void RetrieveNewlyCreatedImages();
+  void CreateImageRenderedSemaphores();
+  void QueuePresent(VkSemaphore waitSemaphore);
 
   void DestroyViews();
   void DestroyFramebuffers();
@@ -70,6 +89,7 @@ private:
   std::vector<FFence> m_Fences{};
   std::vector<FSemaphore> m_ImageAvailableSemaphores{};
   std::vector<FSemaphore> m_PresentableImagesReadySemaphores{};
+  std::vector<FSemaphore> m_ImageRenderedSemaphores{};
   std::vector<VkImage> m_Images{};
   std::vector<VkImageView> m_ImageViews{};
   std::vector<VkFramebuffer> m_Framebuffers{};
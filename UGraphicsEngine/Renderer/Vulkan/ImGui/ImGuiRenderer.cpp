@@ -30,17 +30,19 @@ void FImGuiRenderer::Create(const FImGuiRendererSpecification& specification)
   m_Device = specification.vkDevice;
   m_pPhysicalDeviceAttributes = specification.pPhysicalDeviceAttributes;
 
-  m_Semaphores.resize(specification.backBufferCount);
-  for(u32 i = 0; i < specification.backBufferCount; i++)
+  m_Semaphores.resize(specification.framesInFlightCount);
+  for(u32 i = 0; i < specification.framesInFlightCount; i++)
   {
     m_Semaphores[i].Create(m_Device);
   }
+  m_VertexBuffers.resize(specification.framesInFlightCount);
+  m_IndexBuffers.resize(specification.framesInFlightCount);
 
   constexpr b32 clearColorAttachmentEveryDraw = UFALSE;
   m_RenderPass.Create(clearColorAttachmentEveryDraw, specification.swapchainFormat, VK_FORMAT_D32_SFLOAT, m_Device);
   m_CommandPool.Create(specification.graphicsQueueFamilyIndex, m_Device,
                        VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-  m_CommandBuffers = m_CommandPool.AllocatePrimaryCommandBuffers(specification.backBufferCount);
+  m_CommandBuffers = m_CommandPool.AllocatePrimaryCommandBuffers(specification.framesInFlightCount);
 
   ImGui::CreateContext();
 
@@ -63,8 +65,14 @@ void FImGuiRenderer::Destroy()
   {
     commandBuffer.Free();
   }
-  m_VertexBuffer.Free();
-  m_IndexBuffer.Free();
+  for (FBuffer& buffer : m_VertexBuffers)
+  {
+    buffer.Free();
+  }
+  for (FBuffer& buffer : m_IndexBuffers)
+  {
+    buffer.Free();
+  }
   m_CommandPool.Destroy();
   m_RenderPass.Destroy();
   m_FontImage.Free();
@@ -92,11 +100,11 @@ void FImGuiRenderer::BeginFrame(VkExtent2D swapchainExtent, FMouseButtonsPressed
 }
 
 
-void FImGuiRenderer::EndFrame(u32 frameIndex, const FQueue& queueUsingBuffers, VkFramebuffer swapchainFramebuffer)
+void FImGuiRenderer::EndFrame(u32 frameIndex, VkFramebuffer swapchainFramebuffer)
 {
   ImGui::Render();
 
-  UpdateBuffers(queueUsingBuffers);
+  UpdateBuffers(frameIndex);
   RecordRenderPass(frameIndex, swapchainFramebuffer);
 }
 
@@ -118,7 +126,7 @@ void FImGuiRenderer::UpdateIO(VkExtent2D extent, FMouseButtonsPressed mouseButto
 }
 
 
-void FImGuiRenderer::UpdateBuffers(const FQueue& queueUsingBuffers)
+void FImGuiRenderer::UpdateBuffers(u32 frameIndex)
 {
   ImDrawData* imDrawData = ImGui::GetDrawData();
   if (not imDrawData)
@@ -134,24 +142,25 @@ void FImGuiRenderer::UpdateBuffers(const FQueue& queueUsingBuffers)
     return;
   }
 
-  if ((not m_VertexBuffer.IsValid()) or (vertexBufferSize > m_VertexBuffer.GetAllocatedSize()))
+  // Buffers of this frame are not used by GPU anymore, so they can be grown without waiting for queue...
+  FBuffer& vertexBuffer = m_VertexBuffers[frameIndex];
+  FBuffer& indexBuffer = m_IndexBuffers[frameIndex];
+  if ((not vertexBuffer.IsValid()) or (vertexBufferSize > vertexBuffer.GetAllocatedSize()))
   {
-    queueUsingBuffers.WaitIdle();
-    m_VertexBuffer.Free();
-    m_VertexBuffer.Allocate(vertexBufferSize * 2, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_Device, m_pPhysicalDeviceAttributes);
+    vertexBuffer.Free();
+    vertexBuffer.Allocate(vertexBufferSize * 2, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_Device, m_pPhysicalDeviceAttributes);
   }
-  if ((not m_IndexBuffer.IsValid()) or (indexBufferSize > m_IndexBuffer.GetAllocatedSize()))
+  if ((not indexBuffer.IsValid()) or (indexBufferSize > indexBuffer.GetAllocatedSize()))
   {
-    queueUsingBuffers.WaitIdle();
-    m_IndexBuffer.Free();
-    m_IndexBuffer.Allocate(indexBufferSize * 2, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_Device, m_pPhysicalDeviceAttributes);
+    indexBuffer.Free();
+    indexBuffer.Allocate(indexBufferSize * 2, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_Device, m_pPhysicalDeviceAttributes);
   }
 
   {
-    auto* pVertexDst = static_cast<ImDrawVert*>(m_VertexBuffer.Map());
-    auto* pIndexDst = static_cast<ImDrawIdx*>(m_IndexBuffer.Map());
+    auto* pVertexDst = static_cast<ImDrawVert*>(vertexBuffer.Map());
+    auto* pIndexDst = static_cast<ImDrawIdx*>(indexBuffer.Map());
 
     std::span<ImDrawList*> cmdLists{ imDrawData->CmdLists, (u32)imDrawData->CmdListsCount };
     for (const ImDrawList* pCmdList : cmdLists)
@@ -162,8 +171,8 @@ void FImGuiRenderer::UpdateBuffers(const FQueue& queueUsingBuffers)
       pIndexDst += pCmdList->IdxBuffer.Size;
     }
 
-    m_VertexBuffer.Unmap();
-    m_IndexBuffer.Unmap();
+    vertexBuffer.Unmap();
+    indexBuffer.Unmap();
   }
 }
 
@@ -207,9 +216,9 @@ void FImGuiRenderer::RecordDrawCommands(u32 frameIndex)
   commandBuffer.PushConstants(m_PipelineLayout.GetHandle(), VK_SHADER_STAGE_VERTEX_BIT, sizeof(FPushConstBlock),
                               &pushConstBlock);
 
-  VkBuffer vertexHandles[]{ m_VertexBuffer.GetHandle() };
+  VkBuffer vertexHandles[]{ m_VertexBuffers[frameIndex].GetHandle() };
   commandBuffer.BindVertexBuffers(vertexHandles);
-  commandBuffer.BindIndexBuffer(m_IndexBuffer.GetHandle(),  VK_INDEX_TYPE_UINT16);
+  commandBuffer.BindIndexBuffer(m_IndexBuffers[frameIndex].GetHandle(),  VK_INDEX_TYPE_UINT16);
 
   ImDrawData* imDrawData = ImGui::GetDrawData();
   i32 vertexOffset = 0;
@@ -363,7 +372,8 @@ void FImGuiRenderer::CreatePipeline(const FImGuiRendererSpecification& specifica
       .pipelineLayout = m_PipelineLayout.GetHandle(),
       .renderPass = GetRenderPass(),
       .vkDevice = m_Device,
-      .targetVulkanVersion = specification.targetVulkanVersion
+      .targetVulkanVersion = specification.targetVulkanVersion,
+      .vkPipelineCache = specification.vkPipelineCache
   };
 
   m_GraphicsPipeline.Create(pipelineSpecification);
@@ -32,8 +32,12 @@ struct FImGuiRendererSpecification
   const FQueue* pTransferQueue{ nullptr };
   VkFormat swapchainFormat{ VK_FORMAT_UNDEFINED };
   vulkan::FQueueFamilyIndex graphicsQueueFamilyIndex{ VK_QUEUE_FAMILY_IGNORED };
-  u32 backBufferCount{ UUNUSED };
+  /// Count of frames recorded while previous ones are still executed, every one has its own command buffer and
+  /// vertex and index buffers
+  u32 framesInFlightCount{ UUNUSED };
   u32 targetVulkanVersion{ UUNUSED };
+  /// Optional pipeline cache, see FPipelineCache
+  VkPipelineCache vkPipelineCache{ VK_NULL_HANDLE };
 };
 
 
@@ -47,7 +51,9 @@ public:
   void Destroy();
 
   void BeginFrame(VkExtent2D swapchainExtent, FMouseButtonsPressed mouseButtonsPressed, FMousePosition mousePosition);
-  void EndFrame(u32 frameIndex, const FQueue& queueUsingBuffers, VkFramebuffer swapchainFramebuffer);
+  /// @brief Writes draw data into buffers of given frame and records its command buffer, previous submit of the
+  /// same frame index must be finished
+  void EndFrame(u32 frameIndex, VkFramebuffer swapchainFramebuffer);
 
   [[nodiscard]] VkSemaphore GetSemaphore(u32 frameIndex) const { return m_Semaphores[frameIndex].GetHandle(); }
   [[nodiscard]] const FCommandBuffer& GetCommandBuffer(u32 frameIndex) const { return m_CommandBuffers[frameIndex]; }
@@ -60,7 +66,7 @@ private:
   void CreatePipeline(const FImGuiRendererSpecification& specification);
 
   void UpdateIO(VkExtent2D extent, FMouseButtonsPressed mouseButtonsPressed, FMousePosition mousePosition);
-  void UpdateBuffers(const FQueue& queueUsingBuffers);
+  void UpdateBuffers(u32 frameIndex);
 
   void RecordRenderPass(u32 frameIndex, VkFramebuffer swapchainFramebuffer);
   void RecordDrawCommands(u32 frameIndex);
@@ -72,8 +78,8 @@ private:
   std::vector<FSemaphore> m_Semaphores{};
   FImage m_FontImage{};
   FSampler m_Sampler{};
-  FBuffer m_VertexBuffer{};
-  FBuffer m_IndexBuffer{};
+  std::vector<FBuffer> m_VertexBuffers{};
+  std::vector<FBuffer> m_IndexBuffers{};
   FDescriptorSetLayout m_DescriptorSetLayout{};
   FDescriptorPool m_DescriptorPool{};
   FPipelineLayout m_PipelineLayout{};
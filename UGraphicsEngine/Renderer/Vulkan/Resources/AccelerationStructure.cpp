@@ -2,29 +2,39 @@
 #include "AccelerationStructure.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/DeletionQueue.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Fence.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
 
 
 namespace uncanny::vulkan
 {
 
 
-void FAccelerationStructure::AcquireSizeForBuild(VkAccelerationStructureTypeKHR type, u32 trianglesCount,
-                                                 const VkAccelerationStructureGeometryKHR* pGeometry)
+void FAccelerationStructure::AcquireSizeForBuild(VkAccelerationStructureTypeKHR type,
+                                                 std::span<const VkAccelerationStructureGeometryKHR> geometries,
+                                                 std::span<const u32> maxPrimitiveCounts)
 {
   VkAccelerationStructureBuildGeometryInfoKHR buildSizeGeometryInfo{
       .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
       .type = type,
-      .flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR,
-      .geometryCount = 1,
-      .pGeometries = pGeometry,
+      .flags = m_BuildFlags,
+      .geometryCount = (u32)geometries.size(),
+      .pGeometries = geometries.data(),
   };
   VkAccelerationStructureBuildSizesInfoKHR buildSizesInfo{
       .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR
   };
-  vkGetAccelerationStructureBuildSizesKHR(m_Device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
-                                          &buildSizeGeometryInfo, &trianglesCount, &buildSizesInfo);
+  const VkAccelerationStructureBuildTypeKHR buildType = m_BuildOnHost ? VK_ACCELERATION_STRUCTURE_BUILD_TYPE_HOST_KHR :
+                                                                         VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
+  vkGetAccelerationStructureBuildSizesKHR(m_Device, buildType, &buildSizeGeometryInfo, maxPrimitiveCounts.data(),
+                                          &buildSizesInfo);
   m_Size = buildSizesInfo.accelerationStructureSize;
+  m_BuildSize = m_Size;
   m_ScratchSize = buildSizesInfo.buildScratchSize;
+  m_UpdateScratchSize = buildSizesInfo.updateScratchSize;
 }
 
 
@@ -32,8 +42,11 @@ void FAccelerationStructure::Create(VkAccelerationStructureTypeKHR type)
 {
   VkBufferUsageFlags accelerationUsageFlags =
       VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-  m_AccelerationMemoryBuffer.Allocate(m_Size, accelerationUsageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                      m_Device, m_pPhysicalDeviceAttributes);
+  // Host builds write structure directly, so its memory must be host visible...
+  VkMemoryPropertyFlags memoryFlags = m_BuildOnHost ?
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  m_AccelerationMemoryBuffer.Allocate(m_Size, accelerationUsageFlags, memoryFlags, m_Device,
+                                      m_pPhysicalDeviceAttributes);
 
   VkAccelerationStructureCreateInfoKHR createInfo{
       .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
@@ -63,37 +76,30 @@ void FAccelerationStructure::Create(VkAccelerationStructureTypeKHR type)
 
 
 void FAccelerationStructure::Build(VkAccelerationStructureTypeKHR type,
-                                   const VkAccelerationStructureGeometryKHR* pGeometry,
-                                   u32 primitiveCount, const FCommandPool& commandPool, const FQueue& queue)
+                                   std::span<const VkAccelerationStructureGeometryKHR> geometries,
+                                   std::span<const VkAccelerationStructureBuildRangeInfoKHR> buildRanges,
+                                   const FCommandPool& commandPool, const FQueue& queue)
 {
+  const VkAccelerationStructureBuildRangeInfoKHR* buildRangeInfos[]{ buildRanges.data() };
+
+  if (m_BuildOnHost)
+  {
+    // Built right away on calling thread, see FAccelerationStructureBuilder for builds spread over job system...
+    std::vector<std::byte> scratchMemory(m_ScratchSize);
+    VkAccelerationStructureBuildGeometryInfoKHR buildGeometryInfo = GetBuildGeometryInfo(type, geometries, 0);
+    buildGeometryInfo.scratchData.hostAddress = scratchMemory.data();
+    VkResult result = vkBuildAccelerationStructuresKHR(m_Device, VK_NULL_HANDLE, 1, &buildGeometryInfo,
+                                                       buildRangeInfos);
+    AssertVkAndThrow(result);
+    return;
+  }
+
   FBuffer scratchBuffer{};
   scratchBuffer.Allocate(m_ScratchSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
-  VkDeviceOrHostAddressKHR scratchDeviceAddress{
-      .deviceAddress = scratchBuffer.GetDeviceAddress()
-  };
 
-  VkAccelerationStructureBuildGeometryInfoKHR buildGeometryInfo{
-      .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
-      .pNext = nullptr,
-      .type = type,
-      .flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR,
-      .mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-      .srcAccelerationStructure = VK_NULL_HANDLE,
-      .dstAccelerationStructure = m_AccelerationStructure,
-      .geometryCount = 1,
-      .pGeometries = pGeometry,
-      .ppGeometries = nullptr,
-      .scratchData = scratchDeviceAddress
-  };
-
-  VkAccelerationStructureBuildRangeInfoKHR buildRangeInfo{
-      .primitiveCount = primitiveCount,
-      .primitiveOffset = 0,
-      .firstVertex = 0,
-      .transformOffset = 0
-  };
-  VkAccelerationStructureBuildRangeInfoKHR* buildRangeInfos[]{ &buildRangeInfo };
+  VkAccelerationStructureBuildGeometryInfoKHR buildGeometryInfo =
+      GetBuildGeometryInfo(type, geometries, scratchBuffer.GetDeviceAddress());
 
   VkAccessFlags accessFlags = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
                               VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
@@ -105,10 +111,68 @@ void FAccelerationStructure::Build(VkAccelerationStructureTypeKHR type,
   commandBuffer.BuildAccelerationStructure(&buildGeometryInfo, buildRangeInfos);
   commandBuffer.EndRecording();
 
-  queue.Submit({}, {}, commandBuffer, {}, VK_NULL_HANDLE);
-  queue.WaitIdle();
+  // Only this build is waited for, other work submitted to the queue keeps running...
+  FFence fence{};
+  fence.Create(m_Device, 0);
+  queue.Submit({}, {}, commandBuffer, {}, fence.GetHandle());
+  fence.WaitAndReset();
+}
+
+
+VkAccelerationStructureBuildGeometryInfoKHR FAccelerationStructure::GetBuildGeometryInfo(
+    VkAccelerationStructureTypeKHR type, std::span<const VkAccelerationStructureGeometryKHR> geometries,
+    u64 scratchDeviceAddress, VkBuildAccelerationStructureModeKHR mode) const
+{
+  const b8 update = mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR;
+  return VkAccelerationStructureBuildGeometryInfoKHR{
+      .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+      .pNext = nullptr,
+      .type = type,
+      .flags = m_BuildFlags,
+      .mode = mode,
+      .srcAccelerationStructure = update ? m_AccelerationStructure : VK_NULL_HANDLE,
+      .dstAccelerationStructure = m_AccelerationStructure,
+      .geometryCount = (u32)geometries.size(),
+      .pGeometries = geometries.data(),
+      .ppGeometries = nullptr,
+      .scratchData = { .deviceAddress = scratchDeviceAddress }
+  };
+}
+
+
+VkBuildAccelerationStructureFlagsKHR FAccelerationStructure::GetBuildFlagsForPolicy(
+    EAccelerationStructureBuildPolicy policy)
+{
+  switch (policy)
+  {
+    case EAccelerationStructureBuildPolicy::Dynamic:
+      return VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR |
+             VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+    case EAccelerationStructureBuildPolicy::Static:
+    default:
+      return VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
+             VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+  }
+}
+
 
-  vkDeviceWaitIdle(m_Device);
+void FAccelerationStructure::ReplaceWith(FAccelerationStructure& other)
+{
+  Destroy();
+  m_AccelerationMemoryBuffer.Swap(other.m_AccelerationMemoryBuffer);
+  std::swap(m_AccelerationStructure, other.m_AccelerationStructure);
+  m_DeviceAddress = other.m_DeviceAddress;
+  m_Size = other.m_Size;
+}
+
+
+VkTransformMatrixKHR FAccelerationStructure::ConvertToTransformMatrix(const math::Matrix4x4f& transform)
+{
+  return {
+      transform[0], transform[4], transform[8], transform[12],
+      transform[1], transform[5], transform[9], transform[13],
+      transform[2], transform[6], transform[10], transform[14]
+  };
 }
 
 
@@ -124,4 +188,20 @@ void FAccelerationStructure::Destroy()
 }
 
 
+void FAccelerationStructure::Destroy(FDeletionQueue& deletionQueue, u64 lastUseValue)
+{
+  if (m_AccelerationStructure != VK_NULL_HANDLE)
+  {
+    // Structure is pushed before its memory, so that it is destroyed first...
+    deletionQueue.Push(lastUseValue, [vkDevice = m_Device, vkAccelerationStructure = m_AccelerationStructure]()
+    {
+      vkDestroyAccelerationStructureKHR(vkDevice, vkAccelerationStructure, nullptr);
+    });
+    m_AccelerationStructure = VK_NULL_HANDLE;
+  }
+
+  m_AccelerationMemoryBuffer.Free(deletionQueue, lastUseValue);
+}
+
+
 }
@@ -15,27 +15,81 @@ namespace uncanny::vulkan
 
 
 class FPhysicalDeviceAttributes;
+class FDeletionQueue;
+
+
+/// @brief Build policy selects build flags of structure depending on how its content changes
+enum class EAccelerationStructureBuildPolicy
+{
+  /// Built once and then only traced (static level geometry): fast trace, compaction
+  Static,
+  /// Geometry itself is refit or built again at runtime (deforming objects): fast build, update. Moving objects
+  /// only change their instance transform in top level structure, so their structures stay static
+  Dynamic
+};
 
 
 class FAccelerationStructure
 {
+
+  friend class FAccelerationStructureBuilder;
+
 public:
 
   [[nodiscard]] VkAccelerationStructureKHR GetHandle() const { return m_AccelerationStructure; }
   [[nodiscard]] u64 GetDeviceAddress() const { return m_DeviceAddress; }
+  [[nodiscard]] const FBuffer& GetMemoryBuffer() const { return m_AccelerationMemoryBuffer; }
+  [[nodiscard]] VkDeviceSize GetScratchSize() const { return m_ScratchSize; }
+  [[nodiscard]] VkDeviceSize GetUpdateScratchSize() const { return m_UpdateScratchSize; }
+  /// @returns size of structure memory, it is smaller than build size after compaction
+  [[nodiscard]] VkDeviceSize GetSize() const { return m_Size; }
+  /// @returns worst-case size of structure memory acquired for build
+  [[nodiscard]] VkDeviceSize GetBuildSize() const { return m_BuildSize; }
+  [[nodiscard]] VkBuildAccelerationStructureFlagsKHR GetBuildFlags() const { return m_BuildFlags; }
+  [[nodiscard]] b32 IsBuiltOnHost() const { return m_BuildOnHost; }
+
+  /// @brief Sets flags used for next build, must be called before structure is created (e.g. ALLOW_COMPACTION)
+  void SetBuildFlags(VkBuildAccelerationStructureFlagsKHR flags) { m_BuildFlags = flags; }
+  void SetBuildPolicy(EAccelerationStructureBuildPolicy policy) { m_BuildFlags = GetBuildFlagsForPolicy(policy); }
+
+  /// @brief Selects host build (vkBuildAccelerationStructuresKHR on CPU threads) instead of device build, must be
+  /// called before build sizes are acquired. Requires accelerationStructureHostCommands feature, structure memory
+  /// is then host visible and geometry is read through host addresses.
+  void SetBuildOnHost(b32 buildOnHost) { m_BuildOnHost = buildOnHost; }
+
+  static VkBuildAccelerationStructureFlagsKHR GetBuildFlagsForPolicy(EAccelerationStructureBuildPolicy policy);
 
   void Destroy();
+  /// @brief Hands structure and its memory over to deletion queue, they are destroyed when timeline passes
+  /// lastUseValue
+  void Destroy(FDeletionQueue& deletionQueue, u64 lastUseValue);
 
 protected:
 
-  void AcquireSizeForBuild(VkAccelerationStructureTypeKHR type, u32 trianglesCount,
-                           const VkAccelerationStructureGeometryKHR* pGeometry);
+  /// @param maxPrimitiveCounts - primitives count of every geometry
+  void AcquireSizeForBuild(VkAccelerationStructureTypeKHR type,
+                           std::span<const VkAccelerationStructureGeometryKHR> geometries,
+                           std::span<const u32> maxPrimitiveCounts);
 
   void Create(VkAccelerationStructureTypeKHR type);
 
-  void Build(VkAccelerationStructureTypeKHR type,
-             const VkAccelerationStructureGeometryKHR* pGeometry,
-             u32 primitiveCount, const FCommandPool& commandPool, const FQueue& queue);
+  /// @param buildRanges - build range of every geometry
+  void Build(VkAccelerationStructureTypeKHR type, std::span<const VkAccelerationStructureGeometryKHR> geometries,
+             std::span<const VkAccelerationStructureBuildRangeInfoKHR> buildRanges, const FCommandPool& commandPool,
+             const FQueue& queue);
+
+  /// @returns build info of structure, geometries must be alive until build is recorded. In update mode structure
+  /// is updated in place (it is both source and destination).
+  [[nodiscard]] VkAccelerationStructureBuildGeometryInfoKHR GetBuildGeometryInfo(
+      VkAccelerationStructureTypeKHR type, std::span<const VkAccelerationStructureGeometryKHR> geometries,
+      u64 scratchDeviceAddress,
+      VkBuildAccelerationStructureModeKHR mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR) const;
+
+  /// @brief Takes over structure and memory of other (e.g. compacted copy), current ones are destroyed
+  void ReplaceWith(FAccelerationStructure& other);
+
+  /// @brief Converts column-major engine matrix into row-major 3x4 Vulkan transform
+  static VkTransformMatrixKHR ConvertToTransformMatrix(const math::Matrix4x4f& transform);
 
 protected:
 
@@ -48,7 +102,11 @@ private:
   VkAccelerationStructureKHR m_AccelerationStructure{ VK_NULL_HANDLE };
   u64 m_DeviceAddress{ UUNUSED };
   VkDeviceSize m_Size{ UUNUSED };
+  VkDeviceSize m_BuildSize{ UUNUSED };
   VkDeviceSize m_ScratchSize{ UUNUSED };
+  VkDeviceSize m_UpdateScratchSize{ UUNUSED };
+  VkBuildAccelerationStructureFlagsKHR m_BuildFlags{ VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR };
+  b32 m_BuildOnHost{ UFALSE };
 
 };
 
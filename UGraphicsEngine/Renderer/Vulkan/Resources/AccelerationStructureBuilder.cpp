@@ -0,0 +1,518 @@
+
+#include "AccelerationStructureBuilder.h"
+#include "AccelerationStructureCache.h"
+#include "UploadManager.h"
+#include "DeviceMemoryAllocator.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Context/LogicalDevice.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Context/PhysicalDeviceAttributes.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Fence.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
+#include "UTools/JobSystem/JobSystem.h"
+#include "UTools/Logger/Log.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+namespace uncanny::vulkan
+{
+
+
+// Serialized structures must be placed at 256 bytes aligned addresses...
+static constexpr VkDeviceSize g_SerializedDataAlignment{ 256 };
+
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+
+static VkQueryPool CreateQueryPool(VkDevice vkDevice, VkQueryType queryType, u32 queryCount)
+{
+  VkQueryPoolCreateInfo queryPoolCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = 0,
+      .queryType = queryType,
+      .queryCount = queryCount,
+      .pipelineStatistics = 0
+  };
+  VkQueryPool queryPool{ VK_NULL_HANDLE };
+  VkResult result = vkCreateQueryPool(vkDevice, &queryPoolCreateInfo, nullptr, &queryPool);
+  AssertVkAndThrow(result);
+  return queryPool;
+}
+
+
+static std::vector<VkDeviceSize> GetQueryResults(VkDevice vkDevice, VkQueryPool queryPool, u32 queryCount)
+{
+  std::vector<VkDeviceSize> results(queryCount);
+  VkResult result = vkGetQueryPoolResults(vkDevice, queryPool, 0, queryCount, results.size() * sizeof(VkDeviceSize),
+                                          results.data(), sizeof(VkDeviceSize),
+                                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+  AssertVkAndThrow(result);
+  return results;
+}
+
+
+static void JoinDeferredOperation(VkDevice vkDevice, VkDeferredOperationKHR deferredOperation)
+{
+  // Thread idle means that there is no work for this thread now, but operation is not complete yet...
+  VkResult result = vkDeferredOperationJoinKHR(vkDevice, deferredOperation);
+  while (result == VK_THREAD_IDLE_KHR)
+  {
+    std::this_thread::yield();
+    result = vkDeferredOperationJoinKHR(vkDevice, deferredOperation);
+  }
+}
+
+
+static void SubmitAndWait(const FCommandBuffer& commandBuffer, const FQueue& queue, VkDevice vkDevice)
+{
+  FFence fence{};
+  fence.Create(vkDevice, 0);
+  queue.Submit({}, {}, commandBuffer, {}, fence.GetHandle());
+  fence.WaitAndReset();
+}
+
+
+void FAccelerationStructureBuilder::Build(std::span<FBottomLevelAccelerationStructure> structures,
+                                          const FCommandPool& commandPool, const FQueue& queue,
+                                          const FLogicalDevice* pLogicalDevice, FAccelerationStructureCache* pCache,
+                                          FJobSystem* pJobSystem, FUploadManager* pUploadManager,
+                                          VkDeviceSize scratchBudget)
+{
+  std::vector<FBottomLevelAccelerationStructure*> pointers{};
+  pointers.reserve(structures.size());
+  for (FBottomLevelAccelerationStructure& structure : structures)
+  {
+    pointers.push_back(&structure);
+  }
+  Build(pointers, commandPool, queue, pLogicalDevice, pCache, pJobSystem, pUploadManager, scratchBudget);
+}
+
+
+void FAccelerationStructureBuilder::Build(std::span<FBottomLevelAccelerationStructure*> structures,
+                                          const FCommandPool& commandPool, const FQueue& queue,
+                                          const FLogicalDevice* pLogicalDevice, FAccelerationStructureCache* pCache,
+                                          FJobSystem* pJobSystem, FUploadManager* pUploadManager,
+                                          VkDeviceSize scratchBudget)
+{
+  if (structures.empty())
+  {
+    return;
+  }
+
+  const VkDevice vkDevice = pLogicalDevice->GetHandle();
+  const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes = structures[0]->m_pPhysicalDeviceAttributes;
+
+  // Structures found in cache are deserialized, other ones are built on device or on host...
+  std::vector<FBottomLevelAccelerationStructure*> builtStructures{};
+  std::vector<FBottomLevelAccelerationStructure*> hostBuiltStructures{};
+  std::vector<FBottomLevelAccelerationStructure*> cachedStructures{};
+  std::vector<std::vector<char>> cachedData{};
+  for (FBottomLevelAccelerationStructure* pStructure : structures)
+  {
+    if (pCache and pCache->IsValid())
+    {
+      std::vector<char> serializedData = pCache->Load(
+          FAccelerationStructureCache::CalculateKey(pStructure->GetContentHash(), pStructure->GetBuildFlags()));
+      if (not serializedData.empty())
+      {
+        cachedStructures.push_back(pStructure);
+        cachedData.push_back(std::move(serializedData));
+        continue;
+      }
+    }
+    if (pStructure->IsBuiltOnHost())
+    {
+      hostBuiltStructures.push_back(pStructure);
+      continue;
+    }
+    builtStructures.push_back(pStructure);
+  }
+
+  // Creating structures, deserialized ones are created with size stored in serialized data...
+  for (FBottomLevelAccelerationStructure* pStructure : builtStructures)
+  {
+    pStructure->Create(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR);
+  }
+  for (FBottomLevelAccelerationStructure* pStructure : hostBuiltStructures)
+  {
+    pStructure->Create(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR);
+  }
+  for (u32 i = 0; i < cachedStructures.size(); i++)
+  {
+    cachedStructures[i]->m_Size = FAccelerationStructureCache::GetDeserializedSize(cachedData[i]);
+    cachedStructures[i]->Create(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR);
+  }
+
+  // Serialized data is uploaded into one host visible buffer...
+  FBuffer serializedBuffer{};
+  std::vector<u64> serializedDeviceAddresses{};
+  if (not cachedStructures.empty())
+  {
+    std::vector<VkDeviceSize> offsets{};
+    VkDeviceSize serializedBufferSize = 0;
+    for (const std::vector<char>& serializedData : cachedData)
+    {
+      offsets.push_back(serializedBufferSize);
+      serializedBufferSize += AlignUp(serializedData.size(), g_SerializedDataAlignment);
+    }
+
+    serializedBuffer.Allocate(serializedBufferSize + g_SerializedDataAlignment,
+                              VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                              VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vkDevice,
+                              pPhysicalDeviceAttributes);
+    const u64 baseDeviceAddress = AlignUp(serializedBuffer.GetDeviceAddress(), g_SerializedDataAlignment);
+    char* pMapped = static_cast<char*>(serializedBuffer.Map()) +
+                    (baseDeviceAddress - serializedBuffer.GetDeviceAddress());
+    for (u32 i = 0; i < cachedData.size(); i++)
+    {
+      memcpy(pMapped + offsets[i], cachedData[i].data(), cachedData[i].size());
+      serializedDeviceAddresses.push_back(baseDeviceAddress + offsets[i]);
+    }
+    serializedBuffer.Unmap();
+  }
+
+  const VkPhysicalDeviceAccelerationStructurePropertiesKHR& properties =
+      pLogicalDevice->GetAttributes().GetAccelerationStructureProperties();
+  const VkDeviceSize alignment = std::max<VkDeviceSize>(properties.minAccelerationStructureScratchOffsetAlignment, 1);
+
+  // Sizing shared scratch buffer...
+  VkDeviceSize largestScratchSize = 0;
+  VkDeviceSize totalScratchSize = 0;
+  for (const FBottomLevelAccelerationStructure* pStructure : builtStructures)
+  {
+    const VkDeviceSize scratchSize = AlignUp(pStructure->GetScratchSize(), alignment);
+    largestScratchSize = std::max(largestScratchSize, scratchSize);
+    totalScratchSize += scratchSize;
+  }
+  const VkDeviceSize scratchBufferSize = std::max(largestScratchSize, std::min(totalScratchSize, scratchBudget));
+
+  FBuffer scratchBuffer{};
+  u64 scratchDeviceAddress{ 0 };
+  if (not builtStructures.empty())
+  {
+    scratchBuffer.Allocate(scratchBufferSize + alignment,
+                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vkDevice, pPhysicalDeviceAttributes);
+    scratchDeviceAddress = AlignUp(scratchBuffer.GetDeviceAddress(), alignment);
+  }
+
+  // Compacted sizes are queried right after build, for structures that allow it. Deserialized structures were
+  // compacted before serialization...
+  std::vector<FBottomLevelAccelerationStructure*> compactedStructures{};
+  std::vector<VkAccelerationStructureKHR> compactedHandles{};
+  for (FBottomLevelAccelerationStructure* pStructure : builtStructures)
+  {
+    if (pStructure->GetBuildFlags() & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR)
+    {
+      compactedStructures.push_back(pStructure);
+      compactedHandles.push_back(pStructure->GetHandle());
+    }
+  }
+
+  VkQueryPool queryPool{ VK_NULL_HANDLE };
+  if (not compactedStructures.empty())
+  {
+    queryPool = CreateQueryPool(vkDevice, VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+                                compactedStructures.size());
+  }
+
+  // Recording all builds, batch is flushed whenever its scratch regions would not fit into scratch buffer...
+  std::vector<VkAccelerationStructureBuildGeometryInfoKHR> buildGeometryInfos{};
+  std::vector<const VkAccelerationStructureBuildRangeInfoKHR*> buildRangeInfos{};
+  buildGeometryInfos.reserve(builtStructures.size());
+  buildRangeInfos.reserve(builtStructures.size());
+
+  VkAccessFlags accessFlags = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
+                              VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+  VkPipelineStageFlags stageFlags = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+
+  FCommandBuffer commandBuffer = commandPool.AllocatePrimaryCommandBuffer();
+  commandBuffer.BeginOneTimeRecording();
+  u64 uploadIndex{ 0 };
+  if (pUploadManager)
+  {
+    uploadIndex = pUploadManager->RecordAcquireBarriers(commandBuffer, queue.GetFamilyIndex(),
+                                                        VK_ACCESS_SHADER_READ_BIT, stageFlags);
+  }
+  if (queryPool != VK_NULL_HANDLE)
+  {
+    commandBuffer.ResetQueryPool(queryPool, 0, compactedStructures.size());
+  }
+  for (u32 i = 0; i < cachedStructures.size(); i++)
+  {
+    commandBuffer.CopyMemoryToAccelerationStructure(serializedDeviceAddresses[i], cachedStructures[i]->GetHandle(),
+                                                    VK_COPY_ACCELERATION_STRUCTURE_MODE_DESERIALIZE_KHR);
+  }
+  commandBuffer.MemoryBarrier(accessFlags, accessFlags, stageFlags, stageFlags);
+
+  u32 batchStart = 0;
+  u32 batchesCount = 0;
+  VkDeviceSize scratchOffset = 0;
+  auto flushBatch = [&]()
+  {
+    if (batchStart == buildGeometryInfos.size())
+    {
+      return;
+    }
+    std::span<const VkAccelerationStructureBuildGeometryInfoKHR> batch{ buildGeometryInfos.begin() + batchStart,
+                                                                        buildGeometryInfos.end() };
+    commandBuffer.BuildAccelerationStructures(batch, buildRangeInfos.data() + batchStart);
+    // Next batch reuses scratch memory...
+    commandBuffer.MemoryBarrier(accessFlags, accessFlags, stageFlags, stageFlags);
+    batchStart = buildGeometryInfos.size();
+    scratchOffset = 0;
+    batchesCount++;
+  };
+
+  for (FBottomLevelAccelerationStructure* pStructure : builtStructures)
+  {
+    const VkDeviceSize scratchSize = AlignUp(pStructure->GetScratchSize(), alignment);
+    if (scratchOffset + scratchSize > scratchBufferSize)
+    {
+      flushBatch();
+    }
+
+    buildGeometryInfos.push_back(pStructure->GetBuildGeometryInfo(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+                                                                  pStructure->m_Geometries,
+                                                                  scratchDeviceAddress + scratchOffset));
+    buildRangeInfos.push_back(pStructure->m_BuildRanges.data());
+    scratchOffset += scratchSize;
+  }
+  flushBatch();
+
+  if (queryPool != VK_NULL_HANDLE)
+  {
+    commandBuffer.WriteAccelerationStructuresProperties(
+        compactedHandles, VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, queryPool, 0);
+  }
+
+  commandBuffer.EndRecording();
+
+  // Host builds run on CPU threads while device builds and deserializes. Uploads are waited for on device...
+  FFence fence{};
+  fence.Create(vkDevice, 0);
+  if (uploadIndex != 0)
+  {
+    VkSemaphore waitSemaphores[]{ pUploadManager->GetTimelineSemaphore() };
+    VkPipelineStageFlags waitStageFlags[]{ stageFlags };
+    const u64 waitValues[]{ uploadIndex };
+    queue.Submit(waitSemaphores, waitStageFlags, waitValues, commandBuffer, {}, {}, fence.GetHandle());
+  }
+  else
+  {
+    queue.Submit({}, {}, commandBuffer, {}, fence.GetHandle());
+  }
+  if (not hostBuiltStructures.empty())
+  {
+    BuildOnHost(hostBuiltStructures, pJobSystem, pLogicalDevice);
+  }
+  fence.WaitAndReset();
+
+  UDEBUG("Built {} bottom level structures in {} batches (scratch buffer: {} bytes), {} on host, deserialized {}",
+         builtStructures.size(), batchesCount, scratchBufferSize, hostBuiltStructures.size(),
+         cachedStructures.size());
+
+  if (queryPool != VK_NULL_HANDLE)
+  {
+    Compact(compactedStructures, queryPool, commandPool, queue, pLogicalDevice);
+    vkDestroyQueryPool(vkDevice, queryPool, nullptr);
+  }
+
+  builtStructures.insert(builtStructures.end(), hostBuiltStructures.begin(), hostBuiltStructures.end());
+  if (pCache and pCache->IsValid() and not builtStructures.empty())
+  {
+    Serialize(builtStructures, pCache, commandPool, queue, pLogicalDevice);
+  }
+}
+
+
+void FAccelerationStructureBuilder::BuildOnHost(std::span<FBottomLevelAccelerationStructure*> structures,
+                                                FJobSystem* pJobSystem, const FLogicalDevice* pLogicalDevice)
+{
+  const VkDevice vkDevice = pLogicalDevice->GetHandle();
+  const VkDeviceSize alignment = std::max<VkDeviceSize>(
+      pLogicalDevice->GetAttributes().GetAccelerationStructureProperties().minAccelerationStructureScratchOffsetAlignment,
+      alignof(std::max_align_t));
+
+  // Every structure gets its own scratch region, as all of them are built at once...
+  std::vector<VkDeviceSize> scratchOffsets{};
+  VkDeviceSize scratchSize = 0;
+  for (const FBottomLevelAccelerationStructure* pStructure : structures)
+  {
+    scratchOffsets.push_back(scratchSize);
+    scratchSize += AlignUp(pStructure->GetScratchSize(), alignment);
+  }
+  std::vector<std::byte> scratchMemory(scratchSize + alignment);
+  const u64 scratchBaseAddress = AlignUp(reinterpret_cast<u64>(scratchMemory.data()), alignment);
+
+  std::vector<VkAccelerationStructureBuildGeometryInfoKHR> buildGeometryInfos{};
+  std::vector<const VkAccelerationStructureBuildRangeInfoKHR*> buildRangeInfos{};
+  buildGeometryInfos.reserve(structures.size());
+  buildRangeInfos.reserve(structures.size());
+  for (u32 i = 0; i < structures.size(); i++)
+  {
+    VkAccelerationStructureBuildGeometryInfoKHR& buildGeometryInfo = buildGeometryInfos.emplace_back(
+        structures[i]->GetBuildGeometryInfo(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+                                            structures[i]->m_Geometries, 0));
+    buildGeometryInfo.scratchData.hostAddress = reinterpret_cast<void*>(scratchBaseAddress + scratchOffsets[i]);
+    buildRangeInfos.push_back(structures[i]->m_BuildRanges.data());
+  }
+
+  VkDeferredOperationKHR deferredOperation{ VK_NULL_HANDLE };
+  VkResult result = vkCreateDeferredOperationKHR(vkDevice, nullptr, &deferredOperation);
+  AssertVkAndThrow(result);
+
+  result = vkBuildAccelerationStructuresKHR(vkDevice, deferredOperation, buildGeometryInfos.size(),
+                                            buildGeometryInfos.data(), buildRangeInfos.data());
+  if (result == VK_OPERATION_DEFERRED_KHR)
+  {
+    // Implementation tells how many threads can join usefully, calling thread is one of them...
+    const u32 threadsCount = pJobSystem ? pJobSystem->GetThreadsCount() : 1;
+    const u32 concurrency = std::min(vkGetDeferredOperationMaxConcurrencyKHR(vkDevice, deferredOperation),
+                                     threadsCount);
+    FJobCounter counter{};
+    for (u32 i = 1; i < concurrency; i++)
+    {
+      pJobSystem->Spawn([vkDevice, deferredOperation]()
+      {
+        JoinDeferredOperation(vkDevice, deferredOperation);
+      }, &counter);
+    }
+    JoinDeferredOperation(vkDevice, deferredOperation);
+    if (pJobSystem)
+    {
+      pJobSystem->Wait(counter);
+    }
+    result = vkGetDeferredOperationResultKHR(vkDevice, deferredOperation);
+  }
+  else if (result == VK_OPERATION_NOT_DEFERRED_KHR)
+  {
+    result = VK_SUCCESS;
+  }
+  vkDestroyDeferredOperationKHR(vkDevice, deferredOperation, nullptr);
+  AssertVkAndThrow(result);
+}
+
+
+void FAccelerationStructureBuilder::Compact(std::span<FBottomLevelAccelerationStructure*> structures,
+                                            VkQueryPool queryPool, const FCommandPool& commandPool,
+                                            const FQueue& queue, const FLogicalDevice* pLogicalDevice)
+{
+  const std::vector<VkDeviceSize> compactedSizes =
+      GetQueryResults(pLogicalDevice->GetHandle(), queryPool, structures.size());
+
+  // Creating right-sized structures and copying built ones into them...
+  std::vector<FAccelerationStructure> compactedStructures(structures.size());
+
+  FCommandBuffer commandBuffer = commandPool.AllocatePrimaryCommandBuffer();
+  commandBuffer.BeginOneTimeRecording();
+  for (u32 i = 0; i < structures.size(); i++)
+  {
+    FAccelerationStructure& compacted = compactedStructures[i];
+    compacted.m_Device = structures[i]->m_Device;
+    compacted.m_pPhysicalDeviceAttributes = structures[i]->m_pPhysicalDeviceAttributes;
+    compacted.m_Size = compactedSizes[i];
+    compacted.Create(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR);
+    commandBuffer.CopyAccelerationStructure(structures[i]->GetHandle(), compacted.GetHandle(),
+                                            VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR);
+  }
+  commandBuffer.EndRecording();
+  SubmitAndWait(commandBuffer, queue, pLogicalDevice->GetHandle());
+
+  // Originals are not needed anymore, their memory is freed...
+  VkDeviceSize savedBytes = 0;
+  for (u32 i = 0; i < structures.size(); i++)
+  {
+    savedBytes += structures[i]->GetSize() - compactedStructures[i].GetSize();
+    structures[i]->ReplaceWith(compactedStructures[i]);
+  }
+
+  UDEBUG("Compacted {} bottom level structures, saved {} bytes", structures.size(), savedBytes);
+}
+
+
+void FAccelerationStructureBuilder::Serialize(std::span<FBottomLevelAccelerationStructure*> structures,
+                                              FAccelerationStructureCache* pCache, const FCommandPool& commandPool,
+                                              const FQueue& queue, const FLogicalDevice* pLogicalDevice)
+{
+  const VkDevice vkDevice = pLogicalDevice->GetHandle();
+
+  // Querying serialization sizes...
+  std::vector<VkAccelerationStructureKHR> handles{};
+  handles.reserve(structures.size());
+  for (const FBottomLevelAccelerationStructure* pStructure : structures)
+  {
+    handles.push_back(pStructure->GetHandle());
+  }
+
+  VkQueryPool queryPool = CreateQueryPool(vkDevice, VK_QUERY_TYPE_ACCELERATION_STRUCTURE_SERIALIZATION_SIZE_KHR,
+                                          structures.size());
+  {
+    FCommandBuffer commandBuffer = commandPool.AllocatePrimaryCommandBuffer();
+    commandBuffer.BeginOneTimeRecording();
+    commandBuffer.ResetQueryPool(queryPool, 0, structures.size());
+    commandBuffer.WriteAccelerationStructuresProperties(
+        handles, VK_QUERY_TYPE_ACCELERATION_STRUCTURE_SERIALIZATION_SIZE_KHR, queryPool, 0);
+    commandBuffer.EndRecording();
+    SubmitAndWait(commandBuffer, queue, vkDevice);
+  }
+  const std::vector<VkDeviceSize> serializedSizes = GetQueryResults(vkDevice, queryPool, structures.size());
+  vkDestroyQueryPool(vkDevice, queryPool, nullptr);
+
+  // Copying all structures into one host visible buffer...
+  std::vector<VkDeviceSize> offsets{};
+  VkDeviceSize serializedBufferSize = 0;
+  for (VkDeviceSize serializedSize : serializedSizes)
+  {
+    offsets.push_back(serializedBufferSize);
+    serializedBufferSize += AlignUp(serializedSize, g_SerializedDataAlignment);
+  }
+
+  // Data is read back by host, so cached memory is preferred, but not every device has cached coherent type...
+  const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes = structures[0]->m_pPhysicalDeviceAttributes;
+  VkMemoryPropertyFlags memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  if (FDeviceMemoryAllocator::FindMemoryTypeIndex(pPhysicalDeviceAttributes->GetMemoryProperties(), ~0u,
+                                                  memoryFlags | VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != UUNUSED)
+  {
+    memoryFlags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  }
+
+  FBuffer serializedBuffer{};
+  serializedBuffer.Allocate(serializedBufferSize + g_SerializedDataAlignment,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                            memoryFlags, vkDevice, pPhysicalDeviceAttributes);
+  const u64 baseDeviceAddress = AlignUp(serializedBuffer.GetDeviceAddress(), g_SerializedDataAlignment);
+
+  FCommandBuffer commandBuffer = commandPool.AllocatePrimaryCommandBuffer();
+  commandBuffer.BeginOneTimeRecording();
+  for (u32 i = 0; i < structures.size(); i++)
+  {
+    commandBuffer.CopyAccelerationStructureToMemory(structures[i]->GetHandle(), baseDeviceAddress + offsets[i],
+                                                    VK_COPY_ACCELERATION_STRUCTURE_MODE_SERIALIZE_KHR);
+  }
+  commandBuffer.EndRecording();
+  SubmitAndWait(commandBuffer, queue, vkDevice);
+
+  const char* pMapped = static_cast<const char*>(serializedBuffer.Map()) +
+                        (baseDeviceAddress - serializedBuffer.GetDeviceAddress());
+  for (u32 i = 0; i < structures.size(); i++)
+  {
+    const u64 key = FAccelerationStructureCache::CalculateKey(structures[i]->GetContentHash(),
+                                                              structures[i]->GetBuildFlags());
+    pCache->Store(key, { pMapped + offsets[i], serializedSizes[i] });
+  }
+  serializedBuffer.Unmap();
+
+  UDEBUG("Serialized {} bottom level structures, {} bytes", structures.size(), serializedBufferSize);
+}
+
+
+}
@@ -0,0 +1,72 @@
+
+#ifndef UNCANNYENGINE_ACCELERATIONSTRUCTUREBUILDER_H
+#define UNCANNYENGINE_ACCELERATIONSTRUCTUREBUILDER_H
+
+
+#include "BottomLevelAccelerationStructure.h"
+#include <span>
+
+
+namespace uncanny
+{
+class FJobSystem;
+}
+
+
+namespace uncanny::vulkan
+{
+
+
+class FLogicalDevice;
+class FAccelerationStructureCache;
+class FUploadManager;
+
+
+/// @brief FAccelerationStructureBuilder builds many prepared bottom level structures with one submit.
+/// @details One scratch buffer is allocated for whole call, it is as big as largest build, but at least
+/// scratchBudget (if total scratch size is not smaller). Structures are split into batches, which fit into scratch
+/// buffer, every batch is single vkCmdBuildAccelerationStructuresKHR call with sub-allocated scratch regions.
+/// Batches are separated with barrier only, so that scratch memory can be reused. All batches are recorded into
+/// one command buffer, which is waited for with single fence, no queue or device wait idle is needed.
+/// Structures created with ALLOW_COMPACTION build flag are compacted afterwards: their compacted sizes are queried
+/// in the same command buffer, then every one is copied into right-sized memory and original memory is freed.
+/// When cache is given, structures found in it are deserialized in the same command buffer instead of being
+/// built, and structures that were built are serialized into cache afterwards (after compaction).
+/// Structures set to build on host are built with one deferred host operation instead, which is joined by job
+/// system threads (or by calling thread only, when no job system is given). They are not compacted.
+/// When upload manager is given, geometry uploaded by other queue family is acquired at the beginning of build
+/// command buffer and its submit waits for uploads on device, so that host does not wait between queues.
+class FAccelerationStructureBuilder
+{
+public:
+
+  /// @brief Builds all structures prepared with FBottomLevelAccelerationStructure::Prepare(), waits until finished
+  static void Build(std::span<FBottomLevelAccelerationStructure> structures, const FCommandPool& commandPool,
+                    const FQueue& queue, const FLogicalDevice* pLogicalDevice,
+                    FAccelerationStructureCache* pCache = nullptr, FJobSystem* pJobSystem = nullptr,
+                    FUploadManager* pUploadManager = nullptr, VkDeviceSize scratchBudget = 64 * 1024 * 1024);
+
+  /// @brief Builds only given structures, e.g. structures of new meshes appended to container of already built ones
+  static void Build(std::span<FBottomLevelAccelerationStructure*> structures, const FCommandPool& commandPool,
+                    const FQueue& queue, const FLogicalDevice* pLogicalDevice,
+                    FAccelerationStructureCache* pCache = nullptr, FJobSystem* pJobSystem = nullptr,
+                    FUploadManager* pUploadManager = nullptr, VkDeviceSize scratchBudget = 64 * 1024 * 1024);
+
+private:
+
+  static void BuildOnHost(std::span<FBottomLevelAccelerationStructure*> structures, FJobSystem* pJobSystem,
+                          const FLogicalDevice* pLogicalDevice);
+
+  static void Compact(std::span<FBottomLevelAccelerationStructure*> structures, VkQueryPool queryPool,
+                      const FCommandPool& commandPool, const FQueue& queue, const FLogicalDevice* pLogicalDevice);
+
+  static void Serialize(std::span<FBottomLevelAccelerationStructure*> structures, FAccelerationStructureCache* pCache,
+                        const FCommandPool& commandPool, const FQueue& queue, const FLogicalDevice* pLogicalDevice);
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_ACCELERATIONSTRUCTUREBUILDER_H
@@ -0,0 +1,151 @@
+
+#include "AccelerationStructureCache.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Context/PhysicalDeviceAttributes.h"
+#include "UTools/Logger/Log.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+
+namespace uncanny::vulkan
+{
+
+
+// Serialized structure starts with driver UUID, compatibility UUID, serialized size, deserialized size and
+// handles count (see vkCmdCopyAccelerationStructureToMemoryKHR)...
+static constexpr u64 g_SerializedHeaderSize{ 2 * VK_UUID_SIZE + 3 * sizeof(u64) };
+static constexpr u64 g_DeserializedSizeOffset{ 2 * VK_UUID_SIZE + sizeof(u64) };
+
+
+static constexpr u64 g_FnvOffsetBasis{ 14695981039346656037ull };
+static constexpr u64 g_FnvPrime{ 1099511628211ull };
+
+
+static u64 HashBytes(u64 hash, const void* pData, u64 size)
+{
+  // FNV-1a over 8 byte words, geometry is tens of megabytes so byte-wise hashing would be noticeable...
+  const auto* pBytes = static_cast<const std::byte*>(pData);
+  u64 i = 0;
+  for (; i + sizeof(u64) <= size; i += sizeof(u64))
+  {
+    u64 word;
+    memcpy(&word, pBytes + i, sizeof(u64));
+    hash = (hash ^ word) * g_FnvPrime;
+  }
+  for (; i < size; i++)
+  {
+    hash = (hash ^ (u64)pBytes[i]) * g_FnvPrime;
+  }
+  return hash;
+}
+
+
+void FAccelerationStructureCache::Initialize(std::string directory,
+                                             const FPhysicalDeviceAttributes& physicalDeviceAttributes,
+                                             VkDevice vkDevice)
+{
+  m_Directory = std::move(directory);
+  m_Device = vkDevice;
+
+  VkPhysicalDeviceIDProperties idProperties{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES
+  };
+  physicalDeviceAttributes.QueryProperties2(&idProperties);
+
+  constexpr char hexDigits[]{ "0123456789abcdef" };
+  m_DriverUUID.clear();
+  for (u8 byte : idProperties.driverUUID)
+  {
+    m_DriverUUID += hexDigits[byte >> 4];
+    m_DriverUUID += hexDigits[byte & 0xF];
+  }
+
+  std::error_code errorCode{};
+  std::filesystem::create_directories(m_Directory, errorCode);
+  if (errorCode)
+  {
+    UERROR("Cannot create acceleration structure cache directory {}", m_Directory);
+  }
+}
+
+
+std::vector<char> FAccelerationStructureCache::Load(u64 key)
+{
+  std::ifstream fileStream{ GetFilePath(key), std::ios::binary | std::ios::ate };
+  if (not fileStream)
+  {
+    m_MissesCount++;
+    return {};
+  }
+
+  std::vector<char> serializedData(fileStream.tellg());
+  fileStream.seekg(0);
+  fileStream.read(serializedData.data(), serializedData.size());
+  if (not fileStream or serializedData.size() < g_SerializedHeaderSize)
+  {
+    m_MissesCount++;
+    return {};
+  }
+
+  VkAccelerationStructureVersionInfoKHR versionInfo{
+      .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_VERSION_INFO_KHR,
+      .pNext = nullptr,
+      .pVersionData = reinterpret_cast<const u8*>(serializedData.data())
+  };
+  VkAccelerationStructureCompatibilityKHR compatibility{ VK_ACCELERATION_STRUCTURE_COMPATIBILITY_INCOMPATIBLE_KHR };
+  vkGetDeviceAccelerationStructureCompatibilityKHR(m_Device, &versionInfo, &compatibility);
+  if (compatibility != VK_ACCELERATION_STRUCTURE_COMPATIBILITY_COMPATIBLE_KHR)
+  {
+    UWARN("Cached acceleration structure {} is not compatible with device, it will be built again", key);
+    m_MissesCount++;
+    return {};
+  }
+
+  m_HitsCount++;
+  return serializedData;
+}
+
+
+void FAccelerationStructureCache::Store(u64 key, std::span<const char> serializedData) const
+{
+  std::ofstream fileStream{ GetFilePath(key), std::ios::binary | std::ios::trunc };
+  if (not fileStream)
+  {
+    UERROR("Cannot write acceleration structure cache file for key {}", key);
+    return;
+  }
+  fileStream.write(serializedData.data(), serializedData.size());
+}
+
+
+VkDeviceSize FAccelerationStructureCache::GetDeserializedSize(std::span<const char> serializedData)
+{
+  VkDeviceSize deserializedSize{ 0 };
+  memcpy(&deserializedSize, serializedData.data() + g_DeserializedSizeOffset, sizeof(VkDeviceSize));
+  return deserializedSize;
+}
+
+
+u64 FAccelerationStructureCache::CalculateContentHash(const FRenderMeshView& meshData)
+{
+  u64 hash = g_FnvOffsetBasis;
+  hash = HashBytes(hash, meshData.vertices.data(), meshData.vertices.size_bytes());
+  hash = HashBytes(hash, meshData.indices.data(), meshData.indices.size_bytes());
+  hash = HashBytes(hash, meshData.submeshes.data(), meshData.submeshes.size_bytes());
+  return hash;
+}
+
+
+u64 FAccelerationStructureCache::CalculateKey(u64 contentHash, VkBuildAccelerationStructureFlagsKHR buildFlags)
+{
+  return HashBytes(contentHash, &buildFlags, sizeof(buildFlags));
+}
+
+
+std::string FAccelerationStructureCache::GetFilePath(u64 key) const
+{
+  return m_Directory + "/" + m_DriverUUID + "_" + std::to_string(key) + ".blas";
+}
+
+
+}
@@ -0,0 +1,76 @@
+
+#ifndef UNCANNYENGINE_ACCELERATIONSTRUCTURECACHE_H
+#define UNCANNYENGINE_ACCELERATIONSTRUCTURECACHE_H
+
+
+#include <volk.h>
+#include "UGraphicsEngine/Renderer/RenderMesh.h"
+#include "UTools/UTypes.h"
+#include <span>
+#include <string>
+#include <vector>
+
+
+namespace uncanny::vulkan
+{
+
+
+class FPhysicalDeviceAttributes;
+
+
+/// @brief FAccelerationStructureCache keeps serialized bottom level structures on disk, so that next runs can
+/// deserialize them instead of building them again.
+/// @details Every structure is stored in its own file named after driver UUID and key (mesh content hash combined
+/// with build flags), so any change of geometry, build flags or driver simply misses the cache. Loaded data is
+/// additionally validated with vkGetDeviceAccelerationStructureCompatibilityKHR, as serialized structures are
+/// valid only for compatible device and driver. Serialization and deserialization itself is recorded by
+/// FAccelerationStructureBuilder.
+class FAccelerationStructureCache
+{
+public:
+
+  /// @param directory directory for cache files, it is created if it does not exist
+  void Initialize(std::string directory, const FPhysicalDeviceAttributes& physicalDeviceAttributes,
+                  VkDevice vkDevice);
+
+  /// @returns serialized structure, empty if it is not cached or is not compatible with current device
+  [[nodiscard]] std::vector<char> Load(u64 key);
+
+  void Store(u64 key, std::span<const char> serializedData) const;
+
+  [[nodiscard]] b32 IsValid() const { return m_Device != VK_NULL_HANDLE; }
+
+  /// @returns count of structures loaded from cache since initialization
+  [[nodiscard]] u32 GetHitsCount() const { return m_HitsCount; }
+
+  /// @returns count of structures that were not found in cache (or were not compatible) since initialization
+  [[nodiscard]] u32 GetMissesCount() const { return m_MissesCount; }
+
+  /// @returns size of structure, which must be created for deserialization, read from serialized data header
+  [[nodiscard]] static VkDeviceSize GetDeserializedSize(std::span<const char> serializedData);
+
+  /// @returns hash of geometry that bottom level structure is built from
+  [[nodiscard]] static u64 CalculateContentHash(const FRenderMeshView& meshData);
+
+  /// @returns cache key of structure with given content and build flags
+  [[nodiscard]] static u64 CalculateKey(u64 contentHash, VkBuildAccelerationStructureFlagsKHR buildFlags);
+
+private:
+
+  [[nodiscard]] std::string GetFilePath(u64 key) const;
+
+private:
+
+  std::string m_Directory{};
+  std::string m_DriverUUID{};
+  VkDevice m_Device{ VK_NULL_HANDLE };
+  u32 m_HitsCount{ 0 };
+  u32 m_MissesCount{ 0 };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_ACCELERATIONSTRUCTURECACHE_H
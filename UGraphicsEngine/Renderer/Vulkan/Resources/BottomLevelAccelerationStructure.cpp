@@ -1,5 +1,10 @@
 
 #include "BottomLevelAccelerationStructure.h"
+#include "AccelerationStructureCache.h"
+#include "UploadManager.h"
+#include "DeletionQueue.h"
+#include "UTools/Logger/Log.h"
+#include <algorithm>
 
 
 namespace uncanny::vulkan
@@ -18,22 +23,67 @@ void FBottomLevelAccelerationStructure::Destroy()
   m_VertexBuffer.Free();
   m_IndexBuffer.Free();
   m_MaterialBuffer.Free();
-  m_MaterialIndexBuffer.Free();
+  m_SubmeshBuffer.Free();
+  m_Geometries.clear();
+  m_BuildRanges.clear();
 }
 
 
-void FBottomLevelAccelerationStructure::Build(const FRenderMeshData& meshData, std::span<FRenderMaterialData> materials,
-                                              const FCommandPool& commandPool, const FQueue& queue, VkDevice vkDevice,
+void FBottomLevelAccelerationStructure::Destroy(FDeletionQueue& deletionQueue, u64 lastUseValue)
+{
+  FAccelerationStructure::Destroy(deletionQueue, lastUseValue);
+  m_VertexBuffer.Free(deletionQueue, lastUseValue);
+  m_IndexBuffer.Free(deletionQueue, lastUseValue);
+  m_MaterialBuffer.Free(deletionQueue, lastUseValue);
+  m_SubmeshBuffer.Free(deletionQueue, lastUseValue);
+  m_Geometries.clear();
+  m_BuildRanges.clear();
+}
+
+
+void FBottomLevelAccelerationStructure::Build(const FRenderMeshView& meshData,
+                                              std::span<const FRenderMaterialData> materials,
+                                              FUploadManager& uploadManager, const FCommandPool& commandPool,
+                                              const FQueue& queue, VkDevice vkDevice,
                                               const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes)
+{
+  // Build is submitted after uploads on the same queue, so it sees uploaded data...
+  Prepare(meshData, materials, uploadManager, vkDevice, pPhysicalDeviceAttributes);
+  uploadManager.Flush();
+  FAccelerationStructure::Create(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR);
+  FAccelerationStructure::Build(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, m_Geometries, m_BuildRanges,
+                                commandPool, queue);
+}
+
+
+void FBottomLevelAccelerationStructure::Prepare(const FRenderMeshView& meshData,
+                                                std::span<const FRenderMaterialData> materials,
+                                                FUploadManager& uploadManager, VkDevice vkDevice,
+                                                const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes)
 {
   m_Device = vkDevice;
   m_pPhysicalDeviceAttributes = pPhysicalDeviceAttributes;
 
   AssignTransformMatrix(meshData.transform);
 
-  const std::vector<FRenderVertex>& vertices = meshData.vertices;
-  const std::vector<u32>& indices = meshData.indices;
-  const std::vector<u32>& materialIndices = meshData.materialIndices;
+  std::span<const FRenderVertex> vertices = meshData.vertices;
+  std::span<const u32> indices = meshData.indices;
+
+  // Submeshes without triangle are not built, so geometry index in hit shaders is index into built submeshes
+  // uploaded below, not into all submeshes of mesh...
+  std::vector<FRenderSubmesh> submeshes{};
+  submeshes.reserve(meshData.submeshes.size());
+  for (const FRenderSubmesh& submesh : meshData.submeshes)
+  {
+    if (submesh.indicesCount >= 3 and submesh.verticesCount > 0)
+    {
+      submeshes.push_back(submesh);
+    }
+  }
+  if (submeshes.size() != meshData.submeshes.size())
+  {
+    UWARN("Skipped {} empty submeshes of bottom level structure", meshData.submeshes.size() - submeshes.size());
+  }
 
   VkBufferUsageFlags bufferUsageFlags =
       VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
@@ -41,24 +91,21 @@ void FBottomLevelAccelerationStructure::Build(const FRenderMeshData& meshData, s
 
   m_VertexBuffer.Allocate(vertices.size() * sizeof(FRenderVertex), bufferUsageFlags | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
-  m_VertexBuffer.FillStaged(vertices.data(), sizeof(FRenderVertex), vertices.size(), commandPool, queue);
+  m_VertexBuffer.FillStaged(vertices.data(), sizeof(FRenderVertex), vertices.size(), uploadManager);
 
   m_IndexBuffer.Allocate(indices.size() * sizeof(u32), bufferUsageFlags | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
-  m_IndexBuffer.FillStaged(indices.data(), sizeof(u32), indices.size(), commandPool, queue);
+  m_IndexBuffer.FillStaged(indices.data(), sizeof(u32), indices.size(), uploadManager);
 
   m_MaterialBuffer.Allocate(materials.size() * sizeof(FRenderMaterialData),
                             bufferUsageFlags | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
-  m_MaterialBuffer.FillStaged(materials.data(), sizeof(FRenderMaterialData), materials.size(), commandPool, queue);
-
-  m_MaterialIndexBuffer.Allocate(materialIndices.size() * sizeof(u32),
-                                 bufferUsageFlags | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
-  m_MaterialIndexBuffer.FillStaged(materialIndices.data(), sizeof(u32), materialIndices.size(), commandPool, queue);
+  m_MaterialBuffer.FillStaged(materials.data(), sizeof(FRenderMaterialData), materials.size(), uploadManager);
 
-  u32 trianglesCount = m_IndexBuffer.GetFilledElementsCount() / 3;
-  u32 vertexMaxCount = m_VertexBuffer.GetFilledElementsCount();
+  m_SubmeshBuffer.Allocate(submeshes.size() * sizeof(FRenderSubmesh),
+                           bufferUsageFlags | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
+  m_SubmeshBuffer.FillStaged(submeshes.data(), sizeof(FRenderSubmesh), submeshes.size(), uploadManager);
 
   VkDeviceOrHostAddressConstKHR vertexBufferDeviceAddress{
       .deviceAddress = m_VertexBuffer.GetDeviceAddress()
@@ -66,42 +113,83 @@ void FBottomLevelAccelerationStructure::Build(const FRenderMeshData& meshData, s
   VkDeviceOrHostAddressConstKHR indexBufferDeviceAddress{
       .deviceAddress = m_IndexBuffer.GetDeviceAddress()
   };
+  if (IsBuiltOnHost())
+  {
+    // Host build reads geometry straight from mesh data...
+    vertexBufferDeviceAddress.hostAddress = vertices.data();
+    indexBufferDeviceAddress.hostAddress = indices.data();
+  }
+
+  // Every submesh is separate geometry sharing vertex and index buffers, gl_GeometryIndexEXT in hit shaders
+  // is then index of submesh and gl_PrimitiveID is relative to its first triangle...
+  m_Geometries.clear();
+  m_BuildRanges.clear();
+  std::vector<u32> trianglesCounts{};
+  m_Geometries.reserve(submeshes.size());
+  m_BuildRanges.reserve(submeshes.size());
+  trianglesCounts.reserve(submeshes.size());
+  for (const FRenderSubmesh& submesh : submeshes)
+  {
+    m_Geometries.push_back(VkAccelerationStructureGeometryKHR{
+        .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+        .pNext = nullptr,
+        .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
+        .geometry = {
+            .triangles = {
+                .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
+                .pNext = nullptr,
+                .vertexFormat = VK_FORMAT_R32G32B32_SFLOAT,
+                .vertexData = vertexBufferDeviceAddress,
+                .vertexStride = m_VertexBuffer.GetFilledStride(),
+                .maxVertex = submesh.firstVertex + submesh.verticesCount - 1,
+                .indexType = VK_INDEX_TYPE_UINT32,
+                .indexData = indexBufferDeviceAddress,
+                .transformData = {}
+            }
+        },
+        .flags = VK_GEOMETRY_OPAQUE_BIT_KHR
+    });
+    m_BuildRanges.push_back(VkAccelerationStructureBuildRangeInfoKHR{
+        .primitiveCount = submesh.indicesCount / 3,
+        .primitiveOffset = submesh.firstIndex * (u32)sizeof(u32),
+        .firstVertex = submesh.firstVertex,
+        .transformOffset = 0
+    });
+    trianglesCounts.push_back(submesh.indicesCount / 3);
+  }
+
+  FAccelerationStructure::AcquireSizeForBuild(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, m_Geometries,
+                                              trianglesCounts);
+  m_ContentHash = FAccelerationStructureCache::CalculateContentHash(meshData);
+}
 
-  VkAccelerationStructureGeometryKHR geometryInfo{
-      .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
-      .pNext = nullptr,
-      .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
-      .geometry = {
-          .triangles = {
-              .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
-              .pNext = nullptr,
-              .vertexFormat = VK_FORMAT_R32G32B32_SFLOAT,
-              .vertexData = vertexBufferDeviceAddress,
-              .vertexStride = m_VertexBuffer.GetFilledStride(),
-              .maxVertex = vertexMaxCount,
-              .indexType = VK_INDEX_TYPE_UINT32,
-              .indexData = indexBufferDeviceAddress,
-              .transformData = {}
-          }
-      },
-      .flags = VK_GEOMETRY_OPAQUE_BIT_KHR
-  };
 
-  FAccelerationStructure::AcquireSizeForBuild(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, trianglesCount,
-                                              &geometryInfo);
-  FAccelerationStructure::Create(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR);
-  FAccelerationStructure::Build(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, &geometryInfo, trianglesCount,
-                                commandPool, queue);
+b32 FBottomLevelAccelerationStructure::HasTriangles(const FRenderMeshView& meshData)
+{
+  return std::ranges::any_of(meshData.submeshes, [](const FRenderSubmesh& submesh)
+  {
+    return submesh.indicesCount >= 3 and submesh.verticesCount > 0;
+  });
+}
+
+
+void FBottomLevelAccelerationStructure::CollectBuffers(std::vector<VkBuffer>& buffers) const
+{
+  // Structure built on host is written by host only, no queue owns its memory...
+  if (not IsBuiltOnHost())
+  {
+    buffers.push_back(GetMemoryBuffer().GetHandle());
+  }
+  buffers.push_back(m_VertexBuffer.GetHandle());
+  buffers.push_back(m_IndexBuffer.GetHandle());
+  buffers.push_back(m_MaterialBuffer.GetHandle());
+  buffers.push_back(m_SubmeshBuffer.GetHandle());
 }
 
 
 void FBottomLevelAccelerationStructure::AssignTransformMatrix(math::Matrix4x4f transform)
 {
-  m_Transform = {
-      transform[0], transform[4], transform[8], transform[12],
-      transform[1], transform[5], transform[9], transform[13],
-      transform[2], transform[6], transform[10], transform[14]
-  };
+  m_Transform = FAccelerationStructure::ConvertToTransformMatrix(transform);
 }
 
 
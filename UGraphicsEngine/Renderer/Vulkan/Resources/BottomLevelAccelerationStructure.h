@@ -5,28 +5,58 @@
 
 #include "AccelerationStructure.h"
 #include <span>
+#include <vector>
 
 
 namespace uncanny::vulkan
 {
 
 
+class FUploadManager;
+
+
 class FBottomLevelAccelerationStructure : public FAccelerationStructure
 {
+
+  friend class FAccelerationStructureBuilder;
+
 public:
 
   ~FBottomLevelAccelerationStructure();
 
-  void Build(const FRenderMeshData& meshData, std::span<FRenderMaterialData> materials, const FCommandPool& commandPool,
-             const FQueue& queue, VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
+  /// @brief Prepares structure and builds it right away, waits until build is finished. Uploads recorded into
+  /// uploadManager are flushed, it must upload on the same queue. Many structures should be prepared and built
+  /// at once with FAccelerationStructureBuilder instead.
+  void Build(const FRenderMeshView& meshData, std::span<const FRenderMaterialData> materials,
+             FUploadManager& uploadManager, const FCommandPool& commandPool, const FQueue& queue, VkDevice vkDevice,
+             const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
+
+  /// @brief Records upload of mesh data and acquires build sizes without creating and building structure, many
+  /// prepared structures are created and built (or deserialized from cache) at once with
+  /// FAccelerationStructureBuilder. Uploads must be flushed to the builder queue before build.
+  /// When structure is built on host, meshData must be alive until it is built. Submeshes without triangle are
+  /// skipped, whole mesh must have some triangles, see HasTriangles().
+  void Prepare(const FRenderMeshView& meshData, std::span<const FRenderMaterialData> materials,
+               FUploadManager& uploadManager, VkDevice vkDevice,
+               const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
+
+  /// @returns whether mesh has any submesh with triangle, structure cannot be built for mesh without them
+  [[nodiscard]] static b32 HasTriangles(const FRenderMeshView& meshData);
 
   void Destroy();
+  /// @brief Hands structure and its geometry buffers over to deletion queue
+  void Destroy(FDeletionQueue& deletionQueue, u64 lastUseValue);
 
   [[nodiscard]] const VkTransformMatrixKHR& GetTransform() const { return m_Transform; }
   [[nodiscard]] const FBuffer& GetVertexBuffer() const { return m_VertexBuffer; }
   [[nodiscard]] const FBuffer& GetIndexBuffer() const { return m_IndexBuffer; }
   [[nodiscard]] const FBuffer& GetMaterialBuffer() const { return m_MaterialBuffer; }
-  [[nodiscard]] const FBuffer& GetMaterialIndicesBuffer() const { return m_MaterialIndexBuffer; }
+  [[nodiscard]] const FBuffer& GetSubmeshBuffer() const { return m_SubmeshBuffer; }
+  /// @brief Appends buffers of structure owned by queue family, which uploaded and built it, e.g. to transfer their
+  /// ownership to other queue family. Memory of structure built on host is not appended.
+  void CollectBuffers(std::vector<VkBuffer>& buffers) const;
+  /// @returns hash of geometry given in Prepare(), see FAccelerationStructureCache
+  [[nodiscard]] u64 GetContentHash() const { return m_ContentHash; }
 
 private:
 
@@ -37,7 +67,10 @@ private:
   FBuffer m_VertexBuffer{};
   FBuffer m_IndexBuffer{};
   FBuffer m_MaterialBuffer{};
-  FBuffer m_MaterialIndexBuffer{};
+  FBuffer m_SubmeshBuffer{};
+  std::vector<VkAccelerationStructureGeometryKHR> m_Geometries{};
+  std::vector<VkAccelerationStructureBuildRangeInfoKHR> m_BuildRanges{};
+  u64 m_ContentHash{ 0 };
   VkTransformMatrixKHR m_Transform{
       1.0f, 0.0f, 0.0f, 0.0f,
       0.0f, 1.0f, 0.0f, 0.0f,
@@ -1,7 +1,11 @@
 
 #include "Buffer.h"
+#include "UploadManager.h"
+#include "DeletionQueue.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Context/PhysicalDeviceAttributes.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
+#include <memory>
+#include <utility>
 
 
 namespace uncanny::vulkan
@@ -46,10 +50,10 @@ void FBuffer::Allocate(VkDeviceSize memorySize, VkBufferUsageFlags usage, VkMemo
   }
 
   m_Memory.Allocate(m_Device, m_pPhysicalDeviceAttributes->GetMemoryProperties(), memoryRequirements,
-                    m_MemoryPropertyFlags, useDeviceAddress);
+                    m_MemoryPropertyFlags, useDeviceAddress, UFALSE,
+                    m_pPhysicalDeviceAttributes->GetMinBufferAlignment(usage));
 
-  constexpr VkDeviceSize memoryOffset{ 0 };
-  vkBindBufferMemory(m_Device, m_Buffer, m_Memory.GetHandle(), memoryOffset);
+  vkBindBufferMemory(m_Device, m_Buffer, m_Memory.GetHandle(), m_Memory.GetOffset());
 
   if (useDeviceAddress)
   {
@@ -74,36 +78,50 @@ void FBuffer::Free()
 }
 
 
-void* FBuffer::Map()
+void FBuffer::Free(FDeletionQueue& deletionQueue, u64 lastUseValue)
 {
-  constexpr VkDeviceSize offset{ 0 };
-  constexpr VkMemoryMapFlags flags{ 0 };
-  void* pMapPtr{ nullptr };
+  if (not IsValid())
+  {
+    return;
+  }
+
+  auto pRetired = std::make_shared<FBuffer>();
+  pRetired->Swap(*this);
+  deletionQueue.Push(lastUseValue, [pRetired]()
+  {
+    pRetired->Free();
+  });
+}
 
-  vkMapMemory(m_Device, m_Memory.GetHandle(), offset, m_AllocatedMemorySize, flags, &pMapPtr);
 
-  return pMapPtr;
+void FBuffer::Swap(FBuffer& other)
+{
+  m_Memory.Swap(other.m_Memory);
+  std::swap(m_pPhysicalDeviceAttributes, other.m_pPhysicalDeviceAttributes);
+  std::swap(m_Device, other.m_Device);
+  std::swap(m_Buffer, other.m_Buffer);
+  std::swap(m_AllocatedMemorySize, other.m_AllocatedMemorySize);
+  std::swap(m_DeviceAddress, other.m_DeviceAddress);
+  std::swap(m_Stride, other.m_Stride);
+  std::swap(m_ElementsCount, other.m_ElementsCount);
+  std::swap(m_ElementsSizeInBytes, other.m_ElementsSizeInBytes);
+  std::swap(m_MemoryPropertyFlags, other.m_MemoryPropertyFlags);
 }
 
 
-void FBuffer::Unmap()
+void* FBuffer::Map()
 {
-  constexpr VkDeviceSize offset{ 0 };
+  // Memory is mapped persistently, sub-allocated memory cannot be mapped by every buffer on its own...
+  return m_Memory.GetMappedPointer();
+}
+
 
+void FBuffer::Unmap()
+{
   if ((m_MemoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
   {
-    VkMappedMemoryRange mappedRange{
-        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-        .pNext = nullptr,
-        .memory = m_Memory.GetHandle(),
-        .offset = offset,
-        .size = m_AllocatedMemorySize,
-    };
-    VkResult result = vkFlushMappedMemoryRanges(m_Device, 1, &mappedRange);
-    AssertVkAndThrow(result);
+    m_Memory.Flush();
   }
-
-  vkUnmapMemory(m_Device, m_Memory.GetHandle());
 }
 
 
@@ -148,4 +166,15 @@ void FBuffer::FillStaged(const void* pData, u32 elementSizeof, u32 elementsCount
 }
 
 
+void FBuffer::FillStaged(const void* pData, u32 elementSizeof, u32 elementsCount, FUploadManager& uploadManager,
+                         FQueueFamilyIndex dstFamilyIndex)
+{
+  m_Stride = elementSizeof;
+  m_ElementsCount = elementsCount;
+  m_ElementsSizeInBytes = m_Stride * m_ElementsCount;
+
+  uploadManager.Upload(*this, pData, m_ElementsSizeInBytes, 0, dstFamilyIndex);
+}
+
+
 }
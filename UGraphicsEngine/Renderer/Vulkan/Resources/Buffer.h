@@ -14,6 +14,8 @@ namespace uncanny::vulkan
 
 
 class FPhysicalDeviceAttributes;
+class FUploadManager;
+class FDeletionQueue;
 
 
 /// @details If it will be used as device local don't forget about TRANSFER_DST buffer usage flag
@@ -26,13 +28,22 @@ public:
   void Allocate(VkDeviceSize memorySize, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags,
                 VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
   void Free();
+  /// @brief Hands buffer over to deletion queue, it is destroyed when timeline passes lastUseValue
+  void Free(FDeletionQueue& deletionQueue, u64 lastUseValue);
 
+  /// @brief Exchanges owned buffer and memory with other, e.g. when resource is replaced with its resized copy
+  void Swap(FBuffer& other);
+
+  /// @brief Host visible memory stays mapped for whole lifetime of buffer, Unmap() only flushes host writes
   void* Map();
   void Unmap();
 
   void Fill(const void* pData, u32 elementSizeof, u32 elementsCount);
   void FillStaged(const void* pData, u32 elementSizeof, u32 elementsCount, const FCommandPool& transferCommandPool,
                   const FQueue& transferQueue);
+  /// @brief Only records copy through upload manager staging ring, data is in buffer after its Flush() is finished
+  void FillStaged(const void* pData, u32 elementSizeof, u32 elementsCount, FUploadManager& uploadManager,
+                  FQueueFamilyIndex dstFamilyIndex = UUNUSED);
 
   [[nodiscard]] VkBuffer GetHandle() const { return m_Buffer; }
   [[nodiscard]] VkDeviceSize GetAllocatedSize() const { return m_AllocatedMemorySize; }
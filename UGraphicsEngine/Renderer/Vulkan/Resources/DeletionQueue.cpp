@@ -0,0 +1,47 @@
+
+#include "DeletionQueue.h"
+#include <algorithm>
+
+
+namespace uncanny::vulkan
+{
+
+
+FDeletionQueue::~FDeletionQueue()
+{
+  Flush();
+}
+
+
+void FDeletionQueue::Push(u64 lastUseValue, std::function<void()> destroy)
+{
+  m_Entries.push_back(FEntry{ .destroy = std::move(destroy), .lastUseValue = lastUseValue });
+}
+
+
+void FDeletionQueue::Collect(u64 completedValue)
+{
+  // Entries are pushed mostly in order of values, but every one is checked, as it is cheap for short queue...
+  std::erase_if(m_Entries, [completedValue](FEntry& entry)
+  {
+    if (entry.lastUseValue > completedValue)
+    {
+      return UFALSE;
+    }
+    entry.destroy();
+    return UTRUE;
+  });
+}
+
+
+void FDeletionQueue::Flush()
+{
+  for (FEntry& entry : m_Entries)
+  {
+    entry.destroy();
+  }
+  m_Entries.clear();
+}
+
+
+}
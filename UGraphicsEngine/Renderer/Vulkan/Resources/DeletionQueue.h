@@ -0,0 +1,57 @@
+
+#ifndef UNCANNYENGINE_DELETIONQUEUE_H
+#define UNCANNYENGINE_DELETIONQUEUE_H
+
+
+#include "UTools/UTypes.h"
+#include <functional>
+#include <vector>
+
+
+namespace uncanny::vulkan
+{
+
+
+/// @brief FDeletionQueue keeps resources alive until GPU timeline passes value of the last submit using them.
+/// @details Resources are handed over with their deferred Free()/Destroy() overloads (FBuffer, FImage, acceleration
+/// structures, swapchain) or with any destroy function. Owner calls Collect() with completed value of its timeline
+/// (e.g. once per frame), so that replaced resources are destroyed without waiting for device idle. Queue does not
+/// know device, Flush() must be called before device is destroyed. It is not thread safe.
+class FDeletionQueue
+{
+public:
+
+  FDeletionQueue() = default;
+  FDeletionQueue(const FDeletionQueue&) = delete;
+  FDeletionQueue& operator=(const FDeletionQueue&) = delete;
+
+  ~FDeletionQueue();
+
+  /// @param lastUseValue - timeline value signaled by the last submit using resource
+  void Push(u64 lastUseValue, std::function<void()> destroy);
+
+  /// @brief Destroys all resources, whose last use value is not greater than completed value
+  void Collect(u64 completedValue);
+
+  /// @brief Destroys all resources at once, caller must ensure that none of them is in use by GPU
+  void Flush();
+
+  [[nodiscard]] u32 GetPendingCount() const { return m_Entries.size(); }
+
+private:
+
+  struct FEntry
+  {
+    std::function<void()> destroy{};
+    u64 lastUseValue{ 0 };
+  };
+
+  std::vector<FEntry> m_Entries{};
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_DELETIONQUEUE_H
@@ -0,0 +1,346 @@
+
+#include "DeviceMemoryAllocator.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
+#include "UTools/Logger/Log.h"
+#include <algorithm>
+#include <cstddef>
+
+
+namespace uncanny::vulkan
+{
+
+
+static std::mutex g_AllocatorsMutex{};
+static std::vector<FDeviceMemoryAllocator*> g_Allocators{};
+static std::vector<VkDevice> g_AllocatorDevices{};
+
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+
+void FDeviceMemoryAllocator::Create(VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice, b8 useDeviceAddress,
+                                    VkDeviceSize blockSize)
+{
+  m_Device = vkDevice;
+  m_UseDeviceAddress = useDeviceAddress;
+  vkGetPhysicalDeviceMemoryProperties(vkPhysicalDevice, &m_MemoryProperties);
+
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(vkPhysicalDevice, &properties);
+  m_NonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+  // Two pools for every memory type, buffers and images...
+  m_Pools.resize(2 * m_MemoryProperties.memoryTypeCount);
+  for (u32 i = 0; i < m_Pools.size(); i++)
+  {
+    const u32 memoryTypeIndex = i / 2;
+    const VkDeviceSize heapSize =
+        m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+    m_Pools[i].memoryTypeIndex = memoryTypeIndex;
+    m_Pools[i].image = i % 2;
+    m_Pools[i].blockSize = std::min(blockSize, heapSize / 8);
+  }
+
+  std::lock_guard lock{ g_AllocatorsMutex };
+  g_Allocators.push_back(this);
+  g_AllocatorDevices.push_back(vkDevice);
+}
+
+
+void FDeviceMemoryAllocator::Destroy()
+{
+  {
+    std::lock_guard lock{ g_AllocatorsMutex };
+    auto it = std::find(g_Allocators.begin(), g_Allocators.end(), this);
+    if (it != g_Allocators.end())
+    {
+      g_AllocatorDevices.erase(g_AllocatorDevices.begin() + (it - g_Allocators.begin()));
+      g_Allocators.erase(it);
+    }
+  }
+
+  std::lock_guard lock{ m_Mutex };
+  for (FPool& pool : m_Pools)
+  {
+    for (FBlock& block : pool.blocks)
+    {
+      if (block.memory == VK_NULL_HANDLE)
+      {
+        continue;
+      }
+      if (not block.allocator.IsEmpty())
+      {
+        UWARN("Device memory block is freed with {} live allocations", block.allocator.GetAllocationsCount());
+      }
+      vkFreeMemory(m_Device, block.memory, nullptr);
+    }
+  }
+  m_Pools.clear();
+
+  // FMemory does not free anything after allocator is destroyed, so that dedicated memory would be leaked...
+  if (not m_DedicatedMemories.empty())
+  {
+    UWARN("Device memory allocator is destroyed with {} live dedicated allocations", m_DedicatedMemories.size());
+  }
+  for (VkDeviceMemory memory : m_DedicatedMemories)
+  {
+    vkFreeMemory(m_Device, memory, nullptr);
+  }
+  m_DedicatedMemories.clear();
+  m_DedicatedBytes = 0;
+  m_Device = VK_NULL_HANDLE;
+}
+
+
+FMemoryAllocation FDeviceMemoryAllocator::Allocate(const VkMemoryRequirements& requirements,
+                                                   VkMemoryPropertyFlags memoryFlags, b8 image, b8 useDeviceAddress,
+                                                   VkDeviceSize minAlignment)
+{
+  const u32 memoryTypeIndex = FindMemoryTypeIndex(m_MemoryProperties, requirements.memoryTypeBits, memoryFlags);
+  if (memoryTypeIndex == UUNUSED)
+  {
+    AssertVkAndThrow(VK_ERROR_INITIALIZATION_FAILED, "No memory type index!");
+  }
+
+  std::lock_guard lock{ m_Mutex };
+
+  const u32 poolIndex = 2 * memoryTypeIndex + (image ? 1 : 0);
+  FPool& pool = m_Pools[poolIndex];
+
+  // Big resources would waste most of block, so they get their own memory...
+  if (requirements.size > pool.blockSize / 2)
+  {
+    FMemoryAllocation allocation{ .offset = 0, .size = requirements.size, .poolIndex = poolIndex };
+    allocation.memory = AllocateDeviceMemory(requirements.size, memoryTypeIndex, useDeviceAddress,
+                                             &allocation.pMapped);
+    m_DedicatedMemories.push_back(allocation.memory);
+    m_DedicatedBytes += requirements.size;
+    return allocation;
+  }
+
+  // First block with enough free space is taken, new block is created only when none has it...
+  const VkDeviceSize alignment = std::max(requirements.alignment, minAlignment);
+  auto tryAllocate = [&pool, poolIndex, &requirements, alignment](u32 blockIndex, FMemoryAllocation& allocation)
+  {
+    FBlock& block = pool.blocks[blockIndex];
+    if (block.memory == VK_NULL_HANDLE)
+    {
+      return UFALSE;
+    }
+
+    FTlsfAllocator::FAllocation subAllocation = block.allocator.Allocate(requirements.size, alignment);
+    if (subAllocation.node == UUNUSED)
+    {
+      return UFALSE;
+    }
+
+    allocation = FMemoryAllocation{
+        .memory = block.memory,
+        .offset = subAllocation.offset,
+        .size = subAllocation.size,
+        .pMapped = block.pMapped ? static_cast<std::byte*>(block.pMapped) + subAllocation.offset : nullptr,
+        .poolIndex = poolIndex,
+        .blockIndex = blockIndex,
+        .node = subAllocation.node
+    };
+    return UTRUE;
+  };
+
+  FMemoryAllocation allocation{};
+  for (u32 i = 0; i < pool.blocks.size(); i++)
+  {
+    if (tryAllocate(i, allocation))
+    {
+      return allocation;
+    }
+  }
+  if (not tryAllocate(CreateBlock(pool), allocation))
+  {
+    AssertVkAndThrow(VK_ERROR_OUT_OF_DEVICE_MEMORY, "Cannot sub-allocate device memory!");
+  }
+  return allocation;
+}
+
+
+void FDeviceMemoryAllocator::Free(const FMemoryAllocation& allocation)
+{
+  std::lock_guard lock{ m_Mutex };
+
+  if (allocation.blockIndex == UUNUSED)
+  {
+    auto it = std::find(m_DedicatedMemories.begin(), m_DedicatedMemories.end(), allocation.memory);
+    if (it != m_DedicatedMemories.end())
+    {
+      *it = m_DedicatedMemories.back();
+      m_DedicatedMemories.pop_back();
+    }
+    vkFreeMemory(m_Device, allocation.memory, nullptr);
+    m_DedicatedBytes -= allocation.size;
+    return;
+  }
+
+  FPool& pool = m_Pools[allocation.poolIndex];
+  FBlock& block = pool.blocks[allocation.blockIndex];
+  block.allocator.Free(allocation.node);
+  if (not block.allocator.IsEmpty())
+  {
+    return;
+  }
+
+  // Empty block is kept only when it is the last one in pool...
+  const auto livingBlocksCount = std::count_if(pool.blocks.begin(), pool.blocks.end(), [](const FBlock& b)
+  {
+    return b.memory != VK_NULL_HANDLE;
+  });
+  if (livingBlocksCount > 1)
+  {
+    vkFreeMemory(m_Device, block.memory, nullptr);
+    block.memory = VK_NULL_HANDLE;
+    block.pMapped = nullptr;
+    block.allocator.Destroy();
+  }
+}
+
+
+void FDeviceMemoryAllocator::Flush(const FMemoryAllocation& allocation) const
+{
+  VkMappedMemoryRange mappedRange{
+      .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+      .pNext = nullptr,
+      .memory = allocation.memory,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE
+  };
+
+  // Flushed range must be aligned to nonCoherentAtomSize or end at the end of memory...
+  if (allocation.blockIndex != UUNUSED)
+  {
+    const VkDeviceSize blockSize = m_Pools[allocation.poolIndex].blockSize;
+    mappedRange.offset = allocation.offset / m_NonCoherentAtomSize * m_NonCoherentAtomSize;
+    const VkDeviceSize end = AlignUp(allocation.offset + allocation.size, m_NonCoherentAtomSize);
+    mappedRange.size = end < blockSize ? end - mappedRange.offset : VK_WHOLE_SIZE;
+  }
+
+  VkResult result = vkFlushMappedMemoryRanges(m_Device, 1, &mappedRange);
+  AssertVkAndThrow(result);
+}
+
+
+FDeviceMemoryStatistics FDeviceMemoryAllocator::GetStatistics() const
+{
+  std::lock_guard lock{ m_Mutex };
+
+  FDeviceMemoryStatistics statistics{
+      .reservedBytes = m_DedicatedBytes,
+      .usedBytes = m_DedicatedBytes,
+      .dedicatedAllocationsCount = (u32)m_DedicatedMemories.size(),
+      .allocationsCount = (u32)m_DedicatedMemories.size()
+  };
+
+  u64 freeBytes = 0;
+  for (const FPool& pool : m_Pools)
+  {
+    for (const FBlock& block : pool.blocks)
+    {
+      if (block.memory == VK_NULL_HANDLE)
+      {
+        continue;
+      }
+      statistics.reservedBytes += block.allocator.GetSize();
+      statistics.usedBytes += block.allocator.GetUsedBytes();
+      statistics.largestFreeRegion = std::max(statistics.largestFreeRegion, block.allocator.GetLargestFreeRegion());
+      statistics.blocksCount++;
+      statistics.allocationsCount += block.allocator.GetAllocationsCount();
+      statistics.freeRegionsCount += block.allocator.GetFreeRegionsCount();
+      freeBytes += block.allocator.GetSize() - block.allocator.GetUsedBytes();
+    }
+  }
+
+  if (freeBytes > 0)
+  {
+    statistics.fragmentation = 1.f - (f32)statistics.largestFreeRegion / (f32)freeBytes;
+  }
+  return statistics;
+}
+
+
+FDeviceMemoryAllocator* FDeviceMemoryAllocator::Find(VkDevice vkDevice)
+{
+  std::lock_guard lock{ g_AllocatorsMutex };
+  auto it = std::find(g_AllocatorDevices.begin(), g_AllocatorDevices.end(), vkDevice);
+  return it != g_AllocatorDevices.end() ? g_Allocators[it - g_AllocatorDevices.begin()] : nullptr;
+}
+
+
+u32 FDeviceMemoryAllocator::FindMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties& memoryProperties,
+                                                u32 typeBits, VkMemoryPropertyFlags flags)
+{
+  for (u32 i = 0; i < memoryProperties.memoryTypeCount; i++)
+  {
+    if ((typeBits & (1u << i)) and (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+    {
+      return i;
+    }
+  }
+  return UUNUSED;
+}
+
+
+VkDeviceMemory FDeviceMemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, u32 memoryTypeIndex,
+                                                            b8 useDeviceAddress, void** ppMapped)
+{
+  VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+      .pNext = nullptr,
+      .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR,
+      .deviceMask = 0
+  };
+  VkMemoryAllocateInfo memoryAllocateInfo{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .pNext = useDeviceAddress ? &memoryAllocateFlagsInfo : nullptr,
+      .allocationSize = size,
+      .memoryTypeIndex = memoryTypeIndex
+  };
+
+  VkDeviceMemory memory{ VK_NULL_HANDLE };
+  VkResult result = vkAllocateMemory(m_Device, &memoryAllocateInfo, nullptr, &memory);
+  AssertVkAndThrow(result);
+
+  // Host visible memory stays mapped until it is freed...
+  *ppMapped = nullptr;
+  if (m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+  {
+    result = vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, ppMapped);
+    AssertVkAndThrow(result);
+  }
+  return memory;
+}
+
+
+u32 FDeviceMemoryAllocator::CreateBlock(FPool& pool)
+{
+  // Slot of freed block is reused, so that indices of living blocks stay the same...
+  auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(), [](const FBlock& block)
+  {
+    return block.memory == VK_NULL_HANDLE;
+  });
+  const u32 blockIndex = it != pool.blocks.end() ? it - pool.blocks.begin() : pool.blocks.size();
+  if (blockIndex == pool.blocks.size())
+  {
+    pool.blocks.emplace_back();
+  }
+
+  FBlock& block = pool.blocks[blockIndex];
+  block.memory = AllocateDeviceMemory(pool.blockSize, pool.memoryTypeIndex, m_UseDeviceAddress and not pool.image,
+                                      &block.pMapped);
+  block.allocator.Create(pool.blockSize);
+  UDEBUG("Allocated device memory block {} of memory type {} ({} bytes)", blockIndex, pool.memoryTypeIndex,
+         pool.blockSize);
+  return blockIndex;
+}
+
+
+}
@@ -0,0 +1,127 @@
+
+#ifndef UNCANNYENGINE_DEVICEMEMORYALLOCATOR_H
+#define UNCANNYENGINE_DEVICEMEMORYALLOCATOR_H
+
+
+#include <volk.h>
+#include "UTools/Memory/TlsfAllocator.h"
+#include "UTools/UTypes.h"
+#include <mutex>
+#include <vector>
+
+
+namespace uncanny::vulkan
+{
+
+
+/// @brief Part of device memory given to one buffer or image
+struct FMemoryAllocation
+{
+  VkDeviceMemory memory{ VK_NULL_HANDLE };
+  VkDeviceSize offset{ 0 };
+  VkDeviceSize size{ 0 };
+  /// Pointer to allocation inside persistently mapped memory, null when memory is not host visible
+  void* pMapped{ nullptr };
+  u32 poolIndex{ UUNUSED };
+  /// UUNUSED for dedicated allocation
+  u32 blockIndex{ UUNUSED };
+  u32 node{ UUNUSED };
+};
+
+
+struct FDeviceMemoryStatistics
+{
+  /// Memory allocated from driver (blocks and dedicated allocations)
+  u64 reservedBytes{ 0 };
+  /// Memory given to resources
+  u64 usedBytes{ 0 };
+  u64 largestFreeRegion{ 0 };
+  u32 blocksCount{ 0 };
+  u32 dedicatedAllocationsCount{ 0 };
+  u32 allocationsCount{ 0 };
+  u32 freeRegionsCount{ 0 };
+  /// 0 when free memory of blocks is one region, close to 1 when it is split into many small ones
+  f32 fragmentation{ 0.f };
+};
+
+
+/// @brief FDeviceMemoryAllocator sub-allocates buffers and images from big device memory blocks, so that count of
+/// vkAllocateMemory calls stays far below maxMemoryAllocationCount.
+/// @details Every memory type has two pools, one for buffers and one for optimal images, so that linear and optimal
+/// resources never share a block and bufferImageGranularity can be ignored. Pool grows by blocks (blockSize, or
+/// 1/8 of smaller heaps), which are sub-allocated with FTlsfAllocator. Resources bigger than half of block get
+/// dedicated allocation. Host visible memory is mapped once for whole lifetime of block. Empty blocks are freed,
+/// except for the last one of every pool, so that level reload does not go back to driver. Dedicated allocations
+/// are tracked too, ones still alive at Destroy() are freed together with blocks.
+/// Allocator is owned by FLogicalDevice, FMemory finds it with Find(). It is thread safe.
+class FDeviceMemoryAllocator
+{
+public:
+
+  FDeviceMemoryAllocator() = default;
+  FDeviceMemoryAllocator(const FDeviceMemoryAllocator&) = delete;
+  FDeviceMemoryAllocator& operator=(const FDeviceMemoryAllocator&) = delete;
+
+  void Create(VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice, b8 useDeviceAddress,
+              VkDeviceSize blockSize = 64 * 1024 * 1024);
+  void Destroy();
+
+  /// @param image - whether memory is for optimal tiling image, it is placed in separate pool
+  /// @param useDeviceAddress - used only for dedicated allocations, block memory always allows device address
+  /// when allocator was created with it
+  /// @param minAlignment - alignment of offset required on top of requirements.alignment (e.g. scratch buffers)
+  [[nodiscard]] FMemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags memoryFlags,
+                                           b8 image, b8 useDeviceAddress, VkDeviceSize minAlignment = 1);
+  void Free(const FMemoryAllocation& allocation);
+
+  /// @brief Flushes host writes to allocation, needed only for non-coherent memory
+  void Flush(const FMemoryAllocation& allocation) const;
+
+  [[nodiscard]] FDeviceMemoryStatistics GetStatistics() const;
+
+  /// @returns allocator created for given device, nullptr if there is none
+  static FDeviceMemoryAllocator* Find(VkDevice vkDevice);
+
+  /// @returns index of first memory type allowed by typeBits with all flags, UUNUSED if there is none
+  static u32 FindMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties& memoryProperties, u32 typeBits,
+                                 VkMemoryPropertyFlags flags);
+
+private:
+
+  struct FBlock
+  {
+    VkDeviceMemory memory{ VK_NULL_HANDLE };
+    void* pMapped{ nullptr };
+    FTlsfAllocator allocator{};
+  };
+
+  struct FPool
+  {
+    std::vector<FBlock> blocks{};
+    u32 memoryTypeIndex{ UUNUSED };
+    VkDeviceSize blockSize{ 0 };
+    b8 image{ UFALSE };
+  };
+
+  VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, u32 memoryTypeIndex, b8 useDeviceAddress, void** ppMapped);
+
+  u32 CreateBlock(FPool& pool);
+
+private:
+
+  std::vector<FPool> m_Pools{};
+  std::vector<VkDeviceMemory> m_DedicatedMemories{};
+  VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+  VkDeviceSize m_NonCoherentAtomSize{ 1 };
+  VkDevice m_Device{ VK_NULL_HANDLE };
+  u64 m_DedicatedBytes{ 0 };
+  b8 m_UseDeviceAddress{ UFALSE };
+  mutable std::mutex m_Mutex{};
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_DEVICEMEMORYALLOCATOR_H
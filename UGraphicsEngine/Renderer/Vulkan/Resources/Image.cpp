@@ -1,8 +1,10 @@
 
 #include "Image.h"
+#include "DeletionQueue.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Context/PhysicalDeviceAttributes.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
 #include "UTools/Logger/Log.h"
+#include <memory>
 
 
 namespace uncanny::vulkan
@@ -65,10 +67,9 @@ void FImage::ActualAllocate()
   vkGetImageMemoryRequirements(m_Device, m_Image, &memoryRequirements);
 
   m_Memory.Allocate(m_Device, m_pPhysicalDeviceAttributes->GetMemoryProperties(), memoryRequirements, m_MemoryFlags,
-                    UFALSE);
+                    UFALSE, UTRUE);
 
-  VkDeviceSize memoryOffset{ 0 };
-  vkBindImageMemory(m_Device, m_Image, m_Memory.GetHandle(), memoryOffset);
+  vkBindImageMemory(m_Device, m_Image, m_Memory.GetHandle(), m_Memory.GetOffset());
 }
 
 
@@ -124,6 +125,27 @@ void FImage::Free()
 }
 
 
+void FImage::Free(FDeletionQueue& deletionQueue, u64 lastUseValue)
+{
+  if (m_Image == VK_NULL_HANDLE)
+  {
+    return;
+  }
+
+  // Only handles and memory are retired, create info stays, so that image can be recreated...
+  auto pRetired = std::make_shared<FImage>();
+  pRetired->m_Device = m_Device;
+  pRetired->m_UsingView = m_UsingView;
+  pRetired->m_Memory.Swap(m_Memory);
+  std::swap(pRetired->m_Image, m_Image);
+  std::swap(pRetired->m_ImageView, m_ImageView);
+  deletionQueue.Push(lastUseValue, [pRetired]()
+  {
+    pRetired->Free();
+  });
+}
+
+
 void FImage::Recreate(VkExtent2D extent)
 {
   if (extent.width == 0 or extent.height == 0)
@@ -142,4 +164,22 @@ void FImage::Recreate(VkExtent2D extent)
 }
 
 
+void FImage::Recreate(VkExtent2D extent, FDeletionQueue& deletionQueue, u64 lastUseValue)
+{
+  if (extent.width == 0 or extent.height == 0)
+  {
+    UWARN("Cannot recreate image, as passed extent is ({}, {})", extent.width, extent.height);
+    return;
+  }
+
+  m_CreateInfo.extent = { .width = extent.width, .height = extent.height, .depth = 1 };
+  Free(deletionQueue, lastUseValue);
+  ActualAllocate();
+  if (m_UsingView)
+  {
+    CreateView();
+  }
+}
+
+
 }
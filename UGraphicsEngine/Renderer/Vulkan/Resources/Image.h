@@ -15,6 +15,7 @@ namespace uncanny::vulkan
 
 
 class FPhysicalDeviceAttributes;
+class FDeletionQueue;
 
 
 class FImage
@@ -27,10 +28,14 @@ public:
                 VkMemoryPropertyFlags memoryFlags, std::span<FQueueFamilyIndex> queueFamilies,
                 VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
   void Free();
+  /// @brief Hands image and its view over to deletion queue, they are destroyed when timeline passes lastUseValue
+  void Free(FDeletionQueue& deletionQueue, u64 lastUseValue);
 
   void CreateView();
 
   void Recreate(VkExtent2D extent);
+  /// @brief Recreates image without waiting for GPU, previous image is handed over to deletion queue
+  void Recreate(VkExtent2D extent, FDeletionQueue& deletionQueue, u64 lastUseValue);
 
   [[nodiscard]] VkImage GetHandle() const { return m_Image; }
   [[nodiscard]] VkImageView GetHandleView() const { return m_ImageView; }
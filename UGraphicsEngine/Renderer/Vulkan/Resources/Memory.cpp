@@ -2,23 +2,13 @@
 #include "Memory.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
 #include "UTools/UTypes.h"
+#include <utility>
 
 
 namespace uncanny::vulkan
 {
 
 
-struct FMemoryTypeIndexResult
-{
-  u32 index{ UUNUSED };
-  b8 found{ UFALSE };
-};
-
-
-static FMemoryTypeIndexResult FindMemoryTypeIndex(VkPhysicalDeviceMemoryProperties properties, u32 typeBits,
-                                                  VkMemoryPropertyFlags flags);
-
-
 FMemory::~FMemory()
 {
   Free();
@@ -26,13 +16,23 @@ FMemory::~FMemory()
 
 
 void FMemory::Allocate(VkDevice vkDevice, VkPhysicalDeviceMemoryProperties memoryProperties,
-                       VkMemoryRequirements requirements, VkMemoryPropertyFlags memoryFlags, b8 useDeviceAddress)
+                       VkMemoryRequirements requirements, VkMemoryPropertyFlags memoryFlags, b8 useDeviceAddress,
+                       b8 image, VkDeviceSize minAlignment)
 {
   m_Device = vkDevice;
 
-  FMemoryTypeIndexResult memoryTypeIndexResult = FindMemoryTypeIndex(memoryProperties, requirements.memoryTypeBits,
-                                                                     memoryFlags);
-  if (not memoryTypeIndexResult.found)
+  m_pAllocator = FDeviceMemoryAllocator::Find(m_Device);
+  if (m_pAllocator)
+  {
+    m_Allocation = m_pAllocator->Allocate(requirements, memoryFlags, image, useDeviceAddress, minAlignment);
+    return;
+  }
+
+  // Own allocation starts at offset 0, so it is aligned to anything...
+
+  const u32 memoryTypeIndex = FDeviceMemoryAllocator::FindMemoryTypeIndex(memoryProperties,
+                                                                          requirements.memoryTypeBits, memoryFlags);
+  if (memoryTypeIndex == UUNUSED)
   {
     AssertVkAndThrow(VK_ERROR_INITIALIZATION_FAILED, "No memory type index!");
   }
@@ -41,7 +41,7 @@ void FMemory::Allocate(VkDevice vkDevice, VkPhysicalDeviceMemoryProperties memor
     .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
     .pNext = nullptr,
     .allocationSize = requirements.size,
-    .memoryTypeIndex = memoryTypeIndexResult.index
+    .memoryTypeIndex = memoryTypeIndex
   };
 
   VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo{
@@ -56,38 +56,67 @@ void FMemory::Allocate(VkDevice vkDevice, VkPhysicalDeviceMemoryProperties memor
     memoryAllocateInfo.pNext = &memoryAllocateFlagsInfo;
   }
 
-  VkResult result = vkAllocateMemory(m_Device, &memoryAllocateInfo, nullptr, &m_DeviceMemory);
+  VkResult result = vkAllocateMemory(m_Device, &memoryAllocateInfo, nullptr, &m_Allocation.memory);
   AssertVkAndThrow(result);
+  m_Allocation.size = requirements.size;
+
+  if (memoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+  {
+    result = vkMapMemory(m_Device, m_Allocation.memory, 0, VK_WHOLE_SIZE, 0, &m_Allocation.pMapped);
+    AssertVkAndThrow(result);
+  }
 }
 
 
 void FMemory::Free()
 {
-  if (m_DeviceMemory != VK_NULL_HANDLE)
+  if (m_Allocation.memory == VK_NULL_HANDLE)
   {
-    vkFreeMemory(m_Device, m_DeviceMemory, nullptr);
-    m_DeviceMemory = VK_NULL_HANDLE;
+    return;
   }
+
+  // Allocator may be already destroyed together with device, its blocks and dedicated memory are freed then...
+  if (m_pAllocator)
+  {
+    if (FDeviceMemoryAllocator::Find(m_Device) == m_pAllocator)
+    {
+      m_pAllocator->Free(m_Allocation);
+    }
+  }
+  else
+  {
+    vkFreeMemory(m_Device, m_Allocation.memory, nullptr);
+  }
+  m_Allocation = {};
+}
+
+
+void FMemory::Swap(FMemory& other)
+{
+  std::swap(m_Allocation, other.m_Allocation);
+  std::swap(m_pAllocator, other.m_pAllocator);
+  std::swap(m_Device, other.m_Device);
 }
 
 
-FMemoryTypeIndexResult FindMemoryTypeIndex(VkPhysicalDeviceMemoryProperties memoryProperties, u32 typeBits,
-                                           VkMemoryPropertyFlags flags)
+void FMemory::Flush() const
 {
-  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+  if (m_pAllocator)
   {
-    if ((typeBits & 1) == 1)
-    {
-      if ((memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
-      {
-        return FMemoryTypeIndexResult{ i, UTRUE };
-      }
-    }
-    typeBits >>= 1;
+    m_pAllocator->Flush(m_Allocation);
+    return;
   }
 
-  return FMemoryTypeIndexResult{ UUNUSED, UFALSE };
+  VkMappedMemoryRange mappedRange{
+      .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+      .pNext = nullptr,
+      .memory = m_Allocation.memory,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE,
+  };
+  VkResult result = vkFlushMappedMemoryRanges(m_Device, 1, &mappedRange);
+  AssertVkAndThrow(result);
 }
 
 
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 
 
 #include <volk.h>
+#include "DeviceMemoryAllocator.h"
 #include "UTools/UTypes.h"
 
 
@@ -12,21 +13,37 @@ namespace uncanny::vulkan
 
 
 /// @details Memory should not be exposed to the end user, FBuffer and FImage should be owners.
+/// Memory is sub-allocated with FDeviceMemoryAllocator of device, so resource must be bound at GetOffset().
+/// When device has no allocator, memory is allocated directly. Host visible memory is persistently mapped.
 class FMemory
 {
 public:
 
   ~FMemory();
 
+  /// @param image - whether memory is for optimal tiling image (linear and optimal resources use separate blocks)
+  /// @param minAlignment - alignment required on top of requirements, see
+  /// FPhysicalDeviceAttributes::GetMinBufferAlignment()
   void Allocate(VkDevice vkDevice, VkPhysicalDeviceMemoryProperties memoryProperties, VkMemoryRequirements requirements,
-                VkMemoryPropertyFlags memoryFlags, b8 useDeviceAddress);
+                VkMemoryPropertyFlags memoryFlags, b8 useDeviceAddress, b8 image = UFALSE,
+                VkDeviceSize minAlignment = 1);
   void Free();
 
-  [[nodiscard]] VkDeviceMemory GetHandle() const { return m_DeviceMemory; }
+  /// @brief Exchanges owned memory with other
+  void Swap(FMemory& other);
+
+  /// @brief Flushes host writes, needed only for memory without HOST_COHERENT flag
+  void Flush() const;
+
+  [[nodiscard]] VkDeviceMemory GetHandle() const { return m_Allocation.memory; }
+  [[nodiscard]] VkDeviceSize GetOffset() const { return m_Allocation.offset; }
+  /// @returns pointer to mapped memory, null when memory is not host visible
+  [[nodiscard]] void* GetMappedPointer() const { return m_Allocation.pMapped; }
 
 private:
 
-  VkDeviceMemory m_DeviceMemory{ VK_NULL_HANDLE };
+  FMemoryAllocation m_Allocation{};
+  FDeviceMemoryAllocator* m_pAllocator{ nullptr };
   VkDevice m_Device{ VK_NULL_HANDLE };
 
 };
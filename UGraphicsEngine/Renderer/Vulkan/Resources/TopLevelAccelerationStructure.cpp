@@ -1,5 +1,9 @@
 
 #include "TopLevelAccelerationStructure.h"
+#include "DeletionQueue.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Fence.h"
+#include <algorithm>
+#include <cstring>
 
 
 namespace uncanny::vulkan
@@ -19,15 +23,13 @@ void FTopLevelAccelerationStructure::Build(std::span<const FBottomLevelAccelerat
                                            const FCommandPool& commandPool, const FQueue& queue, VkDevice vkDevice,
                                            const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes)
 {
-  m_Device = vkDevice;
-  m_pPhysicalDeviceAttributes = pPhysicalDeviceAttributes;
+  SetBottomLevelStructures(bottomLevelStructures, vkDevice, pPhysicalDeviceAttributes);
 
-  std::vector<VkAccelerationStructureInstanceKHR> instances;
-  instances.reserve(bottomLevelStructures.size());
-  m_BottomUniformData.reserve(bottomLevelStructures.size());
+  m_Instances.clear();
+  m_Instances.reserve(bottomLevelStructures.size());
   for (u32 i = 0; i < bottomLevelStructures.size(); i++)
   {
-    instances.push_back({
+    m_Instances.push_back({
       .transform = bottomLevelStructures[i].GetTransform(),
       .instanceCustomIndex = i,
       .mask = 0xFF,
@@ -35,36 +37,220 @@ void FTopLevelAccelerationStructure::Build(std::span<const FBottomLevelAccelerat
       .flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR,
       .accelerationStructureReference = bottomLevelStructures[i].GetDeviceAddress()
     });
-    m_BottomUniformData.push_back(FBottomLevelStructureReferenceUniformData{
-      .vertexBufferDeviceAddress = bottomLevelStructures[i].GetVertexBuffer().GetDeviceAddress(),
-      .indexBufferDeviceAddress = bottomLevelStructures[i].GetIndexBuffer().GetDeviceAddress(),
-      .materialBufferDeviceAddress = bottomLevelStructures[i].GetMaterialBuffer().GetDeviceAddress(),
-      .materialIndicesBufferDeviceAddress = bottomLevelStructures[i].GetMaterialIndicesBuffer().GetDeviceAddress(),
-    });
   }
-  Build(instances, commandPool, queue);
+  BuildInstances(UTRUE, commandPool, queue);
+}
+
+
+void FTopLevelAccelerationStructure::Build(std::span<const FBottomLevelAccelerationStructure> bottomLevelStructures,
+                                           std::span<const FTopLevelInstance> instances,
+                                           const FCommandPool& commandPool, const FQueue& queue, VkDevice vkDevice,
+                                           const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes)
+{
+  SetBottomLevelStructures(bottomLevelStructures, vkDevice, pPhysicalDeviceAttributes);
+  Build(instances, commandPool, queue, vkDevice, pPhysicalDeviceAttributes);
+}
+
+
+void FTopLevelAccelerationStructure::Build(std::span<const FTopLevelInstance> instances,
+                                           const FCommandPool& commandPool, const FQueue& queue, VkDevice vkDevice,
+                                           const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes)
+{
+  Create(instances, vkDevice, pPhysicalDeviceAttributes);
+  BuildInstances(UFALSE, commandPool, queue);
+}
+
+
+void FTopLevelAccelerationStructure::Create(std::span<const FTopLevelInstance> instances, VkDevice vkDevice,
+                                            const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes)
+{
+  m_Device = vkDevice;
+  m_pPhysicalDeviceAttributes = pPhysicalDeviceAttributes;
+
+  m_Instances.clear();
+  m_Instances.reserve(instances.size());
+  for (const FTopLevelInstance& instance : instances)
+  {
+    AddInstance(instance);
+  }
+  m_InstanceCapacity = std::max<u32>(m_Instances.size(), 1);
+  CreateStructure();
 }
 
 
-void FTopLevelAccelerationStructure::Build(std::span<VkAccelerationStructureInstanceKHR> instances,
-                                           const FCommandPool&commandPool, const FQueue& queue)
+void FTopLevelAccelerationStructure::SetBottomLevelStructures(
+    std::span<const FBottomLevelAccelerationStructure> bottomLevelStructures, VkDevice vkDevice,
+    const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes)
 {
-  u32 instancesCount = instances.size();
+  m_Device = vkDevice;
+  m_pPhysicalDeviceAttributes = pPhysicalDeviceAttributes;
+
+  m_BottomUniformData.clear();
+  m_BottomLevelDeviceAddresses.clear();
+  m_BottomUniformData.reserve(bottomLevelStructures.size());
+  m_BottomLevelDeviceAddresses.reserve(bottomLevelStructures.size());
+  for (const FBottomLevelAccelerationStructure& bottomLevelStructure : bottomLevelStructures)
+  {
+    AddBottomLevelStructure(bottomLevelStructure);
+  }
+}
+
+
+u32 FTopLevelAccelerationStructure::AddBottomLevelStructure(
+    const FBottomLevelAccelerationStructure& bottomLevelStructure)
+{
+  m_BottomUniformData.push_back(FBottomLevelStructureReferenceUniformData{
+    .vertexBufferDeviceAddress = bottomLevelStructure.GetVertexBuffer().GetDeviceAddress(),
+    .indexBufferDeviceAddress = bottomLevelStructure.GetIndexBuffer().GetDeviceAddress(),
+    .materialBufferDeviceAddress = bottomLevelStructure.GetMaterialBuffer().GetDeviceAddress(),
+    .submeshBufferDeviceAddress = bottomLevelStructure.GetSubmeshBuffer().GetDeviceAddress(),
+  });
+  m_BottomLevelDeviceAddresses.push_back(bottomLevelStructure.GetDeviceAddress());
+  return m_BottomUniformData.size() - 1;
+}
+
 
-  FBuffer instanceBuffer{};
+u32 FTopLevelAccelerationStructure::AddInstance(const FTopLevelInstance& instance)
+{
+  // Custom index selects BLAS reference entry in hit shaders, so it is index of bottom level structure...
+  m_Instances.push_back({
+    .transform = FAccelerationStructure::ConvertToTransformMatrix(instance.transform),
+    .instanceCustomIndex = instance.bottomLevelIndex,
+    .mask = 0xFF,
+    .instanceShaderBindingTableRecordOffset = 0,
+    .flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR,
+    .accelerationStructureReference = m_BottomLevelDeviceAddresses[instance.bottomLevelIndex]
+  });
+  // Refit requires the same count of instances as previous build...
+  m_RebuildRequested = UTRUE;
+  return m_Instances.size() - 1;
+}
+
+
+u32 FTopLevelAccelerationStructure::RemoveInstance(u32 index)
+{
+  const u32 lastIndex = m_Instances.size() - 1;
+  m_Instances[index] = m_Instances[lastIndex];
+  m_Instances.pop_back();
+  m_RebuildRequested = UTRUE;
+  return index == lastIndex ? UUNUSED : lastIndex;
+}
+
+
+b32 FTopLevelAccelerationStructure::ReserveInstances(FDeletionQueue& deletionQueue, u64 lastUseValue)
+{
+  if (m_Instances.size() <= m_InstanceCapacity)
+  {
+    return UFALSE;
+  }
+
+  FAccelerationStructure::Destroy(deletionQueue, lastUseValue);
+  m_InstanceBuffer.Free(deletionQueue, lastUseValue);
+  m_ScratchBuffer.Free(deletionQueue, lastUseValue);
+  m_InstanceCapacity = std::max<u32>(m_Instances.size(), m_InstanceCapacity * 2);
+  CreateStructure();
+  return UTRUE;
+}
+
+
+void FTopLevelAccelerationStructure::SetInstance(u32 index, u32 bottomLevelIndex,
+                                                 const FBottomLevelAccelerationStructure& bottomLevelStructure)
+{
+  m_Instances[index].instanceCustomIndex = bottomLevelIndex;
+  m_Instances[index].accelerationStructureReference = bottomLevelStructure.GetDeviceAddress();
+  // Refit keeps tree topology of previous geometry, so it would be poor fit for other mesh...
+  m_RebuildRequested = UTRUE;
+}
+
+
+void FTopLevelAccelerationStructure::SetInstanceTransform(u32 index, const math::Matrix4x4f& transform)
+{
+  m_Instances[index].transform = FAccelerationStructure::ConvertToTransformMatrix(transform);
+}
+
+
+void FTopLevelAccelerationStructure::UpdateInstances(const FCommandPool& commandPool, const FQueue& queue)
+{
+  BuildInstances(UFALSE, commandPool, queue);
+}
+
+
+void FTopLevelAccelerationStructure::RecordUpdateInstances(FCommandBuffer& commandBuffer, u32 frameIndex)
+{
+  // Structure is rewritten in place, while rays of previous frames may still traverse it...
+  const VkAccessFlags accessFlags = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
+                                    VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+  commandBuffer.MemoryBarrier(accessFlags, accessFlags,
+                              VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+                              VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                              VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR);
+  RecordBuildInstances(commandBuffer, frameIndex % m_FramesInFlightCount);
+  commandBuffer.MemoryBarrier(VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                              VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR,
+                              VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                              VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+}
+
+
+void FTopLevelAccelerationStructure::BuildInstances(b8 createStructure, const FCommandPool& commandPool,
+                                                    const FQueue& queue)
+{
+  if (createStructure)
+  {
+    m_InstanceCapacity = std::max<u32>(m_Instances.size(), 1);
+    CreateStructure();
+  }
+
+  VkAccessFlags accessFlags = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
+                              VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+  VkPipelineStageFlags stageFlags = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+
+  FCommandBuffer commandBuffer = commandPool.AllocatePrimaryCommandBuffer();
+  commandBuffer.BeginOneTimeRecording();
+  commandBuffer.MemoryBarrier(accessFlags, accessFlags, stageFlags, stageFlags);
+  RecordBuildInstances(commandBuffer, 0);
+  commandBuffer.EndRecording();
+
+  FFence fence{};
+  fence.Create(m_Device, 0);
+  queue.Submit({}, {}, commandBuffer, {}, fence.GetHandle());
+  fence.WaitAndReset();
+}
+
+
+void FTopLevelAccelerationStructure::CreateStructure()
+{
+  m_InstanceBuffer.Free();
   VkBufferUsageFlags usageFlags =
       VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
-      VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-  instanceBuffer.Allocate(sizeof(VkAccelerationStructureInstanceKHR) * instancesCount, usageFlags,
-                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
-  instanceBuffer.FillStaged(instances.data(), sizeof(VkAccelerationStructureInstanceKHR), instancesCount, commandPool,
-                            queue);
-  VkDeviceOrHostAddressConstKHR instanceDataDeviceAddress{
-      .deviceAddress = instanceBuffer.GetDeviceAddress()
-  };
+      VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+  const VkDeviceSize regionSize = sizeof(VkAccelerationStructureInstanceKHR) * m_InstanceCapacity;
+  m_InstanceBuffer.Allocate(regionSize * m_FramesInFlightCount, usageFlags,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Device,
+                            m_pPhysicalDeviceAttributes);
+  m_pMappedInstances = (VkAccelerationStructureInstanceKHR*)m_InstanceBuffer.Map();
 
-  VkAccelerationStructureGeometryKHR geometryInfo{
+  // Structure is sized for capacity, so that it can be built with any count of instances up to it...
+  const VkAccelerationStructureGeometryKHR geometryInfo = GetInstancesGeometry(m_InstanceBuffer.GetDeviceAddress());
+  FAccelerationStructure::AcquireSizeForBuild(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, { &geometryInfo, 1 },
+                                              { &m_InstanceCapacity, 1 });
+  FAccelerationStructure::Create(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR);
+
+  // Scratch buffer is kept for all next updates and rebuilds...
+  m_ScratchBuffer.Free();
+  m_ScratchBuffer.Allocate(std::max(GetScratchSize(), GetUpdateScratchSize()),
+                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Device, m_pPhysicalDeviceAttributes);
+
+  // New structure has no tree yet, so it is built first...
+  m_UpdatesSinceRebuild = 0;
+  m_RebuildRequested = UTRUE;
+}
+
+
+VkAccelerationStructureGeometryKHR FTopLevelAccelerationStructure::GetInstancesGeometry(u64 instancesDeviceAddress)
+{
+  return VkAccelerationStructureGeometryKHR{
       .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
       .pNext = nullptr,
       .geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
@@ -73,24 +259,75 @@ void FTopLevelAccelerationStructure::Build(std::span<VkAccelerationStructureInst
               .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
               .pNext = nullptr,
               .arrayOfPointers = VK_FALSE,
-              .data = instanceDataDeviceAddress
+              .data = { .deviceAddress = instancesDeviceAddress }
           }
       },
       .flags = VK_GEOMETRY_OPAQUE_BIT_KHR
   };
+}
 
-  FAccelerationStructure::AcquireSizeForBuild(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, instancesCount,
-                                              &geometryInfo);
-  FAccelerationStructure::Create(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR);
-  FAccelerationStructure::Build(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, &geometryInfo, instancesCount,
-                                commandPool, queue);
+
+void FTopLevelAccelerationStructure::RecordBuildInstances(FCommandBuffer& commandBuffer, u32 region)
+{
+  const u32 instancesCount = m_Instances.size();
+
+  // Regions are capacity apart, so every region stays aligned to instance record size and fits every count...
+  const u32 firstInstance = region * m_InstanceCapacity;
+  memcpy(m_pMappedInstances + firstInstance, m_Instances.data(),
+         sizeof(VkAccelerationStructureInstanceKHR) * instancesCount);
+
+  const VkAccelerationStructureGeometryKHR geometryInfo = GetInstancesGeometry(
+      m_InstanceBuffer.GetDeviceAddress() + firstInstance * sizeof(VkAccelerationStructureInstanceKHR));
+
+  VkAccelerationStructureBuildRangeInfoKHR buildRange{
+      .primitiveCount = instancesCount,
+      .primitiveOffset = 0,
+      .firstVertex = 0,
+      .transformOffset = 0
+  };
+
+  const b8 update = not m_RebuildRequested and
+                    (GetBuildFlags() & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR) and
+                    m_UpdatesSinceRebuild < m_MaxUpdatesBeforeRebuild;
+  const VkBuildAccelerationStructureModeKHR mode =
+      update ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+  VkAccelerationStructureBuildGeometryInfoKHR buildGeometryInfo = GetBuildGeometryInfo(
+      VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, { &geometryInfo, 1 }, m_ScratchBuffer.GetDeviceAddress(), mode);
+  const VkAccelerationStructureBuildRangeInfoKHR* buildRangeInfos[]{ &buildRange };
+  commandBuffer.BuildAccelerationStructure(&buildGeometryInfo, buildRangeInfos);
+
+  m_UpdatesSinceRebuild = update ? m_UpdatesSinceRebuild + 1 : 0;
+  m_RebuildRequested = UFALSE;
 }
 
 
 void FTopLevelAccelerationStructure::Destroy()
 {
   FAccelerationStructure::Destroy();
+  m_InstanceBuffer.Free();
+  m_ScratchBuffer.Free();
+  m_pMappedInstances = nullptr;
+  m_UpdatesSinceRebuild = 0;
+  m_InstanceCapacity = 0;
+  m_RebuildRequested = UFALSE;
+  m_Instances.clear();
+  m_BottomUniformData.clear();
+  m_BottomLevelDeviceAddresses.clear();
+}
+
+
+void FTopLevelAccelerationStructure::Destroy(FDeletionQueue& deletionQueue, u64 lastUseValue)
+{
+  FAccelerationStructure::Destroy(deletionQueue, lastUseValue);
+  m_InstanceBuffer.Free(deletionQueue, lastUseValue);
+  m_ScratchBuffer.Free(deletionQueue, lastUseValue);
+  m_pMappedInstances = nullptr;
+  m_UpdatesSinceRebuild = 0;
+  m_InstanceCapacity = 0;
+  m_RebuildRequested = UFALSE;
+  m_Instances.clear();
   m_BottomUniformData.clear();
+  m_BottomLevelDeviceAddresses.clear();
 }
 
 
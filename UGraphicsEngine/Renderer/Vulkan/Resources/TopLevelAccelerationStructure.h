@@ -4,6 +4,7 @@
 
 
 #include "BottomLevelAccelerationStructure.h"
+#include <algorithm>
 #include <span>
 
 
@@ -16,10 +17,31 @@ struct FBottomLevelStructureReferenceUniformData
   u64 vertexBufferDeviceAddress{ UUNUSED };
   u64 indexBufferDeviceAddress{ UUNUSED };
   u64 materialBufferDeviceAddress{ UUNUSED };
-  u64 materialIndicesBufferDeviceAddress{ UUNUSED };
+  u64 submeshBufferDeviceAddress{ UUNUSED };
 };
 
 
+/// @brief Instance of bottom level structure placed in top level structure
+struct FTopLevelInstance
+{
+  math::Matrix4x4f transform{};
+  u32 bottomLevelIndex{ UUNUSED };
+};
+
+
+/// @brief FTopLevelAccelerationStructure keeps instances of bottom level structures.
+/// @details Bottom level identity is split from instance identity: BLAS reference entries are stored once per
+/// bottom level structure and every instance record points to its bottom level structure with
+/// instanceCustomIndex, so that many instances (with own transforms) can share one mesh.
+/// Instance records live in persistently mapped host visible buffer and scratch buffer is kept, so moving instances
+/// costs only memcpy and one build command. When structure is built with ALLOW_UPDATE flag, instances are refitted
+/// in place (update mode). Refit only moves bounding boxes of existing tree, so after some updates, or when instance
+/// is pointed to other bottom level structure, tree is built again from scratch.
+/// Instance buffer has one region per frame in flight, so that RecordUpdateInstances() writes records of next frame
+/// while refits of previous frames may still read theirs.
+/// Structure and regions are sized for instance capacity, not for current count, so instances can be added and
+/// removed without creating structure again. Changed count of instances is always built again, as refit requires
+/// the same count as previous build. When added instances exceed capacity, it grows geometrically.
 class FTopLevelAccelerationStructure final : public FAccelerationStructure
 {
 public:
@@ -27,24 +49,111 @@ public:
   void Build(const FBottomLevelAccelerationStructure& bottomLevelStructure, const FCommandPool& commandPool,
              const FQueue& queue, VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
 
+  /// @brief Builds one instance per bottom level structure with its own transform
   void Build(std::span<const FBottomLevelAccelerationStructure> bottomLevelStructures, const FCommandPool& commandPool,
              const FQueue& queue, VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
 
+  /// @brief Builds given instances, each referencing bottom level structure by index
+  void Build(std::span<const FBottomLevelAccelerationStructure> bottomLevelStructures,
+             std::span<const FTopLevelInstance> instances, const FCommandPool& commandPool, const FQueue& queue,
+             VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
+
+  /// @brief Builds given instances of bottom level structures added with AddBottomLevelStructure()
+  void Build(std::span<const FTopLevelInstance> instances, const FCommandPool& commandPool, const FQueue& queue,
+             VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
+
+  /// @brief Creates structure for given instances of bottom level structures added with AddBottomLevelStructure(),
+  /// but does not build it. Build is recorded by next RecordUpdateInstances(), so that it can be recorded into frame
+  /// command buffer after bottom level structures are acquired from other queue family, without any host wait.
+  void Create(std::span<const FTopLevelInstance> instances, VkDevice vkDevice,
+              const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
+
   void Destroy();
+  /// @brief Hands structure, instance and scratch buffers over to deletion queue
+  void Destroy(FDeletionQueue& deletionQueue, u64 lastUseValue);
+
+  /// @brief Points instance record at given index to other bottom level structure, takes effect after
+  /// UpdateInstances()
+  void SetInstance(u32 index, u32 bottomLevelIndex, const FBottomLevelAccelerationStructure& bottomLevelStructure);
+
+  /// @brief Patches only transform of instance record at given index, takes effect after UpdateInstances()
+  void SetInstanceTransform(u32 index, const math::Matrix4x4f& transform);
+
+  /// @brief Appends BLAS reference entry and remembers address of bottom level structure, already existing
+  /// entries keep their indices
+  /// @returns index of bottom level structure, which is referenced by instances
+  u32 AddBottomLevelStructure(const FBottomLevelAccelerationStructure& bottomLevelStructure);
+
+  /// @brief Appends instance record, takes effect after UpdateInstances(). When count of instances exceeds
+  /// capacity, ReserveInstances() must be called first.
+  /// @returns index of instance
+  u32 AddInstance(const FTopLevelInstance& instance);
+
+  /// @brief Removes instance record, the last record is moved into its place, so that records stay contiguous
+  /// @returns previous index of moved record, UUNUSED when the last record was removed
+  u32 RemoveInstance(u32 index);
+
+  /// @brief Grows capacity when instances do not fit into it anymore, at least twice, so that instances added one
+  /// by one rarely create structure again. Structure, instance and scratch buffers are then created again and old
+  /// ones are handed over to deletion queue.
+  /// @returns whether structure was created again, so that its new handle must be written into descriptor sets
+  b32 ReserveInstances(FDeletionQueue& deletionQueue, u64 lastUseValue);
+
+  /// @brief Uploads patched instance records and refits (or builds again) structure in place.
+  /// @details Instances fit into capacity, so already created structure (and its handle written into descriptor
+  /// sets) is reused. Caller must ensure that structure is not in use by GPU.
+  void UpdateInstances(const FCommandPool& commandPool, const FQueue& queue);
+
+  /// @brief Writes patched instance records into region of given frame and records refit (or build) of structure
+  /// into frame command buffer, surrounded by barriers against ray tracing shaders of previous and this frame.
+  /// @details Nothing is waited for on host, caller must only ensure that previous submit using the same frame
+  /// region is finished. Structure must be used on the same queue as command buffer is submitted to.
+  void RecordUpdateInstances(FCommandBuffer& commandBuffer, u32 frameIndex);
+
+  /// @brief Sets count of instance buffer regions, it is applied on next Build()
+  void SetFramesInFlightCount(u32 count) { m_FramesInFlightCount = std::max(count, 1u); }
+
+  /// @brief Sets how many refits are allowed before structure is built again, 0 disables refitting
+  void SetMaxUpdatesBeforeRebuild(u32 count) { m_MaxUpdatesBeforeRebuild = count; }
+
+  [[nodiscard]] u32 GetUpdatesSinceRebuild() const { return m_UpdatesSinceRebuild; }
 
   [[nodiscard]] const std::vector<FBottomLevelStructureReferenceUniformData>& GetBLASReferenceUniformData() const
   {
     return m_BottomUniformData;
   }
 
+  [[nodiscard]] u32 GetInstancesCount() const { return m_Instances.size(); }
+  [[nodiscard]] u32 GetInstanceCapacity() const { return m_InstanceCapacity; }
+
 private:
 
-  void Build(std::span<VkAccelerationStructureInstanceKHR> instances, const FCommandPool& commandPool,
-             const FQueue& queue);
+  void SetBottomLevelStructures(std::span<const FBottomLevelAccelerationStructure> bottomLevelStructures,
+                                VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes);
+
+  void BuildInstances(b8 createStructure, const FCommandPool& commandPool, const FQueue& queue);
+
+  /// @brief Creates structure, instance buffer and scratch buffer for current instance capacity
+  void CreateStructure();
+
+  /// @brief Copies instance records into given region of instance buffer and records build (or refit) from them
+  void RecordBuildInstances(FCommandBuffer& commandBuffer, u32 region);
+
+  [[nodiscard]] static VkAccelerationStructureGeometryKHR GetInstancesGeometry(u64 instancesDeviceAddress);
 
 private:
 
+  std::vector<VkAccelerationStructureInstanceKHR> m_Instances{};
   std::vector<FBottomLevelStructureReferenceUniformData> m_BottomUniformData{};
+  std::vector<u64> m_BottomLevelDeviceAddresses{};
+  FBuffer m_InstanceBuffer{};
+  FBuffer m_ScratchBuffer{};
+  VkAccelerationStructureInstanceKHR* m_pMappedInstances{ nullptr };
+  u32 m_UpdatesSinceRebuild{ 0 };
+  u32 m_MaxUpdatesBeforeRebuild{ 64 };
+  u32 m_FramesInFlightCount{ 1 };
+  u32 m_InstanceCapacity{ 0 };
+  b8 m_RebuildRequested{ UFALSE };
 
 };
 
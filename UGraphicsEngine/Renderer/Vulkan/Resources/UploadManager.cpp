@@ -0,0 +1,293 @@
+
+#include "UploadManager.h"
+#include <algorithm>
+#include <cstring>
+#undef MemoryBarrier
+
+
+namespace uncanny::vulkan
+{
+
+
+static constexpr VkDeviceSize g_StagingRegionAlignment{ 16 };
+
+
+static u64 AlignUp(u64 value, u64 alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+
+FUploadManager::~FUploadManager()
+{
+  Destroy();
+}
+
+
+void FUploadManager::Create(VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes,
+                            const FQueue* pQueue, FQueueFamilyIndex dstFamilyIndex, VkDeviceSize ringSize)
+{
+  m_Device = vkDevice;
+  m_pQueue = pQueue;
+  m_DstFamilyIndex = dstFamilyIndex;
+  m_RingSize = AlignUp(ringSize, g_StagingRegionAlignment);
+
+  // Ring is mapped once, so that every upload is only memcpy...
+  m_RingBuffer.Allocate(m_RingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Device,
+                        pPhysicalDeviceAttributes);
+  m_pRingData = static_cast<std::byte*>(m_RingBuffer.Map());
+
+  m_CommandPool.Create(m_pQueue->GetFamilyIndex(), m_Device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+  m_CommandBuffers = m_CommandPool.AllocatePrimaryCommandBuffers(g_MaxSubmitsInFlight);
+  m_Timeline.Create(m_Device, 0);
+}
+
+
+void FUploadManager::Destroy()
+{
+  if (not IsValid())
+  {
+    return;
+  }
+
+  WaitAll();
+
+  for (FCommandBuffer& commandBuffer : m_CommandBuffers)
+  {
+    commandBuffer.Free();
+  }
+  m_CommandBuffers.clear();
+  m_CommandPool.Destroy();
+  m_Timeline.Destroy();
+  m_RingBuffer.Free();
+
+  m_RecordedTransfers.clear();
+  m_ReleasedTransfers.clear();
+  m_pRingData = nullptr;
+  m_RingHead = 0;
+  m_RingTail = 0;
+  m_SubmittedIndex = 0;
+  m_FinishedIndex = 0;
+  m_Statistics = {};
+}
+
+
+void FUploadManager::Upload(const FBuffer& dstBuffer, const void* pData, VkDeviceSize size, VkDeviceSize dstOffset,
+                            FQueueFamilyIndex dstFamilyIndex)
+{
+  if (size == 0)
+  {
+    return;
+  }
+
+  m_Statistics.uploadsCount++;
+  m_Statistics.uploadedBytes += size;
+
+  // Data bigger than half of ring is split, so that one chunk never needs whole ring released...
+  const VkDeviceSize maxChunkSize = m_RingSize / 2;
+  const auto* pSrc = static_cast<const std::byte*>(pData);
+  for (VkDeviceSize copied = 0; copied < size;)
+  {
+    const VkDeviceSize chunkSize = std::min(size - copied, maxChunkSize);
+    const VkDeviceSize stagingOffset = AllocateStagingRegion(chunkSize);
+    memcpy(m_pRingData + stagingOffset, pSrc + copied, chunkSize);
+
+    const u32 slot = (m_SubmittedIndex + 1) % g_MaxSubmitsInFlight;
+    if (not m_Recording)
+    {
+      // Command buffer of this slot may be still executed by submit from previous round...
+      if (m_SubmittedIndex + 1 > g_MaxSubmitsInFlight)
+      {
+        Wait(m_SubmittedIndex + 1 - g_MaxSubmitsInFlight);
+      }
+      m_CommandBuffers[slot].BeginOneTimeRecording();
+      m_Recording = UTRUE;
+    }
+
+    VkBufferCopy copyRegion{
+      .srcOffset = stagingOffset,
+      .dstOffset = dstOffset + copied,
+      .size = chunkSize
+    };
+    vkCmdCopyBuffer(m_CommandBuffers[slot].GetHandle(), m_RingBuffer.GetHandle(), dstBuffer.GetHandle(), 1,
+                    &copyRegion);
+    copied += chunkSize;
+  }
+
+  // Buffer is released only once, by submit with its last chunk, as earlier chunks are on the same queue...
+  if (dstFamilyIndex == UUNUSED)
+  {
+    dstFamilyIndex = m_DstFamilyIndex;
+  }
+  if (dstFamilyIndex != m_pQueue->GetFamilyIndex() and
+      (m_RecordedTransfers.empty() or m_RecordedTransfers.back().buffer != dstBuffer.GetHandle()))
+  {
+    m_RecordedTransfers.push_back(FOwnershipTransfer{
+      .buffer = dstBuffer.GetHandle(),
+      .dstFamilyIndex = dstFamilyIndex
+    });
+  }
+}
+
+
+u64 FUploadManager::Flush()
+{
+  if (not m_Recording)
+  {
+    return m_SubmittedIndex;
+  }
+
+  const u32 slot = (m_SubmittedIndex + 1) % g_MaxSubmitsInFlight;
+  FCommandBuffer& commandBuffer = m_CommandBuffers[slot];
+
+  // Buffers used by other queue families are released to them...
+  std::vector<VkBuffer> releasedBuffers{};
+  releasedBuffers.reserve(m_RecordedTransfers.size());
+  while (not m_RecordedTransfers.empty())
+  {
+    const FQueueFamilyIndex dstFamilyIndex = m_RecordedTransfers.front().dstFamilyIndex;
+    releasedBuffers.clear();
+    for (FOwnershipTransfer& transfer : m_RecordedTransfers)
+    {
+      if (transfer.dstFamilyIndex == dstFamilyIndex)
+      {
+        releasedBuffers.push_back(transfer.buffer);
+        transfer.uploadIndex = m_SubmittedIndex + 1;
+        m_ReleasedTransfers.push_back(transfer);
+      }
+    }
+    commandBuffer.BufferOwnershipBarrier(releasedBuffers, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                         m_pQueue->GetFamilyIndex(), dstFamilyIndex);
+    std::erase_if(m_RecordedTransfers, [dstFamilyIndex](const FOwnershipTransfer& transfer)
+    {
+      return transfer.dstFamilyIndex == dstFamilyIndex;
+    });
+  }
+
+  // Everything submitted later to the queue sees uploaded data...
+  commandBuffer.MemoryBarrier(VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  commandBuffer.EndRecording();
+  VkSemaphore signalSemaphores[]{ m_Timeline.GetHandle() };
+  const u64 signalValues[]{ m_SubmittedIndex + 1 };
+  m_pQueue->Submit({}, {}, {}, commandBuffer, signalSemaphores, signalValues, VK_NULL_HANDLE);
+
+  m_SubmitRingEnds[slot] = m_RingHead;
+  m_SubmittedIndex++;
+  m_Statistics.submitsCount++;
+  m_Recording = UFALSE;
+  return m_SubmittedIndex;
+}
+
+
+b32 FUploadManager::IsFinished(u64 uploadIndex)
+{
+  const u64 lastIndex = std::min(uploadIndex, m_SubmittedIndex);
+  while (m_FinishedIndex < lastIndex and RetireSubmit(m_FinishedIndex + 1, UFALSE))
+  {
+  }
+  return uploadIndex <= m_FinishedIndex;
+}
+
+
+void FUploadManager::Wait(u64 uploadIndex)
+{
+  const u64 lastIndex = std::min(uploadIndex, m_SubmittedIndex);
+  while (m_FinishedIndex < lastIndex)
+  {
+    RetireSubmit(m_FinishedIndex + 1, UTRUE);
+  }
+}
+
+
+void FUploadManager::WaitAll()
+{
+  Wait(Flush());
+}
+
+
+u64 FUploadManager::RecordAcquireBarriers(FCommandBuffer& commandBuffer, FQueueFamilyIndex dstFamilyIndex,
+                                          VkAccessFlags dstAccess, VkPipelineStageFlags dstStage)
+{
+  std::vector<VkBuffer> acquiredBuffers{};
+  u64 lastUploadIndex{ 0 };
+  for (const FOwnershipTransfer& transfer : m_ReleasedTransfers)
+  {
+    if (transfer.dstFamilyIndex == dstFamilyIndex)
+    {
+      acquiredBuffers.push_back(transfer.buffer);
+      lastUploadIndex = std::max(lastUploadIndex, transfer.uploadIndex);
+    }
+  }
+  if (acquiredBuffers.empty())
+  {
+    return 0;
+  }
+
+  // Acquire starts at the same stages, which semaphore wait of submit blocks, so that it is ordered after release...
+  commandBuffer.BufferOwnershipBarrier(acquiredBuffers, 0, dstAccess, dstStage, dstStage, m_pQueue->GetFamilyIndex(),
+                                       dstFamilyIndex);
+  std::erase_if(m_ReleasedTransfers, [dstFamilyIndex](const FOwnershipTransfer& transfer)
+  {
+    return transfer.dstFamilyIndex == dstFamilyIndex;
+  });
+  return lastUploadIndex;
+}
+
+
+VkDeviceSize FUploadManager::AllocateStagingRegion(VkDeviceSize size)
+{
+  while (UTRUE)
+  {
+    // When nothing is in flight, writing starts from beginning of ring, so that whole ring is available...
+    if (m_RingHead == m_RingTail)
+    {
+      m_RingHead = AlignUp(m_RingHead, m_RingSize);
+      m_RingTail = m_RingHead;
+    }
+
+    // Region must be contiguous, so it is moved to beginning of ring when it would cross its end...
+    u64 position = AlignUp(m_RingHead, g_StagingRegionAlignment);
+    if (position % m_RingSize + size > m_RingSize)
+    {
+      position = AlignUp(position, m_RingSize);
+    }
+    if (position + size <= m_RingTail + m_RingSize)
+    {
+      m_RingHead = position + size;
+      return position % m_RingSize;
+    }
+
+    // Ring is full, the oldest submit must be finished. When nothing is in flight, recorded copies are submitted
+    // first, as they occupy the ring...
+    if (m_FinishedIndex == m_SubmittedIndex)
+    {
+      Flush();
+    }
+    RetireSubmit(m_FinishedIndex + 1, UTRUE);
+  }
+}
+
+
+b32 FUploadManager::RetireSubmit(u64 uploadIndex, b8 block)
+{
+  const u32 slot = uploadIndex % g_MaxSubmitsInFlight;
+  if (m_Timeline.GetCompletedValue() < uploadIndex)
+  {
+    if (not block)
+    {
+      return UFALSE;
+    }
+    m_Statistics.queueWaitsCount++;
+    m_Timeline.Wait(uploadIndex);
+  }
+
+  m_RingTail = m_SubmitRingEnds[slot];
+  m_FinishedIndex = uploadIndex;
+  return UTRUE;
+}
+
+
+}
@@ -0,0 +1,136 @@
+
+#ifndef UNCANNYENGINE_UPLOADMANAGER_H
+#define UNCANNYENGINE_UPLOADMANAGER_H
+
+
+#include "Buffer.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Commands/CommandPool.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Synchronization/TimelineSemaphore.h"
+#include "UTools/UTypes.h"
+#include <cstddef>
+#include <vector>
+
+
+namespace uncanny::vulkan
+{
+
+
+class FPhysicalDeviceAttributes;
+
+
+struct FUploadStatistics
+{
+  u64 uploadedBytes{ 0 };
+  /// Count of Upload() calls, every one of them used to be a separate submit with queue wait idle
+  u32 uploadsCount{ 0 };
+  u32 submitsCount{ 0 };
+  /// Count of times host actually blocked on upload timeline (already finished uploads are not counted)
+  u32 queueWaitsCount{ 0 };
+};
+
+
+/// @brief FUploadManager copies data into device local buffers through one persistently mapped staging ring buffer.
+/// @details Upload() copies data into ring and only records vkCmdCopyBuffer, all copies recorded until Flush() are
+/// submitted as one command buffer. Flush() returns upload index, which is value signaled by the submit on timeline
+/// semaphore. It can be polled with IsFinished() or waited for with Wait() on host, or waited for on device by
+/// submits of other queues, so that caller does not have to stall right after upload. Commands submitted later to
+/// the same queue see uploaded data, as every submit ends with memory barrier. Ring space is released when its
+/// submit is finished, host waits for the oldest submit only when ring is full. Data bigger than ring is split into
+/// chunks. When upload queue is from other family than queue using the data (e.g. dedicated transfer queue),
+/// buffers are released to that family at the end of submit and must be acquired with RecordAcquireBarriers() on
+/// its queue before they are used (and before they are uploaded again). It is not thread safe.
+class FUploadManager
+{
+public:
+
+  FUploadManager() = default;
+  FUploadManager(const FUploadManager&) = delete;
+  FUploadManager& operator=(const FUploadManager&) = delete;
+
+  ~FUploadManager();
+
+  /// @param dstFamilyIndex - family of queue, which uses uploaded data by default
+  void Create(VkDevice vkDevice, const FPhysicalDeviceAttributes* pPhysicalDeviceAttributes, const FQueue* pQueue,
+              FQueueFamilyIndex dstFamilyIndex, VkDeviceSize ringSize = 32 * 1024 * 1024);
+  void Destroy();
+
+  /// @brief Copies data into staging ring and records copy into dstBuffer, it is executed after Flush()
+  /// @param dstFamilyIndex - family of queue, which uses dstBuffer, UUNUSED for default one given in Create()
+  void Upload(const FBuffer& dstBuffer, const void* pData, VkDeviceSize size, VkDeviceSize dstOffset = 0,
+              FQueueFamilyIndex dstFamilyIndex = UUNUSED);
+
+  /// @brief Submits all recorded copies at once
+  /// @returns upload index of submit, it is the last submitted index when there was nothing to submit
+  u64 Flush();
+
+  /// @returns whether upload with given index is finished, does not block
+  [[nodiscard]] b32 IsFinished(u64 uploadIndex);
+  void Wait(u64 uploadIndex);
+  /// @brief Flushes recorded copies and waits until all uploads are finished
+  void WaitAll();
+
+  /// @brief Records acquire of all flushed buffers released to dstFamilyIndex, nothing is recorded when upload queue
+  /// is from the same family. Nothing is waited for on host, release must be executed before acquire, so submit of
+  /// command buffer must wait on timeline semaphore for returned upload index.
+  /// @returns upload index of the last release, 0 when nothing was recorded (wait for it is always satisfied)
+  [[nodiscard]] u64 RecordAcquireBarriers(FCommandBuffer& commandBuffer, FQueueFamilyIndex dstFamilyIndex,
+                                          VkAccessFlags dstAccess, VkPipelineStageFlags dstStage);
+
+  /// @returns semaphore signaled with upload index by every submit
+  [[nodiscard]] VkSemaphore GetTimelineSemaphore() const { return m_Timeline.GetHandle(); }
+
+  [[nodiscard]] const FUploadStatistics& GetStatistics() const { return m_Statistics; }
+  void ResetStatistics() { m_Statistics = {}; }
+
+  [[nodiscard]] b32 IsValid() const { return m_RingBuffer.IsValid(); }
+
+private:
+
+  static constexpr u32 g_MaxSubmitsInFlight{ 4 };
+
+  struct FOwnershipTransfer
+  {
+    VkBuffer buffer{ VK_NULL_HANDLE };
+    FQueueFamilyIndex dstFamilyIndex{ UUNUSED };
+    /// Index of submit, which released buffer
+    u64 uploadIndex{ 0 };
+  };
+
+  /// @returns offset in ring buffer of region, where size bytes can be written
+  VkDeviceSize AllocateStagingRegion(VkDeviceSize size);
+
+  /// @brief Releases ring space of finished submit with given index, optionally blocks until it is finished
+  b32 RetireSubmit(u64 uploadIndex, b8 block);
+
+private:
+
+  FBuffer m_RingBuffer{};
+  FCommandPool m_CommandPool{};
+  std::vector<FCommandBuffer> m_CommandBuffers{};
+  FTimelineSemaphore m_Timeline{};
+  /// Ring position (not wrapped) after last byte of every submit in flight
+  u64 m_SubmitRingEnds[g_MaxSubmitsInFlight]{};
+  /// Buffers to be released at the end of recorded submit
+  std::vector<FOwnershipTransfer> m_RecordedTransfers{};
+  /// Buffers released by submitted uploads, which are not acquired yet
+  std::vector<FOwnershipTransfer> m_ReleasedTransfers{};
+  FUploadStatistics m_Statistics{};
+  const FQueue* m_pQueue{ nullptr };
+  std::byte* m_pRingData{ nullptr };
+  VkDevice m_Device{ VK_NULL_HANDLE };
+  VkDeviceSize m_RingSize{ 0 };
+  FQueueFamilyIndex m_DstFamilyIndex{ UUNUSED };
+  /// Ring positions only grow, position in buffer is position modulo ring size
+  u64 m_RingHead{ 0 };
+  u64 m_RingTail{ 0 };
+  u64 m_SubmittedIndex{ 0 };
+  u64 m_FinishedIndex{ 0 };
+  b8 m_Recording{ UFALSE };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_UPLOADMANAGER_H
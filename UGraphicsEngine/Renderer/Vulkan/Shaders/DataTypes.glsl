@@ -20,12 +20,21 @@ struct Material
     int illuminationModel;
 };
 
+struct Submesh
+{
+    uint firstIndex;
+    uint indicesCount;
+    uint firstVertex;
+    uint verticesCount;
+    uint materialIndex;
+};
+
 struct BottomStructureUniformData
 {
     uint64_t vertexAddress;
     uint64_t indexAddress;
     uint64_t materialAddress;
-    uint64_t materialIndicesAddress;
+    uint64_t submeshAddress;
 };
 
 struct LightData
@@ -46,4 +46,10 @@ void FFence::WaitAndReset() const {
 }
 
 
+b32 FFence::IsSignaled() const
+{
+  return vkGetFenceStatus(m_Device, m_Fence) == VK_SUCCESS;
+}
+
+
 }
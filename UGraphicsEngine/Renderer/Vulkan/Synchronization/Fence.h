@@ -4,6 +4,7 @@
 
 
 #include <volk.h>
+#include "UTools/UTypes.h"
 
 
 namespace uncanny::vulkan
@@ -21,6 +22,9 @@ public:
 
   void WaitAndReset() const;
 
+  /// @returns whether fence is signaled, does not block
+  [[nodiscard]] b32 IsSignaled() const;
+
   [[nodiscard]] VkFence GetHandle() const { return m_Fence; }
 
 private:
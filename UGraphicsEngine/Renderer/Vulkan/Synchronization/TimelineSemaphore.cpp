@@ -0,0 +1,73 @@
+
+#include "TimelineSemaphore.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Utilities.h"
+#include <limits>
+
+
+namespace uncanny::vulkan
+{
+
+
+FTimelineSemaphore::~FTimelineSemaphore()
+{
+  Destroy();
+}
+
+
+void FTimelineSemaphore::Create(VkDevice vkDevice, u64 initialValue)
+{
+  m_Device = vkDevice;
+
+  VkSemaphoreTypeCreateInfo typeCreateInfo{
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+    .pNext = nullptr,
+    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+    .initialValue = initialValue
+  };
+  VkSemaphoreCreateInfo createInfo{
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    .pNext = &typeCreateInfo,
+    .flags = 0
+  };
+
+  VkResult result = vkCreateSemaphore(m_Device, &createInfo, nullptr, &m_Semaphore);
+  AssertVkAndThrow(result);
+}
+
+
+void FTimelineSemaphore::Destroy()
+{
+  if (m_Semaphore != VK_NULL_HANDLE)
+  {
+    vkDestroySemaphore(m_Device, m_Semaphore, nullptr);
+    m_Semaphore = VK_NULL_HANDLE;
+  }
+}
+
+
+void FTimelineSemaphore::Wait(u64 value) const
+{
+  VkSemaphoreWaitInfo waitInfo{
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+    .pNext = nullptr,
+    .flags = 0,
+    .semaphoreCount = 1,
+    .pSemaphores = &m_Semaphore,
+    .pValues = &value
+  };
+  constexpr u64 timeout{ std::numeric_limits<u64>::max() };
+  VkResult result = vkWaitSemaphores(m_Device, &waitInfo, timeout);
+  AssertVkAndThrow(result);
+}
+
+
+u64 FTimelineSemaphore::GetCompletedValue() const
+{
+  u64 value{ 0 };
+  VkResult result = vkGetSemaphoreCounterValue(m_Device, m_Semaphore, &value);
+  AssertVkAndThrow(result);
+  return value;
+}
+
+
+}
@@ -0,0 +1,46 @@
+
+#ifndef UNCANNYENGINE_TIMELINESEMAPHORE_H
+#define UNCANNYENGINE_TIMELINESEMAPHORE_H
+
+
+#include <volk.h>
+#include "UTools/UTypes.h"
+
+
+namespace uncanny::vulkan
+{
+
+
+/// @brief FTimelineSemaphore is semaphore with monotonically growing 64-bit value (core since Vulkan 1.2).
+/// @details Every submit signals next value, so that one semaphore replaces fence per frame: host waits until value of
+/// given submit is reached, or only polls it without blocking. Values are set in FQueue::Submit() overload with
+/// wait and signal values.
+class FTimelineSemaphore
+{
+public:
+
+  ~FTimelineSemaphore();
+
+  void Create(VkDevice vkDevice, u64 initialValue = 0);
+  void Destroy();
+
+  /// @brief Blocks until semaphore value is at least given value
+  void Wait(u64 value) const;
+
+  /// @returns value of the last finished signal operation, does not block
+  [[nodiscard]] u64 GetCompletedValue() const;
+
+  [[nodiscard]] VkSemaphore GetHandle() const { return m_Semaphore; }
+
+private:
+
+  VkSemaphore m_Semaphore{ VK_NULL_HANDLE };
+  VkDevice m_Device{ VK_NULL_HANDLE };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_TIMELINESEMAPHORE_H
@@ -1,5 +1,7 @@
 
 #include "App.h"
+#include <chrono>
+#include <cstring>
 
 
 Application::Application()
@@ -27,63 +29,74 @@ void Application::Run() {
     }
     f32 deltaTime = m_Window->GetDeltaTime();
 
-    m_Camera.ProcessMovement(m_Window.get(), deltaTime);
+    // Frame index is reused only after GPU finished frame submitted g_FramesInFlightCount frames ago, so that its
+    // command buffers, uniform region and instance records can be written while newer frames are executed...
+    m_FrameIndex = m_SubmittedFramesCount % g_FramesInFlightCount;
+    if (m_SubmittedFramesCount >= g_FramesInFlightCount)
     {
-      FPerspectiveCameraUniformData uniformData = m_Camera.GetUniformData();
-      m_CameraUniformBuffer.Fill(&uniformData, sizeof(FPerspectiveCameraUniformData), 1);
+      m_FrameTimeline.Wait(m_SubmittedFramesCount + 1 - g_FramesInFlightCount);
     }
+    m_DeletionQueue.Collect(m_FrameTimeline.GetCompletedValue());
 
-    m_Swapchain.WaitForNextImage();
+    // Transient memory of previous frame is released at once...
+    FFrameAllocator::NextFrame();
+    m_Systems.Run(&m_JobSystem, deltaTime);
 
-    u32 frameIndex = m_Swapchain.GetCurrentFrameIndex();
+    // When no image is acquired, nothing is recorded nor submitted, swapchain is recreated and frame is retried...
+    if (not m_Swapchain.AcquireNextImage(m_ImageAvailableSemaphores[m_FrameIndex].GetHandle()))
+    {
+      if (m_Swapchain.IsRecreatePossible())
+      {
+        RecreateSwapchainResources();
+      }
+      continue;
+    }
+
+    const u32 imageIndex = m_Swapchain.GetCurrentImageIndex();
     const vulkan::FQueue& graphicsQueue = m_RenderContext.GetLogicalDevice()->GetGraphicsQueue();
 
     m_ImGuiRenderer.BeginFrame(m_Swapchain.GetCurrentExtent(), m_Window->GetMouseButtonsPressed(),
                                m_Window->GetMousePosition());
     DrawImGui();
-    m_ImGuiRenderer.EndFrame(frameIndex, graphicsQueue, m_Swapchain.GetFramebuffers()[frameIndex]);
+    m_ImGuiRenderer.EndFrame(m_FrameIndex, m_Swapchain.GetFramebuffers()[imageIndex]);
+
+    RecordRayTracingCommands(m_FrameIndex, imageIndex);
 
     {
-      VkSemaphore waitSemaphores[]{ m_Swapchain.GetImageAvailableSemaphore().GetHandle() };
-      VkPipelineStageFlags waitStageFlags[]{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-      VkSemaphore signalSemaphores[]{ m_ImGuiRenderer.GetSemaphore(frameIndex) };
-      graphicsQueue.Submit(waitSemaphores, waitStageFlags, m_CommandBuffers[frameIndex], signalSemaphores,
-                           VK_NULL_HANDLE);
+      // Structures and uploaded buffers acquired by frame commands are waited for on device, already reached values
+      // do not block...
+      const VkPipelineStageFlags acquireStageFlags = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                                     VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+      VkSemaphore waitSemaphores[]{ m_ImageAvailableSemaphores[m_FrameIndex].GetHandle(),
+                                    m_ComputeTimeline.GetHandle(), m_UploadManager.GetTimelineSemaphore() };
+      VkPipelineStageFlags waitStageFlags[]{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, acquireStageFlags,
+                                             acquireStageFlags };
+      const u64 waitValues[]{ 0, m_ComputeWaitValue, m_UploadWaitValue };
+      VkSemaphore signalSemaphores[]{ m_ImGuiRenderer.GetSemaphore(m_FrameIndex) };
+      graphicsQueue.Submit(waitSemaphores, waitStageFlags, waitValues, m_CommandBuffers[m_FrameIndex],
+                           signalSemaphores, {}, VK_NULL_HANDLE);
     }
     {
-      VkSemaphore waitSemaphores[]{ m_ImGuiRenderer.GetSemaphore(frameIndex) };
+      // Timeline value replaces per frame fence, binary semaphore is kept for present...
+      VkSemaphore waitSemaphores[]{ m_ImGuiRenderer.GetSemaphore(m_FrameIndex) };
       VkPipelineStageFlags waitStageFlags[]{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-      VkSemaphore signalSemaphores[]{ m_Swapchain.GetPresentableImageReadySemaphore().GetHandle() };
-      VkFence fence{ m_Swapchain.GetFence().GetHandle() };
-      graphicsQueue.Submit(waitSemaphores, waitStageFlags, m_ImGuiRenderer.GetCommandBuffer(frameIndex),
-                           signalSemaphores, fence);
+      VkSemaphore signalSemaphores[]{ m_Swapchain.GetImageRenderedSemaphore().GetHandle(),
+                                      m_FrameTimeline.GetHandle() };
+      const u64 signalValues[]{ 0, m_SubmittedFramesCount + 1 };
+      graphicsQueue.Submit(waitSemaphores, waitStageFlags, {}, m_ImGuiRenderer.GetCommandBuffer(m_FrameIndex),
+                           signalSemaphores, signalValues, VK_NULL_HANDLE);
+      m_SubmittedFramesCount++;
     }
 
-    m_Swapchain.Present();
+    m_Swapchain.PresentImage();
 
     if (m_Swapchain.IsOutOfDate() and m_Swapchain.IsRecreatePossible())
     {
-      m_RenderContext.GetLogicalDevice()->WaitIdle();
-
-      m_Swapchain.Recreate();
-
-      m_OffscreenImage.Recreate(m_Swapchain.GetCurrentExtent());
-      m_WriteOffscreenImageToDescriptorSet(m_OffscreenImage.GetHandleView());
-
-      m_Camera.SetAspectRatio(m_Swapchain.GetCurrentAspectRatio());
-
-      m_DepthImage.Recreate(m_Swapchain.GetCurrentExtent());
-
-      m_Swapchain.CreateViews();
-      m_Swapchain.CreateFramebuffers(m_ImGuiRenderer.GetRenderPass(), m_DepthImage.GetHandleView());
-
-      RecordRayTracingCommands();
-      m_Camera.ResetAccumulatedFrameCounter();
+      RecreateSwapchainResources();
     }
 
     if (m_ShouldChangeScene)
     {
-      m_RenderContext.GetLogicalDevice()->WaitIdle();
       DestroyLevelResources();
       CreateLevelResources(m_ScenePaths[m_SelectedScenePath]);
       m_Camera.ResetSpecification();
@@ -91,17 +104,66 @@ void Application::Run() {
       m_Camera.DontAccumulatePreviousColors();
     }
 
+    if (m_ShouldRebuildAccelerationStructures)
+    {
+      DestroyAccelerationStructures();
+      BuildAccelerationStructures();
+      m_Camera.ResetAccumulatedFrameCounter();
+    }
+
+    // Commands are recorded every frame, so selected pipeline is simply bound by the next one...
     if (m_ShouldChangePipeline)
     {
-      m_RenderContext.GetLogicalDevice()->WaitIdle();
       m_Camera.ResetAccumulatedFrameCounter();
       m_Camera.DontAccumulatePreviousColors();
-      RecordRayTracingCommands();
     }
   }
 }
 
 
+void Application::RecreateSwapchainResources()
+{
+  // Images are last used by the last submitted frame. Presentation engine is not tracked by frame timeline, so old
+  // swapchain is kept until frames submitted after its last present are finished too...
+  m_Swapchain.Recreate(m_DeletionQueue, m_SubmittedFramesCount + g_FramesInFlightCount);
+
+  m_OffscreenImage.Recreate(m_Swapchain.GetCurrentExtent(), m_DeletionQueue, m_SubmittedFramesCount);
+  MarkFrameDescriptorsOutdated();
+
+  m_Camera.SetAspectRatio(m_Swapchain.GetCurrentAspectRatio());
+
+  m_DepthImage.Recreate(m_Swapchain.GetCurrentExtent(), m_DeletionQueue, m_SubmittedFramesCount);
+
+  m_Swapchain.CreateViews();
+  m_Swapchain.CreateFramebuffers(m_ImGuiRenderer.GetRenderPass(), m_DepthImage.GetHandleView());
+
+  m_Camera.ResetAccumulatedFrameCounter();
+}
+
+
+void Application::UpdateFrameDescriptors(u32 frameIndex)
+{
+  if (not m_FrameDescriptorsOutdated[frameIndex])
+  {
+    return;
+  }
+
+  m_WriteTlasToDescriptorSet(frameIndex, m_TopLevelAS.GetHandle());
+  m_WriteOffscreenImageToDescriptorSet(frameIndex, m_OffscreenImage.GetHandleView());
+  m_WriteBlasReferenceUniformToDescriptorSet(frameIndex, m_BLASReferenceUniformBuffer.GetHandle());
+  m_FrameDescriptorsOutdated[frameIndex] = UFALSE;
+}
+
+
+void Application::MarkFrameDescriptorsOutdated()
+{
+  for (b8& outdated : m_FrameDescriptorsOutdated)
+  {
+    outdated = UTRUE;
+  }
+}
+
+
 void Application::DrawImGui()
 {
   ImGui::SetNextWindowPos(ImVec2(2.5f, 2.5f));
@@ -113,6 +175,18 @@ void Application::DrawImGui()
 
   u32 accumulatedFrames = m_Camera.GetAccumulatedFramesCounter();
   ImGui::Text("Accumulated Frames: %u", accumulatedFrames);
+  ImGui::Text("Pipelines created in %.2f ms (%s cache, %.1f KB)", m_PipelinesCreateTime,
+              m_PipelineCache.IsLoadedFromDisk() ? "warm" : "cold", (f64)m_PipelineCache.GetLoadedSize() / 1024.0);
+
+  if (ImGui::CollapsingHeader("Systems"))
+  {
+    ImGui::Text("Systems frame: %.3f ms on %u threads", m_Systems.GetLastFrameTime(), m_JobSystem.GetThreadsCount());
+    for (const FSystemTiming& timing : m_Systems.GetTimings())
+    {
+      ImGui::Text("%s: start %.3f ms, duration %.3f ms, thread %u", timing.name, timing.startTime, timing.duration,
+                  timing.threadIndex);
+    }
+  }
 
   ImGui::Separator();
 
@@ -163,6 +237,19 @@ void Application::DrawImGui()
     }
   }
 
+  // Host builds are available on CPU-only devices too, toggling rebuilds level structures for comparison...
+  {
+    m_ShouldRebuildAccelerationStructures = UFALSE;
+    const VkPhysicalDeviceAccelerationStructureFeaturesKHR& features =
+        m_RenderContext.GetLogicalDevice()->GetAttributes().GetAccelerationStructureFeatures();
+    if (features.accelerationStructureHostCommands)
+    {
+      bool buildOnHost = m_BuildBottomLevelOnHost;
+      m_ShouldRebuildAccelerationStructures = ImGui::Checkbox("Build Bottom AS On Host", &buildOnHost);
+      m_BuildBottomLevelOnHost = buildOnHost;
+    }
+  }
+
   ImGui::Separator();
 
   auto& camSpecs = m_Camera.GetSpecification();
@@ -184,15 +271,38 @@ void Application::DrawImGui()
 
   ImGui::Text("Scene statistics");
   ImGui::Text("Bottom AS Count: %u", m_LevelStats.bottomLevelStructsCount);
+  ImGui::Text("Instances: %u", m_LevelStats.instancesCount);
+  ImGui::Text("Top AS updates since rebuild: %u", m_TopLevelAS.GetUpdatesSinceRebuild());
   ImGui::Text("Triangles: %u", m_LevelStats.allTrianglesCount);
   ImGui::Text("Vertices: %u", m_LevelStats.allVerticesCount);
   ImGui::Text("Indices: %u", m_LevelStats.allIndicesCount);
+  ImGui::Text("Bottom AS memory: %.2f MB (compaction saved %.2f MB)",
+              (f64)m_LevelStats.bottomLevelStructsMemory / (1024.0 * 1024.0),
+              (f64)m_LevelStats.compactionSavedMemory / (1024.0 * 1024.0));
+  ImGui::Text("Bottom AS load time: %.2f ms on %s (%u of %u from cache)", m_LevelStats.bottomLevelStructsLoadTime,
+              m_BuildBottomLevelOnHost ? "host" : "device", m_LevelStats.cachedBottomLevelStructsCount,
+              m_LevelStats.bottomLevelStructsCount);
+  // Every upload used to be submitted on its own and waited for with queue wait idle...
+  ImGui::Text("Upload: %.2f ms, %.2f MB in %u submits, %u queue waits (%u before batching)", m_LevelStats.uploadTime,
+              (f64)m_LevelStats.uploadStats.uploadedBytes / (1024.0 * 1024.0), m_LevelStats.uploadStats.submitsCount,
+              m_LevelStats.uploadStats.queueWaitsCount, m_LevelStats.uploadStats.uploadsCount);
+  const FLinearAllocator& assetMemory = m_AssetRegistry.GetLevelMemory();
+  ImGui::Text("Asset memory: %.2f / %.2f MB", (f64)assetMemory.GetUsedBytes() / (1024.0 * 1024.0),
+              (f64)assetMemory.GetCapacity() / (1024.0 * 1024.0));
+  const vulkan::FDeviceMemoryStatistics deviceMemory =
+      m_RenderContext.GetLogicalDevice()->GetMemoryAllocator().GetStatistics();
+  ImGui::Text("Device memory: %.2f / %.2f MB in %u blocks + %u dedicated",
+              (f64)deviceMemory.usedBytes / (1024.0 * 1024.0), (f64)deviceMemory.reservedBytes / (1024.0 * 1024.0),
+              deviceMemory.blocksCount, deviceMemory.dedicatedAllocationsCount);
+  ImGui::Text("Device allocations: %u, free regions: %u, fragmentation: %.1f%%", deviceMemory.allocationsCount,
+              deviceMemory.freeRegionsCount, 100.f * deviceMemory.fragmentation);
 
   ImGui::End();
 }
 
 void Application::CreateEngineResources() {
   FLog::create();
+  m_JobSystem.Create();
 
   // Creating window...
   FWindowConfiguration windowConfiguration{
@@ -235,9 +345,28 @@ void Application::CreateEngineResources() {
   m_CommandPool.Create(pLogicalDevice->GetGraphicsFamilyIndex(),
                        pLogicalDevice->GetHandle(),
                        VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+  m_ComputeCommandPool.Create(pLogicalDevice->GetComputeFamilyIndex(), pLogicalDevice->GetHandle(),
+                              VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+
+  // Creating command buffers and frame synchronization, one set per frame in flight...
+  m_CommandBuffers = m_CommandPool.AllocatePrimaryCommandBuffers(g_FramesInFlightCount);
+  m_ComputeCommandBuffers = m_ComputeCommandPool.AllocatePrimaryCommandBuffers(g_FramesInFlightCount);
+  m_FrameTimeline.Create(pLogicalDevice->GetHandle());
+  m_ComputeTimeline.Create(pLogicalDevice->GetHandle());
+  for (vulkan::FSemaphore& semaphore : m_ImageAvailableSemaphores)
+  {
+    semaphore.Create(pLogicalDevice->GetHandle());
+  }
+
+  // Creating upload manager, all level data goes through its staging ring on transfer queue. Bottom level structures
+  // are built on compute queue, so that neither uploads nor builds wait behind rendering on graphics queue...
+  m_UploadManager.Create(pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes(),
+                         &pLogicalDevice->GetTransferQueue(), pLogicalDevice->GetComputeFamilyIndex());
 
-  // Creating command buffers...
-  m_CommandBuffers = m_CommandPool.AllocatePrimaryCommandBuffers(m_Swapchain.GetBackBufferCount());
+  // Creating acceleration structure cache, bottom level structures built in previous runs are deserialized...
+  m_AccelerationStructureCache.Initialize(
+      FPath::Append(FPath::GetEngineProjectPath(), { "cache", "blas" }).GetStringPath(),
+      pPhysicalDevice->GetAttributes(), pLogicalDevice->GetHandle());
 
   // Creating camera...
   {
@@ -267,11 +396,18 @@ void Application::CreateEngineResources() {
     m_Camera.SetRayTracingSpecification(rayTracingSpecification);
     FPerspectiveCameraUniformData uniformData = m_Camera.GetUniformData();
 
-    // Creating per frame buffer for camera...
-    m_CameraUniformBuffer.Allocate(sizeof(uniformData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+    // Creating camera buffer with one region per frame in flight, regions must be aligned for dynamic offsets...
+    const VkDeviceSize alignment =
+        pPhysicalDevice->GetAttributes().GetDeviceProperties().limits.minUniformBufferOffsetAlignment;
+    m_CameraUniformStride = (sizeof(uniformData) + alignment - 1) / alignment * alignment;
+    m_CameraUniformBuffer.Allocate(m_CameraUniformStride * g_FramesInFlightCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                                    pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes());
-    m_CameraUniformBuffer.Fill(&uniformData, sizeof(uniformData), 1);
+    m_pCameraUniformData = static_cast<std::byte*>(m_CameraUniformBuffer.Map());
+    for (u32 i = 0; i < g_FramesInFlightCount; i++)
+    {
+      memcpy(m_pCameraUniformData + i * m_CameraUniformStride, &uniformData, sizeof(uniformData));
+    }
 
     // Initial setup for imgui...
     m_SelectedAccumulatedColor = m_Camera.GetRayTracingSpecification().accumulatePreviousColors;
@@ -297,14 +433,17 @@ void Application::CreateEngineResources() {
   });
   m_SceneDescriptorSetLayout.Create(pLogicalDevice->GetHandle());
 
-  m_SceneDescriptorPool.Create(pLogicalDevice->GetHandle(), &m_SceneDescriptorSetLayout, 1);
-  m_SceneDescriptorPool.AllocateDescriptorSet();
+  for (vulkan::FDescriptorPool& descriptorPool : m_SceneDescriptorPools)
+  {
+    descriptorPool.Create(pLogicalDevice->GetHandle(), &m_SceneDescriptorSetLayout, 1);
+    descriptorPool.AllocateDescriptorSet();
+  }
   {
     u32 dstBinding = m_SceneDescriptorSetLayout.GetBindings()[0].binding;
     VkDescriptorType type = m_SceneDescriptorSetLayout.GetBindings()[0].descriptorType;
-    m_WriteBlasReferenceUniformToDescriptorSet = [this, dstBinding, type](VkBuffer bufferHandle)
+    m_WriteBlasReferenceUniformToDescriptorSet = [this, dstBinding, type](u32 frameIndex, VkBuffer bufferHandle)
     {
-      m_SceneDescriptorPool.WriteBufferToDescriptorSet(bufferHandle, VK_WHOLE_SIZE, dstBinding, type);
+      m_SceneDescriptorPools[frameIndex].WriteBufferToDescriptorSet(bufferHandle, VK_WHOLE_SIZE, dstBinding, type);
     };
   }
 
@@ -325,36 +464,44 @@ void Application::CreateEngineResources() {
   });
   m_RayTracingDescriptorSetLayout.AddBinding(VkDescriptorSetLayoutBinding{
       .binding = 2,
-      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
       .descriptorCount = 1,
       .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR,
       .pImmutableSamplers = nullptr
   });
   m_RayTracingDescriptorSetLayout.Create(pLogicalDevice->GetHandle());
 
-  m_RayTracingDescriptorPool.Create(pLogicalDevice->GetHandle(), &m_RayTracingDescriptorSetLayout, 1);
-  m_RayTracingDescriptorPool.AllocateDescriptorSet();
+  for (vulkan::FDescriptorPool& descriptorPool : m_RayTracingDescriptorPools)
+  {
+    descriptorPool.Create(pLogicalDevice->GetHandle(), &m_RayTracingDescriptorSetLayout, 1);
+    descriptorPool.AllocateDescriptorSet();
+  }
 
+  // Level and render target resources are written into frame sets lazily, when frame is recorded...
   {
     u32 dstBinding = m_RayTracingDescriptorSetLayout.GetBindings()[0].binding;
-    m_WriteTlasToDescriptorSet = [this, dstBinding](VkAccelerationStructureKHR asHandle)
+    m_WriteTlasToDescriptorSet = [this, dstBinding](u32 frameIndex, VkAccelerationStructureKHR asHandle)
     {
-      m_RayTracingDescriptorPool.WriteTopLevelAsToDescriptorSet(asHandle, dstBinding);
+      m_RayTracingDescriptorPools[frameIndex].WriteTopLevelAsToDescriptorSet(asHandle, dstBinding);
     };
   }
   {
     u32 dstBinding = m_RayTracingDescriptorSetLayout.GetBindings()[1].binding;
-    m_WriteOffscreenImageToDescriptorSet = [this, dstBinding](VkImageView offscreenView)
+    m_WriteOffscreenImageToDescriptorSet = [this, dstBinding](u32 frameIndex, VkImageView offscreenView)
     {
-      m_RayTracingDescriptorPool.WriteStorageImageToDescriptorSet(offscreenView, dstBinding);
+      m_RayTracingDescriptorPools[frameIndex].WriteStorageImageToDescriptorSet(offscreenView, dstBinding);
     };
-    m_WriteOffscreenImageToDescriptorSet(m_OffscreenImage.GetHandleView());
   }
   {
     u32 dstBinding = m_RayTracingDescriptorSetLayout.GetBindings()[2].binding;
     VkDescriptorType type = m_RayTracingDescriptorSetLayout.GetBindings()[2].descriptorType;
+    // Descriptor covers one region, frame region is selected with dynamic offset when binding...
     VkBuffer bufferHandle = m_CameraUniformBuffer.GetHandle();
-    m_RayTracingDescriptorPool.WriteBufferToDescriptorSet(bufferHandle, VK_WHOLE_SIZE, dstBinding, type);
+    for (const vulkan::FDescriptorPool& descriptorPool : m_RayTracingDescriptorPools)
+    {
+      descriptorPool.WriteBufferToDescriptorSet(bufferHandle, sizeof(FPerspectiveCameraUniformData), dstBinding,
+                                                type);
+    }
   }
 
   // Creating ray tracing pipeline...
@@ -369,6 +516,10 @@ void Application::CreateEngineResources() {
     vulkan::FGLSLShaderCompiler glslCompiler{};
     glslCompiler.Initialize(m_RenderContext.GetInstance()->GetAttributes().GetFullVersion());
 
+    FPath pipelineCachePath = FPath::Append(FPath::GetEngineProjectPath(), { "cache", "pipelines", "sandbox.bin" });
+    m_PipelineCache.Create(pipelineCachePath.GetStringPath(), pPhysicalDevice->GetAttributes(),
+                           pLogicalDevice->GetHandle());
+
     vulkan::FRayTracingPipelineSpecification rayTracingPipelineSpecification{
         .rayClosestHitPath = FPath::Append(shadersPath, "sandbox.rchit.spv"),
         .rayGenerationPath = FPath::Append(shadersPath, "sandbox.rgen.spv"),
@@ -378,8 +529,10 @@ void Application::CreateEngineResources() {
         .pPipelineLayout = &m_RayTracingPipelineLayout,
         .pProperties = &pLogicalDevice->GetAttributes().GetRayTracingProperties(),
         .vkDevice = pLogicalDevice->GetHandle(),
-        .pPhysicalDeviceAttributes = &pPhysicalDevice->GetAttributes()
+        .pPhysicalDeviceAttributes = &pPhysicalDevice->GetAttributes(),
+        .vkPipelineCache = m_PipelineCache.GetHandle()
     };
+    const auto pipelinesStart = std::chrono::steady_clock::now();
     m_RayTracingPipelines.reserve(3);   // When there will be reallocation program will fail!
     {
       rayTracingPipelineSpecification.rayClosestHitPath = FPath::Append(shadersPath, "sandbox.rchit.spv");
@@ -399,6 +552,8 @@ void Application::CreateEngineResources() {
       rtxPipeline.Create(rayTracingPipelineSpecification);
       m_RayTracingPipelinesCstr.emplace_back("World Space Positions");
     }
+    const auto pipelinesEnd = std::chrono::steady_clock::now();
+    m_PipelinesCreateTime = std::chrono::duration<f64, std::milli>(pipelinesEnd - pipelinesStart).count();
   }
 
   // Creating imgui
@@ -420,11 +575,20 @@ void Application::CreateEngineResources() {
         .pTransferQueue = &pLogicalDevice->GetGraphicsQueue(),
         .swapchainFormat = m_Swapchain.GetFormat(),
         .graphicsQueueFamilyIndex = pLogicalDevice->GetGraphicsFamilyIndex(),
-        .backBufferCount = m_Swapchain.GetBackBufferCount(),
-        .targetVulkanVersion = m_RenderContext.GetInstance()->GetAttributes().GetFullVersion()
+        .framesInFlightCount = g_FramesInFlightCount,
+        .targetVulkanVersion = m_RenderContext.GetInstance()->GetAttributes().GetFullVersion(),
+        .vkPipelineCache = m_PipelineCache.GetHandle()
     };
 
+    const auto imGuiStart = std::chrono::steady_clock::now();
     m_ImGuiRenderer.Create(imGuiRendererSpecification);
+    const auto imGuiEnd = std::chrono::steady_clock::now();
+    m_PipelinesCreateTime += std::chrono::duration<f64, std::milli>(imGuiEnd - imGuiStart).count();
+
+    // All pipelines are created, so cache is saved right away for the next (warm) startup...
+    m_PipelineCache.Save();
+    UINFO("Pipelines created in {} ms with {} pipeline cache", m_PipelinesCreateTime,
+          m_PipelineCache.IsLoadedFromDisk() ? "warm" : "cold");
 
     m_Swapchain.CreateViews();
     m_Swapchain.CreateFramebuffers(m_ImGuiRenderer.GetRenderPass(), m_DepthImage.GetHandleView());
@@ -443,105 +607,410 @@ void Application::CreateEngineResources() {
       m_ScenePathsCstr.emplace_back(scene.GetStringFilename().c_str());
     }
   }
+
+  RegisterSystems();
+}
+
+
+void Application::RegisterSystems()
+{
+  // Camera polls window input, so it stays on main thread, but it runs concurrently with transforms...
+  m_Systems.AddSystem("CameraMovement", FSystemAccess{}.Writes<FPerspectiveCamera>().OnMainThread(),
+                      [this](f32 deltaTime)
+  {
+    m_Camera.ProcessMovement(m_Window.get(), deltaTime);
+  });
+
+  m_Systems.AddSystem("TransformPropagation", FSystemAccess{}.Writes<FTransformHierarchy>(),
+                      [this](f32)
+  {
+    m_EntityRegistry.GetTransforms().Update(&m_JobSystem);
+  });
+
+  m_Systems.AddSystem("RenderExtraction",
+                      FSystemAccess{}
+                          .Reads<FTransformHierarchy, FTransformComponent, FRenderMeshComponent>()
+                          .Writes<FRenderEntityChanges>(),
+                      [this](f32)
+  {
+    m_EntityRegistry.CollectRenderChanges(UFALSE);
+  });
+
+  // Acceleration structures are rebuilt with Vulkan calls, which are recorded on main thread. Added and switched
+  // meshes read world transforms, mesh components and assets...
+  m_Systems.AddSystem("LevelResourcesUpdate",
+                      FSystemAccess{}
+                          .Reads<FRenderEntityChanges, FTransformHierarchy, FTransformComponent, FRenderMeshComponent,
+                                 FAssetRegistry>()
+                          .Writes<vulkan::FTopLevelAccelerationStructure, FPerspectiveCamera>()
+                          .OnMainThread(),
+                      [this](f32)
+  {
+    UpdateLevelResources(m_EntityRegistry.GetRenderChanges());
+  });
+
+  // Region of current frame is not read by GPU anymore, so it is written directly into mapped memory...
+  m_Systems.AddSystem("CameraUniformUpload",
+                      FSystemAccess{}.Reads<FPerspectiveCamera>().Writes<FPerspectiveCameraUniformData>(),
+                      [this](f32)
+  {
+    FPerspectiveCameraUniformData uniformData = m_Camera.GetUniformData();
+    memcpy(m_pCameraUniformData + m_FrameIndex * m_CameraUniformStride, &uniformData, sizeof(uniformData));
+  });
 }
 
 
 void Application::CreateLevelResources(const FPath& scenePath)
+{
+  // Registering entities with render mesh components and loading several obj files, json or binary scene...
+  m_EntityRegistry.Create();
+  FEntityRegistryLoader::LoadScene(scenePath.GetStringPath().c_str(), &m_EntityRegistry, &m_AssetRegistry);
+
+  // Whole level is built from current state, so changes recorded during loading are not needed...
+  m_EntityRegistry.ClearRenderChanges();
+
+  BuildAccelerationStructures();
+}
+
+
+void Application::BuildAccelerationStructures()
 {
   const vulkan::FPhysicalDeviceAttributes& physicalDeviceAttributes =
       m_RenderContext.GetPhysicalDevice()->GetAttributes();
   const vulkan::FLogicalDevice* pLogicalDevice = m_RenderContext.GetLogicalDevice();
 
-  // Registering entities with render mesh components and loading several obj files...
-  m_EntityRegistry.Create();
-  FEntityRegistryLoader::LoadJsonScene(scenePath.GetStringPath().c_str(), &m_EntityRegistry, &m_AssetRegistry);
-
-  // Converting asset meshes and materials into render meshes and materials...
-  u32 blasCount = 0;
-  m_EntityRegistry.ForEach<FRenderMeshComponent>([this, &blasCount](FRenderMeshComponent& component)
+  // Render data is needed only until acceleration structures are built, views point into assets and level arena...
+  m_LevelAllocator.Reset();
+  std::pmr::vector<FRenderDataView> renderDataVector{ &m_LevelAllocator };
+  std::pmr::vector<vulkan::FTopLevelInstance> instances{ &m_LevelAllocator };
+  renderDataVector.reserve(m_AssetRegistry.GetMeshesCount());
+
+  // Every unique mesh asset is converted (and later built) once in object space, every entity is only an instance
+  // of it with its own world transform...
+  const FTransformHierarchy& transforms = m_EntityRegistry.GetTransforms();
+  m_EntityRegistry.ForEach<FRenderMeshComponent, FTransformComponent>(
+      [this, &renderDataVector, &instances, &transforms](FEntity entity, FRenderMeshComponent& component,
+                                                         FTransformComponent& transform)
   {
-    const FMeshAsset& meshAsset = m_AssetRegistry.GetMesh(component.id);
-    blasCount += meshAsset.GetMeshes().size();
+    const u32 bottomLevelIndex = FindBottomLevelIndex(entity, component.id, renderDataVector);
+    if (bottomLevelIndex == UUNUSED)
+    {
+      return;
+    }
+
+    // Instance index of entity is remembered, so that its instance record can be patched later...
+    m_EntityInstanceIndices[entity.GetID()] = instances.size();
+    m_InstanceEntityIds.push_back(entity.GetID());
+    m_InstanceMeshIds.push_back(component.id);
+    instances.push_back(vulkan::FTopLevelInstance{
+      .transform = transforms.GetWorldMatrix(transform.handle),
+      .bottomLevelIndex = bottomLevelIndex
+    });
   });
 
-  std::vector<FRenderData> renderDataVector;
-  renderDataVector.reserve(blasCount);
-  m_EntityRegistry.ForEach<FRenderMeshComponent>([this, &renderDataVector](FRenderMeshComponent& component)
+  m_LevelStats = {};
+  BuildBottomLevelStructures(renderDataVector);
+
+  // Top level structure is built in command buffer of the next frame, after bottom level structures are acquired
+  // there. Moving entities then only refit it in place, in command buffer of recorded frame too...
+  m_TopLevelAS.SetFramesInFlightCount(g_FramesInFlightCount);
+  m_TopLevelAS.SetBuildFlags(VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
+                             VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR);
+  m_TopLevelAS.Create(instances, pLogicalDevice->GetHandle(), &physicalDeviceAttributes);
+  m_TopLevelUpdatePending = UTRUE;
+  m_LevelStats.instancesCount = m_TopLevelAS.GetInstancesCount();
+
+  UploadBottomLevelReferences();
+}
+
+
+u32 Application::FindBottomLevelIndex(FEntity entity, u64 meshId, std::pmr::vector<FRenderDataView>& renderDataVector)
+{
+  auto it = m_MeshBottomLevelIndices.find(meshId);
+  if (it != m_MeshBottomLevelIndices.end())
   {
-    const FMeshAsset& meshAsset = m_AssetRegistry.GetMesh(component.id);
-    renderDataVector.emplace_back(FRenderMeshFactory::ConvertAssetToOneRenderData(&meshAsset, component.GetMatrix()));
-  });
+    return it->second;
+  }
+
+  // Entity with mesh without triangles has no instance, as its structure cannot be built...
+  const FMeshAsset& meshAsset = m_AssetRegistry.GetMesh(meshId);
+  FRenderDataView renderData = FRenderMeshFactory::ConvertAssetToOneRenderView(&meshAsset, math::Identity<f32>(),
+                                                                                &m_LevelAllocator);
+  if (not vulkan::FBottomLevelAccelerationStructure::HasTriangles(renderData.mesh))
+  {
+    UWARN("Entity {} has mesh without triangles, it is not rendered", entity.GetID());
+    return UUNUSED;
+  }
+
+  // Structures of converted meshes are appended after already built ones, in order of conversion...
+  const u32 bottomLevelIndex = m_BottomLevelAccelerationStructures.size() + renderDataVector.size();
+  m_MeshBottomLevelIndices.emplace(meshId, bottomLevelIndex);
+  renderDataVector.push_back(renderData);
+  return bottomLevelIndex;
+}
+
+
+void Application::BuildBottomLevelStructures(std::span<const FRenderDataView> renderDataVector)
+{
+  if (renderDataVector.empty())
+  {
+    return;
+  }
+
+  const vulkan::FPhysicalDeviceAttributes& physicalDeviceAttributes =
+      m_RenderContext.GetPhysicalDevice()->GetAttributes();
+  const vulkan::FLogicalDevice* pLogicalDevice = m_RenderContext.GetLogicalDevice();
+
+  // Creating acceleration structures, mesh data of all of them is uploaded with as few submits as ring allows...
+  m_UploadManager.ResetStatistics();
+  const auto uploadStart = std::chrono::steady_clock::now();
+  std::vector<vulkan::FBottomLevelAccelerationStructure*> structures{};
+  structures.reserve(renderDataVector.size());
+  for (const FRenderDataView& data : renderDataVector)
+  {
+    auto& bottomAS = m_BottomLevelAccelerationStructures.emplace_back();
+    // Moving entities only change their instance transforms, no mesh is deformed, so every structure is static...
+    bottomAS.SetBuildPolicy(vulkan::EAccelerationStructureBuildPolicy::Static);
+    bottomAS.SetBuildOnHost(m_BuildBottomLevelOnHost);
+    bottomAS.Prepare(data.mesh, data.materials, m_UploadManager, pLogicalDevice->GetHandle(),
+                     &physicalDeviceAttributes);
+    structures.push_back(&bottomAS);
+  }
+  // Uploads released by transfer queue are acquired in builder command buffer, which waits for them on device...
+  m_UploadManager.Flush();
+  const auto uploadEnd = std::chrono::steady_clock::now();
+  const u32 cacheHitsCount = m_AccelerationStructureCache.GetHitsCount();
+  const auto buildStart = std::chrono::steady_clock::now();
+  vulkan::FAccelerationStructureBuilder::Build(structures, m_ComputeCommandPool, pLogicalDevice->GetComputeQueue(),
+                                               pLogicalDevice, &m_AccelerationStructureCache, &m_JobSystem,
+                                               &m_UploadManager);
+  const auto buildEnd = std::chrono::steady_clock::now();
+
+  // Structures and their geometry are used by top level build and hit shaders on graphics queue from now on, they
+  // are passed over to it in the next recorded frame...
+  if (pLogicalDevice->HasAsyncComputeQueue())
+  {
+    for (const vulkan::FBottomLevelAccelerationStructure* pBottomAS : structures)
+    {
+      pBottomAS->CollectBuffers(m_PendingOwnershipBuffers);
+    }
+  }
 
-  // Creating acceleration structures...
-  m_BottomLevelAccelerationVector.reserve(renderDataVector.size());
-  for (auto& data : renderDataVector)
+  // BLAS reference entries are appended in the same order as structures, so that indices of meshes match...
+  for (const vulkan::FBottomLevelAccelerationStructure* pBottomAS : structures)
   {
-    auto& bottomAS = m_BottomLevelAccelerationVector.emplace_back();
-    bottomAS.Build(data.mesh, data.materials, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
-                   pLogicalDevice->GetHandle(), &physicalDeviceAttributes);
+    m_TopLevelAS.AddBottomLevelStructure(*pBottomAS);
+    m_LevelStats.bottomLevelStructsMemory += pBottomAS->GetSize();
+    m_LevelStats.compactionSavedMemory += pBottomAS->GetBuildSize() - pBottomAS->GetSize();
   }
-  m_TopLevelAS.Build(m_BottomLevelAccelerationVector, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
-                     pLogicalDevice->GetHandle(), &physicalDeviceAttributes);
-  m_WriteTlasToDescriptorSet(m_TopLevelAS.GetHandle());
+  for (const FRenderDataView& renderData : renderDataVector)
+  {
+    m_LevelStats.allVerticesCount += renderData.mesh.vertices.size();
+    m_LevelStats.allIndicesCount += renderData.mesh.indices.size();
+  }
+  m_LevelStats.allTrianglesCount = m_LevelStats.allIndicesCount / 3;
+  m_LevelStats.bottomLevelStructsCount = m_BottomLevelAccelerationStructures.size();
+  m_LevelStats.cachedBottomLevelStructsCount += m_AccelerationStructureCache.GetHitsCount() - cacheHitsCount;
+  m_LevelStats.bottomLevelStructsLoadTime = std::chrono::duration<f64, std::milli>(buildEnd - buildStart).count();
+  m_LevelStats.uploadTime = std::chrono::duration<f64, std::milli>(uploadEnd - uploadStart).count();
+  m_LevelStats.uploadStats = m_UploadManager.GetStatistics();
+}
+
+
+void Application::UploadBottomLevelReferences()
+{
+  const vulkan::FPhysicalDeviceAttributes& physicalDeviceAttributes =
+      m_RenderContext.GetPhysicalDevice()->GetAttributes();
+  const vulkan::FLogicalDevice* pLogicalDevice = m_RenderContext.GetLogicalDevice();
+
+  // Old buffer may be still read by frames in flight, or acquired by the next frame, when it was uploaded but not
+  // acquired yet...
+  m_BLASReferenceUniformBuffer.Free(m_DeletionQueue, m_SubmittedFramesCount + 1);
 
-  // Creating blas reference uniform buffer...
   const auto& blasUniformData = m_TopLevelAS.GetBLASReferenceUniformData();
-  m_BLASReferenceUniformBuffer.Allocate(blasUniformData.size() * sizeof(blasUniformData[0]),
+  m_BLASReferenceUniformBuffer.Allocate(std::max<u64>(blasUniformData.size(), 1) * sizeof(blasUniformData[0]),
                                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pLogicalDevice->GetHandle(),
                                         &physicalDeviceAttributes);
   m_BLASReferenceUniformBuffer.FillStaged(blasUniformData.data(), sizeof(blasUniformData[0]),
-                                          blasUniformData.size(), m_CommandPool,
-                                          pLogicalDevice->GetGraphicsQueue());
-  m_WriteBlasReferenceUniformToDescriptorSet(m_BLASReferenceUniformBuffer.GetHandle());
+                                          blasUniformData.size(), m_UploadManager,
+                                          pLogicalDevice->GetGraphicsFamilyIndex());
+  // Buffer is acquired by command buffer of the next frame, when it is uploaded on dedicated transfer queue...
+  m_UploadManager.Flush();
+  MarkFrameDescriptorsOutdated();
+}
 
-  // Recording commands
-  RecordRayTracingCommands();
 
-  CalculateStatisticsForLevelResources(renderDataVector);
+void Application::AddInstance(FEntity entity, u64 meshId, u32 bottomLevelIndex, const math::Matrix4x4f& worldMatrix)
+{
+  const u32 instanceIndex = m_TopLevelAS.AddInstance(vulkan::FTopLevelInstance{
+    .transform = worldMatrix,
+    .bottomLevelIndex = bottomLevelIndex
+  });
+  m_EntityInstanceIndices[entity.GetID()] = instanceIndex;
+  m_InstanceEntityIds.push_back(entity.GetID());
+  m_InstanceMeshIds.push_back(meshId);
 }
 
 
-void Application::CalculateStatisticsForLevelResources(const std::vector<FRenderData>& renderDataVector)
+void Application::RemoveInstance(u32 entityId)
 {
-  m_LevelStats = {};
-
-  m_LevelStats.bottomLevelStructsCount = m_BottomLevelAccelerationVector.size();
+  auto it = m_EntityInstanceIndices.find(entityId);
+  if (it == m_EntityInstanceIndices.end())
+  {
+    return;
+  }
 
-  for (const auto& renderData : renderDataVector)
+  // The last instance is moved into place of removed one, so its entity is pointed to the new index...
+  const u32 instanceIndex = it->second;
+  m_EntityInstanceIndices.erase(it);
+  const u32 movedIndex = m_TopLevelAS.RemoveInstance(instanceIndex);
+  if (movedIndex != UUNUSED)
   {
-    m_LevelStats.allVerticesCount += renderData.mesh.vertices.size();
-    m_LevelStats.allIndicesCount += renderData.mesh.indices.size();
+    m_InstanceEntityIds[instanceIndex] = m_InstanceEntityIds[movedIndex];
+    m_InstanceMeshIds[instanceIndex] = m_InstanceMeshIds[movedIndex];
+    m_EntityInstanceIndices[m_InstanceEntityIds[instanceIndex]] = instanceIndex;
   }
-  m_LevelStats.allTrianglesCount += m_LevelStats.allIndicesCount / 3;
+  m_InstanceEntityIds.pop_back();
+  m_InstanceMeshIds.pop_back();
 }
 
 
-void Application::DestroyLevelResources()
+void Application::UpdateLevelResources(const FRenderEntityChanges& changes)
 {
-  if (m_RenderContext.GetLogicalDevice()->IsValid())
+  if (changes.IsEmpty())
   {
-    m_RenderContext.GetLogicalDevice()->WaitIdle();
+    return;
   }
 
-  // Destroying bottom level acceleration structures...
-  for (vulkan::FBottomLevelAccelerationStructure& bottomAS : m_BottomLevelAccelerationVector)
+  m_Camera.ResetAccumulatedFrameCounter();
+
+  // Instances of removed entities are swapped out, structures of their meshes are kept for entities added later...
+  for (FEntity entity : changes.removed)
   {
-    bottomAS.Destroy();
+    RemoveInstance(entity.GetID());
   }
-  m_BottomLevelAccelerationVector.clear();
 
-  // Destroying top level acceleration structure...
-  m_TopLevelAS.Destroy();
+  // Only meshes, which have no structure yet, are converted and built, all other instances share existing ones...
+  const FTransformHierarchy& transforms = m_EntityRegistry.GetTransforms();
+  if (not changes.added.empty())
+  {
+    m_LevelAllocator.Reset();
+    std::pmr::vector<FRenderDataView> renderDataVector{ &m_LevelAllocator };
+    std::pmr::vector<u32> bottomLevelIndices{ &m_LevelAllocator };
+    bottomLevelIndices.reserve(changes.added.size());
+    for (FEntity entity : changes.added)
+    {
+      bottomLevelIndices.push_back(FindBottomLevelIndex(entity, entity.Get<FRenderMeshComponent>().id,
+                                                        renderDataVector));
+    }
+    BuildBottomLevelStructures(renderDataVector);
+    if (not renderDataVector.empty())
+    {
+      UploadBottomLevelReferences();
+    }
+
+    for (u32 i = 0; i < changes.added.size(); i++)
+    {
+      if (bottomLevelIndices[i] != UUNUSED)
+      {
+        FEntity entity = changes.added[i];
+        AddInstance(entity, entity.Get<FRenderMeshComponent>().id, bottomLevelIndices[i],
+                    transforms.GetWorldMatrix(entity.Get<FTransformComponent>().handle));
+      }
+    }
+  }
 
-  // Free blas reference uniform buffer...
-  m_BLASReferenceUniformBuffer.Free();
+  // Structure is created again only when instances do not fit into its capacity, old one is kept alive by deletion
+  // queue until frames in flight stopped using it. Changed count is built again in the next frame, not refitted...
+  if (m_TopLevelAS.ReserveInstances(m_DeletionQueue, m_SubmittedFramesCount))
+  {
+    MarkFrameDescriptorsOutdated();
+  }
+  m_LevelStats.instancesCount = m_TopLevelAS.GetInstancesCount();
+
+  // Instance records of modified entities are only patched...
+  for (FEntity entity : changes.modified)
+  {
+    auto it = m_EntityInstanceIndices.find(entity.GetID());
+    if (it == m_EntityInstanceIndices.end())
+    {
+      continue;
+    }
+    const u32 instanceIndex = it->second;
+    const FRenderMeshComponent& component = entity.Get<FRenderMeshComponent>();
+    const math::Matrix4x4f& worldMatrix = transforms.GetWorldMatrix(entity.Get<FTransformComponent>().handle);
+
+    if (component.id == m_InstanceMeshIds[instanceIndex])
+    {
+      m_TopLevelAS.SetInstanceTransform(instanceIndex, worldMatrix);
+      continue;
+    }
+
+    // Switched mesh is shared with other instances, so entity is only pointed to its bottom level structure.
+    // When the mesh has no structure in this level yet, only its structure is built and its blas reference is
+    // appended, all other structures and instances stay as they are...
+    m_LevelAllocator.Reset();
+    std::pmr::vector<FRenderDataView> renderDataVector{ &m_LevelAllocator };
+    const u32 bottomLevelIndex = FindBottomLevelIndex(entity, component.id, renderDataVector);
+    if (bottomLevelIndex == UUNUSED)
+    {
+      // Mesh without triangles cannot be traced, so entity has no instance anymore...
+      RemoveInstance(entity.GetID());
+      continue;
+    }
+    if (not renderDataVector.empty())
+    {
+      BuildBottomLevelStructures(renderDataVector);
+      UploadBottomLevelReferences();
+    }
+
+    m_TopLevelAS.SetInstance(instanceIndex, bottomLevelIndex, m_BottomLevelAccelerationStructures[bottomLevelIndex]);
+    m_TopLevelAS.SetInstanceTransform(instanceIndex, worldMatrix);
+    m_InstanceMeshIds[instanceIndex] = component.id;
+  }
+
+  // Nothing is waited for, refit (or build of changed count) is recorded before rays are traced in the next frame...
+  m_TopLevelUpdatePending = UTRUE;
+}
+
+
+void Application::DestroyLevelResources()
+{
+  DestroyAccelerationStructures();
 
   // Destroying ECS...
   m_EntityRegistry.Destroy();
 
   // Destroying asset system...
   m_AssetRegistry.Clear();
+  m_LevelAllocator.Reset();
+}
+
+
+void Application::DestroyAccelerationStructures()
+{
+  // Structures may be still traced by frames in flight, the last one of them signals submitted frames count...
+  const u64 lastUseValue = m_SubmittedFramesCount;
+
+  // Destroying bottom level acceleration structures...
+  for (vulkan::FBottomLevelAccelerationStructure& bottomAS : m_BottomLevelAccelerationStructures)
+  {
+    bottomAS.Destroy(m_DeletionQueue, lastUseValue);
+  }
+  m_BottomLevelAccelerationStructures.clear();
+
+  // Destroying top level acceleration structure...
+  m_TopLevelAS.Destroy(m_DeletionQueue, lastUseValue);
+
+  // Free blas reference uniform buffer, its upload may be still acquired by the next frame...
+  m_BLASReferenceUniformBuffer.Free(m_DeletionQueue, lastUseValue + 1);
+
+  m_EntityInstanceIndices.clear();
+  m_InstanceEntityIds.clear();
+  m_InstanceMeshIds.clear();
+  m_MeshBottomLevelIndices.clear();
+  m_PendingOwnershipBuffers.clear();
 }
 
 
@@ -552,6 +1021,9 @@ void Application::DestroyEngineResources()
     m_RenderContext.GetLogicalDevice()->WaitIdle();
   }
 
+  // Nothing is in flight anymore, so retired resources are destroyed before device...
+  m_DeletionQueue.Flush();
+
   // Closing imgui
   m_ImGuiRenderer.Destroy();
   m_DepthImage.Free();
@@ -559,25 +1031,46 @@ void Application::DestroyEngineResources()
   // Closing render target images...
   m_OffscreenImage.Free();
 
+  m_UploadManager.Destroy();
+
   // Closing command buffers...
   for (vulkan::FCommandBuffer& cmdBuf : m_CommandBuffers)
   {
     cmdBuf.Free();
   }
   m_CommandBuffers.clear();
+  for (vulkan::FCommandBuffer& cmdBuf : m_ComputeCommandBuffers)
+  {
+    cmdBuf.Free();
+  }
+  m_ComputeCommandBuffers.clear();
+  for (vulkan::FSemaphore& semaphore : m_ImageAvailableSemaphores)
+  {
+    semaphore.Destroy();
+  }
+  m_FrameTimeline.Destroy();
+  m_ComputeTimeline.Destroy();
 
   // Closing Command Pools...
+  m_ComputeCommandPool.Destroy();
   m_CommandPool.Destroy();
 
   // Destroying descriptors...
   m_RayTracingDescriptorSetLayout.Destroy();
-  m_RayTracingDescriptorPool.Destroy();
+  for (vulkan::FDescriptorPool& descriptorPool : m_RayTracingDescriptorPools)
+  {
+    descriptorPool.Destroy();
+  }
 
   m_SceneDescriptorSetLayout.Destroy();
-  m_SceneDescriptorPool.Destroy();
+  for (vulkan::FDescriptorPool& descriptorPool : m_SceneDescriptorPools)
+  {
+    descriptorPool.Destroy();
+  }
 
   // Freeing buffers...
   m_CameraUniformBuffer.Free();
+  m_pCameraUniformData = nullptr;
 
   // Destroying pipelines...
   m_RayTracingPipelineLayout.Destroy();
@@ -585,6 +1078,7 @@ void Application::DestroyEngineResources()
   {
     rtxPipeline.Destroy();
   }
+  m_PipelineCache.Destroy();
 
   // Closing renderer...
   m_Swapchain.Destroy();
@@ -593,14 +1087,16 @@ void Application::DestroyEngineResources()
   // Destroying window...
   m_Window->Destroy();
 
+  // Closing systems and job system...
+  m_Systems.Clear();
+  m_JobSystem.Destroy();
+
   // imgui.ini causes app a crash, that is why I decided to delete at the end :/
   DeleteImGuiIni();
 }
 
-void Application::RecordRayTracingCommands()
+void Application::RecordRayTracingCommands(u32 frameIndex, u32 imageIndex)
 {
-  m_CommandPool.Reset();
-
   VkExtent3D offscreenExtent = m_OffscreenImage.GetExtent3D();
   VkImage offscreenImage = m_OffscreenImage.GetHandle();
 
@@ -618,45 +1114,92 @@ void Application::RecordRayTracingCommands()
       .layerCount = 1
   };
 
-  std::span<const VkImage> swapchainImages = m_Swapchain.GetImages();
+  VkImage swapchainImage = m_Swapchain.GetImages()[imageIndex];
   VkExtent2D swapchainExtent = m_Swapchain.GetCurrentExtent();
-  VkDescriptorSet descriptorSets[]{ m_RayTracingDescriptorPool.GetDescriptorSet(),
-                                    m_SceneDescriptorPool.GetDescriptorSet() };
+  UpdateFrameDescriptors(frameIndex);
+  VkDescriptorSet descriptorSets[]{ m_RayTracingDescriptorPools[frameIndex].GetDescriptorSet(),
+                                    m_SceneDescriptorPools[frameIndex].GetDescriptorSet() };
+  const u32 dynamicOffsets[]{ static_cast<u32>(frameIndex * m_CameraUniformStride) };
   vulkan::FRayTracingPipeline& rtxPipeline = m_RayTracingPipelines[m_SelectedRtxPipeline];
 
-  for (u32 i = 0; i < swapchainImages.size(); i++)
-  {
-    vulkan::FCommandBuffer& cmdBuf = m_CommandBuffers[i];
-    VkImage swapchainImage = swapchainImages[i];
-
-    cmdBuf.BeginRecording();
-    cmdBuf.ImageMemoryBarrier(offscreenImage,
-                              VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
-                              VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
-                              subresourceRange,
-                              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-    cmdBuf.BindPipeline(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rtxPipeline.GetHandle());
-    cmdBuf.BindDescriptorSets(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_RayTracingPipelineLayout.GetHandle(),
-                              descriptorSets);
-    cmdBuf.TraceRays(&rtxPipeline, offscreenExtent);
-    cmdBuf.ImageMemoryBarrier(offscreenImage,
-                              VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
-                              VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                              subresourceRange,
-                              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-    cmdBuf.ImageMemoryBarrier(swapchainImage,
-                              VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
-                              VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                              subresourceRange,
-                              VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-    cmdBuf.CopyImage(offscreenImage, swapchainImage, subresourceLayers, swapchainExtent);
-    cmdBuf.ImageMemoryBarrier(swapchainImage,
-                              VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT,
-                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                              subresourceRange,
-                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
-    cmdBuf.EndRecording();
+  // Command buffer of frame index is not executed anymore, so it is recorded again with current state...
+  vulkan::FCommandBuffer& cmdBuf = m_CommandBuffers[frameIndex];
+  cmdBuf.BeginOneTimeRecording();
+  RecordOwnershipTransfers(cmdBuf, frameIndex);
+  if (m_TopLevelUpdatePending)
+  {
+    m_TopLevelAS.RecordUpdateInstances(cmdBuf, frameIndex);
+    m_TopLevelUpdatePending = UFALSE;
   }
+  cmdBuf.ImageMemoryBarrier(offscreenImage,
+                            VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                            subresourceRange,
+                            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  cmdBuf.BindPipeline(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rtxPipeline.GetHandle());
+  cmdBuf.BindDescriptorSets(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_RayTracingPipelineLayout.GetHandle(),
+                            descriptorSets, dynamicOffsets);
+  cmdBuf.TraceRays(&rtxPipeline, offscreenExtent);
+  cmdBuf.ImageMemoryBarrier(offscreenImage,
+                            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            subresourceRange,
+                            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  cmdBuf.ImageMemoryBarrier(swapchainImage,
+                            VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            subresourceRange,
+                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+  cmdBuf.CopyImage(offscreenImage, swapchainImage, subresourceLayers, swapchainExtent);
+  cmdBuf.ImageMemoryBarrier(swapchainImage,
+                            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                            subresourceRange,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+  cmdBuf.EndRecording();
+}
+
+
+void Application::RecordOwnershipTransfers(vulkan::FCommandBuffer& commandBuffer, u32 frameIndex)
+{
+  const vulkan::FLogicalDevice* pLogicalDevice = m_RenderContext.GetLogicalDevice();
+  const VkPipelineStageFlags acquireStageFlags = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+
+  // Buffers uploaded for graphics queue on dedicated transfer queue (blas references)...
+  const u64 uploadIndex = m_UploadManager.RecordAcquireBarriers(commandBuffer, pLogicalDevice->GetGraphicsFamilyIndex(),
+                                                                VK_ACCESS_SHADER_READ_BIT, acquireStageFlags);
+  m_UploadWaitValue = std::max(m_UploadWaitValue, uploadIndex);
+
+  if (m_PendingOwnershipBuffers.empty())
+  {
+    return;
+  }
+
+  // Compute command buffer of frame index was waited for by graphics submit of that frame, which is finished...
+  const VkAccessFlags accessFlags = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR |
+                                    VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_SHADER_READ_BIT |
+                                    VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  const VkPipelineStageFlags stageFlags = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT;
+  vulkan::FCommandBuffer& computeCommandBuffer = m_ComputeCommandBuffers[frameIndex];
+  computeCommandBuffer.BeginOneTimeRecording();
+  computeCommandBuffer.BufferOwnershipBarrier(m_PendingOwnershipBuffers, accessFlags, 0, stageFlags,
+                                              VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                              pLogicalDevice->GetComputeFamilyIndex(),
+                                              pLogicalDevice->GetGraphicsFamilyIndex());
+  computeCommandBuffer.EndRecording();
+  m_ComputeWaitValue = m_SubmittedFramesCount + 1;
+  VkSemaphore signalSemaphores[]{ m_ComputeTimeline.GetHandle() };
+  const u64 signalValues[]{ m_ComputeWaitValue };
+  pLogicalDevice->GetComputeQueue().Submit({}, {}, {}, computeCommandBuffer, signalSemaphores, signalValues,
+                                           VK_NULL_HANDLE);
+
+  // Acquire starts at the same stages, which semaphore wait of frame submit blocks...
+  commandBuffer.BufferOwnershipBarrier(m_PendingOwnershipBuffers, 0, accessFlags, acquireStageFlags,
+                                       stageFlags | acquireStageFlags, pLogicalDevice->GetComputeFamilyIndex(),
+                                       pLogicalDevice->GetGraphicsFamilyIndex());
+  m_PendingOwnershipBuffers.clear();
 }
 
 
@@ -13,22 +13,34 @@
 #include "UTools/EntityComponentSystem/EntityRegistryLoader.h"
 #include "UTools/EntityComponentSystem/EntityRegistry.h"
 #include "UTools/EntityComponentSystem/Entity.h"
+#include "UTools/EntityComponentSystem/SystemScheduler.h"
+#include "UTools/JobSystem/JobSystem.h"
+#include "UTools/Memory/LinearAllocator.h"
 #include "UGraphicsEngine/Renderer/Vulkan/RenderContext.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/GlslShaderCompiler.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/Swapchain.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/PipelineLayout.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Device/PipelineCache.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/RayTracingPipeline.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Descriptors/DescriptorSetLayout.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Descriptors/DescriptorPool.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Image.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/AccelerationStructureBuilder.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/AccelerationStructureCache.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/DeletionQueue.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/TopLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Fence.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Semaphore.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Synchronization/TimelineSemaphore.h"
 #include "UGraphicsEngine/Renderer/Vulkan/ImGui/ImGuiRenderer.h"
 #include "UGraphicsEngine/Renderer/PerspectiveCamera.h"
 #include "UGraphicsEngine/Renderer/RenderMesh.h"
 #include "UGraphicsEngine/Renderer/Light.h"
+#include <deque>
+#include <unordered_map>
 
 
 using namespace uncanny;
@@ -48,63 +60,132 @@ public:
 private:
 
   void CreateEngineResources();
+  void RegisterSystems();
 
   void CreateLevelResources(const FPath& scenePath);
+  void UpdateLevelResources(const FRenderEntityChanges& changes);
   void DestroyLevelResources();
 
+  void BuildAccelerationStructures();
+  void DestroyAccelerationStructures();
+
+  /// @returns index of bottom level structure of mesh, mesh without structure is converted into renderDataVector
+  /// and gets index after already built structures, UUNUSED when mesh has no triangles
+  u32 FindBottomLevelIndex(FEntity entity, u64 meshId, std::pmr::vector<FRenderDataView>& renderDataVector);
+
+  /// @brief Appends and builds bottom level structures of given meshes only, already built ones are kept
+  void BuildBottomLevelStructures(std::span<const FRenderDataView> renderDataVector);
+
+  /// @brief Uploads all BLAS reference entries into new buffer, old one is handed over to deletion queue
+  void UploadBottomLevelReferences();
+
+  void AddInstance(FEntity entity, u64 meshId, u32 bottomLevelIndex, const math::Matrix4x4f& worldMatrix);
+  void RemoveInstance(u32 entityId);
+
   void DestroyEngineResources();
 
-  void RecordRayTracingCommands();
+  void RecordRayTracingCommands(u32 frameIndex, u32 imageIndex);
+
+  /// @brief Releases pending bottom level structures on compute queue and records their acquire, together with
+  /// acquire of buffers uploaded for graphics queue, into frame command buffer. Nothing is waited for on host, frame
+  /// submit waits for release submits on device.
+  void RecordOwnershipTransfers(vulkan::FCommandBuffer& commandBuffer, u32 frameIndex);
+
+  /// @brief Recreates swapchain and resources sized by it, old ones are handed over to deletion queue
+  void RecreateSwapchainResources();
+
+  /// @brief Writes replaced resources into descriptor sets of given frame, only sets of frame, which is not in flight,
+  /// may be updated
+  void UpdateFrameDescriptors(u32 frameIndex);
+  void MarkFrameDescriptorsOutdated();
 
   void DrawImGui();
 
   void DeleteImGuiIni();
 
-  void CalculateStatisticsForLevelResources(const std::vector<FRenderData>& renderDataVector);
-
 private:
 
+  /// Count of frames recorded by CPU while previous ones are still executed by GPU, it is independent of count of
+  /// swapchain images
+  static constexpr u32 g_FramesInFlightCount{ 2 };
+
   // Engine Resources that are initialized once and then reused...
 
   std::shared_ptr<IWindow> m_Window;
+  FJobSystem m_JobSystem{};
+  FSystemScheduler m_Systems{};
   vulkan::FRenderContext m_RenderContext{};
   vulkan::FSwapchain m_Swapchain{};
 
   vulkan::FCommandPool m_CommandPool{};
+  vulkan::FCommandPool m_ComputeCommandPool{};
   std::vector<vulkan::FCommandBuffer> m_CommandBuffers{};
+  std::vector<vulkan::FCommandBuffer> m_ComputeCommandBuffers{};
+
+  // Frame pacing, frame with number n signals value n + 1 of timeline, so that reused frame index waits for the frame
+  // submitted g_FramesInFlightCount frames earlier...
+  vulkan::FTimelineSemaphore m_FrameTimeline{};
+  vulkan::FSemaphore m_ImageAvailableSemaphores[g_FramesInFlightCount]{};
+  u64 m_SubmittedFramesCount{ 0 };
+  u32 m_FrameIndex{ 0 };
+  // Ownership of resources is passed between queues on device, graphics submit of frame waits for the last release
+  // on compute queue (frame with number n signals value n + 1) and for the last upload acquired by its commands...
+  vulkan::FTimelineSemaphore m_ComputeTimeline{};
+  u64 m_ComputeWaitValue{ 0 };
+  u64 m_UploadWaitValue{ 0 };
+  // Replaced resources are destroyed when timeline passes the last frame using them, so that nothing drains device...
+  vulkan::FDeletionQueue m_DeletionQueue{};
 
   FPerspectiveCamera m_Camera{};
+  // One persistently mapped buffer with region per frame in flight, bound with dynamic offset...
   vulkan::FBuffer m_CameraUniformBuffer{};
+  std::byte* m_pCameraUniformData{ nullptr };
+  VkDeviceSize m_CameraUniformStride{ 0 };
 
   vulkan::FImage m_OffscreenImage{};
 
+  // Descriptor sets are created per frame in flight, as sets used by pending frames must not be updated...
   vulkan::FDescriptorSetLayout m_SceneDescriptorSetLayout{};
-  vulkan::FDescriptorPool m_SceneDescriptorPool{};
-  std::function<void(VkBuffer)> m_WriteBlasReferenceUniformToDescriptorSet{};
+  vulkan::FDescriptorPool m_SceneDescriptorPools[g_FramesInFlightCount]{};
+  std::function<void(u32, VkBuffer)> m_WriteBlasReferenceUniformToDescriptorSet{};
 
   vulkan::FDescriptorSetLayout m_RayTracingDescriptorSetLayout{};
-  vulkan::FDescriptorPool m_RayTracingDescriptorPool{};
-  std::function<void(VkImageView)> m_WriteOffscreenImageToDescriptorSet{};
-  std::function<void(VkAccelerationStructureKHR)> m_WriteTlasToDescriptorSet{};
+  vulkan::FDescriptorPool m_RayTracingDescriptorPools[g_FramesInFlightCount]{};
+  std::function<void(u32, VkImageView)> m_WriteOffscreenImageToDescriptorSet{};
+  std::function<void(u32, VkAccelerationStructureKHR)> m_WriteTlasToDescriptorSet{};
+  b8 m_FrameDescriptorsOutdated[g_FramesInFlightCount]{};
 
   vulkan::FPipelineLayout m_RayTracingPipelineLayout{};
   std::vector<vulkan::FRayTracingPipeline> m_RayTracingPipelines{};
   std::vector<const char*> m_RayTracingPipelinesCstr{};
+  // Compiled pipelines are kept on disk, so that only the first (cold) startup compiles them...
+  vulkan::FPipelineCache m_PipelineCache{};
+  f64 m_PipelinesCreateTime{ 0.0 };
 
   vulkan::FImage m_DepthImage{};
   vulkan::FImGuiRenderer m_ImGuiRenderer{};
+  vulkan::FAccelerationStructureCache m_AccelerationStructureCache{};
+  vulkan::FUploadManager m_UploadManager{};
 
   std::vector<FPath> m_ScenePaths{};
   std::vector<const char*> m_ScenePathsCstr{};
 
   // Level Resources that can be reinitialized when scene is changed at runtime
 
-  std::vector<vulkan::FBottomLevelAccelerationStructure> m_BottomLevelAccelerationVector{};
+  // Structures are not movable, deque keeps already built ones in place when structures of new meshes are appended
+  std::deque<vulkan::FBottomLevelAccelerationStructure> m_BottomLevelAccelerationStructures{};
   vulkan::FTopLevelAccelerationStructure m_TopLevelAS{};
   vulkan::FBuffer m_BLASReferenceUniformBuffer{};
+  std::unordered_map<u32, u32> m_EntityInstanceIndices{};
+  std::vector<u32> m_InstanceEntityIds{};
+  std::vector<u64> m_InstanceMeshIds{};
+  /// Buffers of built bottom level structures, which are released by compute queue in the next recorded frame
+  std::vector<VkBuffer> m_PendingOwnershipBuffers{};
+  std::unordered_map<u64, u32> m_MeshBottomLevelIndices{};
 
   FAssetRegistry m_AssetRegistry{};
   FEntityRegistry m_EntityRegistry{};
+  FLinearAllocator m_LevelAllocator{ 16 * 1024 * 1024 };
 
   i32 m_SelectedScenePath{ 0 };
   b32 m_ShouldChangeScene{ UFALSE };
@@ -114,12 +195,25 @@ private:
 
   b32 m_SelectedAccumulatedColor{ UFALSE };
 
+  b32 m_BuildBottomLevelOnHost{ UFALSE };
+  b32 m_ShouldRebuildAccelerationStructures{ UFALSE };
+
+  // Moved instances are refitted in command buffer of the next recorded frame...
+  b32 m_TopLevelUpdatePending{ UFALSE };
+
   struct LevelStatistics
   {
     u32 bottomLevelStructsCount{ 0 };
+    u32 instancesCount{ 0 };
     u32 allTrianglesCount{ 0 };
     u32 allVerticesCount{ 0 };
     u32 allIndicesCount{ 0 };
+    u64 bottomLevelStructsMemory{ 0 };
+    u64 compactionSavedMemory{ 0 };
+    u32 cachedBottomLevelStructsCount{ 0 };
+    f64 bottomLevelStructsLoadTime{ 0.0 };
+    f64 uploadTime{ 0.0 };
+    vulkan::FUploadStatistics uploadStats{};
   };
 
   LevelStatistics m_LevelStats{};
@@ -11,6 +11,7 @@
 #include "UGraphicsEngine/Renderer/Vulkan/Descriptors/DescriptorSetLayout.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Descriptors/DescriptorPool.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/TopLevelAccelerationStructure.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Image.h"
@@ -123,7 +124,10 @@ private:
     // Creating acceleration structures...
     FRenderData triangleData = FRenderMeshFactory::CreateTriangle();
 
-    m_BottomLevelAS.Build(triangleData.mesh, triangleData.materials, m_CommandPool,
+    vulkan::FUploadManager uploadManager{};
+    uploadManager.Create(pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes(),
+                         &pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetGraphicsFamilyIndex());
+    m_BottomLevelAS.Build(triangleData.mesh, triangleData.materials, uploadManager, m_CommandPool,
                           pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetHandle(),
                           &pPhysicalDevice->GetAttributes());
 
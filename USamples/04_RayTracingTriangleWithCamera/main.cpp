@@ -18,6 +18,7 @@
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Image.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/TopLevelAccelerationStructure.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Semaphore.h"
 #include "UGraphicsEngine/Renderer/PerspectiveCamera.h"
@@ -147,7 +148,10 @@ private:
     // Creating acceleration structures...
     FRenderData triangleData = FRenderMeshFactory::CreateTriangle();
 
-    m_BottomLevelAS.Build(triangleData.mesh, triangleData.materials, m_CommandPool,
+    vulkan::FUploadManager uploadManager{};
+    uploadManager.Create(pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes(),
+                         &pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetGraphicsFamilyIndex());
+    m_BottomLevelAS.Build(triangleData.mesh, triangleData.materials, uploadManager, m_CommandPool,
                           pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetHandle(),
                           &pPhysicalDevice->GetAttributes());
 
@@ -18,6 +18,7 @@
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Image.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/TopLevelAccelerationStructure.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Semaphore.h"
 #include "UGraphicsEngine/Renderer/PerspectiveCamera.h"
@@ -167,7 +168,10 @@ private:
       FRenderData renderData = FRenderMeshFactory::ConvertAssetToOneRenderData(&meshAsset,
                                                                                renderMeshComponent.GetMatrix());
 
-      m_BottomLevelAS.Build(renderData.mesh, renderData.materials, m_CommandPool,
+      vulkan::FUploadManager uploadManager{};
+      uploadManager.Create(pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes(),
+                           &pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetGraphicsFamilyIndex());
+      m_BottomLevelAS.Build(renderData.mesh, renderData.materials, uploadManager, m_CommandPool,
                             pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetHandle(),
                             &pPhysicalDevice->GetAttributes());
     }
@@ -18,6 +18,8 @@
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Image.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/AccelerationStructureBuilder.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/TopLevelAccelerationStructure.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Semaphore.h"
 #include "UGraphicsEngine/Renderer/PerspectiveCamera.h"
@@ -195,14 +197,20 @@ private:
       renderDataVector.emplace_back(FRenderMeshFactory::ConvertAssetToOneRenderData(&meshAsset, component.GetMatrix()));
     });
 
-    // Creating acceleration structures...
+    // Creating acceleration structures, all meshes are uploaded at once and built in one batch...
+    vulkan::FUploadManager uploadManager{};
+    uploadManager.Create(pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes(),
+                         &pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetGraphicsFamilyIndex());
     m_BottomLevelAccelerationVector.reserve(renderDataVector.size());
     for (auto& data : renderDataVector)
     {
       auto& bottomAS = m_BottomLevelAccelerationVector.emplace_back();
-      bottomAS.Build(data.mesh, data.materials, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
-                     pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes());
+      bottomAS.Prepare(data.mesh, data.materials, uploadManager, pLogicalDevice->GetHandle(),
+                       &pPhysicalDevice->GetAttributes());
     }
+    uploadManager.Flush();
+    vulkan::FAccelerationStructureBuilder::Build(m_BottomLevelAccelerationVector, m_CommandPool,
+                                                 pLogicalDevice->GetGraphicsQueue(), pLogicalDevice);
     m_TopLevelAS.Build(m_BottomLevelAccelerationVector, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
                        pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes());
 
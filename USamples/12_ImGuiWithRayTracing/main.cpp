@@ -19,6 +19,8 @@
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Image.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/AccelerationStructureBuilder.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/TopLevelAccelerationStructure.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Semaphore.h"
 #include "UGraphicsEngine/Renderer/Vulkan/ImGui/ImGuiRenderer.h"
@@ -71,7 +73,7 @@ public:
         ImGui::End();
         ImGui::ShowDemoWindow();
       }
-      m_ImGuiRenderer.EndFrame(frameIndex, graphicsQueue, m_Swapchain.GetFramebuffers()[frameIndex]);
+      m_ImGuiRenderer.EndFrame(frameIndex, m_Swapchain.GetFramebuffers()[frameIndex]);
 
       {
         VkSemaphore waitSemaphores[]{ m_Swapchain.GetImageAvailableSemaphore().GetHandle() };
@@ -222,14 +224,20 @@ private:
       renderDataVector.emplace_back(FRenderMeshFactory::ConvertAssetToOneRenderData(&meshAsset, component.GetMatrix()));
     });
 
-    // Creating acceleration structures...
+    // Creating acceleration structures, all meshes are uploaded at once and built in one batch...
+    vulkan::FUploadManager uploadManager{};
+    uploadManager.Create(pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes(),
+                         &pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetGraphicsFamilyIndex());
     m_BottomLevelAccelerationVector.reserve(renderDataVector.size());
     for (auto& data : renderDataVector)
     {
       auto& bottomAS = m_BottomLevelAccelerationVector.emplace_back();
-      bottomAS.Build(data.mesh, data.materials, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
-                     pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes());
+      bottomAS.Prepare(data.mesh, data.materials, uploadManager, pLogicalDevice->GetHandle(),
+                       &pPhysicalDevice->GetAttributes());
     }
+    uploadManager.Flush();
+    vulkan::FAccelerationStructureBuilder::Build(m_BottomLevelAccelerationVector, m_CommandPool,
+                                                 pLogicalDevice->GetGraphicsQueue(), pLogicalDevice);
     m_TopLevelAS.Build(m_BottomLevelAccelerationVector, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
                        pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes());
 
@@ -389,7 +397,7 @@ private:
         .pTransferQueue = &pLogicalDevice->GetGraphicsQueue(),
         .swapchainFormat = m_Swapchain.GetFormat(),
         .graphicsQueueFamilyIndex = pLogicalDevice->GetGraphicsFamilyIndex(),
-        .backBufferCount = m_Swapchain.GetBackBufferCount(),
+        .framesInFlightCount = m_Swapchain.GetBackBufferCount(),
         .targetVulkanVersion = m_RenderContext.GetInstance()->GetAttributes().GetFullVersion()
       };
 
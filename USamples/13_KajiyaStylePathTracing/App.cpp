@@ -1,5 +1,6 @@
 
 #include "App.h"
+#include <chrono>
 
 
 Application::Application()
@@ -28,6 +29,7 @@ void Application::Run() {
     f32 deltaTime = m_Window->GetDeltaTime();
 
     m_Camera.ProcessMovement(m_Window.get(), deltaTime);
+    m_EntityRegistry.GetTransforms().Update();
     {
       FPerspectiveCameraUniformData uniformData = m_Camera.GetUniformData();
       m_CameraUniformBuffer.Fill(&uniformData, sizeof(FPerspectiveCameraUniformData), 1);
@@ -41,7 +43,7 @@ void Application::Run() {
     m_ImGuiRenderer.BeginFrame(m_Swapchain.GetCurrentExtent(), m_Window->GetMouseButtonsPressed(),
                                m_Window->GetMousePosition());
     DrawImGui();
-    m_ImGuiRenderer.EndFrame(frameIndex, graphicsQueue, m_Swapchain.GetFramebuffers()[frameIndex]);
+    m_ImGuiRenderer.EndFrame(frameIndex, m_Swapchain.GetFramebuffers()[frameIndex]);
 
     {
       VkSemaphore waitSemaphores[]{ m_Swapchain.GetImageAvailableSemaphore().GetHandle() };
@@ -113,6 +115,8 @@ void Application::DrawImGui()
 
   u32 accumulatedFrames = m_Camera.GetAccumulatedFramesCounter();
   ImGui::Text("Accumulated Frames: %u", accumulatedFrames);
+  ImGui::Text("Pipelines created in %.2f ms (%s cache, %.1f KB)", m_PipelinesCreateTime,
+              m_PipelineCache.IsLoadedFromDisk() ? "warm" : "cold", (f64)m_PipelineCache.GetLoadedSize() / 1024.0);
 
   ImGui::Separator();
 
@@ -385,6 +389,11 @@ void Application::CreateEngineResources() {
     vulkan::FGLSLShaderCompiler glslCompiler{};
     glslCompiler.Initialize(m_RenderContext.GetInstance()->GetAttributes().GetFullVersion());
 
+    FPath pipelineCachePath = FPath::Append(FPath::GetEngineProjectPath(),
+                                            { "cache", "pipelines", "kajiya_path_tracing.bin" });
+    m_PipelineCache.Create(pipelineCachePath.GetStringPath(), pPhysicalDevice->GetAttributes(),
+                           pLogicalDevice->GetHandle());
+
     vulkan::FRayTracingPipelineSpecification rayTracingPipelineSpecification{
         .rayClosestHitPath = FPath::Append(shadersPath, "pt_closesthit.rchit.spv"),
         .rayGenerationPath = FPath::Append(shadersPath, "pt_raygeneration.rgen.spv"),
@@ -394,8 +403,10 @@ void Application::CreateEngineResources() {
         .pPipelineLayout = &m_RayTracingPipelineLayout,
         .pProperties = &pLogicalDevice->GetAttributes().GetRayTracingProperties(),
         .vkDevice = pLogicalDevice->GetHandle(),
-        .pPhysicalDeviceAttributes = &pPhysicalDevice->GetAttributes()
+        .pPhysicalDeviceAttributes = &pPhysicalDevice->GetAttributes(),
+        .vkPipelineCache = m_PipelineCache.GetHandle()
     };
+    const auto pipelinesStart = std::chrono::steady_clock::now();
     m_RayTracingPipelines.reserve(3);   // When there will be reallocation program will fail!
     {
       rayTracingPipelineSpecification.rayClosestHitPath = FPath::Append(shadersPath, "pt_closesthit.rchit.spv");
@@ -416,6 +427,8 @@ void Application::CreateEngineResources() {
       rtxPipeline.Create(rayTracingPipelineSpecification);
       m_RayTracingPipelinesCstr.emplace_back("Hit World Space Positions");
     }
+    const auto pipelinesEnd = std::chrono::steady_clock::now();
+    m_PipelinesCreateTime = std::chrono::duration<f64, std::milli>(pipelinesEnd - pipelinesStart).count();
   }
 
   // Creating imgui
@@ -437,11 +450,20 @@ void Application::CreateEngineResources() {
         .pTransferQueue = &pLogicalDevice->GetGraphicsQueue(),
         .swapchainFormat = m_Swapchain.GetFormat(),
         .graphicsQueueFamilyIndex = pLogicalDevice->GetGraphicsFamilyIndex(),
-        .backBufferCount = m_Swapchain.GetBackBufferCount(),
-        .targetVulkanVersion = m_RenderContext.GetInstance()->GetAttributes().GetFullVersion()
+        .framesInFlightCount = m_Swapchain.GetBackBufferCount(),
+        .targetVulkanVersion = m_RenderContext.GetInstance()->GetAttributes().GetFullVersion(),
+        .vkPipelineCache = m_PipelineCache.GetHandle()
     };
 
+    const auto imGuiStart = std::chrono::steady_clock::now();
     m_ImGuiRenderer.Create(imGuiRendererSpecification);
+    const auto imGuiEnd = std::chrono::steady_clock::now();
+    m_PipelinesCreateTime += std::chrono::duration<f64, std::milli>(imGuiEnd - imGuiStart).count();
+
+    // All pipelines are created, so cache is saved right away for the next (warm) startup...
+    m_PipelineCache.Save();
+    UINFO("Pipelines created in {} ms with {} pipeline cache", m_PipelinesCreateTime,
+          m_PipelineCache.IsLoadedFromDisk() ? "warm" : "cold");
 
     m_Swapchain.CreateViews();
     m_Swapchain.CreateFramebuffers(m_ImGuiRenderer.GetRenderPass(), m_DepthImage.GetHandleView());
@@ -476,20 +498,28 @@ void Application::CreateLevelResources(const FPath& scenePath)
   // Converting asset meshes and materials into render meshes and materials...
   std::vector<FRenderData> renderDataVector;
   renderDataVector.reserve(m_EntityRegistry.GetEntities().size());
-  m_EntityRegistry.ForEach<FRenderMeshComponent>([this, &renderDataVector](FRenderMeshComponent& component)
+  const FTransformHierarchy& transforms = m_EntityRegistry.GetTransforms();
+  m_EntityRegistry.ForEach<FRenderMeshComponent, FTransformComponent>(
+      [this, &renderDataVector, &transforms](FRenderMeshComponent& component, FTransformComponent& transform)
   {
     const FMeshAsset& meshAsset = m_AssetRegistry.GetMesh(component.id);
-    renderDataVector.emplace_back(FRenderMeshFactory::ConvertAssetToOneRenderData(&meshAsset, component.GetMatrix()));
+    renderDataVector.emplace_back(FRenderMeshFactory::ConvertAssetToOneRenderData(
+        &meshAsset, transforms.GetWorldMatrix(transform.handle)));
   });
 
-  // Creating acceleration structures...
+  // Creating acceleration structures, all meshes are uploaded at once and built in one batch...
+  vulkan::FUploadManager uploadManager{};
+  uploadManager.Create(pLogicalDevice->GetHandle(), &physicalDeviceAttributes,
+                       &pLogicalDevice->GetGraphicsQueue(), pLogicalDevice->GetGraphicsFamilyIndex());
   m_BottomLevelAccelerationVector.reserve(renderDataVector.size());
   for (auto& data : renderDataVector)
   {
     auto& bottomAS = m_BottomLevelAccelerationVector.emplace_back();
-    bottomAS.Build(data.mesh, data.materials, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
-                   pLogicalDevice->GetHandle(), &physicalDeviceAttributes);
+    bottomAS.Prepare(data.mesh, data.materials, uploadManager, pLogicalDevice->GetHandle(), &physicalDeviceAttributes);
   }
+  uploadManager.Flush();
+  vulkan::FAccelerationStructureBuilder::Build(m_BottomLevelAccelerationVector, m_CommandPool,
+                                               pLogicalDevice->GetGraphicsQueue(), pLogicalDevice);
   m_TopLevelAS.Build(m_BottomLevelAccelerationVector, m_CommandPool, pLogicalDevice->GetGraphicsQueue(),
                      pLogicalDevice->GetHandle(), &physicalDeviceAttributes);
   m_WriteTlasToDescriptorSet(m_TopLevelAS.GetHandle());
@@ -579,6 +609,7 @@ void Application::DestroyEngineResources()
   {
     rtxPipeline.Destroy();
   }
+  m_PipelineCache.Destroy();
 
   // Closing renderer...
   m_Swapchain.Destroy();
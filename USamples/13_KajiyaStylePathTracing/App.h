@@ -17,12 +17,15 @@
 #include "UGraphicsEngine/Renderer/Vulkan/Device/GlslShaderCompiler.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/Swapchain.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/PipelineLayout.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Device/PipelineCache.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Device/RayTracingPipeline.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Descriptors/DescriptorSetLayout.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Descriptors/DescriptorPool.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Buffer.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/Image.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/AccelerationStructureBuilder.h"
+#include "UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Resources/TopLevelAccelerationStructure.h"
 #include "UGraphicsEngine/Renderer/Vulkan/Synchronization/Semaphore.h"
 #include "UGraphicsEngine/Renderer/Vulkan/ImGui/ImGuiRenderer.h"
@@ -91,6 +94,9 @@ private:
   vulkan::FPipelineLayout m_RayTracingPipelineLayout{};
   std::vector<vulkan::FRayTracingPipeline> m_RayTracingPipelines{};
   std::vector<const char*> m_RayTracingPipelinesCstr{};
+  // Compiled pipelines are kept on disk, so that only the first (cold) startup compiles them...
+  vulkan::FPipelineCache m_PipelineCache{};
+  f64 m_PipelinesCreateTime{ 0.0 };
 
   vulkan::FImage m_DepthImage{};
   vulkan::FImGuiRenderer m_ImGuiRenderer{};
@@ -0,0 +1,109 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/Assets/MeshStreamLoader.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+
+using namespace uncanny;
+
+
+/// @brief Benchmark of out-of-core .obj import. Synthetic grid mesh of requested size (in MB, the first argument,
+/// 3 GB by default) is generated and then streamed with bounded memory three ways: straight to consumer, into
+/// paged file and back from paged file. Peak memory of every import is compared with memory budget.
+class Application {
+public:
+
+  explicit Application(u64 objSizeInMegabytes)
+    : m_ObjSizeInBytes(objSizeInMegabytes * 1024 * 1024)
+  {
+    FLog::create();
+  }
+
+  void Run() {
+    std::filesystem::create_directories(std::filesystem::path(m_ObjPath).parent_path());
+
+    // Generating synthetic input...
+    {
+      const auto start = std::chrono::steady_clock::now();
+      if (not FMeshStreamLoader::GenerateSyntheticObj(m_ObjPath, m_ObjSizeInBytes))
+      {
+        UERROR("Cannot generate synthetic obj {}", m_ObjPath);
+        return;
+      }
+      const f64 time = ElapsedMilliseconds(start);
+      UINFO("Generated {} ({:.2f} MB) in {:.1f} ms", m_ObjPath, ToMegabytes(std::filesystem::file_size(m_ObjPath)),
+            time);
+    }
+
+    // Streaming straight to consumer, consumer only touches pages so that nothing is optimized away...
+    {
+      u64 checksum{ 0 };
+      const auto start = std::chrono::steady_clock::now();
+      const FMeshStreamStatistics statistics = FMeshStreamLoader::LoadObj(m_ObjPath, m_Specification,
+                                                                          [&checksum](const FMeshAssetPage& page)
+      {
+        checksum += page.vertices.size() + page.indices.size();
+      });
+      PrintStatistics("LoadObj", statistics, ElapsedMilliseconds(start));
+      UINFO("LoadObj checksum {}", checksum);
+    }
+
+    // Streaming into paged file and reading it back...
+    {
+      const auto start = std::chrono::steady_clock::now();
+      const FMeshStreamStatistics statistics = FMeshStreamLoader::LoadObjToPagedFile(m_ObjPath, m_PagedFilePath,
+                                                                                     m_Specification);
+      PrintStatistics("LoadObjToPagedFile", statistics, ElapsedMilliseconds(start));
+    }
+    {
+      u64 checksum{ 0 };
+      const auto start = std::chrono::steady_clock::now();
+      const FMeshStreamStatistics statistics = FMeshStreamLoader::ReadPagedFile(m_PagedFilePath,
+                                                                                [&checksum](const FMeshAssetPage& page)
+      {
+        checksum += page.vertices.size() + page.indices.size();
+      });
+      PrintStatistics("ReadPagedFile", statistics, ElapsedMilliseconds(start));
+      UINFO("ReadPagedFile checksum {}", checksum);
+    }
+
+    std::filesystem::remove(m_ObjPath);
+    std::filesystem::remove(m_PagedFilePath);
+  }
+
+private:
+
+  void PrintStatistics(const char* name, const FMeshStreamStatistics& statistics, f64 time) const
+  {
+    UINFO("{}: {} vertices, {} indices, {} pages, {:.1f} ms, {:.1f} MB/s, peak memory {:.2f} MB (budget {:.2f} MB)",
+          name, statistics.verticesCount, statistics.indicesCount, statistics.pagesCount, time,
+          ToMegabytes(statistics.bytesRead) / (time / 1000.0), ToMegabytes(statistics.peakMemoryInBytes),
+          ToMegabytes(m_Specification.memoryBudgetInBytes));
+  }
+
+  static f64 ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  static f64 ToMegabytes(u64 bytes)
+  {
+    return (f64)bytes / (1024.0 * 1024.0);
+  }
+
+private:
+
+  const char* m_ObjPath{ "cache/benchmarks/synthetic.obj" };
+  const char* m_PagedFilePath{ "cache/benchmarks/synthetic.upaged" };
+  FMeshStreamSpecification m_Specification{ .memoryBudgetInBytes = 32ull * 1024 * 1024 };
+  u64 m_ObjSizeInBytes{ 0 };
+
+};
+
+
+int main(int argc, char** argv) {
+  Application app{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 3072 };
+  app.Run();
+
+  return 0;
+}
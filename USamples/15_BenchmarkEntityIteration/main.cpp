@@ -0,0 +1,129 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/EntityComponentSystem/EntityRegistry.h>
+#include <UTools/JobSystem/JobSystem.h>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+using namespace uncanny;
+
+
+struct FPositionComponent : public FEntityComponent
+{
+  math::Vector3f value{};
+};
+
+
+struct FVelocityComponent : public FEntityComponent
+{
+  math::Vector3f value{};
+};
+
+
+/// @brief Benchmark of entity iteration. Entities count (the first argument, 1M by default) get position and
+/// velocity and every entity integrates its position, once through type erased std::function, once through
+/// template ForEach() and once through ParallelForEach() on job system threads.
+class Application {
+public:
+
+  explicit Application(u32 entitiesCount)
+    : m_EntitiesCount(entitiesCount)
+  {
+    FLog::create();
+    m_JobSystem.Create();
+    m_EntityRegistry.Create();
+
+    const FEntityBatch batch = m_EntityRegistry.RegisterBatch(m_EntitiesCount);
+    batch.Add(FPositionComponent{});
+    batch.Add(FVelocityComponent{ .value = { 1.f, 2.f, 3.f } });
+  }
+
+  ~Application() {
+    m_EntityRegistry.Destroy();
+    m_JobSystem.Destroy();
+  }
+
+  void Run() {
+    UINFO("Iterating {} entities, {} job system threads", m_EntitiesCount, m_JobSystem.GetThreadsCount());
+
+    Measure("ForEach std::function", [this]()
+    {
+      std::function<void(FPositionComponent&, FVelocityComponent&)> func =
+          [](FPositionComponent& position, FVelocityComponent& velocity)
+      {
+        position.value = position.value + velocity.value * g_DeltaTime;
+      };
+      m_EntityRegistry.ForEach<FPositionComponent, FVelocityComponent>(func);
+    });
+
+    Measure("ForEach template", [this]()
+    {
+      m_EntityRegistry.ForEach<FPositionComponent, FVelocityComponent>(
+          [](FPositionComponent& position, FVelocityComponent& velocity)
+      {
+        position.value = position.value + velocity.value * g_DeltaTime;
+      });
+    });
+
+    Measure("ParallelForEach", [this]()
+    {
+      m_EntityRegistry.ParallelForEach<FPositionComponent, FVelocityComponent>(&m_JobSystem,
+          [](FPositionComponent& position, FVelocityComponent& velocity)
+      {
+        position.value = position.value + velocity.value * g_DeltaTime;
+      });
+    });
+
+    // Positions are read back, so that no iteration can be optimized away...
+    f64 checksum{ 0.0 };
+    m_EntityRegistry.ForEach<FPositionComponent>([&checksum](FPositionComponent& position)
+    {
+      checksum += position.value.x;
+    });
+    UINFO("Checksum {}", checksum);
+  }
+
+private:
+
+  template<typename TFunc>
+  void Measure(const char* name, TFunc&& func)
+  {
+    constexpr u32 warmUpCount{ 3 };
+    constexpr u32 iterationsCount{ 20 };
+    for (u32 i = 0; i < warmUpCount; i++)
+    {
+      func();
+    }
+
+    f64 best{ std::numeric_limits<f64>::max() };
+    f64 sum{ 0.0 };
+    for (u32 i = 0; i < iterationsCount; i++)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      func();
+      const f64 time = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+      best = std::min(best, time);
+      sum += time;
+    }
+    UINFO("{}: best {:.3f} ms, average {:.3f} ms, {:.2f} ns per entity", name, best, sum / iterationsCount,
+          best * 1000000.0 / m_EntitiesCount);
+  }
+
+private:
+
+  static constexpr f32 g_DeltaTime{ 0.016f };
+
+  FJobSystem m_JobSystem{};
+  FEntityRegistry m_EntityRegistry{};
+  u32 m_EntitiesCount{ 0 };
+
+};
+
+
+int main(int argc, char** argv) {
+  Application app{ argc > 1 ? (u32)std::strtoul(argv[1], nullptr, 10) : 1000000 };
+  app.Run();
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/EntityComponentSystem/EntityRegistry.h>
+#include <UTools/EntityComponentSystem/EntityRegistryLoader.h>
+#include <UTools/EntityComponentSystem/SceneSerializer.h>
+#include <UTools/Assets/AssetRegistry.h>
+#include <UTools/Filesystem/Path.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+
+using namespace uncanny;
+
+
+/// @brief Benchmark of json scene loading. Scene with entities count (the first argument, 100k by default) is
+/// generated and read three ways: with json DOM indexed per entity (the way scene loader used to read it), with
+/// single-pass SAX reader and with complete LoadScene(). Previous loader also loaded mesh for every entity, its
+/// cost is estimated from single mesh load.
+class Application {
+public:
+
+  explicit Application(u32 entitiesCount)
+    : m_EntitiesCount(entitiesCount)
+  {
+    FLog::create();
+  }
+
+  void Run() {
+    const std::initializer_list<const char*> meshPath{ "resources", "CornellBox", "CornellBox-Sphere.obj" };
+    std::filesystem::create_directories(std::filesystem::path(m_ScenePath).parent_path());
+
+    {
+      const auto start = std::chrono::steady_clock::now();
+      if (not FEntityRegistryLoader::GenerateJsonScene(m_ScenePath, m_EntitiesCount, meshPath))
+      {
+        UERROR("Cannot generate json scene {}", m_ScenePath);
+        return;
+      }
+      UINFO("Generated {} with {} entities ({:.2f} MB) in {:.1f} ms", m_ScenePath, m_EntitiesCount,
+            (f64)std::filesystem::file_size(m_ScenePath) / (1024.0 * 1024.0), ElapsedMilliseconds(start));
+    }
+
+    f64 domTime{ 0.0 };
+    {
+      FSceneDescription scene{};
+      const auto start = std::chrono::steady_clock::now();
+      ReadJsonDom(m_ScenePath, &scene);
+      domTime = ElapsedMilliseconds(start);
+      UINFO("Json DOM: {:.1f} ms, {} entities", domTime, scene.GetEntitiesCount());
+    }
+
+    f64 saxTime{ 0.0 };
+    {
+      FSceneDescription scene{};
+      const auto start = std::chrono::steady_clock::now();
+      if (not FSceneSerializer::ReadJson(m_ScenePath, &scene))
+      {
+        UERROR("Cannot read json scene {}", m_ScenePath);
+        return;
+      }
+      saxTime = ElapsedMilliseconds(start);
+      UINFO("Json SAX: {:.1f} ms, {} entities, {:.1f}x faster than DOM", saxTime, scene.GetEntitiesCount(),
+            domTime / saxTime);
+    }
+
+    f64 meshTime{ 0.0 };
+    {
+      const FPath meshAssetPath = FPath::Append(FPath::GetEngineProjectPath(), meshPath);
+      FMeshAsset meshAsset{ 0 };
+      const auto start = std::chrono::steady_clock::now();
+      meshAsset.LoadObj(meshAssetPath.GetStringPath().c_str(), UFALSE);
+      meshTime = ElapsedMilliseconds(start);
+    }
+
+    {
+      FEntityRegistry entityRegistry{};
+      entityRegistry.Create();
+      FAssetRegistry assetRegistry{};
+      const auto start = std::chrono::steady_clock::now();
+      FEntityRegistryLoader::LoadScene(m_ScenePath, &entityRegistry, &assetRegistry);
+      const f64 loadTime = ElapsedMilliseconds(start);
+      const f64 previousLoadTime = domTime + meshTime * m_EntitiesCount;
+      UINFO("LoadScene: {:.1f} ms, {} meshes, previous loader estimate {:.1f} ms (mesh load {:.3f} ms per entity), "
+            "{:.1f}x faster", loadTime, assetRegistry.GetMeshesCount(), previousLoadTime, meshTime,
+            previousLoadTime / loadTime);
+      entityRegistry.Destroy();
+    }
+
+    std::filesystem::remove(m_ScenePath);
+  }
+
+private:
+
+  /// @brief Reads scene the way loader did before SAX reader, json DOM is indexed from root for every value
+  static void ReadJsonDom(const char* path, FSceneDescription* pScene)
+  {
+    std::ifstream jsonFileStream{ path };
+    nlohmann::json data = nlohmann::json::parse(jsonFileStream);
+
+    const FPath enginePath = FPath::GetEngineProjectPath();
+    const u32 entitiesCount = data["Scene"]["Entities"].size();
+    pScene->Reserve(entitiesCount);
+
+    for (u32 entityIdx = 0; entityIdx < entitiesCount; entityIdx++)
+    {
+      FPath meshAssetPath = enginePath;
+      const u32 pathPartsCount = data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["path"].size();
+      for (u32 pathIdx = 0; pathIdx < pathPartsCount; pathIdx++)
+      {
+        std::string pathPart = data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["path"][pathIdx];
+        meshAssetPath = FPath::Append(meshAssetPath, pathPart.c_str());
+      }
+
+      const u32 index = pScene->AddEntity();
+      pScene->positions[index] = ReadVector(data, entityIdx, "position");
+      pScene->rotations[index] = ReadVector(data, entityIdx, "rotation");
+      pScene->scales[index] = ReadVector(data, entityIdx, "scale");
+    }
+  }
+
+  static math::Vector3f ReadVector(nlohmann::json& data, u32 entityIdx, const char* name)
+  {
+    return math::Vector3f{
+        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"][name]["x"].get<float>(),
+        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"][name]["y"].get<float>(),
+        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"][name]["z"].get<float>()
+    };
+  }
+
+  static f64 ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+
+  const char* m_ScenePath{ "cache/benchmarks/generated_scene.json" };
+  u32 m_EntitiesCount{ 0 };
+
+};
+
+
+int main(int argc, char** argv) {
+  Application app{ argc > 1 ? (u32)std::strtoul(argv[1], nullptr, 10) : 100000 };
+  app.Run();
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/EntityComponentSystem/EntityRegistryLoader.h>
+#include <UTools/EntityComponentSystem/SceneSerializer.h>
+#include <UTools/Filesystem/Path.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <string>
+
+using namespace uncanny;
+
+
+/// @brief Benchmark of scene file formats. Every json scene from USceneSamples and generated scene with entities
+/// count (the first argument, 100k by default) is converted to binary .uscene file, both files are read and
+/// compared by size and reading time. Converted scene is also checked to read back the same as json scene.
+class Application {
+public:
+
+  explicit Application(u32 entitiesCount)
+    : m_EntitiesCount(entitiesCount)
+  {
+    FLog::create();
+  }
+
+  void Run() {
+    std::filesystem::create_directories(m_OutputDirectory);
+
+    std::vector<std::string> jsonPaths{};
+    const FPath sceneSamplesPath = FPath::Append(FPath::GetEngineProjectPath(), "USceneSamples");
+    for (const FPath& path : FPath::GetFilePathsInDirectory(sceneSamplesPath))
+    {
+      if (FPath::HasExtension(path, ".json"))
+      {
+        jsonPaths.push_back(path.GetStringPath());
+      }
+    }
+    std::sort(jsonPaths.begin(), jsonPaths.end());
+
+    const std::string generatedPath = std::string{ m_OutputDirectory } + "/generated_scene.json";
+    if (FEntityRegistryLoader::GenerateJsonScene(generatedPath.c_str(), m_EntitiesCount,
+                                                 { "resources", "CornellBox", "CornellBox-Sphere.obj" }))
+    {
+      jsonPaths.push_back(generatedPath);
+    }
+
+    for (const std::string& jsonPath : jsonPaths)
+    {
+      Compare(jsonPath);
+    }
+
+    std::filesystem::remove_all(m_OutputDirectory);
+  }
+
+private:
+
+  void Compare(const std::string& jsonPath) const
+  {
+    const std::string binaryPath = std::string{ m_OutputDirectory } + "/" +
+                                   std::filesystem::path(jsonPath).stem().string() + ".uscene";
+    if (not FEntityRegistryLoader::ConvertJsonToBinaryScene(jsonPath.c_str(), binaryPath.c_str()))
+    {
+      UERROR("Cannot convert {} to binary scene", jsonPath);
+      return;
+    }
+
+    FSceneDescription jsonScene{};
+    const f64 jsonTime = Measure([&jsonPath, &jsonScene]()
+    {
+      jsonScene = FSceneDescription{};
+      FSceneSerializer::ReadJson(jsonPath.c_str(), &jsonScene);
+    });
+
+    FSceneDescription binaryScene{};
+    const f64 binaryTime = Measure([&binaryPath, &binaryScene]()
+    {
+      binaryScene = FSceneDescription{};
+      FSceneSerializer::ReadBinary(binaryPath.c_str(), &binaryScene);
+    });
+
+    const u64 jsonSize = std::filesystem::file_size(jsonPath);
+    const u64 binarySize = std::filesystem::file_size(binaryPath);
+    UINFO("{}: {} entities, {} meshes, json {} bytes {:.3f} ms, uscene {} bytes {:.3f} ms, {:.1f}x smaller, "
+          "{:.1f}x faster, {}", std::filesystem::path(jsonPath).filename().string(), jsonScene.GetEntitiesCount(),
+          jsonScene.meshPaths.size(), jsonSize, jsonTime, binarySize, binaryTime, (f64)jsonSize / (f64)binarySize,
+          jsonTime / binaryTime, AreEqual(jsonScene, binaryScene) ? "lossless" : "NOT EQUAL");
+  }
+
+  /// @returns the best time of a few iterations in milliseconds
+  template<typename TFunc>
+  static f64 Measure(TFunc&& func)
+  {
+    constexpr u32 iterationsCount{ 10 };
+    f64 best{ std::numeric_limits<f64>::max() };
+    for (u32 i = 0; i < iterationsCount; i++)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      func();
+      best = std::min(best, std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+  }
+
+  static b32 AreEqual(const FSceneDescription& a, const FSceneDescription& b)
+  {
+    auto equalVectors = [](const std::vector<math::Vector3f>& x, const std::vector<math::Vector3f>& y)
+    {
+      return std::equal(x.begin(), x.end(), y.begin(), y.end(), [](math::Vector3f u, math::Vector3f v)
+      {
+        return u.x == v.x and u.y == v.y and u.z == v.z;
+      });
+    };
+    return a.meshPaths == b.meshPaths and a.meshIds == b.meshIds and a.entityMeshIndices == b.entityMeshIndices and
+           a.parents == b.parents and equalVectors(a.positions, b.positions) and
+           equalVectors(a.rotations, b.rotations) and equalVectors(a.scales, b.scales);
+  }
+
+private:
+
+  const char* m_OutputDirectory{ "cache/benchmarks/scenes" };
+  u32 m_EntitiesCount{ 0 };
+
+};
+
+
+int main(int argc, char** argv) {
+  Application app{ argc > 1 ? (u32)std::strtoul(argv[1], nullptr, 10) : 100000 };
+  app.Run();
+
+  return 0;
+}
@@ -0,0 +1,237 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/JobSystem/JobSystem.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace uncanny;
+
+
+/// @brief Benchmarks of job system. Microbenchmarks measure cost of spawning and executing empty jobs from worker,
+/// from thread outside of job system (through injection queue) and with dependencies, and how many jobs spawned
+/// by single worker are stolen by others. Scaling test runs the same ParallelFor workload with 1..N threads
+/// (N is the first argument, hardware threads by default) and reports speedup against single thread.
+class Application {
+public:
+
+  explicit Application(u32 maxThreadsCount)
+    : m_MaxThreadsCount(maxThreadsCount)
+  {
+    FLog::create();
+    m_Values.resize(g_ScalingValuesCount);
+    for (u32 i = 0; i < m_Values.size(); i++)
+    {
+      m_Values[i] = (f32)(i % 1000) * 0.5f;
+    }
+  }
+
+  void Run() {
+    {
+      FJobSystem jobSystem{};
+      jobSystem.Create(m_MaxThreadsCount - 1);
+      UINFO("Microbenchmarks with {} threads, {} jobs each", jobSystem.GetThreadsCount(), g_JobsCount);
+      MeasureSpawnFromWorker(jobSystem);
+      MeasureSpawnFromExternalThread(jobSystem);
+      MeasureSpawnWithDependency(jobSystem);
+      MeasureStealing(jobSystem);
+      jobSystem.Destroy();
+    }
+
+    UINFO("Scaling of ParallelFor over {} values", g_ScalingValuesCount);
+    f64 singleThreadTime{ 0.0 };
+    for (u32 threadsCount = 1; threadsCount <= m_MaxThreadsCount; threadsCount++)
+    {
+      FJobSystem jobSystem{};
+      jobSystem.Create(threadsCount - 1);
+      f64 checksum{ 0.0 };
+      const f64 time = Measure([this, &jobSystem, &checksum]()
+      {
+        checksum = RunScalingWorkload(jobSystem);
+      });
+      jobSystem.Destroy();
+
+      if (threadsCount == 1)
+      {
+        singleThreadTime = time;
+      }
+      const f64 speedup = singleThreadTime / time;
+      UINFO("{} threads: {:.3f} ms, speedup {:.2f}x, efficiency {:.0f}%, checksum {:.1f}", threadsCount, time,
+            speedup, 100.0 * speedup / threadsCount, checksum);
+    }
+  }
+
+private:
+
+  static void MeasureSpawnFromWorker(FJobSystem& jobSystem)
+  {
+    std::atomic<u32> executedCount{ 0 };
+    const f64 time = Measure([&jobSystem, &executedCount]()
+    {
+      FJobCounter counter{};
+      for (u32 i = 0; i < g_JobsCount; i++)
+      {
+        jobSystem.Spawn([&executedCount]()
+        {
+          executedCount.fetch_add(1, std::memory_order_relaxed);
+        }, &counter);
+      }
+      jobSystem.Wait(counter);
+    });
+    PrintJobsTime("Spawn from worker", time);
+  }
+
+  static void MeasureSpawnFromExternalThread(FJobSystem& jobSystem)
+  {
+    // External thread submits through injection queue, worker 0 waits on counter and helps meanwhile...
+    std::atomic<u32> executedCount{ 0 };
+    const f64 time = Measure([&jobSystem, &executedCount]()
+    {
+      FJobCounter counter{};
+      std::thread externalThread{ [&jobSystem, &executedCount, &counter]()
+      {
+        for (u32 i = 0; i < g_JobsCount; i++)
+        {
+          jobSystem.Spawn([&executedCount]()
+          {
+            executedCount.fetch_add(1, std::memory_order_relaxed);
+          }, &counter);
+        }
+      } };
+      externalThread.join();
+      jobSystem.Wait(counter);
+    });
+    PrintJobsTime("Spawn from external thread", time);
+  }
+
+  static void MeasureSpawnWithDependency(FJobSystem& jobSystem)
+  {
+    // Every job waits for one shared root job, so all of them are scheduled by the thread that finishes it...
+    std::atomic<u32> executedCount{ 0 };
+    const f64 time = Measure([&jobSystem, &executedCount]()
+    {
+      FJobCounter rootCounter{};
+      FJobCounter counter{};
+      std::atomic<b32> released{ UFALSE };
+      jobSystem.Spawn([&released]()
+      {
+        while (not released.load(std::memory_order_acquire))
+        {
+          std::this_thread::yield();
+        }
+      }, &rootCounter);
+      for (u32 i = 0; i < g_JobsCount; i++)
+      {
+        jobSystem.Spawn([&executedCount]()
+        {
+          executedCount.fetch_add(1, std::memory_order_relaxed);
+        }, &counter, rootCounter);
+      }
+      released.store(UTRUE, std::memory_order_release);
+      jobSystem.Wait(counter);
+    });
+    PrintJobsTime("Spawn with dependency", time);
+  }
+
+  static void MeasureStealing(FJobSystem& jobSystem)
+  {
+    // Worker 0 spawns all jobs into its own deque, every job executed on other thread was stolen...
+    std::vector<std::atomic<u32>> executedPerThread(jobSystem.GetThreadsCount());
+    const f64 time = Measure([&jobSystem, &executedPerThread]()
+    {
+      FJobCounter counter{};
+      for (u32 i = 0; i < g_JobsCount; i++)
+      {
+        jobSystem.Spawn([&jobSystem, &executedPerThread]()
+        {
+          // Some work, so that other threads have a chance to steal...
+          volatile f32 value{ 1.f };
+          for (u32 j = 0; j < 256; j++)
+          {
+            value = value * 1.0001f;
+          }
+          executedPerThread[jobSystem.GetCurrentThreadIndex()].fetch_add(1, std::memory_order_relaxed);
+        }, &counter);
+      }
+      jobSystem.Wait(counter);
+    });
+
+    u64 executedCount{ 0 };
+    for (const std::atomic<u32>& count : executedPerThread)
+    {
+      executedCount += count.load(std::memory_order_relaxed);
+    }
+    const u64 stolenCount = executedCount - executedPerThread[0].load(std::memory_order_relaxed);
+    PrintJobsTime("Stealing", time);
+    UINFO("Stealing: {:.1f}% of jobs executed by other threads", 100.0 * (f64)stolenCount / (f64)executedCount);
+  }
+
+  [[nodiscard]] f64 RunScalingWorkload(FJobSystem& jobSystem) const
+  {
+    std::vector<f64> partialSums(jobSystem.GetThreadsCount(), 0.0);
+    jobSystem.ParallelFor(m_Values.size(), [this, &jobSystem, &partialSums](u32 first, u32 last)
+    {
+      f64 sum{ 0.0 };
+      for (u32 i = first; i < last; i++)
+      {
+        sum += std::sqrt(m_Values[i]) * std::sin(m_Values[i]);
+      }
+      partialSums[jobSystem.GetCurrentThreadIndex()] += sum;
+    }, 4096);
+
+    f64 checksum{ 0.0 };
+    for (f64 sum : partialSums)
+    {
+      checksum += sum;
+    }
+    return checksum;
+  }
+
+  /// @returns the best time of a few iterations in milliseconds
+  template<typename TFunc>
+  static f64 Measure(TFunc&& func)
+  {
+    constexpr u32 warmUpCount{ 2 };
+    constexpr u32 iterationsCount{ 10 };
+    for (u32 i = 0; i < warmUpCount; i++)
+    {
+      func();
+    }
+
+    f64 best{ std::numeric_limits<f64>::max() };
+    for (u32 i = 0; i < iterationsCount; i++)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      func();
+      best = std::min(best, std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+  }
+
+  static void PrintJobsTime(const char* name, f64 time)
+  {
+    UINFO("{}: {:.3f} ms, {:.1f} ns per job", name, time, time * 1000000.0 / g_JobsCount);
+  }
+
+private:
+
+  static constexpr u32 g_JobsCount{ 100000 };
+  static constexpr u32 g_ScalingValuesCount{ 16 * 1024 * 1024 };
+
+  std::vector<f32> m_Values{};
+  u32 m_MaxThreadsCount{ 1 };
+
+};
+
+
+int main(int argc, char** argv) {
+  const u32 hardwareThreadsCount = std::max<u32>(1, std::thread::hardware_concurrency());
+  Application app{ std::max<u32>(1, argc > 1 ? (u32)std::strtoul(argv[1], nullptr, 10) : hardwareThreadsCount) };
+  app.Run();
+
+  return 0;
+}
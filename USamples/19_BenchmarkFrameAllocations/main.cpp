@@ -0,0 +1,152 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/EntityComponentSystem/EntityRegistry.h>
+#include <UTools/Assets/AssetRegistry.h>
+#include <UTools/Filesystem/Path.h>
+#include <UTools/Memory/LinearAllocator.h>
+#include <UGraphicsEngine/Renderer/RenderMesh.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+using namespace uncanny;
+
+
+// Every allocation of global operator new is counted, so that heap traffic of a frame is visible. Nothing on
+// measured path is over-aligned, so aligned operator new is left as it is...
+static std::atomic<u64> g_AllocationsCount{ 0 };
+
+void* operator new(std::size_t size)
+{
+  g_AllocationsCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size))
+  {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+
+/// @brief Benchmark of heap allocations per frame. Every frame moves changed entities count (the first argument,
+/// 100 by default) out of 10k entities, collects render changes and converts mesh of every modified entity into
+/// render data, the way level resources are rebuilt. Frames are run once with render data on global heap and
+/// once in per-frame arena, allocations counted by global operator new and frame time are compared.
+class Application {
+public:
+
+  explicit Application(u32 changedEntitiesCount)
+    : m_ChangedEntitiesCount(changedEntitiesCount)
+  {
+    FLog::create();
+    m_EntityRegistry.Create();
+
+    const FPath meshPath = FPath::Append(FPath::GetEngineProjectPath(), { "resources", "CornellBox",
+                                                                          "CornellBox-Original.obj" });
+    FMeshAsset& meshAsset = m_AssetRegistry.RegisterMesh();
+    meshAsset.LoadObj(meshPath.GetStringPath().c_str(), UFALSE);
+
+    FTransformHierarchy& transforms = m_EntityRegistry.GetTransforms();
+    const FEntityBatch batch = m_EntityRegistry.RegisterBatch(g_EntitiesCount);
+    for (u32 i = 0; i < g_EntitiesCount; i++)
+    {
+      batch[i].Add<FTransformComponent>(FTransformComponent{ .handle = transforms.Add() });
+      batch[i].Add<FRenderMeshComponent>(FRenderMeshComponent{ .id = meshAsset.ID() });
+    }
+    m_EntityRegistry.CollectRenderChanges();
+    m_EntityRegistry.ClearRenderChanges();
+  }
+
+  ~Application() {
+    m_EntityRegistry.Destroy();
+  }
+
+  void Run() {
+    UINFO("{} entities, {} changed per frame, {} frames", g_EntitiesCount, m_ChangedEntitiesCount, g_FramesCount);
+    RunFrames("Global heap", UFALSE);
+    RunFrames("Frame arena", UTRUE);
+    const FLinearAllocator& arena = FFrameAllocator::Get();
+    UINFO("Frame arena: capacity {} KB, {} upstream allocations", arena.GetCapacity() / 1024,
+          arena.GetUpstreamAllocationsCount());
+  }
+
+private:
+
+  void RunFrames(const char* name, b32 useFrameArena)
+  {
+    // Warm-up frames let arena grow to its final block and containers reach their capacity...
+    constexpr u32 warmUpCount{ 3 };
+    u64 checksum{ 0 };
+    for (u32 i = 0; i < warmUpCount; i++)
+    {
+      checksum += RunFrame(useFrameArena);
+    }
+
+    const u64 allocationsStart = g_AllocationsCount.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < g_FramesCount; i++)
+    {
+      checksum += RunFrame(useFrameArena);
+    }
+    const f64 time = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const u64 allocationsCount = g_AllocationsCount.load(std::memory_order_relaxed) - allocationsStart;
+    UINFO("{}: {:.1f} allocations per frame, {:.3f} ms per frame, checksum {}", name,
+          (f64)allocationsCount / g_FramesCount, time / g_FramesCount, checksum);
+  }
+
+  u64 RunFrame(b32 useFrameArena)
+  {
+    FFrameAllocator::NextFrame();
+    std::pmr::memory_resource* pMemory = useFrameArena ? (std::pmr::memory_resource*)&FFrameAllocator::Get() :
+                                                         std::pmr::new_delete_resource();
+
+    FTransformHierarchy& transforms = m_EntityRegistry.GetTransforms();
+    const std::span<const FEntity> entities = m_EntityRegistry.GetEntities();
+    for (u32 i = 0; i < m_ChangedEntitiesCount; i++)
+    {
+      const FEntity entity = entities[(m_FrameIndex * m_ChangedEntitiesCount + i) % entities.size()];
+      const f32 offset = (f32)(m_FrameIndex % 100);
+      transforms.SetLocal(entity.Get<FTransformComponent>().handle, math::Vector3f{ offset, 0.f, 0.f },
+                          math::Vector3f{ 0.f, 0.f, 0.f }, math::Vector3f{ 1.f, 1.f, 1.f });
+    }
+    m_FrameIndex++;
+
+    const FRenderEntityChanges& changes = m_EntityRegistry.CollectRenderChanges();
+    std::pmr::vector<FRenderData> renderDataVector{ pMemory };
+    renderDataVector.reserve(changes.modified.size());
+    for (FEntity entity : changes.modified)
+    {
+      const FMeshAsset& meshAsset = m_AssetRegistry.GetMesh(entity.Get<FRenderMeshComponent>().id);
+      const math::Matrix4x4f& worldMatrix = transforms.GetWorldMatrix(entity.Get<FTransformComponent>().handle);
+      renderDataVector.push_back(FRenderMeshFactory::ConvertAssetToOneRenderData(&meshAsset, worldMatrix, pMemory));
+    }
+
+    u64 checksum{ 0 };
+    for (const FRenderData& renderData : renderDataVector)
+    {
+      checksum += renderData.mesh.vertices.size() + renderData.mesh.indices.size();
+    }
+    return checksum;
+  }
+
+private:
+
+  static constexpr u32 g_EntitiesCount{ 10000 };
+  static constexpr u32 g_FramesCount{ 1000 };
+
+  FEntityRegistry m_EntityRegistry{};
+  FAssetRegistry m_AssetRegistry{};
+  u32 m_ChangedEntitiesCount{ 0 };
+  u32 m_FrameIndex{ 0 };
+
+};
+
+
+int main(int argc, char** argv) {
+  Application app{ argc > 1 ? (u32)std::strtoul(argv[1], nullptr, 10) : 100 };
+  app.Run();
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/Assets/MeshAsset.h>
+#include <UTools/Filesystem/Path.h>
+#include <UTools/Memory/LinearAllocator.h>
+#include <UGraphicsEngine/Renderer/RenderMesh.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+
+using namespace uncanny;
+
+
+/// @brief Benchmark of asset to render data conversion. Sponza (or obj given as the first argument) is loaded and
+/// converted many times into render data copy and into render view, both into linear arena. Time and arena bytes
+/// of both conversions are compared, view should copy nothing but submesh ranges.
+class Application {
+public:
+
+  explicit Application(std::string objPath)
+    : m_ObjPath(std::move(objPath))
+  {
+    FLog::create();
+  }
+
+  void Run() {
+    if (not FPath::Exists(FPath{ m_ObjPath }))
+    {
+      UERROR("Cannot find mesh {}", m_ObjPath);
+      return;
+    }
+
+    FLinearAllocator assetMemory{ 64 * 1024 * 1024 };
+    FMeshAsset meshAsset{ 0, &assetMemory };
+    {
+      const auto start = std::chrono::steady_clock::now();
+      meshAsset.LoadObj(m_ObjPath.c_str(), UFALSE);
+      UINFO("Loaded {} with {} meshes and {} materials in {:.1f} ms", m_ObjPath, meshAsset.GetMeshes().size(),
+            meshAsset.GetMaterials().size(), ElapsedMilliseconds(start));
+    }
+
+    FLinearAllocator arena{ 64 * 1024 * 1024 };
+    const math::Matrix4x4f transform = math::Identity<f32>();
+
+    u64 checksum{ 0 };
+    u64 dataBytes{ 0 };
+    const f64 dataTime = Measure([&]()
+    {
+      arena.Reset();
+      const FRenderData renderData = FRenderMeshFactory::ConvertAssetToOneRenderData(&meshAsset, transform, &arena);
+      checksum += renderData.mesh.vertices.size() + renderData.mesh.indices.size();
+      dataBytes = arena.GetUsedBytes();
+    });
+
+    u64 viewBytes{ 0 };
+    const f64 viewTime = Measure([&]()
+    {
+      arena.Reset();
+      const FRenderDataView renderView = FRenderMeshFactory::ConvertAssetToOneRenderView(&meshAsset, transform,
+                                                                                        &arena);
+      checksum += renderView.mesh.vertices.size() + renderView.mesh.indices.size();
+      viewBytes = arena.GetUsedBytes();
+    });
+
+    UINFO("ConvertAssetToOneRenderData: {:.3f} ms, {:.2f} MB in arena", dataTime, ToMegabytes(dataBytes));
+    UINFO("ConvertAssetToOneRenderView: {:.3f} ms, {:.2f} MB in arena, {:.1f}x faster", viewTime,
+          ToMegabytes(viewBytes), dataTime / viewTime);
+    UINFO("Checksum {}", checksum);
+  }
+
+private:
+
+  /// @returns the best time of a few iterations in milliseconds
+  template<typename TFunc>
+  static f64 Measure(TFunc&& func)
+  {
+    constexpr u32 iterationsCount{ 20 };
+    f64 best{ std::numeric_limits<f64>::max() };
+    for (u32 i = 0; i < iterationsCount; i++)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      func();
+      best = std::min(best, ElapsedMilliseconds(start));
+    }
+    return best;
+  }
+
+  static f64 ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  static f64 ToMegabytes(u64 bytes)
+  {
+    return (f64)bytes / (1024.0 * 1024.0);
+  }
+
+private:
+
+  std::string m_ObjPath{};
+
+};
+
+
+int main(int argc, char** argv) {
+  const FPath sponzaPath = FPath::Append(FPath::GetEngineProjectPath(), { "resources", "sponza", "sponza.obj" });
+  Application app{ argc > 1 ? std::string{ argv[1] } : sponzaPath.GetStringPath() };
+  app.Run();
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/Window/WindowGLFW.h>
+#include <UTools/Filesystem/Path.h>
+#include <UTools/Assets/MeshAsset.h>
+#include <UTools/JobSystem/JobSystem.h>
+#include <UTools/Memory/LinearAllocator.h>
+#include <UGraphicsEngine/Renderer/RenderMesh.h>
+#include <UGraphicsEngine/Renderer/Vulkan/RenderContext.h>
+#include <UGraphicsEngine/Renderer/Vulkan/Commands/CommandPool.h>
+#include <UGraphicsEngine/Renderer/Vulkan/Resources/UploadManager.h>
+#include <UGraphicsEngine/Renderer/Vulkan/Resources/BottomLevelAccelerationStructure.h>
+#include <UGraphicsEngine/Renderer/Vulkan/Resources/AccelerationStructureBuilder.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace uncanny;
+
+
+/// @brief Benchmark of bottom level structure builds on device and on host. Sponza is converted once and its
+/// structure is built copies count times (the first argument, 8 by default) with one builder call: on compute
+/// queue, on host with deferred operation joined by job system threads and on host by calling thread only.
+/// Geometry is uploaded before timing starts, so only builds are compared. Host builds are measured only when
+/// device supports accelerationStructureHostCommands.
+class Application {
+public:
+
+  explicit Application(u32 copiesCount)
+    : m_CopiesCount(copiesCount)
+  {
+    Start();
+  }
+
+  ~Application() {
+    Destroy();
+  }
+
+  void Run() {
+    const FPath sponzaPath = FPath::Append(FPath::GetEngineProjectPath(), { "resources", "sponza", "sponza.obj" });
+    FMeshAsset meshAsset{ 0, &m_AssetMemory };
+    meshAsset.LoadObj(sponzaPath.GetStringPath().c_str(), UFALSE);
+    const FRenderDataView renderData = FRenderMeshFactory::ConvertAssetToOneRenderView(&meshAsset,
+                                                                                       math::Identity<f32>(),
+                                                                                       &m_AssetMemory);
+    if (not vulkan::FBottomLevelAccelerationStructure::HasTriangles(renderData.mesh))
+    {
+      UERROR("Mesh {} has no triangles", sponzaPath.GetStringPath());
+      return;
+    }
+    UINFO("Building {} copies of {} ({} vertices, {} triangles) with {} job system threads", m_CopiesCount,
+          sponzaPath.GetStringPath(), renderData.mesh.vertices.size(), renderData.mesh.indices.size() / 3,
+          m_JobSystem.GetThreadsCount());
+
+    Measure("Device", renderData, UFALSE, nullptr);
+
+    const VkPhysicalDeviceAccelerationStructureFeaturesKHR& features =
+        m_RenderContext.GetLogicalDevice()->GetAttributes().GetAccelerationStructureFeatures();
+    if (not features.accelerationStructureHostCommands)
+    {
+      UWARN("Device does not support accelerationStructureHostCommands, host builds are not measured");
+      return;
+    }
+    Measure("Host on job system", renderData, UTRUE, &m_JobSystem);
+    Measure("Host on calling thread", renderData, UTRUE, nullptr);
+  }
+
+private:
+
+  void Start() {
+    FLog::create();
+    m_JobSystem.Create();
+
+    // Window is needed only for render context surface...
+    FWindowConfiguration windowConfiguration{
+        .resizable = UFALSE,
+        .fullscreen = UFALSE,
+        .size = {
+            .width = 320,
+            .height = 180
+        },
+        .name = "UncannyEngine Sample 21 BenchmarkBottomLevelBuild"
+    };
+    m_Window = std::make_shared<FWindowGLFW>();
+    m_Window->Create(windowConfiguration);
+
+    vulkan::FRenderContextAttributes renderContextAttributes{
+        .instanceLayers = {},
+        .instanceExtensions = { VK_KHR_SURFACE_EXTENSION_NAME,
+                                VK_KHR_WIN32_SURFACE_EXTENSION_NAME },
+        .deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+                              VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+                              VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
+                              VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
+                              VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME },
+        .pWindow = m_Window.get(),
+        .apiVersion = VK_API_VERSION_1_3
+    };
+    m_RenderContext.Create(renderContextAttributes);
+
+    const vulkan::FPhysicalDevice* pPhysicalDevice = m_RenderContext.GetPhysicalDevice();
+    const vulkan::FLogicalDevice* pLogicalDevice = m_RenderContext.GetLogicalDevice();
+
+    // Uploads go through compute queue, which also builds, so no ownership transfer is needed...
+    m_ComputeCommandPool.Create(pLogicalDevice->GetComputeFamilyIndex(), pLogicalDevice->GetHandle(),
+                                VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    m_UploadManager.Create(pLogicalDevice->GetHandle(), &pPhysicalDevice->GetAttributes(),
+                           &pLogicalDevice->GetComputeQueue(), pLogicalDevice->GetComputeFamilyIndex());
+  }
+
+  void Destroy() {
+    m_RenderContext.GetLogicalDevice()->WaitIdle();
+    m_UploadManager.Destroy();
+    m_ComputeCommandPool.Destroy();
+    m_RenderContext.Destroy();
+    m_Window->Destroy();
+    m_JobSystem.Destroy();
+  }
+
+  void Measure(const char* name, const FRenderDataView& renderData, b32 buildOnHost, FJobSystem* pJobSystem)
+  {
+    const vulkan::FPhysicalDeviceAttributes& physicalDeviceAttributes =
+        m_RenderContext.GetPhysicalDevice()->GetAttributes();
+    const vulkan::FLogicalDevice* pLogicalDevice = m_RenderContext.GetLogicalDevice();
+
+    std::vector<vulkan::FBottomLevelAccelerationStructure> structures{};
+    structures.reserve(m_CopiesCount);
+    for (u32 i = 0; i < m_CopiesCount; i++)
+    {
+      auto& bottomAS = structures.emplace_back();
+      bottomAS.SetBuildPolicy(vulkan::EAccelerationStructureBuildPolicy::Static);
+      bottomAS.SetBuildOnHost(buildOnHost);
+      bottomAS.Prepare(renderData.mesh, renderData.materials, m_UploadManager, pLogicalDevice->GetHandle(),
+                       &physicalDeviceAttributes);
+    }
+    m_UploadManager.WaitAll();
+
+    const auto start = std::chrono::steady_clock::now();
+    vulkan::FAccelerationStructureBuilder::Build(structures, m_ComputeCommandPool, pLogicalDevice->GetComputeQueue(),
+                                                 pLogicalDevice, nullptr, pJobSystem);
+    const f64 time = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    VkDeviceSize memorySize{ 0 };
+    for (vulkan::FBottomLevelAccelerationStructure& bottomAS : structures)
+    {
+      memorySize += bottomAS.GetSize();
+      bottomAS.Destroy();
+    }
+    UINFO("{}: {:.2f} ms, {:.2f} ms per structure, {:.2f} MB of structures", name, time, time / m_CopiesCount,
+          (f64)memorySize / (1024.0 * 1024.0));
+  }
+
+private:
+
+  FJobSystem m_JobSystem{};
+  std::shared_ptr<FWindowGLFW> m_Window{};
+  vulkan::FRenderContext m_RenderContext{};
+  vulkan::FCommandPool m_ComputeCommandPool{};
+  vulkan::FUploadManager m_UploadManager{};
+  FLinearAllocator m_AssetMemory{ 64 * 1024 * 1024 };
+  u32 m_CopiesCount{ 1 };
+
+};
+
+
+int main(int argc, char** argv) {
+  Application app{ std::max<u32>(1, argc > 1 ? (u32)std::strtoul(argv[1], nullptr, 10) : 8) };
+  app.Run();
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include <UTools/Logger/Log.h>
+#include <UTools/Assets/MeshAsset.h>
+#include <UTools/Memory/LinearAllocator.h>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__)
+  #include <malloc.h>
+#endif
+
+using namespace uncanny;
+
+
+/// @brief Benchmark of level asset memory. Levels with meshes count (the first argument, 4000 by default) and
+/// geometry size (the second argument, 300 MB by default) are loaded and unloaded several times, once with
+/// geometry on global heap and once in level arena, the way FAssetRegistry allocates it. Every loaded mesh also
+/// leaves small long-lived allocation on heap (as names and bookkeeping of loader do), so that freed geometry
+/// fragments the heap. Load and unload times and free heap chunks (glibc only) are compared.
+class Application {
+public:
+
+  Application(u32 meshesCount, u64 geometrySizeInMegabytes)
+    : m_MeshesCount(meshesCount),
+    m_VerticesPerMesh(geometrySizeInMegabytes * 1024 * 1024 / meshesCount / (sizeof(FVertex) + sizeof(u32)))
+  {
+    FLog::create();
+  }
+
+  void Run() {
+    UINFO("{} levels of {} meshes, {} vertices and indices per mesh", g_LevelsCount, m_MeshesCount,
+          m_VerticesPerMesh);
+    RunLevels("Global heap", std::pmr::new_delete_resource(), nullptr);
+
+    FLinearAllocator levelMemory{ 16 * 1024 * 1024 };
+    RunLevels("Level arena", &levelMemory, &levelMemory);
+    UINFO("Level arena: capacity {} MB, {} upstream allocations", levelMemory.GetCapacity() / (1024 * 1024),
+          levelMemory.GetUpstreamAllocationsCount());
+  }
+
+private:
+
+  void RunLevels(const char* name, std::pmr::memory_resource* pMemory, FLinearAllocator* pArena)
+  {
+    std::vector<std::unique_ptr<std::string>> longLivedAllocations{};
+    for (u32 level = 0; level < g_LevelsCount; level++)
+    {
+      auto start = std::chrono::steady_clock::now();
+      std::pmr::vector<FMeshAssetData> meshes{ pMemory };
+      const u64 checksum = LoadLevel(meshes, longLivedAllocations);
+      const f64 loadTime = ElapsedMilliseconds(start);
+
+      start = std::chrono::steady_clock::now();
+      meshes = std::pmr::vector<FMeshAssetData>{ pMemory };
+      if (pArena)
+      {
+        pArena->Reset();
+      }
+      const f64 unloadTime = ElapsedMilliseconds(start);
+
+      UINFO("{} level {}: load {:.2f} ms, unload {:.3f} ms, free heap chunks {}, checksum {}", name, level,
+            loadTime, unloadTime, GetFreeHeapChunksCount(), checksum);
+    }
+  }
+
+  u64 LoadLevel(std::pmr::vector<FMeshAssetData>& meshes,
+                std::vector<std::unique_ptr<std::string>>& longLivedAllocations) const
+  {
+    // Mesh array is reserved up front like in loader, geometry of every mesh is filled after small allocation...
+    meshes.reserve(m_MeshesCount);
+    u64 checksum{ 0 };
+    for (u32 i = 0; i < m_MeshesCount; i++)
+    {
+      longLivedAllocations.push_back(std::make_unique<std::string>(64, 'm'));
+
+      FMeshAssetData& mesh = meshes.emplace_back();
+      mesh.vertices.resize(m_VerticesPerMesh, FVertex{ .position = { (f32)i, 0.f, 0.f } });
+      mesh.indices.resize(m_VerticesPerMesh, i);
+      mesh.materialIndex = i % 16;
+      checksum += mesh.vertices.size() + mesh.indices.back();
+    }
+    return checksum;
+  }
+
+  static u64 GetFreeHeapChunksCount()
+  {
+#if defined(__GLIBC__)
+    return mallinfo2().ordblks;
+#else
+    return 0;
+#endif
+  }
+
+  static f64 ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+
+  static constexpr u32 g_LevelsCount{ 4 };
+
+  u32 m_MeshesCount{ 0 };
+  u64 m_VerticesPerMesh{ 0 };
+
+};
+
+
+int main(int argc, char** argv) {
+  Application app{ argc > 1 ? (u32)std::strtoul(argv[1], nullptr, 10) : 4000,
+                   argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 300 };
+  app.Run();
+
+  return 0;
+}
@@ -14,8 +14,8 @@ class FAssimpSceneProcessor
 {
 public:
 
-  FAssimpSceneProcessor(std::vector<FMeshAssetData>* pReturnMeshData,
-                        std::vector<FMaterialData>* pReturnMaterialData)
+  FAssimpSceneProcessor(std::pmr::vector<FMeshAssetData>* pReturnMeshData,
+                        std::pmr::vector<FMaterialData>* pReturnMaterialData)
     : m_pReturnMeshData(pReturnMeshData),
     m_pReturnMaterialData(pReturnMaterialData)
   {
@@ -168,14 +168,14 @@ private:
 
 private:
 
-  std::vector<FMeshAssetData>* m_pReturnMeshData{ nullptr };
-  std::vector<FMaterialData>* m_pReturnMaterialData{ nullptr };
+  std::pmr::vector<FMeshAssetData>* m_pReturnMeshData{ nullptr };
+  std::pmr::vector<FMaterialData>* m_pReturnMaterialData{ nullptr };
 
 };
 
 
-void FAssetLoader::LoadOBJ(const char* path, std::vector<FMeshAssetData>* pMeshData,
-                           std::vector<FMaterialData>* pMaterialData, b8 flipNormals)
+void FAssetLoader::LoadOBJ(const char* path, std::pmr::vector<FMeshAssetData>* pMeshData,
+                           std::pmr::vector<FMaterialData>* pMaterialData, b8 flipNormals)
 {
   Assimp::Importer importer;
   const aiScene* aiScene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -188,6 +188,9 @@ void FAssetLoader::LoadOBJ(const char* path, std::vector<FMeshAssetData>* pMeshD
     return;
   }
 
+  // Mesh data may live in arena, where every reallocation leaves unused memory behind...
+  pMeshData->reserve(pMeshData->size() + aiScene->mNumMeshes);
+
   FAssimpSceneProcessor sceneProcessor(pMeshData, pMaterialData);
   sceneProcessor.ProcessNode(aiScene->mRootNode, aiScene, flipNormals);
   sceneProcessor.ProcessMaterial(aiScene);
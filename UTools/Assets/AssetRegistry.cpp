@@ -10,7 +10,7 @@ namespace uncanny
 FMeshAsset& FAssetRegistry::RegisterMesh()
 {
   u64 uniqueID = m_IDRegistry.GenerateID();
-  auto [it, inserted] = m_MeshAssets.emplace(std::make_pair(uniqueID, FMeshAsset{ uniqueID }));
+  auto [it, inserted] = m_MeshAssets.try_emplace(uniqueID, uniqueID, &m_LevelMemory);
   if (not inserted)
   {
     UWARN("Asset with ID {} is already inserted!");
@@ -19,9 +19,21 @@ FMeshAsset& FAssetRegistry::RegisterMesh()
 }
 
 
+FMeshAsset& FAssetRegistry::RegisterMesh(u64 id)
+{
+  auto [it, inserted] = m_MeshAssets.try_emplace(id, id, &m_LevelMemory);
+  if (not inserted)
+  {
+    UWARN("Asset with ID {} is already inserted!", id);
+  }
+  return it->second;
+}
+
+
 void FAssetRegistry::Clear()
 {
   m_MeshAssets.clear();
+  m_LevelMemory.Reset();
 }
 
 
@@ -5,6 +5,7 @@
 
 #include "MeshAsset.h"
 #include "IdentifierRegistry.h"
+#include "UTools/Memory/LinearAllocator.h"
 #include <variant>
 #include <unordered_map>
 
@@ -13,18 +14,34 @@ namespace uncanny
 {
 
 
+/// @brief FAssetRegistry owns assets of currently loaded level.
+/// @details Geometry of every registered mesh is allocated from level arena, so loading does not hit general heap
+/// for every vertex / index vector and Clear() gives whole level memory back at once instead of freeing
+/// vectors one by one. Arena keeps its biggest block, next level of similar size is loaded without upstream
+/// allocations.
 class FAssetRegistry
 {
 public:
 
   FMeshAsset& RegisterMesh();
 
+  /// @brief Registers mesh with already known ID (e.g. stable ID stored in scene file), if mesh with that ID
+  /// is already registered, it is returned instead.
+  FMeshAsset& RegisterMesh(u64 id);
+
+  /// @brief Removes all assets and resets level arena, references to previously registered assets are invalid
   void Clear();
 
   [[nodiscard]] const FMeshAsset& GetMesh(u64 id) const { return m_MeshAssets.at(id); }
 
+  [[nodiscard]] u32 GetMeshesCount() const { return m_MeshAssets.size(); }
+
+  [[nodiscard]] const FLinearAllocator& GetLevelMemory() const { return m_LevelMemory; }
+
 private:
 
+  // Arena must be declared before assets, they are destroyed first...
+  FLinearAllocator m_LevelMemory{ 16 * 1024 * 1024 };
   std::unordered_map<u64, FMeshAsset> m_MeshAssets{};
   FIdentifierRegistry m_IDRegistry{};
 
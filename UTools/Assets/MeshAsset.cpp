@@ -7,8 +7,10 @@ namespace uncanny
 {
 
 
-FMeshAsset::FMeshAsset(u64 id)
-  : m_ID(id)
+FMeshAsset::FMeshAsset(u64 id, std::pmr::memory_resource* pMemory)
+  : m_Meshes(pMemory),
+  m_Materials(pMemory),
+  m_ID(id)
 {
 }
 
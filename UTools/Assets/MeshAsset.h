@@ -5,6 +5,7 @@
 
 #include "UTools/UTypes.h"
 #include "UMath/Vector3.h"
+#include <memory_resource>
 #include <vector>
 
 
@@ -19,10 +20,37 @@ struct FVertex
 };
 
 
+/// @brief FMeshAssetData is allocator-aware, when stored in std::pmr::vector it allocates its vertices and indices
+/// from the same memory resource as the vector itself.
 struct FMeshAssetData
 {
-  std::vector<FVertex> vertices{};
-  std::vector<u32> indices{};
+  typedef std::pmr::polymorphic_allocator<> allocator_type;
+
+  FMeshAssetData() = default;
+  explicit FMeshAssetData(const allocator_type& allocator)
+    : vertices(allocator),
+    indices(allocator)
+  {
+  }
+  FMeshAssetData(const FMeshAssetData& other, const allocator_type& allocator)
+    : vertices(other.vertices, allocator),
+    indices(other.indices, allocator),
+    materialIndex(other.materialIndex)
+  {
+  }
+  FMeshAssetData(FMeshAssetData&& other, const allocator_type& allocator)
+    : vertices(std::move(other.vertices), allocator),
+    indices(std::move(other.indices), allocator),
+    materialIndex(other.materialIndex)
+  {
+  }
+  FMeshAssetData(const FMeshAssetData&) = default;
+  FMeshAssetData(FMeshAssetData&&) noexcept = default;
+  FMeshAssetData& operator=(const FMeshAssetData&) = default;
+  FMeshAssetData& operator=(FMeshAssetData&&) noexcept = default;
+
+  std::pmr::vector<FVertex> vertices{};
+  std::pmr::vector<u32> indices{};
   u32 materialIndex{ UUNUSED };
 };
 
@@ -46,19 +74,21 @@ class FMeshAsset
 public:
 
   FMeshAsset() = delete;
-  explicit FMeshAsset(u64 id);
+
+  /// @brief All mesh data of asset is allocated from pMemory, which must outlive the asset
+  explicit FMeshAsset(u64 id, std::pmr::memory_resource* pMemory = std::pmr::get_default_resource());
 
   void LoadObj(const char* path, b8 flipNormals);
 
-  [[nodiscard]] const std::vector<FMeshAssetData>& GetMeshes() const { return m_Meshes; }
-  [[nodiscard]] const std::vector<FMaterialData>& GetMaterials() const { return m_Materials; }
+  [[nodiscard]] const std::pmr::vector<FMeshAssetData>& GetMeshes() const { return m_Meshes; }
+  [[nodiscard]] const std::pmr::vector<FMaterialData>& GetMaterials() const { return m_Materials; }
 
   [[nodiscard]] u64 ID() const { return m_ID; }
 
 private:
 
-  std::vector<FMeshAssetData> m_Meshes{};
-  std::vector<FMaterialData> m_Materials{};
+  std::pmr::vector<FMeshAssetData> m_Meshes{};
+  std::pmr::vector<FMaterialData> m_Materials{};
   u64 m_ID{ UUNUSED };
 
 };
@@ -0,0 +1,535 @@
+
+#include "MeshStreamLoader.h"
+#include "UTools/Logger/Log.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+
+namespace uncanny
+{
+
+
+/// @brief Minimal amount of bytes left for reading source chunk, if budget leaves less, import is rejected
+static constexpr u64 g_MinimalReadChunkSize{ 64 * 1024 };
+
+static constexpr char g_PagedFileMagic[4]{ 'U', 'M', 'S', 'P' };
+static constexpr u32 g_PagedFileVersion{ 1 };
+
+
+struct FPagedFileHeader
+{
+  char magic[4]{};
+  u32 version{ UVERSION_UNDEFINED };
+  u32 verticesPerPage{ 0 };
+  u32 indicesPerPage{ 0 };
+  u64 verticesCount{ 0 };
+  u64 indicesCount{ 0 };
+  u64 pagesCount{ 0 };
+};
+
+
+struct FPagedFilePageHeader
+{
+  u64 verticesCount{ 0 };
+  u64 indicesCount{ 0 };
+  u64 firstVertex{ 0 };
+  u64 firstIndex{ 0 };
+};
+
+
+static std::string_view SkipWhitespaces(std::string_view str)
+{
+  while (not str.empty() and (str.front() == ' ' or str.front() == '\t'))
+  {
+    str.remove_prefix(1);
+  }
+  return str;
+}
+
+
+class FObjStreamParser
+{
+public:
+
+  FObjStreamParser(const FMeshStreamSpecification& specification, const FMeshPageConsumer& consumer)
+    : m_Consumer(consumer)
+  {
+    m_VerticesPerPage = specification.verticesPerPage;
+    // Keeping whole triangles in one index page...
+    m_IndicesPerPage = specification.indicesPerPage - (specification.indicesPerPage % 3);
+
+    const u64 pagesSize = m_VerticesPerPage * sizeof(FVertex) + m_IndicesPerPage * sizeof(u32);
+    if (pagesSize < specification.memoryBudgetInBytes)
+    {
+      m_ReadChunkSize = specification.memoryBudgetInBytes - pagesSize;
+    }
+  }
+
+  b32 Parse(const char* path, FMeshStreamStatistics* pStatistics)
+  {
+    if (m_VerticesPerPage == 0 or m_IndicesPerPage == 0)
+    {
+      UERROR("Vertex and index pages cannot be empty during streaming {}!", path);
+      return UFALSE;
+    }
+    if (m_ReadChunkSize < g_MinimalReadChunkSize)
+    {
+      UERROR("Memory budget is too small for streaming {}, pages leave only {} bytes for reading!", path,
+             m_ReadChunkSize);
+      return UFALSE;
+    }
+
+    std::ifstream fileStream{ path, std::ios::binary };
+    if (not fileStream.is_open())
+    {
+      UERROR("Cannot open obj file {} for streaming!", path);
+      return UFALSE;
+    }
+
+    // Those are the only allocations during whole import...
+    std::vector<char> readChunk(m_ReadChunkSize);
+    m_Vertices.reserve(m_VerticesPerPage);
+    m_Indices.reserve(m_IndicesPerPage);
+
+    u64 carriedSize = 0;
+    b32 endOfFile = UFALSE;
+    while (not endOfFile)
+    {
+      fileStream.read(readChunk.data() + carriedSize, (std::streamsize)(readChunk.size() - carriedSize));
+      const u64 readSize = fileStream.gcount();
+      m_BytesRead += readSize;
+      endOfFile = fileStream.eof() or readSize == 0;
+
+      std::string_view chunk{ readChunk.data(), carriedSize + readSize };
+      size_t processedSize = chunk.size();
+      if (not endOfFile)
+      {
+        size_t lastNewLine = chunk.rfind('\n');
+        if (lastNewLine == std::string_view::npos)
+        {
+          UERROR("Line in {} is longer than read chunk of {} bytes!", path, readChunk.size());
+          return UFALSE;
+        }
+        processedSize = lastNewLine + 1;
+      }
+
+      ParseLines(chunk.substr(0, processedSize));
+      if (m_Failed)
+      {
+        UERROR("Cannot stream {}, file is malformed or too large!", path);
+        return UFALSE;
+      }
+
+      // Moving incomplete line to the beginning of chunk, it will be finished during next read...
+      carriedSize = chunk.size() - processedSize;
+      std::memmove(readChunk.data(), readChunk.data() + processedSize, carriedSize);
+    }
+
+    Flush();
+
+    *pStatistics = FMeshStreamStatistics{
+      .verticesCount = m_VerticesCount,
+      .indicesCount = m_IndicesCount,
+      .pagesCount = m_PagesCount,
+      .bytesRead = m_BytesRead,
+      .peakMemoryInBytes = readChunk.capacity() + m_Vertices.capacity() * sizeof(FVertex) +
+                           m_Indices.capacity() * sizeof(u32)
+    };
+    return UTRUE;
+  }
+
+private:
+
+  void ParseLines(std::string_view chunk)
+  {
+    while (not chunk.empty() and not m_Failed)
+    {
+      size_t endOfLine = chunk.find('\n');
+      std::string_view line = chunk.substr(0, endOfLine);
+      if (not line.empty() and line.back() == '\r')
+      {
+        line.remove_suffix(1);
+      }
+      ParseLine(line);
+
+      if (endOfLine == std::string_view::npos)
+      {
+        break;
+      }
+      chunk.remove_prefix(endOfLine + 1);
+    }
+  }
+
+  void ParseLine(std::string_view line)
+  {
+    if (line.size() < 2)
+    {
+      return;
+    }
+    // "vn", "vt", "o", "g", "usemtl" etc. are skipped as only positions and faces are streamed
+    if (line[0] == 'v' and (line[1] == ' ' or line[1] == '\t'))
+    {
+      ParseVertex(line.substr(2));
+    }
+    else if (line[0] == 'f' and (line[1] == ' ' or line[1] == '\t'))
+    {
+      ParseFace(line.substr(2));
+    }
+  }
+
+  void ParseVertex(std::string_view line)
+  {
+    f32 position[3]{ 0.f, 0.f, 0.f };
+    for (f32& coordinate : position)
+    {
+      line = SkipWhitespaces(line);
+      auto [ptr, ec] = std::from_chars(line.data(), line.data() + line.size(), coordinate);
+      if (ec != std::errc())
+      {
+        m_Failed = UTRUE;
+        return;
+      }
+      line.remove_prefix(ptr - line.data());
+    }
+
+    if (m_Vertices.size() == m_VerticesPerPage)
+    {
+      Flush();
+    }
+    m_Vertices.push_back(FVertex{ .position = { .x = position[0], .y = position[1], .z = position[2] } });
+    m_VerticesCount++;
+    if (m_VerticesCount > std::numeric_limits<u32>::max())
+    {
+      m_Failed = UTRUE;
+    }
+  }
+
+  void ParseFace(std::string_view line)
+  {
+    u32 firstIndex{ UUNUSED };
+    u32 previousIndex{ UUNUSED };
+    u32 cornersCount = 0;
+
+    line = SkipWhitespaces(line);
+    while (not line.empty())
+    {
+      // Only position index matters, "v/vt/vn" and "v//vn" are parsed till first slash
+      i64 objIndex{ 0 };
+      auto [ptr, ec] = std::from_chars(line.data(), line.data() + line.size(), objIndex);
+      if (ec != std::errc() or objIndex == 0)
+      {
+        m_Failed = UTRUE;
+        return;
+      }
+      size_t endOfCorner = line.find_first_of(" \t");
+      line.remove_prefix(endOfCorner == std::string_view::npos ? line.size() : endOfCorner);
+      line = SkipWhitespaces(line);
+
+      // Negative indices are relative to vertices read so far, it works fine with streaming. Index must point to
+      // vertex that was already read, as page with it could have been flushed, and must fit into u32...
+      const i64 resolvedIndex = objIndex > 0 ? objIndex - 1 : (i64)m_VerticesCount + objIndex;
+      if (resolvedIndex < 0 or (u64)resolvedIndex >= m_VerticesCount or
+          (u64)resolvedIndex > std::numeric_limits<u32>::max())
+      {
+        m_Failed = UTRUE;
+        return;
+      }
+      const u32 index = (u32)resolvedIndex;
+
+      if (cornersCount == 0)
+      {
+        firstIndex = index;
+      }
+      else if (cornersCount >= 2)
+      {
+        PushTriangle(firstIndex, previousIndex, index);
+      }
+      previousIndex = index;
+      cornersCount++;
+    }
+  }
+
+  void PushTriangle(u32 a, u32 b, u32 c)
+  {
+    if (m_Indices.size() + 3 > m_IndicesPerPage)
+    {
+      Flush();
+    }
+    m_Indices.push_back(a);
+    m_Indices.push_back(b);
+    m_Indices.push_back(c);
+  }
+
+  void Flush()
+  {
+    if (m_Vertices.empty() and m_Indices.empty())
+    {
+      return;
+    }
+
+    FMeshAssetPage page{
+      .vertices = m_Vertices,
+      .indices = m_Indices,
+      .firstVertex = m_FlushedVerticesCount,
+      .firstIndex = m_IndicesCount
+    };
+    m_Consumer(page);
+
+    m_FlushedVerticesCount += m_Vertices.size();
+    m_IndicesCount += m_Indices.size();
+    m_PagesCount++;
+    // clear() keeps capacity, so there is no reallocation for next page
+    m_Vertices.clear();
+    m_Indices.clear();
+  }
+
+private:
+
+  const FMeshPageConsumer& m_Consumer;
+  std::vector<FVertex> m_Vertices{};
+  std::vector<u32> m_Indices{};
+  u64 m_ReadChunkSize{ 0 };
+  u64 m_VerticesPerPage{ 0 };
+  u64 m_IndicesPerPage{ 0 };
+  u64 m_VerticesCount{ 0 };
+  u64 m_FlushedVerticesCount{ 0 };
+  u64 m_IndicesCount{ 0 };
+  u64 m_PagesCount{ 0 };
+  u64 m_BytesRead{ 0 };
+  b32 m_Failed{ UFALSE };
+
+};
+
+
+FMeshStreamStatistics FMeshStreamLoader::LoadObj(const char* path, const FMeshStreamSpecification& specification,
+                                                 const FMeshPageConsumer& consumer)
+{
+  FMeshStreamStatistics statistics{};
+  FObjStreamParser parser(specification, consumer);
+  if (not parser.Parse(path, &statistics))
+  {
+    return {};
+  }
+
+  UDEBUG("Streamed .obj file: {}, vertices: {}, indices: {}, pages: {}, peak memory: {} bytes", path,
+         statistics.verticesCount, statistics.indicesCount, statistics.pagesCount, statistics.peakMemoryInBytes);
+  return statistics;
+}
+
+
+FMeshStreamStatistics FMeshStreamLoader::LoadObjToPagedFile(const char* path, const char* pagedFilePath,
+                                                            const FMeshStreamSpecification& specification)
+{
+  // Pages are written into temporary file first, so that half-written paged file is never left behind...
+  const std::string temporaryPath = std::string(pagedFilePath) + ".tmp";
+  std::ofstream pagedFileStream{ temporaryPath, std::ios::binary | std::ios::trunc };
+  if (not pagedFileStream.is_open())
+  {
+    UERROR("Cannot open paged file {} for writing!", temporaryPath);
+    return {};
+  }
+
+  // Header is written twice, second time with final counts...
+  FPagedFileHeader header{
+    .version = g_PagedFileVersion,
+    .verticesPerPage = (u32)specification.verticesPerPage,
+    .indicesPerPage = (u32)specification.indicesPerPage
+  };
+  std::memcpy(header.magic, g_PagedFileMagic, sizeof(g_PagedFileMagic));
+  pagedFileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  FMeshStreamStatistics statistics = LoadObj(path, specification, [&pagedFileStream](const FMeshAssetPage& page)
+  {
+    FPagedFilePageHeader pageHeader{
+      .verticesCount = page.vertices.size(),
+      .indicesCount = page.indices.size(),
+      .firstVertex = page.firstVertex,
+      .firstIndex = page.firstIndex
+    };
+    pagedFileStream.write(reinterpret_cast<const char*>(&pageHeader), sizeof(pageHeader));
+    pagedFileStream.write(reinterpret_cast<const char*>(page.vertices.data()),
+                          (std::streamsize)page.vertices.size_bytes());
+    pagedFileStream.write(reinterpret_cast<const char*>(page.indices.data()),
+                          (std::streamsize)page.indices.size_bytes());
+  });
+
+  header.verticesCount = statistics.verticesCount;
+  header.indicesCount = statistics.indicesCount;
+  header.pagesCount = statistics.pagesCount;
+  pagedFileStream.seekp(0);
+  pagedFileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  pagedFileStream.close();
+
+  // On failure paged file of previous import is removed too, as it does not match source any more...
+  std::error_code errorCode{};
+  if (statistics.verticesCount == 0 or pagedFileStream.fail())
+  {
+    if (statistics.verticesCount != 0)
+    {
+      UERROR("Failed to write paged file {}!", temporaryPath);
+    }
+    std::filesystem::remove(temporaryPath, errorCode);
+    std::filesystem::remove(pagedFilePath, errorCode);
+    return {};
+  }
+
+  std::filesystem::rename(temporaryPath, pagedFilePath, errorCode);
+  if (errorCode)
+  {
+    UERROR("Cannot replace paged file {}!", pagedFilePath);
+    std::filesystem::remove(temporaryPath, errorCode);
+    std::filesystem::remove(pagedFilePath, errorCode);
+    return {};
+  }
+  return statistics;
+}
+
+
+FMeshStreamStatistics FMeshStreamLoader::ReadPagedFile(const char* pagedFilePath, const FMeshPageConsumer& consumer)
+{
+  std::ifstream pagedFileStream{ pagedFilePath, std::ios::binary };
+  if (not pagedFileStream.is_open())
+  {
+    UERROR("Cannot open paged file {}!", pagedFilePath);
+    return {};
+  }
+
+  FPagedFileHeader header{};
+  pagedFileStream.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (std::memcmp(header.magic, g_PagedFileMagic, sizeof(g_PagedFileMagic)) != 0 or
+      header.version != g_PagedFileVersion)
+  {
+    UERROR("File {} is not a paged mesh file or its version is not supported!", pagedFilePath);
+    return {};
+  }
+
+  std::vector<FVertex> vertices(header.verticesPerPage);
+  std::vector<u32> indices(header.indicesPerPage);
+
+  FMeshStreamStatistics statistics{};
+  for (u64 i = 0; i < header.pagesCount; i++)
+  {
+    FPagedFilePageHeader pageHeader{};
+    pagedFileStream.read(reinterpret_cast<char*>(&pageHeader), sizeof(pageHeader));
+    if (not pagedFileStream.good() or
+        pageHeader.verticesCount > vertices.size() or
+        pageHeader.indicesCount > indices.size())
+    {
+      UERROR("Paged file {} is corrupted at page {}!", pagedFilePath, i);
+      return {};
+    }
+    pagedFileStream.read(reinterpret_cast<char*>(vertices.data()),
+                         (std::streamsize)(pageHeader.verticesCount * sizeof(FVertex)));
+    pagedFileStream.read(reinterpret_cast<char*>(indices.data()),
+                         (std::streamsize)(pageHeader.indicesCount * sizeof(u32)));
+    if (not pagedFileStream.good())
+    {
+      UERROR("Paged file {} is corrupted at page {}!", pagedFilePath, i);
+      return {};
+    }
+
+    consumer(FMeshAssetPage{
+      .vertices = { vertices.data(), pageHeader.verticesCount },
+      .indices = { indices.data(), pageHeader.indicesCount },
+      .firstVertex = pageHeader.firstVertex,
+      .firstIndex = pageHeader.firstIndex
+    });
+
+    statistics.verticesCount += pageHeader.verticesCount;
+    statistics.indicesCount += pageHeader.indicesCount;
+    statistics.pagesCount++;
+  }
+
+  statistics.bytesRead = pagedFileStream.tellg();
+  statistics.peakMemoryInBytes = vertices.capacity() * sizeof(FVertex) + indices.capacity() * sizeof(u32);
+  return statistics;
+}
+
+
+b32 FMeshStreamLoader::GenerateSyntheticObj(const char* path, u64 targetSizeInBytes)
+{
+  std::ofstream fileStream{ path, std::ios::binary | std::ios::trunc };
+  if (not fileStream.is_open())
+  {
+    UERROR("Cannot open {} for synthetic obj generation!", path);
+    return UFALSE;
+  }
+
+  // Approximately every grid point produces one "v x y z" line and one "f a b c d" quad line
+  constexpr u64 approximateBytesPerGridPoint = 24 + 40;
+  const u64 side = std::max<u64>(2, (u64)std::sqrt((f64)targetSizeInBytes / approximateBytesPerGridPoint));
+
+  std::vector<char> writeBuffer(4 * 1024 * 1024);
+  char* pCursor = writeBuffer.data();
+  const char* pEnd = writeBuffer.data() + writeBuffer.size();
+  constexpr u64 maxLineSize = 128;
+
+  auto flushIfNeeded = [&](b32 force)
+  {
+    if (force or (u64)(pEnd - pCursor) < maxLineSize)
+    {
+      fileStream.write(writeBuffer.data(), pCursor - writeBuffer.data());
+      pCursor = writeBuffer.data();
+    }
+  };
+  auto writeText = [&pCursor](const char* pText)
+  {
+    const size_t length = std::strlen(pText);
+    std::memcpy(pCursor, pText, length);
+    pCursor += length;
+  };
+  auto writeFloat = [&pCursor, pEnd](f32 value)
+  {
+    pCursor = std::to_chars(pCursor, const_cast<char*>(pEnd), value, std::chars_format::fixed, 3).ptr;
+  };
+  auto writeIndex = [&pCursor, pEnd](u64 value)
+  {
+    pCursor = std::to_chars(pCursor, const_cast<char*>(pEnd), value).ptr;
+  };
+
+  writeText("# UncannyEngine synthetic grid mesh\n");
+  for (u64 row = 0; row < side; row++)
+  {
+    for (u64 column = 0; column < side; column++)
+    {
+      writeText("v ");
+      writeFloat((f32)column);
+      writeText(" ");
+      writeFloat(std::sin((f32)(row + column) * 0.01f));
+      writeText(" ");
+      writeFloat((f32)row);
+      writeText("\n");
+      flushIfNeeded(UFALSE);
+    }
+  }
+  for (u64 row = 0; row + 1 < side; row++)
+  {
+    for (u64 column = 0; column + 1 < side; column++)
+    {
+      const u64 a = row * side + column + 1;
+      writeText("f ");
+      writeIndex(a);
+      writeText(" ");
+      writeIndex(a + 1);
+      writeText(" ");
+      writeIndex(a + side + 1);
+      writeText(" ");
+      writeIndex(a + side);
+      writeText("\n");
+      flushIfNeeded(UFALSE);
+    }
+  }
+  flushIfNeeded(UTRUE);
+
+  UDEBUG("Generated synthetic obj file: {} with {} vertices", path, side * side);
+  return fileStream.good();
+}
+
+
+}
@@ -0,0 +1,85 @@
+
+#ifndef UNCANNYENGINE_MESHSTREAMLOADER_H
+#define UNCANNYENGINE_MESHSTREAMLOADER_H
+
+
+#include "MeshAsset.h"
+#include <functional>
+#include <span>
+
+
+namespace uncanny
+{
+
+
+/// @brief FMeshStreamSpecification describes bounds for out-of-core mesh import.
+/// @details Whole import (read chunk, vertex page, index page) must fit into memoryBudgetInBytes. Remaining
+/// budget after both pages is used for reading source file chunks.
+struct FMeshStreamSpecification
+{
+  u64 memoryBudgetInBytes{ 64ull * 1024 * 1024 };
+  u32 verticesPerPage{ 256 * 1024 };
+  u32 indicesPerPage{ 3 * 256 * 1024 };
+};
+
+
+/// @brief FMeshAssetPage is a view over one block of streamed geometry. It is valid only during consumer call.
+/// @details Indices are global, they point into whole vertex stream, not only into given page. This is why
+/// firstVertex is also passed, consumer can place vertex block at proper offset.
+struct FMeshAssetPage
+{
+  std::span<const FVertex> vertices{};
+  std::span<const u32> indices{};
+  u64 firstVertex{ 0 };
+  u64 firstIndex{ 0 };
+};
+
+
+struct FMeshStreamStatistics
+{
+  u64 verticesCount{ 0 };
+  u64 indicesCount{ 0 };
+  u64 pagesCount{ 0 };
+  u64 bytesRead{ 0 };
+  u64 peakMemoryInBytes{ 0 };
+};
+
+
+typedef std::function<void(const FMeshAssetPage&)> FMeshPageConsumer;
+
+
+/// @brief FMeshStreamLoader is an out-of-core .obj importer for meshes that are larger than RAM.
+/// @details Contrary to FAssetLoader it does not materialize whole scene. Source is read in bounded chunks and
+/// fixed-capacity vertex / index pages are emitted straight to consumer or to paged file on disk.
+/// Only positions are streamed, normals are left zeroed and should be generated by consumer. Faces are
+/// triangulated as fans, materials are ignored.
+class FMeshStreamLoader
+{
+public:
+
+  /// @brief Streams .obj file into consumer page by page
+  /// @returns statistics of import, verticesCount is 0 when file could not be streamed
+  static FMeshStreamStatistics LoadObj(const char* path, const FMeshStreamSpecification& specification,
+                                       const FMeshPageConsumer& consumer);
+
+  /// @brief Streams .obj file into paged binary file that can be read back with ReadPagedFile()
+  /// @details Pages are written into temporary file, which replaces paged file only when whole import succeeded,
+  /// on failure paged file is removed, so that it is never picked up half-written.
+  /// @returns statistics of import, verticesCount is 0 when paged file could not be written
+  static FMeshStreamStatistics LoadObjToPagedFile(const char* path, const char* pagedFilePath,
+                                                  const FMeshStreamSpecification& specification);
+
+  /// @brief Reads paged binary file created by LoadObjToPagedFile() one page at a time
+  static FMeshStreamStatistics ReadPagedFile(const char* pagedFilePath, const FMeshPageConsumer& consumer);
+
+  /// @brief Writes synthetic grid mesh .obj file of approximately targetSizeInBytes, used for testing streaming
+  /// import with multi-GB inputs.
+  static b32 GenerateSyntheticObj(const char* path, u64 targetSizeInBytes);
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_MESHSTREAMLOADER_H
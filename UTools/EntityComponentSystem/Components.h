@@ -7,6 +7,7 @@
 #include <type_traits>
 #include "UMath/Matrix4x4.h"
 #include "UMath/Trig.h"
+#include "TransformHierarchy.h"
 
 
 namespace uncanny
@@ -16,6 +17,9 @@ namespace uncanny
 struct FEntityComponent { };
 
 
+/// @details position, rotation and scale are used only by entities that are not part of transform hierarchy.
+/// Entities loaded with FEntityRegistryLoader have FTransformComponent and their matrix should be taken from
+/// FTransformHierarchy::GetWorldMatrix().
 struct FRenderMeshComponent : public FEntityComponent
 {
   u64 id{ UUNUSED };
@@ -37,6 +41,13 @@ struct FRenderMeshComponent : public FEntityComponent
 };
 
 
+/// @brief FTransformComponent links entity with its node in FTransformHierarchy owned by entity registry
+struct FTransformComponent : public FEntityComponent
+{
+  FTransformHandle handle{ UUNUSED };
+};
+
+
 template<typename T>
 concept ConceptComponent = std::is_base_of_v<FEntityComponent, T>;
 
@@ -15,6 +15,7 @@ class FEntity
 {
 
   friend class FEntityRegistry;
+  friend class FEntityBatch;
 
 public:
 
@@ -24,6 +25,9 @@ public:
 
   [[nodiscard]] b32 IsValid() const;
 
+  /// @brief Identifier that is unique among alive entities, it can be used as a key after entity is destroyed
+  [[nodiscard]] u32 GetID() const { return entt::to_integral(m_Entity); }
+
   template<ConceptComponent TComponent, typename... Args>
   TComponent& Add(Args&&... args) const
   {
@@ -36,6 +40,21 @@ public:
     return m_pRegistry->get<TComponent>(m_Entity);
   }
 
+  /// @brief Modifies component in place with given functions and notifies registry about the change. Use it
+  /// instead of writing through Get() when change should be tracked (see FEntityRegistry::CollectRenderChanges()).
+  template<ConceptComponent TComponent, typename... TFuncs>
+  TComponent& Patch(TFuncs&&... funcs) const
+  {
+    return m_pRegistry->patch<TComponent>(m_Entity, std::forward<TFuncs>(funcs)...);
+  }
+
+  /// @brief Replaces component with new one and notifies registry about the change
+  template<ConceptComponent TComponent, typename... Args>
+  TComponent& Replace(Args&&... args) const
+  {
+    return m_pRegistry->replace<TComponent>(m_Entity, std::forward<Args>(args)...);
+  }
+
   template<ConceptComponent TComponent>
   [[nodiscard]] TComponent& Remove() const
   {
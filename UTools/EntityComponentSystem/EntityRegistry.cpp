@@ -6,15 +6,34 @@ namespace uncanny
 {
 
 
+namespace ERenderChangeFlags
+{
+  static constexpr u8 Added = 1 << 0;
+  static constexpr u8 Removed = 1 << 1;
+  static constexpr u8 Modified = 1 << 2;
+}
+
+
 void FEntityRegistry::Create()
 {
   m_Registry = entt::registry();
+
+  m_Registry.on_construct<FRenderMeshComponent>().connect<&FEntityRegistry::OnRenderMeshConstruct>(*this);
+  m_Registry.on_update<FRenderMeshComponent>().connect<&FEntityRegistry::OnRenderMeshUpdate>(*this);
+  m_Registry.on_destroy<FRenderMeshComponent>().connect<&FEntityRegistry::OnRenderMeshDestroy>(*this);
+  m_Registry.on_construct<FTransformComponent>().connect<&FEntityRegistry::OnTransformConstruct>(*this);
+  m_Registry.on_destroy<FTransformComponent>().connect<&FEntityRegistry::OnTransformDestroy>(*this);
 }
 
 
 void FEntityRegistry::Destroy()
 {
+  // Transforms are cleared first, so that destroy signals don't remove nodes one by one...
+  m_Transforms.Clear();
   m_Registry.clear();
+  m_Entities.clear();
+  m_TransformOwners.clear();
+  ClearRenderChanges();
 }
 
 
@@ -27,14 +46,132 @@ FEntity FEntityRegistry::Register()
 
 std::span<FEntity> FEntityRegistry::Register(u32 count)
 {
-  u32 savingSize = m_Entities.size();
-  for (u32 i = 0; i < count; i++)
+  const FEntityBatch batch = RegisterBatch(count);
+  return { std::prev(m_Entities.end(), batch.GetCount()), m_Entities.end() };
+}
+
+
+FEntityBatch FEntityRegistry::RegisterBatch(u32 count)
+{
+  FEntityBatch batch{};
+  batch.m_pRegistry = &m_Registry;
+  batch.m_Entities.resize(count);
+  m_Registry.create(batch.m_Entities.begin(), batch.m_Entities.end());
+
+  // Handles are appended at once, so registering thousands of entities reallocates at most once...
+  if (m_Entities.capacity() < m_Entities.size() + count)
+  {
+    m_Entities.reserve(std::max<u64>(m_Entities.size() + count, 2 * m_Entities.capacity()));
+  }
+  for (entt::entity entity : batch.m_Entities)
+  {
+    m_Entities.push_back(MakeEntity(entity));
+  }
+  return batch;
+}
+
+
+const FRenderEntityChanges& FEntityRegistry::CollectRenderChanges(b32 updateTransforms)
+{
+  m_RenderChanges.added.clear();
+  m_RenderChanges.removed.clear();
+  m_RenderChanges.modified.clear();
+
+  if (updateTransforms)
+  {
+    m_Transforms.Update();
+  }
+  m_ChangedTransforms.clear();
+  m_Transforms.GatherChangedHandles(m_ChangedTransforms);
+  for (FTransformHandle handle : m_ChangedTransforms)
+  {
+    const entt::entity entity = handle < m_TransformOwners.size() ? m_TransformOwners[handle] : entt::null;
+    if (entity != entt::null and m_Registry.all_of<FRenderMeshComponent>(entity))
+    {
+      m_PendingRenderChanges[entity] |= ERenderChangeFlags::Modified;
+    }
+  }
+
+  for (const auto& [entity, flags] : m_PendingRenderChanges)
+  {
+    if ((flags & ERenderChangeFlags::Added) and (flags & ERenderChangeFlags::Removed))
+    {
+      continue;
+    }
+
+    if (flags & ERenderChangeFlags::Added)
+    {
+      m_RenderChanges.added.push_back(MakeEntity(entity));
+    }
+    else if (flags & ERenderChangeFlags::Removed)
+    {
+      m_RenderChanges.removed.push_back(MakeEntity(entity));
+    }
+    else
+    {
+      m_RenderChanges.modified.push_back(MakeEntity(entity));
+    }
+  }
+  m_PendingRenderChanges.clear();
+
+  return m_RenderChanges;
+}
+
+
+void FEntityRegistry::ClearRenderChanges()
+{
+  m_PendingRenderChanges.clear();
+  m_RenderChanges.added.clear();
+  m_RenderChanges.removed.clear();
+  m_RenderChanges.modified.clear();
+}
+
+
+void FEntityRegistry::OnRenderMeshConstruct(entt::registry&, entt::entity entity)
+{
+  m_PendingRenderChanges[entity] |= ERenderChangeFlags::Added;
+}
+
+
+void FEntityRegistry::OnRenderMeshUpdate(entt::registry&, entt::entity entity)
+{
+  m_PendingRenderChanges[entity] |= ERenderChangeFlags::Modified;
+}
+
+
+void FEntityRegistry::OnRenderMeshDestroy(entt::registry&, entt::entity entity)
+{
+  m_PendingRenderChanges[entity] |= ERenderChangeFlags::Removed;
+}
+
+
+void FEntityRegistry::OnTransformConstruct(entt::registry& registry, entt::entity entity)
+{
+  const FTransformHandle handle = registry.get<FTransformComponent>(entity).handle;
+  if (handle == UUNUSED)
+  {
+    return;
+  }
+
+  if (handle >= m_TransformOwners.size())
   {
-    Register();
+    m_TransformOwners.resize(handle + 1, entt::null);
   }
+  m_TransformOwners[handle] = entity;
+}
+
 
-  auto it = std::next(m_Entities.begin(), savingSize);
-  return { it, m_Entities.end() };
+void FEntityRegistry::OnTransformDestroy(entt::registry& registry, entt::entity entity)
+{
+  const FTransformHandle handle = registry.get<FTransformComponent>(entity).handle;
+  if (m_Transforms.IsValid(handle))
+  {
+    m_Transforms.Remove(handle);
+  }
+  if (handle < m_TransformOwners.size())
+  {
+    m_TransformOwners[handle] = entt::null;
+  }
 }
 
 
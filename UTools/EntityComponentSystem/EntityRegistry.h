@@ -5,13 +5,78 @@
 
 #include <entt/entt.hpp>
 #include "Entity.h"
+#include "TransformHierarchy.h"
+#include "UTools/JobSystem/JobSystem.h"
 #include <span>
+#include <algorithm>
+#include <memory_resource>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 
 namespace uncanny
 {
 
 
+/// @brief FRenderEntityChanges lists render entities (with FRenderMeshComponent) changed since previous collection.
+/// @details Every entity is present in at most one list. Entity added and removed within the same frame is not
+/// reported at all. Removed entities are no longer valid, only their FEntity::GetID() can be used as a key.
+struct FRenderEntityChanges
+{
+  std::vector<FEntity> added{};
+  std::vector<FEntity> removed{};
+  std::vector<FEntity> modified{};
+
+  [[nodiscard]] b32 IsEmpty() const { return added.empty() and removed.empty() and modified.empty(); }
+};
+
+
+/// @brief FEntityBatch is a group of entities created at once by FEntityRegistry::RegisterBatch().
+/// @details Entities are kept contiguous, so components can be emplaced for all of them in bulk. Batch owns its
+/// copy of handles, they stay valid no matter how registry grows later.
+class FEntityBatch
+{
+
+  friend class FEntityRegistry;
+
+public:
+
+  FEntityBatch() = default;
+
+  [[nodiscard]] u32 GetCount() const { return m_Entities.size(); }
+
+  [[nodiscard]] FEntity operator[](u32 index) const
+  {
+    FEntity rtn{};
+    rtn.m_pRegistry = m_pRegistry;
+    rtn.m_Entity = m_Entities[index];
+    return rtn;
+  }
+
+  /// @brief Emplaces components[i] for i-th entity of batch, components count must be equal to batch count
+  template<ConceptComponent TComponent>
+  void Add(std::span<const TComponent> components) const
+  {
+    m_pRegistry->insert<TComponent>(m_Entities.begin(), m_Entities.end(), components.begin());
+  }
+
+  /// @brief Emplaces copy of the same component for every entity of batch
+  template<ConceptComponent TComponent>
+  void Add(const TComponent& component) const
+  {
+    m_pRegistry->insert<TComponent>(m_Entities.begin(), m_Entities.end(), component);
+  }
+
+private:
+
+  entt::registry* m_pRegistry{ nullptr };
+  std::vector<entt::entity> m_Entities{};
+
+};
+
+
 class FEntityRegistry
 {
 public:
@@ -20,25 +85,117 @@ public:
   void Destroy();
 
   FEntity Register();
+
+  /// @brief Creates count entities at once, returned span is invalidated by next registration
   std::span<FEntity> Register(u32 count);
 
+  /// @brief Creates count entities at once and returns them as batch, which allows emplacing components in bulk
+  FEntityBatch RegisterBatch(u32 count);
+
   [[nodiscard]] std::span<const FEntity> GetEntities() const { return m_Entities; }
 
-  template<ConceptComponent TComponent>
-  void ForEach(std::function<void(TComponent&)> func)
+  [[nodiscard]] FTransformHierarchy& GetTransforms() { return m_Transforms; }
+  [[nodiscard]] const FTransformHierarchy& GetTransforms() const { return m_Transforms; }
+
+  /// @brief Updates transform hierarchy and gathers render entities added, removed or modified since last call.
+  /// @details Should be called once per frame. Modification is detected when FRenderMeshComponent was changed
+  /// through FEntity::Patch() / FEntity::Replace() or when world matrix of entity's FTransformComponent changed.
+  /// Returned reference is valid until next call. When transforms are updated separately (e.g. by transform
+  /// system scheduled before), updateTransforms must be false, otherwise changes of that update would be lost.
+  const FRenderEntityChanges& CollectRenderChanges(b32 updateTransforms = UTRUE);
+
+  /// @returns changes gathered by last CollectRenderChanges()
+  [[nodiscard]] const FRenderEntityChanges& GetRenderChanges() const { return m_RenderChanges; }
+
+  /// @brief Drops all pending changes, useful after whole level was built from current state
+  void ClearRenderChanges();
+
+  /// @brief Iterates over every entity that has all TComponents and calls func with references to them.
+  /// @details func is a template callable, so there is no type erasure and call can be inlined. Iteration is
+  /// driven by entt multi-view, so it goes over the smallest storage of requested components. If func accepts
+  /// FEntity as first argument, entity is passed as well.
+  template<ConceptComponent... TComponents, typename TFunc>
+  void ForEach(TFunc&& func)
   {
-    auto view = m_Registry.view<TComponent>();
+    auto view = m_Registry.view<TComponents...>();
     for (auto entity : view)
     {
-      auto& component = view.template get<TComponent>(entity);
-      func(component);
+      if constexpr (std::is_invocable_v<TFunc, FEntity, TComponents&...>)
+      {
+        func(MakeEntity(entity), view.template get<TComponents>(entity)...);
+      }
+      else
+      {
+        func(view.template get<TComponents>(entity)...);
+      }
     }
   }
 
+  /// @brief Parallel version of ForEach(), leading storage (first of TComponents) is split into ranges of at
+  /// least minGrainSize entities with FJobSystem::ParallelFor() and calling thread helps until all are done.
+  /// @details func must be safe to call concurrently for different entities and it must not add / remove
+  /// components or entities, as storages cannot be modified during parallel iteration. Place the component
+  /// with the smallest storage first for the best performance.
+  template<ConceptComponent... TComponents, typename TFunc>
+  void ParallelForEach(FJobSystem* pJobSystem, TFunc&& func, u32 minGrainSize = 4096)
+  {
+    auto view = m_Registry.view<TComponents...>();
+    const auto& leadingStorage = m_Registry.storage<std::tuple_element_t<0, std::tuple<TComponents...>>>();
+    const entt::entity* pEntities = leadingStorage.data();
+
+    pJobSystem->ParallelFor((u32)leadingStorage.size(), [this, &view, &func, pEntities](u32 first, u32 last)
+    {
+      for (u32 i = first; i < last; i++)
+      {
+        const entt::entity entity = pEntities[i];
+        if constexpr (sizeof...(TComponents) > 1)
+        {
+          if (not view.contains(entity))
+          {
+            continue;
+          }
+        }
+        if constexpr (std::is_invocable_v<TFunc, FEntity, TComponents&...>)
+        {
+          func(MakeEntity(entity), view.template get<TComponents>(entity)...);
+        }
+        else
+        {
+          func(view.template get<TComponents>(entity)...);
+        }
+      }
+    }, minGrainSize);
+  }
+
+private:
+
+  [[nodiscard]] FEntity MakeEntity(entt::entity entity)
+  {
+    FEntity rtn{};
+    rtn.m_pRegistry = &m_Registry;
+    rtn.m_Entity = entity;
+    return rtn;
+  }
+
+  void OnRenderMeshConstruct(entt::registry& registry, entt::entity entity);
+  void OnRenderMeshUpdate(entt::registry& registry, entt::entity entity);
+  void OnRenderMeshDestroy(entt::registry& registry, entt::entity entity);
+  void OnTransformConstruct(entt::registry& registry, entt::entity entity);
+  void OnTransformDestroy(entt::registry& registry, entt::entity entity);
+
 private:
 
   entt::registry m_Registry{};
   std::vector<FEntity> m_Entities{};
+  FTransformHierarchy m_Transforms{};
+
+  // Change tracking, flags from ERenderChangeFlags are accumulated per entity until next collection. Map nodes
+  // are recycled by pool, so tracking doesn't allocate from heap every frame...
+  std::pmr::unsynchronized_pool_resource m_RenderChangesPool{};
+  std::pmr::unordered_map<entt::entity, u8> m_PendingRenderChanges{ &m_RenderChangesPool };
+  std::vector<entt::entity> m_TransformOwners{};
+  std::vector<FTransformHandle> m_ChangedTransforms{};
+  FRenderEntityChanges m_RenderChanges{};
 
 };
 
@@ -1,80 +1,190 @@
 
 #include "EntityRegistryLoader.h"
 #include "EntityRegistry.h"
+#include "SceneSerializer.h"
 #include "UTools/Assets/AssetRegistry.h"
 #include "UTools/Logger/Log.h"
 #include "UTools/Filesystem/Path.h"
-#include <nlohmann/json.hpp>
-#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <string_view>
 
 
 namespace uncanny
 {
 
 
+static b32 IsBinaryScenePath(std::string_view path)
+{
+  constexpr std::string_view binaryExtension{ ".uscene" };
+  return path.size() >= binaryExtension.size() and path.ends_with(binaryExtension);
+}
+
+
+void FEntityRegistryLoader::LoadScene(const char* path, FEntityRegistry* pEntityRegistry,
+                                      FAssetRegistry* pAssetRegistry)
+{
+  if (IsBinaryScenePath(path))
+  {
+    LoadBinaryScene(path, pEntityRegistry, pAssetRegistry);
+  }
+  else
+  {
+    LoadJsonScene(path, pEntityRegistry, pAssetRegistry);
+  }
+}
+
+
 void FEntityRegistryLoader::LoadJsonScene(const char* path, FEntityRegistry* pEntityRegistry,
                                           FAssetRegistry* pAssetRegistry)
 {
   pEntityRegistry->Destroy();
   pAssetRegistry->Clear();
+  UDEBUG("Loading json scene file: {}", path);
 
-  std::ifstream jsonFileStream{ path };
-  if (not jsonFileStream.is_open())
+  const auto start = std::chrono::steady_clock::now();
+  FSceneDescription scene{};
+  if (not FSceneSerializer::ReadJson(path, &scene))
   {
-    UERROR("Cannot open json scene file {}!", path);
     return;
   }
-  UDEBUG("Loading json scene file: {}", path);
+  const auto end = std::chrono::steady_clock::now();
+
+  InstantiateScene(path, scene, pEntityRegistry, pAssetRegistry,
+                   std::chrono::duration<f64, std::milli>(end - start).count());
+}
 
-  nlohmann::json data = nlohmann::json::parse(jsonFileStream);
-  jsonFileStream.close();
 
-  const FPath enginePath = FPath::GetEngineProjectPath();
+void FEntityRegistryLoader::LoadBinaryScene(const char* path, FEntityRegistry* pEntityRegistry,
+                                            FAssetRegistry* pAssetRegistry)
+{
+  pEntityRegistry->Destroy();
+  pAssetRegistry->Clear();
+  UDEBUG("Loading binary scene file: {}", path);
+
+  const auto start = std::chrono::steady_clock::now();
+  FSceneDescription scene{};
+  if (not FSceneSerializer::ReadBinary(path, &scene))
+  {
+    return;
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  InstantiateScene(path, scene, pEntityRegistry, pAssetRegistry,
+                   std::chrono::duration<f64, std::milli>(end - start).count());
+}
+
+
+b32 FEntityRegistryLoader::ConvertJsonToBinaryScene(const char* jsonPath, const char* binaryPath)
+{
+  FSceneDescription scene{};
+  return FSceneSerializer::ReadJson(jsonPath, &scene) and FSceneSerializer::WriteBinary(binaryPath, scene);
+}
+
+
+b32 FEntityRegistryLoader::ConvertBinaryToJsonScene(const char* binaryPath, const char* jsonPath)
+{
+  FSceneDescription scene{};
+  return FSceneSerializer::ReadBinary(binaryPath, &scene) and FSceneSerializer::WriteJson(jsonPath, scene);
+}
 
-  u32 entityIdx = 0;
-  for (nlohmann::json& _entity : data["Scene"]["Entities"]) {
-    // Load path to mesh...
-    u32 pathIdx = 0;
-    FPath meshAssetPath = enginePath;
-    for (nlohmann::json& _meshPath : data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["path"])
+
+void FEntityRegistryLoader::InstantiateScene(const char* path, const FSceneDescription& scene,
+                                             FEntityRegistry* pEntityRegistry, FAssetRegistry* pAssetRegistry,
+                                             f64 readingTime)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  // Every unique mesh is loaded once, its ID is stable, so it is the same across runs and scene formats...
+  const std::string enginePath = FPath::GetEngineProjectPath().GetStringPath();
+  for (u32 i = 0; i < scene.meshPaths.size(); i++)
+  {
+    const FPath meshAssetPath{ enginePath + scene.meshPaths[i] };
+    FMeshAsset& meshAsset = pAssetRegistry->RegisterMesh(scene.meshIds[i]);
+    meshAsset.LoadObj(meshAssetPath.GetStringPath().c_str(), UFALSE);
+  }
+
+  const auto meshesLoaded = std::chrono::steady_clock::now();
+
+  // Local transforms are copied in bulk, parent is referenced by index of entity in scene file and it can be
+  // declared after child, so parents are set afterwards...
+  const u32 entitiesCount = scene.GetEntitiesCount();
+  FTransformHierarchy& transforms = pEntityRegistry->GetTransforms();
+  std::vector<FTransformHandle> transformHandles(entitiesCount, UUNUSED);
+  transforms.AddRange(scene.positions, scene.rotations, scene.scales, transformHandles);
+
+  // Entities are created in one pass, transform components are emplaced in bulk...
+  const FEntityBatch entities = pEntityRegistry->RegisterBatch(entitiesCount);
+  std::vector<FTransformComponent> transformComponents(entitiesCount);
+  for (u32 i = 0; i < entitiesCount; i++)
+  {
+    transformComponents[i].handle = transformHandles[i];
+  }
+  entities.Add<FTransformComponent>(std::span<const FTransformComponent>{ transformComponents });
+
+  for (u32 i = 0; i < entitiesCount; i++)
+  {
+    const u32 meshIndex = scene.entityMeshIndices[i];
+    if (meshIndex != UUNUSED)
     {
-      std::string pathPart = data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["path"][pathIdx];
-      meshAssetPath = FPath::Append(meshAssetPath, pathPart.c_str());
-      pathIdx++;
+      entities[i].Add<FRenderMeshComponent>(FRenderMeshComponent{ .id = scene.meshIds[meshIndex] });
     }
+  }
+
+  for (u32 i = 0; i < entitiesCount; i++)
+  {
+    const u32 parentIndex = scene.parents[i];
+    if (parentIndex == UUNUSED)
+    {
+      continue;
+    }
+    if (parentIndex >= entitiesCount or parentIndex == i)
+    {
+      UERROR("Entity {} in scene file {} has invalid parent {}!", i, path, parentIndex);
+      continue;
+    }
+    transforms.SetParent(transformHandles[i], transformHandles[parentIndex]);
+  }
+  transforms.Update();
+
+  const auto end = std::chrono::steady_clock::now();
+  UINFO("Loaded scene {} with {} entities and {} unique meshes, reading {} ms, meshes {} ms, entities {} ms",
+        path, entitiesCount, scene.meshPaths.size(), readingTime,
+        std::chrono::duration<f64, std::milli>(meshesLoaded - start).count(),
+        std::chrono::duration<f64, std::milli>(end - meshesLoaded).count());
+}
 
-    // Loading position...
-    math::Vector3f position{
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["position"]["x"].get<float>(),
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["position"]["y"].get<float>(),
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["position"]["z"].get<float>()
-    };
-    // Loading rotation...
-    math::Vector3f rotation{
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["rotation"]["x"].get<float>(),
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["rotation"]["y"].get<float>(),
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["rotation"]["z"].get<float>()
-    };
-    // Loading scale...
-    math::Vector3f scale{
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["scale"]["x"].get<float>(),
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["scale"]["y"].get<float>(),
-        data["Scene"]["Entities"][entityIdx]["RenderMeshComponent"]["scale"]["z"].get<float>()
-    };
-
-    FMeshAsset& meshAsset = pAssetRegistry->RegisterMesh();
-    meshAsset.LoadObj(meshAssetPath.GetStringPath().c_str(), UFALSE);
 
-    FEntity entity = pEntityRegistry->Register();
-    entity.Add<FRenderMeshComponent>(FRenderMeshComponent{
-        .id = meshAsset.ID(),
-        .position = position,
-        .rotation = rotation,
-        .scale = scale
-    });
+b32 FEntityRegistryLoader::GenerateJsonScene(const char* path, u32 entitiesCount,
+                                             std::initializer_list<const char*> meshPath)
+{
+  std::string joinedMeshPath{};
+  for (const char* pPart : meshPath)
+  {
+    if (not joinedMeshPath.empty())
+    {
+      joinedMeshPath += '/';
+    }
+    joinedMeshPath += pPart;
+  }
+
+  FSceneDescription scene{};
+  scene.Reserve(entitiesCount);
+  const u32 meshIndex = scene.AddMesh(joinedMeshPath);
 
-    entityIdx++;
+  // Entities are placed on a square grid, so that generated scene is also viewable...
+  const u32 gridSize = std::max<u32>(1, (u32)std::ceil(std::sqrt((f64)entitiesCount)));
+  constexpr f32 spacing{ 3.f };
+  for (u32 i = 0; i < entitiesCount; i++)
+  {
+    const u32 entityIndex = scene.AddEntity(meshIndex);
+    scene.positions[entityIndex] = math::Vector3f{ (f32)(i % gridSize) * spacing, 0.f, (f32)(i / gridSize) * spacing };
+    scene.rotations[entityIndex] = math::Vector3f{ 0.f, (f32)((i * 37) % 360), 0.f };
+    scene.scales[entityIndex] = math::Vector3f{ -1.f, -1.f, -1.f };
   }
+
+  return FSceneSerializer::WriteJson(path, scene);
 }
 
 
@@ -2,26 +2,54 @@
 #define UNCANNYENGINE_ENTITYLOADER_H
 
 
+#include "UTools/UTypes.h"
+#include <initializer_list>
+
+
 namespace uncanny
 {
 
 
 class FEntityRegistry;
 class FAssetRegistry;
+struct FSceneDescription;
 
 
 class FEntityRegistryLoader
 {
 public:
 
+  /// @brief Loads binary .uscene file or json scene file depending on extension
+  static void LoadScene(const char* path, FEntityRegistry* pEntityRegistry, FAssetRegistry* pAssetRegistry);
+
   /// @details I have decided to write a FEntityRegistryLoader and pass a asset registry pointer as every
   /// FRenderMeshComponent contains an ID to asset registry mesh. During loading all entities we need to
   /// load mesh and generate its unique ID.
   /// TODO__: this is not ideal, I would like to write some FAssetRegistryLoader which will load meshes with already
   ///     generated IDs and entity registry will also load those already generated IDs, then we would have complete
   ///     separation between entity registry and asset registry
+  /// @details Scene file is parsed in a single SAX pass straight into preallocated arrays, no json DOM
+  /// is created. Every unique mesh path is loaded once and shared by all entities referencing it.
   static void LoadJsonScene(const char* path, FEntityRegistry* pEntityRegistry, FAssetRegistry* pAssetRegistry);
 
+  /// @brief Loads binary .uscene file, every section of it is copied in bulk, see FSceneSerializer.
+  static void LoadBinaryScene(const char* path, FEntityRegistry* pEntityRegistry, FAssetRegistry* pAssetRegistry);
+
+  /// @brief Converts json scene to binary .uscene file, conversion is lossless in both directions
+  static b32 ConvertJsonToBinaryScene(const char* jsonPath, const char* binaryPath);
+  static b32 ConvertBinaryToJsonScene(const char* binaryPath, const char* jsonPath);
+
+  /// @brief Writes json scene with entitiesCount entities placed on a grid, all referencing the same mesh.
+  /// @details Used for measuring loading of big scenes. meshPath is relative to engine project path, the same
+  /// way as "path" array in scene files, e.g. { "resources", "CornellBox", "CornellBox-Sphere.obj" }.
+  static b32 GenerateJsonScene(const char* path, u32 entitiesCount, std::initializer_list<const char*> meshPath);
+
+private:
+
+  /// @brief Creates entities, transforms and mesh assets described by scene
+  static void InstantiateScene(const char* path, const FSceneDescription& scene, FEntityRegistry* pEntityRegistry,
+                               FAssetRegistry* pAssetRegistry, f64 readingTime);
+
 };
 
 
@@ -0,0 +1,748 @@
+
+#include "SceneSerializer.h"
+#include "UTools/Logger/Log.h"
+#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+
+namespace uncanny
+{
+
+
+void FSceneDescription::Reserve(u32 entitiesCount)
+{
+  entityMeshIndices.reserve(entitiesCount);
+  parents.reserve(entitiesCount);
+  positions.reserve(entitiesCount);
+  rotations.reserve(entitiesCount);
+  scales.reserve(entitiesCount);
+}
+
+
+u32 FSceneDescription::AddEntity(u32 meshIndex)
+{
+  entityMeshIndices.push_back(meshIndex);
+  parents.push_back(UUNUSED);
+  positions.push_back(math::Vector3f{ 0.f, 0.f, 0.f });
+  rotations.push_back(math::Vector3f{ 0.f, 0.f, 0.f });
+  scales.push_back(math::Vector3f{ 1.f, 1.f, 1.f });
+  return entityMeshIndices.size() - 1;
+}
+
+
+u32 FSceneDescription::AddMesh(std::string meshPath)
+{
+  meshIds.push_back(FSceneSerializer::CalculateStableID(meshPath));
+  meshPaths.push_back(std::move(meshPath));
+  return meshPaths.size() - 1;
+}
+
+
+static b32 ReadWholeFile(const char* path, std::string& outContent)
+{
+  std::ifstream fileStream{ path, std::ios::binary | std::ios::ate };
+  if (not fileStream.is_open())
+  {
+    UERROR("Cannot open scene file {}!", path);
+    return UFALSE;
+  }
+
+  outContent.resize((size_t)fileStream.tellg());
+  fileStream.seekg(0);
+  fileStream.read(outContent.data(), (std::streamsize)outContent.size());
+  return fileStream.good();
+}
+
+
+/// @brief FJsonSaxReader is minimal single pass json reader that reports parsed tokens to THandler.
+/// @details It works directly on loaded file content. Strings without escape sequences are passed as views into
+/// content, so no allocations are made for keys and values. Numbers are converted with std::from_chars.
+template<typename THandler>
+class FJsonSaxReader
+{
+public:
+
+  FJsonSaxReader(std::string_view content, THandler* pHandler)
+    : m_Content(content), m_pHandler(pHandler)
+  {
+  }
+
+  b32 Parse()
+  {
+    SkipWhitespace();
+    if (not ParseValue())
+    {
+      UERROR("Json parse error at byte {}!", m_Position);
+      return UFALSE;
+    }
+    return UTRUE;
+  }
+
+private:
+
+  void SkipWhitespace()
+  {
+    while (m_Position < m_Content.size())
+    {
+      const char c = m_Content[m_Position];
+      if (c != ' ' and c != '\n' and c != '\r' and c != '\t')
+      {
+        break;
+      }
+      m_Position++;
+    }
+  }
+
+  [[nodiscard]] char Peek() const { return m_Position < m_Content.size() ? m_Content[m_Position] : '\0'; }
+
+  b32 ParseValue()
+  {
+    switch (Peek())
+    {
+      case '{': return ParseObject();
+      case '[': return ParseArray();
+      case '"':
+      {
+        std::string_view value{};
+        if (not ParseString(value))
+        {
+          return UFALSE;
+        }
+        m_pHandler->String(value);
+        return UTRUE;
+      }
+      case 't': return ParseLiteral("true") and (m_pHandler->Bool(UTRUE), UTRUE);
+      case 'f': return ParseLiteral("false") and (m_pHandler->Bool(UFALSE), UTRUE);
+      case 'n': return ParseLiteral("null") and (m_pHandler->Null(), UTRUE);
+      default: return ParseNumber();
+    }
+  }
+
+  b32 ParseObject()
+  {
+    m_Position++;
+    m_pHandler->StartObject();
+    SkipWhitespace();
+    if (Peek() == '}')
+    {
+      m_Position++;
+      m_pHandler->EndObject();
+      return UTRUE;
+    }
+
+    while (UTRUE)
+    {
+      std::string_view key{};
+      if (Peek() != '"' or not ParseString(key))
+      {
+        return UFALSE;
+      }
+      m_pHandler->Key(key);
+
+      SkipWhitespace();
+      if (Peek() != ':')
+      {
+        return UFALSE;
+      }
+      m_Position++;
+      SkipWhitespace();
+      if (not ParseValue())
+      {
+        return UFALSE;
+      }
+
+      SkipWhitespace();
+      const char c = Peek();
+      m_Position++;
+      if (c == '}')
+      {
+        m_pHandler->EndObject();
+        return UTRUE;
+      }
+      if (c != ',')
+      {
+        return UFALSE;
+      }
+      SkipWhitespace();
+    }
+  }
+
+  b32 ParseArray()
+  {
+    m_Position++;
+    m_pHandler->StartArray();
+    SkipWhitespace();
+    if (Peek() == ']')
+    {
+      m_Position++;
+      m_pHandler->EndArray();
+      return UTRUE;
+    }
+
+    while (UTRUE)
+    {
+      if (not ParseValue())
+      {
+        return UFALSE;
+      }
+
+      SkipWhitespace();
+      const char c = Peek();
+      m_Position++;
+      if (c == ']')
+      {
+        m_pHandler->EndArray();
+        return UTRUE;
+      }
+      if (c != ',')
+      {
+        return UFALSE;
+      }
+      SkipWhitespace();
+    }
+  }
+
+  b32 ParseString(std::string_view& outValue)
+  {
+    const u64 first = ++m_Position;
+    while (m_Position < m_Content.size() and m_Content[m_Position] != '"' and m_Content[m_Position] != '\\')
+    {
+      m_Position++;
+    }
+    if (Peek() == '"')
+    {
+      outValue = m_Content.substr(first, m_Position - first);
+      m_Position++;
+      return UTRUE;
+    }
+
+    // Rare case with escape sequences, string is decoded into scratch buffer...
+    m_Scratch.assign(m_Content.data() + first, m_Position - first);
+    while (m_Position < m_Content.size())
+    {
+      const char c = m_Content[m_Position++];
+      if (c == '"')
+      {
+        outValue = m_Scratch;
+        return UTRUE;
+      }
+      if (c != '\\')
+      {
+        m_Scratch += c;
+        continue;
+      }
+
+      switch (Peek())
+      {
+        case 'n': m_Scratch += '\n'; break;
+        case 't': m_Scratch += '\t'; break;
+        case 'r': m_Scratch += '\r'; break;
+        case 'b': m_Scratch += '\b'; break;
+        case 'f': m_Scratch += '\f'; break;
+        case '"': case '\\': case '/': m_Scratch += Peek(); break;
+        default: return UFALSE;
+      }
+      m_Position++;
+    }
+    return UFALSE;
+  }
+
+  b32 ParseNumber()
+  {
+    f64 value{ 0.0 };
+    const char* pFirst = m_Content.data() + m_Position;
+    const char* pLast = m_Content.data() + m_Content.size();
+    auto [ptr, errorCode] = std::from_chars(pFirst, pLast, value);
+    if (errorCode != std::errc{})
+    {
+      return UFALSE;
+    }
+    m_Position += ptr - pFirst;
+    m_pHandler->Number(value, std::string_view(pFirst, ptr - pFirst));
+    return UTRUE;
+  }
+
+  b32 ParseLiteral(std::string_view literal)
+  {
+    if (m_Content.substr(m_Position, literal.size()) != literal)
+    {
+      return UFALSE;
+    }
+    m_Position += literal.size();
+    return UTRUE;
+  }
+
+private:
+
+  std::string_view m_Content{};
+  std::string m_Scratch{};
+  THandler* m_pHandler{ nullptr };
+  u64 m_Position{ 0 };
+
+};
+
+
+/// @brief FJsonSceneHandler consumes tokens from FJsonSaxReader and fills FSceneDescription in a single pass.
+/// @details Only the keys used by scene format are recognized, every other key is skipped. Every opened container
+/// is pushed on a stack together with the key that opened it, so value handlers know where they are without any
+/// DOM lookups. Mesh path is concatenated once per entity and deduplicated with hash map.
+class FJsonSceneHandler
+{
+public:
+
+  enum class EKey
+  {
+    None, Scene, Entities, Entity, RenderMeshComponent, Path, Position, Rotation, Scale, X, Y, Z, Parent
+  };
+
+  explicit FJsonSceneHandler(FSceneDescription* pScene)
+    : m_pScene(pScene)
+  {
+    m_Stack.reserve(16);
+  }
+
+  void Null() { m_LastKey = EKey::None; }
+  void Bool(b32) { m_LastKey = EKey::None; }
+
+  void String(std::string_view value)
+  {
+    if (Top() == EKey::Path)
+    {
+      if (not m_CurrentPath.empty())
+      {
+        m_CurrentPath += '/';
+      }
+      m_CurrentPath += value;
+    }
+    m_LastKey = EKey::None;
+  }
+
+  void StartObject()
+  {
+    const EKey container = Top() == EKey::Entities ? EKey::Entity : m_LastKey;
+    m_Stack.push_back(container);
+    m_LastKey = EKey::None;
+    if (container == EKey::Entity)
+    {
+      m_CurrentEntity = m_pScene->AddEntity();
+      m_CurrentPath.clear();
+    }
+  }
+
+  void EndObject()
+  {
+    if (Top() == EKey::Entity)
+    {
+      EndEntity();
+    }
+    m_Stack.pop_back();
+    m_LastKey = EKey::None;
+  }
+
+  void StartArray()
+  {
+    m_Stack.push_back(m_LastKey);
+    m_LastKey = EKey::None;
+  }
+
+  void EndArray()
+  {
+    m_Stack.pop_back();
+    m_LastKey = EKey::None;
+  }
+
+  void Key(std::string_view key)
+  {
+    m_LastKey = ClassifyKey(key);
+  }
+
+  void Number(f64 value, std::string_view text)
+  {
+    const EKey container = Top();
+    math::Vector3f* pVector = nullptr;
+    if (container == EKey::Position)
+    {
+      pVector = &m_pScene->positions[m_CurrentEntity];
+    }
+    else if (container == EKey::Rotation)
+    {
+      pVector = &m_pScene->rotations[m_CurrentEntity];
+    }
+    else if (container == EKey::Scale)
+    {
+      pVector = &m_pScene->scales[m_CurrentEntity];
+    }
+
+    if (pVector)
+    {
+      // Parsed directly as float, so that shortest float representation written by WriteJson() reads back exactly...
+      f32 floatValue{ (f32)value };
+      std::from_chars(text.data(), text.data() + text.size(), floatValue);
+      switch (m_LastKey)
+      {
+        case EKey::X: pVector->x = floatValue; break;
+        case EKey::Y: pVector->y = floatValue; break;
+        case EKey::Z: pVector->z = floatValue; break;
+        default: break;
+      }
+    }
+    else if (container == EKey::Entity and m_LastKey == EKey::Parent)
+    {
+      m_pScene->parents[m_CurrentEntity] = value >= 0.0 ? (u32)value : UUNUSED;
+    }
+
+    m_LastKey = EKey::None;
+  }
+
+private:
+
+  [[nodiscard]] EKey Top() const { return m_Stack.empty() ? EKey::None : m_Stack.back(); }
+
+  static EKey ClassifyKey(std::string_view key)
+  {
+    if (key.size() == 1)
+    {
+      switch (key[0])
+      {
+        case 'x': return EKey::X;
+        case 'y': return EKey::Y;
+        case 'z': return EKey::Z;
+        default: return EKey::None;
+      }
+    }
+    if (key == "path") return EKey::Path;
+    if (key == "position") return EKey::Position;
+    if (key == "rotation") return EKey::Rotation;
+    if (key == "scale") return EKey::Scale;
+    if (key == "parent") return EKey::Parent;
+    if (key == "RenderMeshComponent") return EKey::RenderMeshComponent;
+    if (key == "Entities") return EKey::Entities;
+    if (key == "Scene") return EKey::Scene;
+    return EKey::None;
+  }
+
+  void EndEntity()
+  {
+    // Entity without mesh path has only transform, it may be used as parent of other entities...
+    if (m_CurrentPath.empty())
+    {
+      return;
+    }
+
+    auto [it, inserted] = m_MeshIndicesByPath.try_emplace(m_CurrentPath, (u32)m_pScene->meshPaths.size());
+    if (inserted)
+    {
+      m_pScene->AddMesh(m_CurrentPath);
+    }
+    m_pScene->entityMeshIndices[m_CurrentEntity] = it->second;
+  }
+
+private:
+
+  FSceneDescription* m_pScene{ nullptr };
+  std::string m_CurrentPath{};
+  std::vector<EKey> m_Stack{};
+  std::unordered_map<std::string, u32> m_MeshIndicesByPath{};
+  u32 m_CurrentEntity{ UUNUSED };
+  EKey m_LastKey{ EKey::None };
+
+};
+
+
+b32 FSceneSerializer::ReadJson(const char* path, FSceneDescription* pScene)
+{
+  *pScene = {};
+
+  std::string content{};
+  if (not ReadWholeFile(path, content))
+  {
+    return UFALSE;
+  }
+
+  // Generated scenes take roughly 250 bytes per entity, arrays are reserved so that they don't grow while parsing...
+  constexpr u32 approximateBytesPerEntity{ 250 };
+  pScene->Reserve(content.size() / approximateBytesPerEntity + 1);
+
+  FJsonSceneHandler handler{ pScene };
+  FJsonSaxReader<FJsonSceneHandler> reader{ content, &handler };
+  if (not reader.Parse())
+  {
+    UERROR("Cannot parse json scene file {}!", path);
+    return UFALSE;
+  }
+  return UTRUE;
+}
+
+
+static void AppendJsonVector(std::string& out, const char* pName, math::Vector3f vec)
+{
+  // Shortest representation that reads back to exactly the same float...
+  char buffer[32];
+  const f32 values[]{ vec.x, vec.y, vec.z };
+  const char* names[]{ "x", "y", "z" };
+
+  out += '"';
+  out += pName;
+  out += "\": { ";
+  for (u32 i = 0; i < 3; i++)
+  {
+    auto [ptr, errorCode] = std::to_chars(buffer, buffer + sizeof(buffer), values[i]);
+    out += '"';
+    out += names[i];
+    out += "\": ";
+    out.append(buffer, ptr);
+    out += i < 2 ? ", " : " }";
+  }
+}
+
+
+b32 FSceneSerializer::WriteJson(const char* path, const FSceneDescription& scene)
+{
+  std::ofstream fileStream{ path, std::ios::binary | std::ios::trunc };
+  if (not fileStream.is_open())
+  {
+    UERROR("Cannot open json scene file {} for writing!", path);
+    return UFALSE;
+  }
+
+  // Path arrays are prepared once per unique mesh...
+  std::vector<std::string> pathArrays{};
+  pathArrays.reserve(scene.meshPaths.size());
+  for (const std::string& meshPath : scene.meshPaths)
+  {
+    std::string& pathArray = pathArrays.emplace_back("\"");
+    for (char c : meshPath)
+    {
+      pathArray += c == '/' ? std::string_view{ "\", \"" } : std::string_view{ &c, 1 };
+    }
+    pathArray += '"';
+  }
+
+  std::string line{};
+  fileStream << "{\n  \"Scene\": {\n    \"Entities\": [\n";
+  const u32 entitiesCount = scene.GetEntitiesCount();
+  for (u32 i = 0; i < entitiesCount; i++)
+  {
+    line = "      { \"RenderMeshComponent\": { ";
+    if (scene.entityMeshIndices[i] != UUNUSED)
+    {
+      line += "\"path\": [ ";
+      line += pathArrays[scene.entityMeshIndices[i]];
+      line += " ], ";
+    }
+    AppendJsonVector(line, "position", scene.positions[i]);
+    line += ", ";
+    AppendJsonVector(line, "rotation", scene.rotations[i]);
+    line += ", ";
+    AppendJsonVector(line, "scale", scene.scales[i]);
+    line += " }";
+    if (scene.parents[i] != UUNUSED)
+    {
+      line += ", \"parent\": ";
+      line += std::to_string(scene.parents[i]);
+    }
+    line += i + 1 < entitiesCount ? " },\n" : " }\n";
+    fileStream.write(line.data(), (std::streamsize)line.size());
+  }
+  fileStream << "    ]\n  }\n}\n";
+
+  return fileStream.good();
+}
+
+
+struct FSceneFileHeader
+{
+  char magic[4]{ 'U', 'S', 'C', 'N' };
+  u32 version{ FSceneSerializer::binaryVersion };
+  u32 entitiesCount{ 0 };
+  u32 assetsCount{ 0 };
+  u64 assetTableOffset{ 0 };
+  u64 entityTableOffset{ 0 };
+  u64 transformsOffset{ 0 };
+  u64 stringsOffset{ 0 };
+  u64 stringsSize{ 0 };
+  u64 fileSize{ 0 };
+};
+
+
+struct FSceneFileAsset
+{
+  u64 stableID{ UUNUSED };
+  u32 pathOffset{ 0 };
+  u32 pathLength{ 0 };
+};
+
+
+static_assert(sizeof(math::Vector3f) == 3 * sizeof(f32), "Transforms are copied in bulk, Vector3f must be packed!");
+static_assert(sizeof(FSceneFileHeader) % 8 == 0 and sizeof(FSceneFileAsset) % 8 == 0);
+
+
+static constexpr u64 AlignTo8(u64 value)
+{
+  return (value + 7) & ~7ull;
+}
+
+
+b32 FSceneSerializer::WriteBinary(const char* path, const FSceneDescription& scene)
+{
+  const u64 entitiesCount = scene.GetEntitiesCount();
+  const u64 assetsCount = scene.meshPaths.size();
+
+  FSceneFileHeader header{};
+  header.entitiesCount = entitiesCount;
+  header.assetsCount = assetsCount;
+  header.assetTableOffset = sizeof(FSceneFileHeader);
+  header.entityTableOffset = AlignTo8(header.assetTableOffset + assetsCount * sizeof(FSceneFileAsset));
+  header.transformsOffset = AlignTo8(header.entityTableOffset + 2 * entitiesCount * sizeof(u32));
+  header.stringsOffset = AlignTo8(header.transformsOffset + 3 * entitiesCount * sizeof(math::Vector3f));
+
+  std::vector<FSceneFileAsset> assets(assetsCount);
+  std::string strings{};
+  for (u64 i = 0; i < assetsCount; i++)
+  {
+    assets[i] = FSceneFileAsset{
+        .stableID = scene.meshIds[i],
+        .pathOffset = (u32)strings.size(),
+        .pathLength = (u32)scene.meshPaths[i].size()
+    };
+    strings += scene.meshPaths[i];
+  }
+  header.stringsSize = strings.size();
+  header.fileSize = header.stringsOffset + header.stringsSize;
+
+  // Whole file is assembled in memory and written at once...
+  std::vector<char> buffer(header.fileSize, 0);
+  auto copySection = [&buffer](u64 offset, const void* pData, u64 size)
+  {
+    if (size > 0)
+    {
+      memcpy(buffer.data() + offset, pData, size);
+    }
+  };
+  const u64 vectorsSize = entitiesCount * sizeof(math::Vector3f);
+  copySection(0, &header, sizeof(header));
+  copySection(header.assetTableOffset, assets.data(), assetsCount * sizeof(FSceneFileAsset));
+  copySection(header.entityTableOffset, scene.entityMeshIndices.data(), entitiesCount * sizeof(u32));
+  copySection(header.entityTableOffset + entitiesCount * sizeof(u32), scene.parents.data(),
+              entitiesCount * sizeof(u32));
+  copySection(header.transformsOffset, scene.positions.data(), vectorsSize);
+  copySection(header.transformsOffset + vectorsSize, scene.rotations.data(), vectorsSize);
+  copySection(header.transformsOffset + 2 * vectorsSize, scene.scales.data(), vectorsSize);
+  copySection(header.stringsOffset, strings.data(), strings.size());
+
+  std::ofstream fileStream{ path, std::ios::binary | std::ios::trunc };
+  if (not fileStream.is_open())
+  {
+    UERROR("Cannot open binary scene file {} for writing!", path);
+    return UFALSE;
+  }
+  fileStream.write(buffer.data(), (std::streamsize)buffer.size());
+  return fileStream.good();
+}
+
+
+b32 FSceneSerializer::ReadBinary(const char* path, FSceneDescription* pScene)
+{
+  *pScene = {};
+
+  std::string content{};
+  if (not ReadWholeFile(path, content))
+  {
+    return UFALSE;
+  }
+
+  FSceneFileHeader header{};
+  if (content.size() < sizeof(FSceneFileHeader))
+  {
+    UERROR("Binary scene file {} is too small!", path);
+    return UFALSE;
+  }
+  memcpy(&header, content.data(), sizeof(FSceneFileHeader));
+
+  if (memcmp(header.magic, FSceneFileHeader{}.magic, sizeof(header.magic)) != 0)
+  {
+    UERROR("File {} is not a binary scene file!", path);
+    return UFALSE;
+  }
+  if (header.version != binaryVersion)
+  {
+    UERROR("Binary scene file {} has version {}, expected {}!", path, header.version, binaryVersion);
+    return UFALSE;
+  }
+
+  const u64 entitiesCount = header.entitiesCount;
+  const u64 assetsCount = header.assetsCount;
+  const u64 vectorsSize = entitiesCount * sizeof(math::Vector3f);
+  const b32 validLayout =
+      header.fileSize == content.size() and
+      header.assetTableOffset + assetsCount * sizeof(FSceneFileAsset) <= header.entityTableOffset and
+      header.entityTableOffset + 2 * entitiesCount * sizeof(u32) <= header.transformsOffset and
+      header.transformsOffset + 3 * vectorsSize <= header.stringsOffset and
+      header.stringsOffset + header.stringsSize <= content.size();
+  if (not validLayout)
+  {
+    UERROR("Binary scene file {} is corrupted!", path);
+    return UFALSE;
+  }
+
+  // Every section is copied in bulk...
+  const char* pData = content.data();
+  auto copySection = [pData](auto& vec, u64 count, u64 offset)
+  {
+    vec.resize(count);
+    if (count > 0)
+    {
+      memcpy(vec.data(), pData + offset, count * sizeof(vec[0]));
+    }
+  };
+  std::vector<FSceneFileAsset> assets{};
+  copySection(assets, assetsCount, header.assetTableOffset);
+  copySection(pScene->entityMeshIndices, entitiesCount, header.entityTableOffset);
+  copySection(pScene->parents, entitiesCount, header.entityTableOffset + entitiesCount * sizeof(u32));
+  copySection(pScene->positions, entitiesCount, header.transformsOffset);
+  copySection(pScene->rotations, entitiesCount, header.transformsOffset + vectorsSize);
+  copySection(pScene->scales, entitiesCount, header.transformsOffset + 2 * vectorsSize);
+
+  pScene->meshPaths.reserve(assetsCount);
+  pScene->meshIds.reserve(assetsCount);
+  for (const FSceneFileAsset& asset : assets)
+  {
+    if ((u64)asset.pathOffset + asset.pathLength > header.stringsSize)
+    {
+      UERROR("Binary scene file {} has invalid asset path!", path);
+      *pScene = {};
+      return UFALSE;
+    }
+    pScene->meshPaths.emplace_back(pData + header.stringsOffset + asset.pathOffset, asset.pathLength);
+    pScene->meshIds.push_back(asset.stableID);
+  }
+
+  for (u32 meshIndex : pScene->entityMeshIndices)
+  {
+    if (meshIndex != UUNUSED and meshIndex >= assetsCount)
+    {
+      UERROR("Binary scene file {} references invalid asset {}!", path, meshIndex);
+      *pScene = {};
+      return UFALSE;
+    }
+  }
+
+  return UTRUE;
+}
+
+
+u64 FSceneSerializer::CalculateStableID(std::string_view meshPath)
+{
+  u64 hash{ 14695981039346656037ull };
+  for (char c : meshPath)
+  {
+    hash ^= (u8)c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+}
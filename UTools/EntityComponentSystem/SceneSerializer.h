@@ -0,0 +1,75 @@
+
+#ifndef UNCANNYENGINE_SCENESERIALIZER_H
+#define UNCANNYENGINE_SCENESERIALIZER_H
+
+
+#include "UTools/UTypes.h"
+#include "UMath/Types.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace uncanny
+{
+
+
+/// @brief FSceneDescription is registry independent form of scene file, every array is indexed by entity in file
+/// order except meshPaths / meshIds, which describe unique mesh assets.
+/// @details Mesh paths are relative to engine project path and '/' separated, e.g.
+/// "resources/CornellBox/CornellBox-Sphere.obj". Entity references mesh with index into meshPaths, mesh is
+/// identified across files and runs with stable ID calculated from its path.
+struct FSceneDescription
+{
+  std::vector<std::string> meshPaths{};
+  std::vector<u64> meshIds{};
+
+  std::vector<u32> entityMeshIndices{};
+  std::vector<u32> parents{};
+  std::vector<math::Vector3f> positions{};
+  std::vector<math::Vector3f> rotations{};
+  std::vector<math::Vector3f> scales{};
+
+  [[nodiscard]] u32 GetEntitiesCount() const { return entityMeshIndices.size(); }
+
+  void Reserve(u32 entitiesCount);
+
+  /// @brief Appends entity with identity transform and returns its index
+  u32 AddEntity(u32 meshIndex = UUNUSED);
+
+  /// @brief Appends mesh with given path and its stable ID, returns its index. Paths are expected to be unique.
+  u32 AddMesh(std::string meshPath);
+};
+
+
+/// @brief FSceneSerializer reads and writes FSceneDescription as json or as binary .uscene file.
+/// @details Binary .uscene file layout (little endian, every section aligned to 8 bytes):
+///  - FSceneFileHeader with magic, version and offsets of all sections,
+///  - asset table: FSceneFileAsset (stable ID, path offset and length) per unique mesh,
+///  - entity table: u32 mesh indices of all entities, then u32 parent indices of all entities,
+///  - transforms in SoA layout: all positions, then all rotations, then all scales,
+///  - string blob with mesh paths.
+/// Reading binary file is bulk copy of every section, nothing is parsed per entity. Conversion between both
+/// formats is lossless, floats are written to json in shortest form that reads back to the same value.
+class FSceneSerializer
+{
+public:
+
+  static b32 ReadJson(const char* path, FSceneDescription* pScene);
+  static b32 WriteJson(const char* path, const FSceneDescription& scene);
+
+  static b32 ReadBinary(const char* path, FSceneDescription* pScene);
+  static b32 WriteBinary(const char* path, const FSceneDescription& scene);
+
+  /// @brief Calculates stable mesh ID from its relative path (64-bit FNV-1a)
+  static u64 CalculateStableID(std::string_view meshPath);
+
+  static constexpr u32 binaryVersion{ 1 };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_SCENESERIALIZER_H
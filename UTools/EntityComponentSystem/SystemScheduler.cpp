@@ -0,0 +1,207 @@
+
+#include "SystemScheduler.h"
+#include "UTools/JobSystem/JobSystem.h"
+#include <algorithm>
+#include <thread>
+
+
+namespace uncanny
+{
+
+
+b32 FSystemAccess::ConflictsWith(const FSystemAccess& other) const
+{
+  auto contains = [](const std::vector<entt::id_type>& types, entt::id_type type)
+  {
+    return std::find(types.begin(), types.end(), type) != types.end();
+  };
+
+  for (entt::id_type type : m_Writes)
+  {
+    if (contains(other.m_Writes, type) or contains(other.m_Reads, type))
+    {
+      return UTRUE;
+    }
+  }
+  for (entt::id_type type : m_Reads)
+  {
+    if (contains(other.m_Writes, type))
+    {
+      return UTRUE;
+    }
+  }
+  return UFALSE;
+}
+
+
+u32 FSystemScheduler::AddSystem(std::string name, FSystemAccess access, FSystemFunction function)
+{
+  m_Systems.push_back(FSystem{
+    .name = std::move(name),
+    .access = std::move(access),
+    .function = std::move(function)
+  });
+  m_GraphInvalid = UTRUE;
+  return m_Systems.size() - 1;
+}
+
+
+void FSystemScheduler::Clear()
+{
+  m_Systems.clear();
+  m_Timings.clear();
+  m_pPendingDependencies.reset();
+  m_MainThreadQueue.clear();
+  m_GraphInvalid = UFALSE;
+}
+
+
+std::span<const u32> FSystemScheduler::GetDependencies(u32 system)
+{
+  if (m_GraphInvalid)
+  {
+    BuildGraph();
+  }
+  return m_Systems[system].dependencies;
+}
+
+
+void FSystemScheduler::BuildGraph()
+{
+  for (u32 i = 0; i < m_Systems.size(); i++)
+  {
+    FSystem& system = m_Systems[i];
+    system.dependencies.clear();
+    system.dependents.clear();
+    for (u32 j = 0; j < i; j++)
+    {
+      if (system.access.ConflictsWith(m_Systems[j].access))
+      {
+        system.dependencies.push_back(j);
+        m_Systems[j].dependents.push_back(i);
+      }
+    }
+  }
+
+  m_Timings.resize(m_Systems.size());
+  for (u32 i = 0; i < m_Systems.size(); i++)
+  {
+    m_Timings[i].name = m_Systems[i].name.c_str();
+  }
+  m_pPendingDependencies = std::make_unique<std::atomic<u32>[]>(m_Systems.size());
+  m_GraphInvalid = UFALSE;
+}
+
+
+void FSystemScheduler::Run(FJobSystem* pJobSystem, f32 deltaTime)
+{
+  if (m_GraphInvalid)
+  {
+    BuildGraph();
+  }
+
+  m_FrameStart = std::chrono::steady_clock::now();
+  m_DeltaTime = deltaTime;
+  m_pJobSystem = pJobSystem and pJobSystem->GetThreadsCount() > 1 ? pJobSystem : nullptr;
+
+  if (not m_pJobSystem)
+  {
+    // Registration order respects every dependency...
+    m_RemainingSystems.store(m_Systems.size(), std::memory_order_relaxed);
+    for (u32 i = 0; i < m_Systems.size(); i++)
+    {
+      Execute(i);
+    }
+  }
+  else
+  {
+    m_RemainingSystems.store(m_Systems.size(), std::memory_order_relaxed);
+    for (u32 i = 0; i < m_Systems.size(); i++)
+    {
+      m_pPendingDependencies[i].store(m_Systems[i].dependencies.size(), std::memory_order_relaxed);
+    }
+    for (u32 i = 0; i < m_Systems.size(); i++)
+    {
+      if (m_Systems[i].dependencies.empty())
+      {
+        Dispatch(i);
+      }
+    }
+
+    while (m_RemainingSystems.load(std::memory_order_acquire) != 0)
+    {
+      if (ExecuteMainThreadSystem() or m_pJobSystem->TryExecuteJob())
+      {
+        continue;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  const auto frameEnd = std::chrono::steady_clock::now();
+  m_LastFrameTime = std::chrono::duration<f64, std::milli>(frameEnd - m_FrameStart).count();
+}
+
+
+void FSystemScheduler::Dispatch(u32 index)
+{
+  if (m_Systems[index].access.m_MainThread)
+  {
+    std::lock_guard lock{ m_MainThreadMutex };
+    m_MainThreadQueue.push_back(index);
+    return;
+  }
+
+  m_pJobSystem->Spawn([this, index]()
+  {
+    Execute(index);
+  });
+}
+
+
+void FSystemScheduler::Execute(u32 index)
+{
+  const auto start = std::chrono::steady_clock::now();
+  m_Systems[index].function(m_DeltaTime);
+  const auto end = std::chrono::steady_clock::now();
+
+  FSystemTiming& timing = m_Timings[index];
+  timing.startTime = std::chrono::duration<f64, std::milli>(start - m_FrameStart).count();
+  timing.duration = std::chrono::duration<f64, std::milli>(end - start).count();
+  timing.threadIndex = m_pJobSystem ? m_pJobSystem->GetCurrentThreadIndex() : 0;
+
+  if (m_pJobSystem)
+  {
+    for (u32 dependent : m_Systems[index].dependents)
+    {
+      if (m_pPendingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        Dispatch(dependent);
+      }
+    }
+  }
+
+  // Last access to scheduler state from this system, Run() may return right after...
+  m_RemainingSystems.fetch_sub(1, std::memory_order_release);
+}
+
+
+b32 FSystemScheduler::ExecuteMainThreadSystem()
+{
+  u32 index;
+  {
+    std::lock_guard lock{ m_MainThreadMutex };
+    if (m_MainThreadQueue.empty())
+    {
+      return UFALSE;
+    }
+    index = m_MainThreadQueue.back();
+    m_MainThreadQueue.pop_back();
+  }
+
+  Execute(index);
+  return UTRUE;
+}
+
+
+}
@@ -0,0 +1,147 @@
+
+#ifndef UNCANNYENGINE_SYSTEMSCHEDULER_H
+#define UNCANNYENGINE_SYSTEMSCHEDULER_H
+
+
+#include <entt/entt.hpp>
+#include "UTools/UTypes.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+
+namespace uncanny
+{
+
+
+class FJobSystem;
+
+
+/// @brief FSystemAccess declares which types system reads and writes. Type can be a component or any other
+/// shared resource (camera, render changes etc.), conflicts are detected by type only.
+class FSystemAccess
+{
+
+  friend class FSystemScheduler;
+
+public:
+
+  template<typename... TTypes>
+  FSystemAccess& Reads()
+  {
+    (m_Reads.push_back(entt::type_hash<TTypes>::value()), ...);
+    return *this;
+  }
+
+  template<typename... TTypes>
+  FSystemAccess& Writes()
+  {
+    (m_Writes.push_back(entt::type_hash<TTypes>::value()), ...);
+    return *this;
+  }
+
+  /// @brief System is always executed on thread calling FSystemScheduler::Run(), e.g. when it polls window input
+  FSystemAccess& OnMainThread()
+  {
+    m_MainThread = UTRUE;
+    return *this;
+  }
+
+  /// @returns true if one of systems writes type, that the other reads or writes
+  [[nodiscard]] b32 ConflictsWith(const FSystemAccess& other) const;
+
+private:
+
+  std::vector<entt::id_type> m_Reads{};
+  std::vector<entt::id_type> m_Writes{};
+  b8 m_MainThread{ UFALSE };
+
+};
+
+
+/// @brief FSystemTiming describes last execution of system, times are in milliseconds since frame start.
+struct FSystemTiming
+{
+  const char* name{ nullptr };
+  f64 startTime{ 0.0 };
+  f64 duration{ 0.0 };
+  u32 threadIndex{ UUNUSED };
+};
+
+
+/// @brief FSystemScheduler runs registered per-frame systems, non-conflicting ones concurrently on FJobSystem.
+/// @details Dependency graph is built from declared access: system depends on every earlier registered system
+/// it conflicts with, so registration order decides order of conflicting systems and is always a valid
+/// sequential order. During Run() every system with all dependencies finished is spawned as a job, main thread
+/// systems are queued for calling thread, which meanwhile helps with other jobs.
+class FSystemScheduler
+{
+public:
+
+  typedef std::function<void(f32 deltaTime)> FSystemFunction;
+
+  /// @returns index of added system
+  u32 AddSystem(std::string name, FSystemAccess access, FSystemFunction function);
+
+  void Clear();
+
+  /// @brief Runs all systems once and waits for them, without job system (or with single thread) they are
+  /// executed in registration order on calling thread.
+  void Run(FJobSystem* pJobSystem, f32 deltaTime);
+
+  [[nodiscard]] u32 GetSystemsCount() const { return m_Systems.size(); }
+
+  /// @returns indices of systems, which must finish before given system starts
+  [[nodiscard]] std::span<const u32> GetDependencies(u32 system);
+
+  /// @returns timings of all systems from last Run(), indexed the same way as systems
+  [[nodiscard]] std::span<const FSystemTiming> GetTimings() const { return m_Timings; }
+
+  /// @returns duration of last Run() in milliseconds
+  [[nodiscard]] f64 GetLastFrameTime() const { return m_LastFrameTime; }
+
+private:
+
+  void BuildGraph();
+
+  void Dispatch(u32 index);
+  void Execute(u32 index);
+  b32 ExecuteMainThreadSystem();
+
+private:
+
+  struct FSystem
+  {
+    std::string name{};
+    FSystemAccess access{};
+    FSystemFunction function{};
+    std::vector<u32> dependencies{};
+    std::vector<u32> dependents{};
+  };
+
+  std::vector<FSystem> m_Systems{};
+  std::vector<FSystemTiming> m_Timings{};
+  std::unique_ptr<std::atomic<u32>[]> m_pPendingDependencies{};
+
+  std::mutex m_MainThreadMutex{};
+  std::vector<u32> m_MainThreadQueue{};
+
+  std::atomic<u32> m_RemainingSystems{ 0 };
+  FJobSystem* m_pJobSystem{ nullptr };
+  std::chrono::steady_clock::time_point m_FrameStart{};
+  f64 m_LastFrameTime{ 0.0 };
+  f32 m_DeltaTime{ 0.f };
+  b8 m_GraphInvalid{ UFALSE };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_SYSTEMSCHEDULER_H
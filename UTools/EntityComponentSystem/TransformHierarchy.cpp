@@ -0,0 +1,515 @@
+
+#include "TransformHierarchy.h"
+#include "UTools/Logger/Log.h"
+#include "UMath/Trig.h"
+#include "UTools/JobSystem/JobSystem.h"
+#include <algorithm>
+
+
+namespace uncanny
+{
+
+
+template<typename T>
+static void PermuteVector(std::vector<T>& vec, const std::vector<u32>& order)
+{
+  std::vector<T> permuted{};
+  permuted.reserve(vec.size());
+  for (u32 oldIndex : order)
+  {
+    permuted.push_back(vec[oldIndex]);
+  }
+  vec = std::move(permuted);
+}
+
+
+FTransformHandle FTransformHierarchy::Add(FTransformHandle parent)
+{
+  FTransformHandle handle;
+  if (not m_FreeHandles.empty())
+  {
+    handle = m_FreeHandles.back();
+    m_FreeHandles.pop_back();
+  }
+  else
+  {
+    handle = m_HandleToIndex.size();
+    m_HandleToIndex.push_back(UUNUSED);
+  }
+
+  const u32 index = m_Parents.size();
+  const u32 parentIndex = parent != UUNUSED ? IndexOf(parent) : UUNUSED;
+  m_HandleToIndex[handle] = index;
+
+  m_Positions.push_back(math::Vector3f{ 0.f, 0.f, 0.f });
+  m_Rotations.push_back(math::Vector3f{ 0.f, 0.f, 0.f });
+  m_Scales.push_back(math::Vector3f{ 1.f, 1.f, 1.f });
+  m_WorldMatrices.push_back(math::Identity<f32>());
+  m_Parents.push_back(parentIndex);
+  m_Roots.push_back(parentIndex != UUNUSED ? m_Roots[parentIndex] : index);
+  m_SubtreeSizes.push_back(1);
+  m_LocalDirty.push_back(UFALSE);
+  m_WorldChanged.push_back(UFALSE);
+  m_RootQueued.push_back(UFALSE);
+  m_IndexToHandle.push_back(handle);
+
+  // New root is appended at the end, so preorder is kept. Child must be placed inside parent's range...
+  if (parentIndex != UUNUSED)
+  {
+    m_OrderInvalid = UTRUE;
+  }
+  MarkDirty(index);
+
+  return handle;
+}
+
+
+void FTransformHierarchy::AddRange(std::span<const math::Vector3f> positions,
+                                   std::span<const math::Vector3f> rotations,
+                                   std::span<const math::Vector3f> scales, std::span<FTransformHandle> outHandles)
+{
+  const u32 count = positions.size();
+  const u32 firstIndex = m_Parents.size();
+  if (m_Parents.capacity() < firstIndex + count)
+  {
+    Reserve(std::max<u32>(firstIndex + count, 2 * m_Parents.capacity()));
+  }
+
+  m_Positions.insert(m_Positions.end(), positions.begin(), positions.end());
+  m_Rotations.insert(m_Rotations.end(), rotations.begin(), rotations.end());
+  m_Scales.insert(m_Scales.end(), scales.begin(), scales.end());
+  m_WorldMatrices.resize(firstIndex + count, math::Identity<f32>());
+  m_Parents.resize(firstIndex + count, UUNUSED);
+  m_SubtreeSizes.resize(firstIndex + count, 1);
+  m_LocalDirty.resize(firstIndex + count, UFALSE);
+  m_WorldChanged.resize(firstIndex + count, UFALSE);
+  m_RootQueued.resize(firstIndex + count, UFALSE);
+
+  // All new nodes are roots appended at the end, so preorder is kept...
+  for (u32 i = 0; i < count; i++)
+  {
+    const u32 index = firstIndex + i;
+    FTransformHandle handle;
+    if (not m_FreeHandles.empty())
+    {
+      handle = m_FreeHandles.back();
+      m_FreeHandles.pop_back();
+    }
+    else
+    {
+      handle = m_HandleToIndex.size();
+      m_HandleToIndex.push_back(UUNUSED);
+    }
+
+    m_HandleToIndex[handle] = index;
+    m_IndexToHandle.push_back(handle);
+    m_Roots.push_back(index);
+    MarkDirty(index);
+    outHandles[i] = handle;
+  }
+}
+
+
+void FTransformHierarchy::Remove(FTransformHandle handle)
+{
+  // Node is only left without handle, it is dropped and its children are attached to its parent in next sort,
+  // so removing many nodes costs one pass over hierarchy instead of one pass per node...
+  const u32 index = IndexOf(handle);
+  m_IndexToHandle[index] = UUNUSED;
+  m_HandleToIndex[handle] = UUNUSED;
+  m_FreeHandles.push_back(handle);
+  m_RemovedNodesCount++;
+  m_LastUpdatedRoots.clear();
+  m_OrderInvalid = UTRUE;
+}
+
+
+void FTransformHierarchy::Clear()
+{
+  m_Positions.clear();
+  m_Rotations.clear();
+  m_Scales.clear();
+  m_WorldMatrices.clear();
+  m_Parents.clear();
+  m_Roots.clear();
+  m_SubtreeSizes.clear();
+  m_LocalDirty.clear();
+  m_WorldChanged.clear();
+  m_IndexToHandle.clear();
+  m_HandleToIndex.clear();
+  m_FreeHandles.clear();
+  m_DirtyRoots.clear();
+  m_RootQueued.clear();
+  m_LastUpdatedRoots.clear();
+  m_LastUpdatedNodesCount = 0;
+  m_RemovedNodesCount = 0;
+  m_OrderInvalid = UFALSE;
+}
+
+
+void FTransformHierarchy::Reserve(u32 count)
+{
+  m_Positions.reserve(count);
+  m_Rotations.reserve(count);
+  m_Scales.reserve(count);
+  m_WorldMatrices.reserve(count);
+  m_Parents.reserve(count);
+  m_Roots.reserve(count);
+  m_SubtreeSizes.reserve(count);
+  m_LocalDirty.reserve(count);
+  m_WorldChanged.reserve(count);
+  m_IndexToHandle.reserve(count);
+  m_HandleToIndex.reserve(count);
+  m_RootQueued.reserve(count);
+}
+
+
+void FTransformHierarchy::SetParent(FTransformHandle handle, FTransformHandle parent)
+{
+  const u32 index = IndexOf(handle);
+  const u32 parentIndex = parent != UUNUSED ? IndexOf(parent) : UUNUSED;
+
+  for (u32 ancestor = parentIndex; ancestor != UUNUSED; ancestor = m_Parents[ancestor])
+  {
+    if (ancestor == index)
+    {
+      UERROR("Cannot set parent of transform {}, as it would create a cycle!", handle);
+      return;
+    }
+  }
+
+  m_Parents[index] = parentIndex;
+  m_LocalDirty[index] = UTRUE;
+  m_OrderInvalid = UTRUE;
+}
+
+
+void FTransformHierarchy::SetLocal(FTransformHandle handle, math::Vector3f position, math::Vector3f rotation,
+                                   math::Vector3f scale)
+{
+  const u32 index = IndexOf(handle);
+  m_Positions[index] = position;
+  m_Rotations[index] = rotation;
+  m_Scales[index] = scale;
+  MarkDirty(index);
+}
+
+
+void FTransformHierarchy::SetPosition(FTransformHandle handle, math::Vector3f position)
+{
+  const u32 index = IndexOf(handle);
+  m_Positions[index] = position;
+  MarkDirty(index);
+}
+
+
+void FTransformHierarchy::SetRotation(FTransformHandle handle, math::Vector3f rotation)
+{
+  const u32 index = IndexOf(handle);
+  m_Rotations[index] = rotation;
+  MarkDirty(index);
+}
+
+
+void FTransformHierarchy::SetScale(FTransformHandle handle, math::Vector3f scale)
+{
+  const u32 index = IndexOf(handle);
+  m_Scales[index] = scale;
+  MarkDirty(index);
+}
+
+
+void FTransformHierarchy::MarkDirty(u32 index)
+{
+  m_LocalDirty[index] = UTRUE;
+  if (m_OrderInvalid)
+  {
+    // Dirty roots are gathered again after sorting...
+    return;
+  }
+
+  const u32 root = m_Roots[index];
+  if (not m_RootQueued[root])
+  {
+    m_RootQueued[root] = UTRUE;
+    m_DirtyRoots.push_back(root);
+  }
+}
+
+
+void FTransformHierarchy::SortDepthFirst()
+{
+  const u32 count = m_Parents.size();
+
+  // Removed nodes are skipped, their children are attached to the closest ancestor that is still alive...
+  if (m_RemovedNodesCount > 0)
+  {
+    for (u32 i = 0; i < count; i++)
+    {
+      u32 parent = m_Parents[i];
+      while (parent != UUNUSED and m_IndexToHandle[parent] == UUNUSED)
+      {
+        parent = m_Parents[parent];
+      }
+      if (parent != m_Parents[i])
+      {
+        m_Parents[i] = parent;
+        m_LocalDirty[i] = UTRUE;
+      }
+    }
+  }
+
+  // Children lists in compressed form, childrenOffsets[i]..childrenOffsets[i + 1] are children of node i...
+  std::vector<u32> childrenOffsets(count + 1, 0);
+  for (u32 i = 0; i < count; i++)
+  {
+    if (m_Parents[i] != UUNUSED and m_IndexToHandle[i] != UUNUSED)
+    {
+      childrenOffsets[m_Parents[i] + 1]++;
+    }
+  }
+  for (u32 i = 0; i < count; i++)
+  {
+    childrenOffsets[i + 1] += childrenOffsets[i];
+  }
+  std::vector<u32> children(childrenOffsets[count]);
+  std::vector<u32> fillOffsets(childrenOffsets.begin(), childrenOffsets.end() - 1);
+  for (u32 i = 0; i < count; i++)
+  {
+    if (m_Parents[i] != UUNUSED and m_IndexToHandle[i] != UUNUSED)
+    {
+      children[fillOffsets[m_Parents[i]]++] = i;
+    }
+  }
+
+  // Preorder traversal, children are pushed in reverse so that their relative order is kept...
+  std::vector<u32> order{};
+  order.reserve(count - m_RemovedNodesCount);
+  std::vector<u32> stack{};
+  for (u32 i = 0; i < count; i++)
+  {
+    if (m_Parents[i] != UUNUSED or m_IndexToHandle[i] == UUNUSED)
+    {
+      continue;
+    }
+
+    stack.push_back(i);
+    while (not stack.empty())
+    {
+      const u32 node = stack.back();
+      stack.pop_back();
+      order.push_back(node);
+      for (u32 c = childrenOffsets[node + 1]; c > childrenOffsets[node]; c--)
+      {
+        stack.push_back(children[c - 1]);
+      }
+    }
+  }
+
+  const u32 aliveCount = order.size();
+  std::vector<u32> oldToNew(count, UUNUSED);
+  for (u32 i = 0; i < aliveCount; i++)
+  {
+    oldToNew[order[i]] = i;
+  }
+
+  std::vector<u32> parents(aliveCount);
+  for (u32 i = 0; i < aliveCount; i++)
+  {
+    const u32 oldParent = m_Parents[order[i]];
+    parents[i] = oldParent != UUNUSED ? oldToNew[oldParent] : UUNUSED;
+  }
+  m_Parents = std::move(parents);
+
+  PermuteVector(m_Positions, order);
+  PermuteVector(m_Rotations, order);
+  PermuteVector(m_Scales, order);
+  PermuteVector(m_WorldMatrices, order);
+  PermuteVector(m_LocalDirty, order);
+  PermuteVector(m_IndexToHandle, order);
+  for (u32 i = 0; i < aliveCount; i++)
+  {
+    m_HandleToIndex[m_IndexToHandle[i]] = i;
+  }
+  m_Roots.resize(aliveCount);
+  m_SubtreeSizes.resize(aliveCount);
+  m_WorldChanged.resize(aliveCount);
+  m_RootQueued.resize(aliveCount);
+  m_RemovedNodesCount = 0;
+
+  // In preorder every parent lies before its children, so sizes can be accumulated backwards and roots forwards...
+  std::fill(m_SubtreeSizes.begin(), m_SubtreeSizes.end(), 1);
+  for (u32 i = aliveCount; i > 0; i--)
+  {
+    if (m_Parents[i - 1] != UUNUSED)
+    {
+      m_SubtreeSizes[m_Parents[i - 1]] += m_SubtreeSizes[i - 1];
+    }
+  }
+  for (u32 i = 0; i < aliveCount; i++)
+  {
+    m_Roots[i] = m_Parents[i] != UUNUSED ? m_Roots[m_Parents[i]] : i;
+  }
+
+  std::fill(m_WorldChanged.begin(), m_WorldChanged.end(), UFALSE);
+  std::fill(m_RootQueued.begin(), m_RootQueued.end(), UFALSE);
+  m_DirtyRoots.clear();
+  m_OrderInvalid = UFALSE;
+  for (u32 i = 0; i < aliveCount; i++)
+  {
+    if (m_LocalDirty[i])
+    {
+      MarkDirty(i);
+    }
+  }
+}
+
+
+void FTransformHierarchy::Update(FJobSystem* pJobSystem, u32 minParallelNodes)
+{
+  // Change flags from previous update are valid only until next one. After sorting all of them are reset, otherwise
+  // they can be set only inside ranges walked previously...
+  if (m_OrderInvalid)
+  {
+    SortDepthFirst();
+  }
+  else
+  {
+    for (u32 root : m_LastUpdatedRoots)
+    {
+      std::fill_n(m_WorldChanged.begin() + root, m_SubtreeSizes[root], UFALSE);
+    }
+  }
+  m_LastUpdatedRoots.clear();
+
+  u32 nodesCount = 0;
+  for (u32 root : m_DirtyRoots)
+  {
+    nodesCount += m_SubtreeSizes[root];
+    m_RootQueued[root] = UFALSE;
+  }
+  m_LastUpdatedNodesCount = nodesCount;
+
+  if (nodesCount == 0)
+  {
+    return;
+  }
+
+  // Dirty roots are independent of each other, so ranges of them are stealable jobs. Grain is given in roots,
+  // so that every job recalculates at least minNodesPerJob nodes on average...
+  const u32 dirtyRootsCount = m_DirtyRoots.size();
+  if (pJobSystem and nodesCount >= minParallelNodes and dirtyRootsCount > 1)
+  {
+    constexpr u64 minNodesPerJob{ 1024 };
+    const u32 minGrainSize = std::max<u64>(1, minNodesPerJob * dirtyRootsCount / nodesCount);
+    pJobSystem->ParallelFor(dirtyRootsCount, [this](u32 firstRoot, u32 lastRoot)
+    {
+      for (u32 r = firstRoot; r < lastRoot; r++)
+      {
+        const u32 root = m_DirtyRoots[r];
+        UpdateRange(root, root + m_SubtreeSizes[root]);
+      }
+    }, minGrainSize);
+  }
+  else
+  {
+    for (u32 root : m_DirtyRoots)
+    {
+      UpdateRange(root, root + m_SubtreeSizes[root]);
+    }
+  }
+
+  std::swap(m_LastUpdatedRoots, m_DirtyRoots);
+}
+
+
+void FTransformHierarchy::UpdateRange(u32 first, u32 last)
+{
+  for (u32 i = first; i < last; i++)
+  {
+    const u32 parent = m_Parents[i];
+    const b8 parentChanged = parent != UUNUSED and m_WorldChanged[parent];
+    if (not m_LocalDirty[i] and not parentChanged)
+    {
+      continue;
+    }
+
+    const math::Matrix4x4f local = ComposeLocalMatrix(i);
+    m_WorldMatrices[i] = parent != UUNUSED ? m_WorldMatrices[parent] * local : local;
+    m_WorldChanged[i] = UTRUE;
+    m_LocalDirty[i] = UFALSE;
+  }
+}
+
+
+math::Matrix4x4f FTransformHierarchy::ComposeLocalMatrix(u32 index) const
+{
+  const math::Vector3f& rotation = m_Rotations[index];
+  return {
+      math::Translation(m_Positions[index]) *
+      math::Rotation(math::radians(rotation.x), {1.f, 0.f, 0.f}) *
+      math::Rotation(math::radians(rotation.y), {0.f, 1.f, 0.f}) *
+      math::Rotation(math::radians(rotation.z), {0.f, 0.f, 1.f}) *
+      math::Scale(m_Scales[index])
+  };
+}
+
+
+const math::Matrix4x4f& FTransformHierarchy::GetWorldMatrix(FTransformHandle handle) const
+{
+  return m_WorldMatrices[IndexOf(handle)];
+}
+
+
+FTransformHandle FTransformHierarchy::GetParent(FTransformHandle handle) const
+{
+  // Removed parents are skipped, as they are dropped only in next sort...
+  u32 parentIndex = m_Parents[IndexOf(handle)];
+  while (parentIndex != UUNUSED and m_IndexToHandle[parentIndex] == UUNUSED)
+  {
+    parentIndex = m_Parents[parentIndex];
+  }
+  return parentIndex != UUNUSED ? m_IndexToHandle[parentIndex] : UUNUSED;
+}
+
+
+math::Vector3f FTransformHierarchy::GetPosition(FTransformHandle handle) const
+{
+  return m_Positions[IndexOf(handle)];
+}
+
+
+math::Vector3f FTransformHierarchy::GetRotation(FTransformHandle handle) const
+{
+  return m_Rotations[IndexOf(handle)];
+}
+
+
+math::Vector3f FTransformHierarchy::GetScale(FTransformHandle handle) const
+{
+  return m_Scales[IndexOf(handle)];
+}
+
+
+b32 FTransformHierarchy::HasChanged(FTransformHandle handle) const
+{
+  return m_WorldChanged[IndexOf(handle)];
+}
+
+
+void FTransformHierarchy::GatherChangedHandles(std::vector<FTransformHandle>& outHandles) const
+{
+  for (u32 root : m_LastUpdatedRoots)
+  {
+    for (u32 i = root; i < root + m_SubtreeSizes[root]; i++)
+    {
+      if (m_WorldChanged[i])
+      {
+        outHandles.push_back(m_IndexToHandle[i]);
+      }
+    }
+  }
+}
+
+
+}
@@ -0,0 +1,136 @@
+
+#ifndef UNCANNYENGINE_TRANSFORMHIERARCHY_H
+#define UNCANNYENGINE_TRANSFORMHIERARCHY_H
+
+
+#include "UTools/UTypes.h"
+#include "UMath/Matrix4x4.h"
+#include <span>
+#include <vector>
+
+
+namespace uncanny
+{
+
+
+class FJobSystem;
+
+
+/// @brief FTransformHandle is stable identifier of node in FTransformHierarchy. It stays valid when nodes are
+/// reordered, only Remove() invalidates it.
+typedef u32 FTransformHandle;
+
+
+/// @brief FTransformHierarchy keeps local transforms of all nodes with parent links and calculates world matrices.
+/// @details Data is stored as structure of arrays in depth-first preorder, so every root with its descendants
+/// is one contiguous range and parent always lies before its children. Thanks to that Update() is a single
+/// linear pass over dirty ranges: world = world[parent] * local, where dirty flag is propagated from parent
+/// while walking. Roots without any changed node are skipped entirely, so static scenes cost nothing.
+/// Reparenting / adding child nodes / removing nodes only marks order as invalid, sorting (and dropping removed
+/// nodes) happens once in next Update().
+/// Local matrix is composed the same way as in FRenderMeshComponent: T * Rx * Ry * Rz * S, rotation in degrees.
+class FTransformHierarchy
+{
+public:
+
+  /// @brief Adds new node with identity local transform as a child of parent (or as root if parent is UUNUSED)
+  FTransformHandle Add(FTransformHandle parent = UUNUSED);
+
+  /// @brief Adds positions.size() root nodes at once with given local transforms, handles are written to
+  /// outHandles. Local transforms are copied in bulk, meant for loading scenes.
+  void AddRange(std::span<const math::Vector3f> positions, std::span<const math::Vector3f> rotations,
+                std::span<const math::Vector3f> scales, std::span<FTransformHandle> outHandles);
+
+  /// @brief Removes node, its children are attached to parent of removed node. Handle is freed at once, node
+  /// itself is dropped in next Update() together with all other removed nodes.
+  void Remove(FTransformHandle handle);
+
+  void Clear();
+
+  /// @brief Reserves space for count nodes, useful before loading big scenes
+  void Reserve(u32 count);
+
+  void SetParent(FTransformHandle handle, FTransformHandle parent);
+
+  void SetLocal(FTransformHandle handle, math::Vector3f position, math::Vector3f rotation, math::Vector3f scale);
+  void SetPosition(FTransformHandle handle, math::Vector3f position);
+  void SetRotation(FTransformHandle handle, math::Vector3f rotation);
+  void SetScale(FTransformHandle handle, math::Vector3f scale);
+
+  /// @brief Recalculates world matrices of all dirty nodes and their descendants.
+  /// @details Ranges of independent dirty roots are run with FJobSystem::ParallelFor() when job system is given
+  /// and there are at least minParallelNodes nodes to recalculate, otherwise everything is done on calling thread.
+  void Update(FJobSystem* pJobSystem = nullptr, u32 minParallelNodes = 16384);
+
+  [[nodiscard]] const math::Matrix4x4f& GetWorldMatrix(FTransformHandle handle) const;
+  [[nodiscard]] FTransformHandle GetParent(FTransformHandle handle) const;
+  [[nodiscard]] math::Vector3f GetPosition(FTransformHandle handle) const;
+  [[nodiscard]] math::Vector3f GetRotation(FTransformHandle handle) const;
+  [[nodiscard]] math::Vector3f GetScale(FTransformHandle handle) const;
+
+  /// @brief Returns true if world matrix of node has changed during last Update()
+  [[nodiscard]] b32 HasChanged(FTransformHandle handle) const;
+
+  /// @brief Appends handles of all nodes changed during last Update(), only ranges walked by it are visited
+  void GatherChangedHandles(std::vector<FTransformHandle>& outHandles) const;
+
+  [[nodiscard]] b32 IsValid(FTransformHandle handle) const
+  {
+    return handle < m_HandleToIndex.size() and m_HandleToIndex[handle] != UUNUSED;
+  }
+
+  [[nodiscard]] u32 GetNodesCount() const { return m_Parents.size() - m_RemovedNodesCount; }
+
+  /// @brief World matrices in internal (preorder) order, valid until next Update()
+  [[nodiscard]] std::span<const math::Matrix4x4f> GetWorldMatrices() const { return m_WorldMatrices; }
+
+  /// @returns count of nodes, which world matrix was recalculated in last Update()
+  [[nodiscard]] u32 GetLastUpdatedNodesCount() const { return m_LastUpdatedNodesCount; }
+
+private:
+
+  [[nodiscard]] u32 IndexOf(FTransformHandle handle) const { return m_HandleToIndex[handle]; }
+
+  void MarkDirty(u32 index);
+
+  void SortDepthFirst();
+
+  void UpdateRange(u32 first, u32 last);
+
+  [[nodiscard]] math::Matrix4x4f ComposeLocalMatrix(u32 index) const;
+
+private:
+
+  // Structure of arrays, indexed by internal index...
+  std::vector<math::Vector3f> m_Positions{};
+  std::vector<math::Vector3f> m_Rotations{};
+  std::vector<math::Vector3f> m_Scales{};
+  std::vector<math::Matrix4x4f> m_WorldMatrices{};
+  std::vector<u32> m_Parents{};
+  std::vector<u32> m_Roots{};
+  std::vector<u32> m_SubtreeSizes{};
+  std::vector<u8> m_LocalDirty{};
+  std::vector<u8> m_WorldChanged{};
+  std::vector<FTransformHandle> m_IndexToHandle{};
+
+  // Indirection from stable handles...
+  std::vector<u32> m_HandleToIndex{};
+  std::vector<FTransformHandle> m_FreeHandles{};
+
+  // Root indices that contain at least one dirty node, every root is stored at most once...
+  std::vector<u32> m_DirtyRoots{};
+  std::vector<u8> m_RootQueued{};
+  std::vector<u32> m_LastUpdatedRoots{};
+
+  u32 m_LastUpdatedNodesCount{ 0 };
+  // Removed nodes are left without handle (m_IndexToHandle is UUNUSED) until next sort...
+  u32 m_RemovedNodesCount{ 0 };
+  b8 m_OrderInvalid{ UFALSE };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_TRANSFORMHIERARCHY_H
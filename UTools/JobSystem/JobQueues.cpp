@@ -0,0 +1,159 @@
+
+#include "JobQueues.h"
+
+
+namespace uncanny
+{
+
+
+FWorkStealingDeque::FWorkStealingDeque()
+  : m_pJobs(std::make_unique<std::atomic<FJob*>[]>(capacity))
+{
+}
+
+
+b32 FWorkStealingDeque::Push(FJob* pJob)
+{
+  const i64 bottom = m_Bottom.load(std::memory_order_relaxed);
+  const i64 top = m_Top.load(std::memory_order_acquire);
+  if (bottom - top >= capacity)
+  {
+    return UFALSE;
+  }
+
+  m_pJobs[bottom & mask].store(pJob, std::memory_order_relaxed);
+  m_Bottom.store(bottom + 1, std::memory_order_release);
+  return UTRUE;
+}
+
+
+FJob* FWorkStealingDeque::Pop()
+{
+  const i64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+  m_Bottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  i64 top = m_Top.load(std::memory_order_relaxed);
+
+  if (top > bottom)
+  {
+    // Deque was empty...
+    m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  FJob* pJob = m_pJobs[bottom & mask].load(std::memory_order_relaxed);
+  if (top == bottom)
+  {
+    // Last job, race against thieves...
+    if (not m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+      pJob = nullptr;
+    }
+    m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return pJob;
+}
+
+
+FJob* FWorkStealingDeque::Steal()
+{
+  i64 top = m_Top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const i64 bottom = m_Bottom.load(std::memory_order_acquire);
+  if (top >= bottom)
+  {
+    return nullptr;
+  }
+
+  FJob* pJob = m_pJobs[top & mask].load(std::memory_order_relaxed);
+  if (not m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+  {
+    return nullptr;
+  }
+  return pJob;
+}
+
+
+b32 FWorkStealingDeque::IsEmpty() const
+{
+  return m_Top.load(std::memory_order_relaxed) >= m_Bottom.load(std::memory_order_relaxed);
+}
+
+
+FJobInjectionQueue::FJobInjectionQueue()
+  : m_pCells(std::make_unique<FCell[]>(capacity))
+{
+  for (u64 i = 0; i < capacity; i++)
+  {
+    m_pCells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+
+b32 FJobInjectionQueue::Push(FJob* pJob)
+{
+  FCell* pCell;
+  u64 position = m_EnqueuePosition.load(std::memory_order_relaxed);
+  while (UTRUE)
+  {
+    pCell = &m_pCells[position & mask];
+    const u64 sequence = pCell->sequence.load(std::memory_order_acquire);
+    const i64 difference = (i64)sequence - (i64)position;
+    if (difference == 0)
+    {
+      if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      // Queue is full...
+      return UFALSE;
+    }
+    else
+    {
+      position = m_EnqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  pCell->pJob = pJob;
+  pCell->sequence.store(position + 1, std::memory_order_release);
+  return UTRUE;
+}
+
+
+FJob* FJobInjectionQueue::Pop()
+{
+  FCell* pCell;
+  u64 position = m_DequeuePosition.load(std::memory_order_relaxed);
+  while (UTRUE)
+  {
+    pCell = &m_pCells[position & mask];
+    const u64 sequence = pCell->sequence.load(std::memory_order_acquire);
+    const i64 difference = (i64)sequence - (i64)(position + 1);
+    if (difference == 0)
+    {
+      if (m_DequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      // Queue is empty...
+      return nullptr;
+    }
+    else
+    {
+      position = m_DequeuePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  FJob* pJob = pCell->pJob;
+  pCell->sequence.store(position + mask + 1, std::memory_order_release);
+  return pJob;
+}
+
+
+}
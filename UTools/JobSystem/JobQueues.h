@@ -0,0 +1,83 @@
+
+#ifndef UNCANNYENGINE_JOBQUEUES_H
+#define UNCANNYENGINE_JOBQUEUES_H
+
+
+#include "UTools/UTypes.h"
+#include <atomic>
+#include <memory>
+
+
+namespace uncanny
+{
+
+
+struct FJob;
+
+
+/// @brief FWorkStealingDeque is fixed size Chase-Lev deque of jobs.
+/// @details Only owner thread can Push() and Pop() (LIFO end, hot in cache), any other thread can Steal()
+/// from opposite end (FIFO, usually bigger pieces of work). Implementation follows "Correct and Efficient
+/// Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Nardelli). Deque does not grow, Push() returns false
+/// when it is full and caller decides what to do with the job.
+class FWorkStealingDeque
+{
+public:
+
+  static constexpr i64 capacity{ 4096 };
+
+  FWorkStealingDeque();
+
+  b32 Push(FJob* pJob);
+  FJob* Pop();
+  FJob* Steal();
+
+  [[nodiscard]] b32 IsEmpty() const;
+
+private:
+
+  static constexpr i64 mask{ capacity - 1 };
+  static_assert((capacity & mask) == 0, "Capacity must be power of two!");
+
+  alignas(64) std::atomic<i64> m_Top{ 0 };
+  alignas(64) std::atomic<i64> m_Bottom{ 0 };
+  std::unique_ptr<std::atomic<FJob*>[]> m_pJobs{};
+
+};
+
+
+/// @brief FJobInjectionQueue is bounded lock-free multi producer / multi consumer queue (D. Vyukov's design).
+/// @details Used for jobs submitted from threads, which don't own any deque, and as overflow of full deques.
+class FJobInjectionQueue
+{
+public:
+
+  static constexpr u64 capacity{ 8192 };
+
+  FJobInjectionQueue();
+
+  b32 Push(FJob* pJob);
+  FJob* Pop();
+
+private:
+
+  struct FCell
+  {
+    std::atomic<u64> sequence{ 0 };
+    FJob* pJob{ nullptr };
+  };
+
+  static constexpr u64 mask{ capacity - 1 };
+  static_assert((capacity & mask) == 0, "Capacity must be power of two!");
+
+  std::unique_ptr<FCell[]> m_pCells{};
+  alignas(64) std::atomic<u64> m_EnqueuePosition{ 0 };
+  alignas(64) std::atomic<u64> m_DequeuePosition{ 0 };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_JOBQUEUES_H
@@ -0,0 +1,349 @@
+
+#include "JobSystem.h"
+#include "UTools/Logger/Log.h"
+
+
+namespace uncanny
+{
+
+
+struct FWorkerContext
+{
+  FJobSystem* pSystem{ nullptr };
+  FWorkStealingDeque deque{};
+  std::vector<FJob*> freeJobs{};
+  std::atomic<FJob*> pRemoteFreeJobs{ nullptr };
+  std::vector<std::unique_ptr<FJob[]>> jobChunks{};
+  u32 index{ UUNUSED };
+  u32 randomState{ 1 };
+};
+
+
+static thread_local FWorkerContext* t_pCurrentContext{ nullptr };
+
+
+FJobSystem::FJobSystem() = default;
+
+
+FJobSystem::~FJobSystem()
+{
+  Destroy();
+}
+
+
+void FJobSystem::Create(u32 workerThreadsCount)
+{
+  if (workerThreadsCount == UUNUSED)
+  {
+    const u32 hardwareThreadsCount = std::thread::hardware_concurrency();
+    workerThreadsCount = hardwareThreadsCount > 1 ? hardwareThreadsCount - 1 : 0;
+  }
+
+  m_Contexts.resize(workerThreadsCount + 1);
+  for (u32 i = 0; i < m_Contexts.size(); i++)
+  {
+    m_Contexts[i] = std::make_unique<FWorkerContext>();
+    m_Contexts[i]->pSystem = this;
+    m_Contexts[i]->index = i;
+    m_Contexts[i]->randomState = 0x9E3779B9u * (i + 1);
+  }
+
+  // Creating thread is worker 0, it executes jobs while it waits...
+  t_pCurrentContext = m_Contexts[0].get();
+
+  m_Running.store(UTRUE, std::memory_order_release);
+  m_Threads.reserve(workerThreadsCount);
+  for (u32 i = 1; i <= workerThreadsCount; i++)
+  {
+    m_Threads.emplace_back(&FJobSystem::WorkerLoop, this, i);
+  }
+
+  UINFO("Created job system with {} worker threads", workerThreadsCount);
+}
+
+
+void FJobSystem::Destroy()
+{
+  if (m_Contexts.empty())
+  {
+    return;
+  }
+
+  m_Running.store(UFALSE, std::memory_order_release);
+  m_WakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+  m_WakeEpoch.notify_all();
+  for (std::thread& thread : m_Threads)
+  {
+    thread.join();
+  }
+  m_Threads.clear();
+
+  // Jobs should be waited for before destroying, only heap allocated leftovers need to be freed...
+  while (FJob* pJob = m_InjectionQueue.Pop())
+  {
+    if (not pJob->pOwner)
+    {
+      delete pJob;
+    }
+  }
+
+  if (GetCurrentContext())
+  {
+    t_pCurrentContext = nullptr;
+  }
+  m_Contexts.clear();
+}
+
+
+void FJobSystem::Wait(const FJobCounter& counter)
+{
+  FWorkerContext* pContext = GetCurrentContext();
+  while (not counter.IsDone())
+  {
+    if (pContext and TryExecuteJob(pContext))
+    {
+      continue;
+    }
+    std::this_thread::yield();
+  }
+}
+
+
+b32 FJobSystem::TryExecuteJob()
+{
+  FWorkerContext* pContext = GetCurrentContext();
+  return pContext and TryExecuteJob(pContext);
+}
+
+
+u32 FJobSystem::GetCurrentThreadIndex() const
+{
+  const FWorkerContext* pContext = GetCurrentContext();
+  return pContext ? pContext->index : UUNUSED;
+}
+
+
+FJob* FJobSystem::AllocateJob()
+{
+  FWorkerContext* pContext = GetCurrentContext();
+  if (not pContext)
+  {
+    // Threads outside of job system have no free list...
+    return new FJob{};
+  }
+
+  if (pContext->freeJobs.empty())
+  {
+    FJob* pReturnedJob = pContext->pRemoteFreeJobs.exchange(nullptr, std::memory_order_acquire);
+    while (pReturnedJob)
+    {
+      pContext->freeJobs.push_back(pReturnedJob);
+      pReturnedJob = pReturnedJob->pNextWaiting;
+    }
+  }
+
+  if (pContext->freeJobs.empty())
+  {
+    constexpr u32 jobsPerChunk{ 256 };
+    FJob* pChunk = pContext->jobChunks.emplace_back(std::make_unique<FJob[]>(jobsPerChunk)).get();
+    pContext->freeJobs.reserve(pContext->freeJobs.capacity() + jobsPerChunk);
+    for (u32 i = 0; i < jobsPerChunk; i++)
+    {
+      pChunk[i].pOwner = pContext;
+      pContext->freeJobs.push_back(&pChunk[i]);
+    }
+  }
+
+  FJob* pJob = pContext->freeJobs.back();
+  pContext->freeJobs.pop_back();
+  return pJob;
+}
+
+
+void FJobSystem::ReleaseJob(FJob* pJob, FWorkerContext* pContext)
+{
+  FWorkerContext* pOwner = pJob->pOwner;
+  if (not pOwner)
+  {
+    delete pJob;
+  }
+  else if (pOwner == pContext)
+  {
+    pContext->freeJobs.push_back(pJob);
+  }
+  else
+  {
+    // Only owner takes the whole list at once, so there is no ABA problem...
+    FJob* pHead = pOwner->pRemoteFreeJobs.load(std::memory_order_relaxed);
+    do
+    {
+      pJob->pNextWaiting = pHead;
+    }
+    while (not pOwner->pRemoteFreeJobs.compare_exchange_weak(pHead, pJob, std::memory_order_release,
+                                                             std::memory_order_relaxed));
+  }
+}
+
+
+void FJobSystem::Schedule(FJob* pJob)
+{
+  FWorkerContext* pContext = GetCurrentContext();
+  const b32 pushed = (pContext and pContext->deque.Push(pJob)) or m_InjectionQueue.Push(pJob);
+  if (not pushed)
+  {
+    // Every queue is full, job is executed immediately instead of waiting for free slot...
+    if (pContext)
+    {
+      Execute(pJob, pContext);
+      return;
+    }
+    while (not m_InjectionQueue.Push(pJob))
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  WakeSleepingWorkers();
+}
+
+
+void FJobSystem::ScheduleAfter(FJob* pJob, FJobCounter& dependency)
+{
+  FJob* pHead = dependency.m_pWaitingJobs.load(std::memory_order_relaxed);
+  do
+  {
+    pJob->pNextWaiting = pHead;
+  }
+  while (not dependency.m_pWaitingJobs.compare_exchange_weak(pHead, pJob, std::memory_order_seq_cst,
+                                                             std::memory_order_relaxed));
+
+  // Either this thread sees finished dependency, or finishing thread sees the job in waiting list...
+  if (dependency.m_Remaining.load(std::memory_order_seq_cst) == 0)
+  {
+    ScheduleWaitingJobs(dependency);
+  }
+}
+
+
+void FJobSystem::ScheduleWaitingJobs(FJobCounter& counter)
+{
+  FJob* pJob = counter.m_pWaitingJobs.exchange(nullptr, std::memory_order_seq_cst);
+  while (pJob)
+  {
+    FJob* pNext = pJob->pNextWaiting;
+    Schedule(pJob);
+    pJob = pNext;
+  }
+}
+
+
+void FJobSystem::WakeSleepingWorkers()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_SleepingCount.load(std::memory_order_relaxed) > 0)
+  {
+    m_WakeEpoch.fetch_add(1, std::memory_order_release);
+    m_WakeEpoch.notify_one();
+  }
+}
+
+
+b32 FJobSystem::TryExecuteJob(FWorkerContext* pContext)
+{
+  FJob* pJob = pContext->deque.Pop();
+  if (not pJob)
+  {
+    pJob = m_InjectionQueue.Pop();
+  }
+  if (not pJob)
+  {
+    // Stealing starts from random victim, so that thieves don't fight over the same deque...
+    u32& state = pContext->randomState;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    const u32 contextsCount = m_Contexts.size();
+    for (u32 i = 0; i < contextsCount and not pJob; i++)
+    {
+      const u32 victim = (state + i) % contextsCount;
+      if (victim != pContext->index)
+      {
+        pJob = m_Contexts[victim]->deque.Steal();
+      }
+    }
+  }
+
+  if (not pJob)
+  {
+    return UFALSE;
+  }
+  Execute(pJob, pContext);
+  return UTRUE;
+}
+
+
+void FJobSystem::Execute(FJob* pJob, FWorkerContext* pContext)
+{
+  pJob->pExecute(*pJob);
+
+  FJobCounter* pCounter = pJob->pCounter;
+  ReleaseJob(pJob, pContext);
+  if (pCounter)
+  {
+    if (pCounter->m_Remaining.fetch_sub(1, std::memory_order_seq_cst) == 1)
+    {
+      ScheduleWaitingJobs(*pCounter);
+    }
+    // Last access to counter, waiting thread may destroy it right after...
+    pCounter->m_Value.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+
+void FJobSystem::WorkerLoop(u32 index)
+{
+  FWorkerContext* pContext = m_Contexts[index].get();
+  t_pCurrentContext = pContext;
+
+  constexpr u32 spinsBeforeSleep{ 64 };
+  u32 idleSpins = 0;
+  while (m_Running.load(std::memory_order_acquire))
+  {
+    if (TryExecuteJob(pContext))
+    {
+      idleSpins = 0;
+      continue;
+    }
+
+    if (++idleSpins < spinsBeforeSleep)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Sleeping is announced before last check, so spawning thread either sees sleeper or job is found here...
+    m_SleepingCount.fetch_add(1, std::memory_order_seq_cst);
+    const u32 epoch = m_WakeEpoch.load(std::memory_order_seq_cst);
+    if (TryExecuteJob(pContext))
+    {
+      idleSpins = 0;
+    }
+    else if (m_Running.load(std::memory_order_acquire))
+    {
+      m_WakeEpoch.wait(epoch, std::memory_order_seq_cst);
+    }
+    m_SleepingCount.fetch_sub(1, std::memory_order_seq_cst);
+  }
+
+  t_pCurrentContext = nullptr;
+}
+
+
+FWorkerContext* FJobSystem::GetCurrentContext() const
+{
+  return t_pCurrentContext and t_pCurrentContext->pSystem == this ? t_pCurrentContext : nullptr;
+}
+
+
+}
@@ -0,0 +1,216 @@
+
+#ifndef UNCANNYENGINE_JOBSYSTEM_H
+#define UNCANNYENGINE_JOBSYSTEM_H
+
+
+#include "UTools/UTypes.h"
+#include "JobQueues.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace uncanny
+{
+
+
+class FJobSystem;
+class FJobCounter;
+struct FWorkerContext;
+
+
+/// @brief FJob is a type erased callable stored inline (no allocation per job), created only by FJobSystem.
+/// Owner is worker context whose pool the job comes from, heap allocated jobs have no owner.
+struct FJob
+{
+  static constexpr u64 inlineStorageSize{ 64 };
+
+  void(*pExecute)(FJob& job){ nullptr };
+  FJobCounter* pCounter{ nullptr };
+  FJob* pNextWaiting{ nullptr };
+  FWorkerContext* pOwner{ nullptr };
+  alignas(std::max_align_t) std::byte storage[inlineStorageSize]{};
+};
+
+
+/// @brief FJobCounter counts unfinished jobs spawned with it, it is used to wait for them or as a dependency of
+/// other jobs. Counter must outlive every job spawned with it, waiting on it guarantees that.
+/// @details Jobs, which depend on counter, are kept in intrusive lock-free list and scheduled by the thread that
+/// finishes the last counted job.
+class FJobCounter
+{
+
+  friend class FJobSystem;
+
+public:
+
+  FJobCounter() = default;
+  FJobCounter(const FJobCounter&) = delete;
+  FJobCounter& operator=(const FJobCounter&) = delete;
+
+  [[nodiscard]] b32 IsDone() const { return m_Value.load(std::memory_order_acquire) == 0; }
+
+private:
+
+  // m_Remaining drives continuations, m_Value is released last, so that waiter can destroy counter right after
+  // it sees zero...
+  std::atomic<u32> m_Value{ 0 };
+  std::atomic<u32> m_Remaining{ 0 };
+  std::atomic<FJob*> m_pWaitingJobs{ nullptr };
+
+};
+
+
+/// @brief FJobSystem runs jobs on worker threads, every worker owns work-stealing deque and idle workers steal
+/// from others. Threads without deque submit jobs through lock-free global injection queue.
+/// @details Thread that calls Create() becomes worker 0 and takes part in execution only while it waits
+/// (Wait() helps with pending jobs instead of blocking). Jobs are allocated from per-thread pools, so
+/// spawning from workers doesn't touch global allocator. Job finished on other thread is returned to its owner
+/// through lock-free list, which owner takes at once when its local free list runs out. Idle workers spin for
+/// a while and then sleep on atomic wait, they are woken only when somebody is sleeping, so spawn is cheap
+/// when everyone is busy.
+class FJobSystem
+{
+public:
+
+  FJobSystem();
+  FJobSystem(const FJobSystem&) = delete;
+  FJobSystem& operator=(const FJobSystem&) = delete;
+  ~FJobSystem();
+
+  /// @brief Starts worker threads, by default one less than hardware threads (calling thread is the last one)
+  void Create(u32 workerThreadsCount = UUNUSED);
+  void Destroy();
+
+  /// @brief Spawns job calling func(), if pCounter is given it is incremented now and decremented when job ends
+  template<typename TFunc>
+  void Spawn(TFunc&& func, FJobCounter* pCounter = nullptr)
+  {
+    Schedule(CreateJob(std::forward<TFunc>(func), pCounter));
+  }
+
+  /// @brief Spawns job calling func(), which starts only after all jobs counted by dependency have finished
+  template<typename TFunc>
+  void Spawn(TFunc&& func, FJobCounter* pCounter, FJobCounter& dependency)
+  {
+    ScheduleAfter(CreateJob(std::forward<TFunc>(func), pCounter), dependency);
+  }
+
+  /// @brief Waits until counter reaches zero, worker threads (and creating thread) execute other jobs meanwhile
+  void Wait(const FJobCounter& counter);
+
+  /// @brief Executes one pending job on calling thread, useful for custom waiting loops
+  /// @returns false when calling thread is not part of job system or no job was found
+  b32 TryExecuteJob();
+
+  /// @brief Calls func(first, last) over disjoint ranges covering [0, count) and waits for all of them.
+  /// @details Range is split recursively in halves, every split off half is spawned as stealable job and the
+  /// calling job continues with the other half. Grain size adapts to threads count (about 8 ranges per thread),
+  /// minGrainSize bounds it from below for cheap iterations. With single thread func is called once inline.
+  template<typename TFunc>
+  void ParallelFor(u32 count, TFunc&& func, u32 minGrainSize = 1)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    const u32 threadsCount = GetThreadsCount();
+    if (threadsCount <= 1 or count <= minGrainSize)
+    {
+      func(0u, count);
+      return;
+    }
+
+    constexpr u32 rangesPerThread{ 8 };
+    const u32 grainSize = std::max<u32>({ 1u, minGrainSize, count / (threadsCount * rangesPerThread) });
+
+    FJobCounter counter{};
+    ParallelForRange(0, count, grainSize, func, counter);
+    Wait(counter);
+  }
+
+  /// @returns count of threads executing jobs, including creating thread
+  [[nodiscard]] u32 GetThreadsCount() const { return m_Contexts.size(); }
+
+  /// @returns index of calling thread within job system, UUNUSED when it is not part of it
+  [[nodiscard]] u32 GetCurrentThreadIndex() const;
+
+private:
+
+  template<typename TFunc>
+  FJob* CreateJob(TFunc&& func, FJobCounter* pCounter)
+  {
+    using FFunc = std::decay_t<TFunc>;
+    static_assert(sizeof(FFunc) <= FJob::inlineStorageSize, "Job callable is too big, capture pointer to data!");
+    static_assert(alignof(FFunc) <= alignof(std::max_align_t));
+
+    FJob* pJob = AllocateJob();
+    new (pJob->storage) FFunc(std::forward<TFunc>(func));
+    pJob->pExecute = [](FJob& job)
+    {
+      FFunc* pFunc = std::launder(reinterpret_cast<FFunc*>(job.storage));
+      (*pFunc)();
+      pFunc->~FFunc();
+    };
+    pJob->pCounter = pCounter;
+    pJob->pNextWaiting = nullptr;
+    if (pCounter)
+    {
+      pCounter->m_Remaining.fetch_add(1, std::memory_order_relaxed);
+      pCounter->m_Value.fetch_add(1, std::memory_order_relaxed);
+    }
+    return pJob;
+  }
+
+  template<typename TFunc>
+  void ParallelForRange(u32 first, u32 last, u32 grainSize, TFunc& func, FJobCounter& counter)
+  {
+    while (last - first > grainSize)
+    {
+      const u32 middle = first + (last - first) / 2;
+      Spawn([this, middle, last, grainSize, &func, &counter]()
+      {
+        ParallelForRange(middle, last, grainSize, func, counter);
+      }, &counter);
+      last = middle;
+    }
+    func(first, last);
+  }
+
+  FJob* AllocateJob();
+  void ReleaseJob(FJob* pJob, FWorkerContext* pContext);
+
+  void Schedule(FJob* pJob);
+  void ScheduleAfter(FJob* pJob, FJobCounter& dependency);
+  void ScheduleWaitingJobs(FJobCounter& counter);
+  void WakeSleepingWorkers();
+
+  b32 TryExecuteJob(FWorkerContext* pContext);
+  void Execute(FJob* pJob, FWorkerContext* pContext);
+
+  void WorkerLoop(u32 index);
+
+  [[nodiscard]] FWorkerContext* GetCurrentContext() const;
+
+private:
+
+  std::vector<std::unique_ptr<FWorkerContext>> m_Contexts{};
+  std::vector<std::thread> m_Threads{};
+  FJobInjectionQueue m_InjectionQueue{};
+  alignas(64) std::atomic<u32> m_WakeEpoch{ 0 };
+  alignas(64) std::atomic<u32> m_SleepingCount{ 0 };
+  std::atomic<b32> m_Running{ UFALSE };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_JOBSYSTEM_H
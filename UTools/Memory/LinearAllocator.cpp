@@ -0,0 +1,162 @@
+
+#include "LinearAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+
+namespace uncanny
+{
+
+
+static constexpr u64 AlignUp(u64 value, u64 alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+
+// Block header is placed at the beginning of every block, allocations start right after it...
+static constexpr u64 g_BlockHeaderSize{ AlignUp(2 * sizeof(u64), alignof(std::max_align_t)) };
+
+
+FLinearAllocator::FLinearAllocator(u64 initialBlockSize, std::pmr::memory_resource* pUpstream)
+  : m_pUpstream(pUpstream),
+  m_NextBlockSize(std::max<u64>(initialBlockSize, 2 * g_BlockHeaderSize))
+{
+}
+
+
+FLinearAllocator::~FLinearAllocator()
+{
+  Release();
+}
+
+
+// Block is aligned only to max_align_t, so absolute address is aligned instead of offset inside block...
+static u64 AlignOffset(const void* pBlock, u64 offset, u64 alignment)
+{
+  const u64 blockAddress = reinterpret_cast<u64>(pBlock);
+  return AlignUp(blockAddress + offset, alignment) - blockAddress;
+}
+
+
+void* FLinearAllocator::Allocate(u64 size, u64 alignment)
+{
+  u64 offset = m_pCurrentBlock ? AlignOffset(m_pCurrentBlock, m_Offset, alignment) : 0;
+  if (not m_pCurrentBlock or offset + size > m_pCurrentBlock->size)
+  {
+    AllocateBlock(size + alignment);
+    offset = AlignOffset(m_pCurrentBlock, m_Offset, alignment);
+  }
+
+  m_Offset = offset + size;
+  return reinterpret_cast<std::byte*>(m_pCurrentBlock) + offset;
+}
+
+
+u64 FLinearAllocator::GetUsedBytes() const
+{
+  return m_pCurrentBlock ? m_UsedBytesInPreviousBlocks + m_Offset - g_BlockHeaderSize : 0;
+}
+
+
+void FLinearAllocator::Reset()
+{
+  if (not m_pCurrentBlock)
+  {
+    return;
+  }
+
+  if (m_pCurrentBlock->pPrevious)
+  {
+    // Workload did not fit into one block, all blocks are released and replaced lazily with one block
+    // as big as all of them, so that next frame / level does not need to chain again...
+    const u64 capacity = m_Capacity;
+    Release();
+    m_NextBlockSize = capacity;
+    return;
+  }
+
+  m_Offset = g_BlockHeaderSize;
+  m_UsedBytesInPreviousBlocks = 0;
+}
+
+
+void FLinearAllocator::Release()
+{
+  FBlock* pBlock = m_pCurrentBlock;
+  while (pBlock)
+  {
+    FBlock* pPrevious = pBlock->pPrevious;
+    m_pUpstream->deallocate(pBlock, pBlock->size, alignof(std::max_align_t));
+    pBlock = pPrevious;
+  }
+
+  m_pCurrentBlock = nullptr;
+  m_Offset = 0;
+  m_UsedBytesInPreviousBlocks = 0;
+  m_Capacity = 0;
+}
+
+
+void FLinearAllocator::AllocateBlock(u64 minimalSize)
+{
+  const u64 blockSize = std::max(m_NextBlockSize, AlignUp(minimalSize + g_BlockHeaderSize, alignof(std::max_align_t)));
+  void* pMemory = m_pUpstream->allocate(blockSize, alignof(std::max_align_t));
+  m_UpstreamAllocationsCount++;
+
+  FBlock* pBlock = new (pMemory) FBlock{ .pPrevious = m_pCurrentBlock, .size = blockSize };
+  if (m_pCurrentBlock)
+  {
+    m_UsedBytesInPreviousBlocks += m_Offset - g_BlockHeaderSize;
+  }
+  m_pCurrentBlock = pBlock;
+  m_Offset = g_BlockHeaderSize;
+  m_Capacity += blockSize;
+  m_NextBlockSize = 2 * blockSize;
+}
+
+
+void* FLinearAllocator::do_allocate(size_t bytes, size_t alignment)
+{
+  return Allocate(bytes, alignment);
+}
+
+
+void FLinearAllocator::do_deallocate(void*, size_t, size_t)
+{
+  // Memory is freed only with Reset()...
+}
+
+
+bool FLinearAllocator::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+
+static std::atomic<u64> g_FrameIndex{ 0 };
+
+
+void FFrameAllocator::NextFrame()
+{
+  g_FrameIndex.fetch_add(1, std::memory_order_release);
+}
+
+
+FLinearAllocator& FFrameAllocator::Get()
+{
+  thread_local FLinearAllocator t_Allocator{ 256 * 1024 };
+  thread_local u64 t_FrameIndex{ 0 };
+
+  const u64 frameIndex = g_FrameIndex.load(std::memory_order_acquire);
+  if (t_FrameIndex != frameIndex)
+  {
+    t_Allocator.Reset();
+    t_FrameIndex = frameIndex;
+  }
+  return t_Allocator;
+}
+
+
+}
@@ -0,0 +1,95 @@
+
+#ifndef UNCANNYENGINE_LINEARALLOCATOR_H
+#define UNCANNYENGINE_LINEARALLOCATOR_H
+
+
+#include "UTools/UTypes.h"
+#include <memory_resource>
+
+
+namespace uncanny
+{
+
+
+/// @brief FLinearAllocator is a bump (arena) allocator, which frees all of its allocations at once with Reset().
+/// @details Memory is taken from upstream resource in blocks, allocation only moves pointer inside current block.
+/// When block is full, next one (at least twice as big) is chained. Reset() keeps the only block, or replaces chained
+/// blocks with a single one as big as all of them, so after first frame or level whole workload fits into one block
+/// and upstream is not touched anymore.
+/// Allocator is std::pmr::memory_resource itself, so it can back any std::pmr container. Deallocation is no-op.
+/// It is not thread safe, use FFrameAllocator for per-thread transient memory.
+class FLinearAllocator : public std::pmr::memory_resource
+{
+public:
+
+  explicit FLinearAllocator(u64 initialBlockSize = 64 * 1024,
+                            std::pmr::memory_resource* pUpstream = std::pmr::new_delete_resource());
+  FLinearAllocator(const FLinearAllocator&) = delete;
+  FLinearAllocator& operator=(const FLinearAllocator&) = delete;
+  ~FLinearAllocator() override;
+
+  void* Allocate(u64 size, u64 alignment = alignof(std::max_align_t));
+
+  /// @brief Frees all allocations at once, memory must not be used anymore
+  void Reset();
+
+  /// @brief Returns all blocks back to upstream
+  void Release();
+
+  /// @returns bytes allocated (with alignment padding) since last Reset(), block headers are not counted
+  [[nodiscard]] u64 GetUsedBytes() const;
+
+  /// @returns size of all blocks held by allocator
+  [[nodiscard]] u64 GetCapacity() const { return m_Capacity; }
+
+  /// @returns how many times allocator asked upstream for memory during its lifetime
+  [[nodiscard]] u64 GetUpstreamAllocationsCount() const { return m_UpstreamAllocationsCount; }
+
+private:
+
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+  [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  void AllocateBlock(u64 minimalSize);
+
+private:
+
+  struct FBlock
+  {
+    FBlock* pPrevious{ nullptr };
+    u64 size{ 0 };
+  };
+
+  std::pmr::memory_resource* m_pUpstream{ nullptr };
+  FBlock* m_pCurrentBlock{ nullptr };
+  u64 m_Offset{ 0 };
+  u64 m_UsedBytesInPreviousBlocks{ 0 };
+  u64 m_Capacity{ 0 };
+  u64 m_NextBlockSize{ 0 };
+  u64 m_UpstreamAllocationsCount{ 0 };
+
+};
+
+
+/// @brief FFrameAllocator gives every thread its own FLinearAllocator for data living at most one frame.
+/// @details NextFrame() only advances global frame index, every thread resets its allocator lazily on first use
+/// in a new frame, so no thread has to touch allocators of other threads. Memory allocated in previous frame
+/// is invalid after NextFrame().
+class FFrameAllocator
+{
+public:
+
+  /// @brief Starts new frame, should be called once per frame by main thread
+  static void NextFrame();
+
+  /// @returns linear allocator of calling thread for current frame
+  static FLinearAllocator& Get();
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_LINEARALLOCATOR_H
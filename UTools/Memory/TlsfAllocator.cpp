@@ -0,0 +1,305 @@
+
+#include "TlsfAllocator.h"
+#include <algorithm>
+#include <bit>
+
+
+namespace uncanny
+{
+
+
+static u64 AlignUp(u64 value, u64 alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+
+static u32 Log2(u64 value)
+{
+  return std::bit_width(value) - 1;
+}
+
+
+void FTlsfAllocator::Create(u64 size)
+{
+  Destroy();
+  m_Size = size;
+  for (auto& secondLevelHeads : m_FreeHeads)
+  {
+    std::fill(std::begin(secondLevelHeads), std::end(secondLevelHeads), UUNUSED);
+  }
+
+  // Whole range is one free region at the beginning...
+  InsertFreeNode(CreateNode(0, size));
+}
+
+
+void FTlsfAllocator::Destroy()
+{
+  m_Nodes.clear();
+  m_ReleasedNodes.clear();
+  std::fill(std::begin(m_SecondLevelBitmaps), std::end(m_SecondLevelBitmaps), 0);
+  m_FirstLevelBitmap = 0;
+  m_Size = 0;
+  m_UsedBytes = 0;
+  m_AllocationsCount = 0;
+  m_FreeRegionsCount = 0;
+}
+
+
+FTlsfAllocator::FAllocation FTlsfAllocator::Allocate(u64 size, u64 alignment)
+{
+  alignment = std::max<u64>(alignment, 1);
+  if (size == 0 or size + alignment - 1 > m_Size)
+  {
+    return {};
+  }
+
+  // Searched size includes worst-case alignment padding, so that found region always fits...
+  u32 node = FindFreeNode(size + alignment - 1);
+  if (node == UUNUSED)
+  {
+    return {};
+  }
+  RemoveFreeNode(node);
+
+  const u64 offset = m_Nodes[node].offset;
+  const u64 padding = AlignUp(offset, alignment) - offset;
+  if (padding > 0)
+  {
+    // Padding stays as free region in front of allocation, previous region is used (otherwise they would be
+    // merged), so it cannot be merged with anything...
+    const u32 alignedNode = CreateNode(offset + padding, m_Nodes[node].size - padding);
+    m_Nodes[alignedNode].previousPhysical = node;
+    m_Nodes[alignedNode].nextPhysical = m_Nodes[node].nextPhysical;
+    if (m_Nodes[node].nextPhysical != UUNUSED)
+    {
+      m_Nodes[m_Nodes[node].nextPhysical].previousPhysical = alignedNode;
+    }
+    m_Nodes[node].nextPhysical = alignedNode;
+    m_Nodes[node].size = padding;
+    InsertFreeNode(node);
+    node = alignedNode;
+  }
+
+  SplitTail(node, size);
+
+  m_UsedBytes += size;
+  m_AllocationsCount++;
+  return FAllocation{ .offset = m_Nodes[node].offset, .size = size, .node = node };
+}
+
+
+void FTlsfAllocator::Free(u32 node)
+{
+  m_UsedBytes -= m_Nodes[node].size;
+  m_AllocationsCount--;
+
+  // Merging with free physical neighbours...
+  const u32 next = m_Nodes[node].nextPhysical;
+  if (next != UUNUSED and m_Nodes[next].free)
+  {
+    RemoveFreeNode(next);
+    m_Nodes[node].size += m_Nodes[next].size;
+    m_Nodes[node].nextPhysical = m_Nodes[next].nextPhysical;
+    if (m_Nodes[node].nextPhysical != UUNUSED)
+    {
+      m_Nodes[m_Nodes[node].nextPhysical].previousPhysical = node;
+    }
+    ReleaseNode(next);
+  }
+
+  const u32 previous = m_Nodes[node].previousPhysical;
+  if (previous != UUNUSED and m_Nodes[previous].free)
+  {
+    RemoveFreeNode(previous);
+    m_Nodes[previous].size += m_Nodes[node].size;
+    m_Nodes[previous].nextPhysical = m_Nodes[node].nextPhysical;
+    if (m_Nodes[previous].nextPhysical != UUNUSED)
+    {
+      m_Nodes[m_Nodes[previous].nextPhysical].previousPhysical = previous;
+    }
+    ReleaseNode(node);
+    node = previous;
+  }
+
+  InsertFreeNode(node);
+}
+
+
+u64 FTlsfAllocator::GetLargestFreeRegion() const
+{
+  if (m_FirstLevelBitmap == 0)
+  {
+    return 0;
+  }
+
+  // Largest region is somewhere in the highest non-empty list...
+  const u32 firstLevel = Log2(m_FirstLevelBitmap);
+  const u32 secondLevel = Log2(m_SecondLevelBitmaps[firstLevel]);
+  u64 largest = 0;
+  for (u32 node = m_FreeHeads[firstLevel][secondLevel]; node != UUNUSED; node = m_Nodes[node].nextFree)
+  {
+    largest = std::max(largest, m_Nodes[node].size);
+  }
+  return largest;
+}
+
+
+static void MapSizeToLevels(u64 size, u32& firstLevel, u32& secondLevel, u32 secondLevelLog2)
+{
+  const u32 secondLevelCount = 1 << secondLevelLog2;
+  if (size < secondLevelCount)
+  {
+    firstLevel = 0;
+    secondLevel = size;
+    return;
+  }
+
+  const u32 log2 = Log2(size);
+  firstLevel = log2 - secondLevelLog2 + 1;
+  secondLevel = (size >> (log2 - secondLevelLog2)) ^ secondLevelCount;
+}
+
+
+u32 FTlsfAllocator::CreateNode(u64 offset, u64 size)
+{
+  u32 node{ UUNUSED };
+  if (not m_ReleasedNodes.empty())
+  {
+    node = m_ReleasedNodes.back();
+    m_ReleasedNodes.pop_back();
+    m_Nodes[node] = FNode{};
+  }
+  else
+  {
+    node = m_Nodes.size();
+    m_Nodes.emplace_back();
+  }
+
+  m_Nodes[node].offset = offset;
+  m_Nodes[node].size = size;
+  return node;
+}
+
+
+void FTlsfAllocator::ReleaseNode(u32 node)
+{
+  m_ReleasedNodes.push_back(node);
+}
+
+
+void FTlsfAllocator::InsertFreeNode(u32 node)
+{
+  u32 firstLevel{ 0 };
+  u32 secondLevel{ 0 };
+  MapSizeToLevels(m_Nodes[node].size, firstLevel, secondLevel, g_SecondLevelLog2);
+
+  const u32 head = m_FreeHeads[firstLevel][secondLevel];
+  m_Nodes[node].free = UTRUE;
+  m_Nodes[node].previousFree = UUNUSED;
+  m_Nodes[node].nextFree = head;
+  if (head != UUNUSED)
+  {
+    m_Nodes[head].previousFree = node;
+  }
+  m_FreeHeads[firstLevel][secondLevel] = node;
+
+  m_FirstLevelBitmap |= 1ull << firstLevel;
+  m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+  m_FreeRegionsCount++;
+}
+
+
+void FTlsfAllocator::RemoveFreeNode(u32 node)
+{
+  u32 firstLevel{ 0 };
+  u32 secondLevel{ 0 };
+  MapSizeToLevels(m_Nodes[node].size, firstLevel, secondLevel, g_SecondLevelLog2);
+
+  const u32 previous = m_Nodes[node].previousFree;
+  const u32 next = m_Nodes[node].nextFree;
+  if (previous != UUNUSED)
+  {
+    m_Nodes[previous].nextFree = next;
+  }
+  if (next != UUNUSED)
+  {
+    m_Nodes[next].previousFree = previous;
+  }
+
+  if (m_FreeHeads[firstLevel][secondLevel] == node)
+  {
+    m_FreeHeads[firstLevel][secondLevel] = next;
+    if (next == UUNUSED)
+    {
+      m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+      if (m_SecondLevelBitmaps[firstLevel] == 0)
+      {
+        m_FirstLevelBitmap &= ~(1ull << firstLevel);
+      }
+    }
+  }
+
+  m_Nodes[node].free = UFALSE;
+  m_Nodes[node].previousFree = UUNUSED;
+  m_Nodes[node].nextFree = UUNUSED;
+  m_FreeRegionsCount--;
+}
+
+
+void FTlsfAllocator::SplitTail(u32 node, u64 size)
+{
+  if (m_Nodes[node].size <= size)
+  {
+    return;
+  }
+
+  // Next region is used (free one would be merged), so remainder is inserted as it is...
+  const u32 tail = CreateNode(m_Nodes[node].offset + size, m_Nodes[node].size - size);
+  m_Nodes[tail].previousPhysical = node;
+  m_Nodes[tail].nextPhysical = m_Nodes[node].nextPhysical;
+  if (m_Nodes[node].nextPhysical != UUNUSED)
+  {
+    m_Nodes[m_Nodes[node].nextPhysical].previousPhysical = tail;
+  }
+  m_Nodes[node].nextPhysical = tail;
+  m_Nodes[node].size = size;
+  InsertFreeNode(tail);
+}
+
+
+u32 FTlsfAllocator::FindFreeNode(u64 size) const
+{
+  // Size is rounded up to next class, so that every region in found list is big enough...
+  if (size >= g_SecondLevelCount)
+  {
+    size += (1ull << (Log2(size) - g_SecondLevelLog2)) - 1;
+  }
+
+  u32 firstLevel{ 0 };
+  u32 secondLevel{ 0 };
+  MapSizeToLevels(size, firstLevel, secondLevel, g_SecondLevelLog2);
+  if (firstLevel >= g_FirstLevelCount)
+  {
+    return UUNUSED;
+  }
+
+  u32 secondLevelMap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+  if (secondLevelMap == 0)
+  {
+    const u64 firstLevelMap = firstLevel + 1 < 64 ? m_FirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+    if (firstLevelMap == 0)
+    {
+      return UUNUSED;
+    }
+    firstLevel = std::countr_zero(firstLevelMap);
+    secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+  }
+
+  secondLevel = std::countr_zero(secondLevelMap);
+  return m_FreeHeads[firstLevel][secondLevel];
+}
+
+
+}
@@ -0,0 +1,94 @@
+
+#ifndef UNCANNYENGINE_TLSFALLOCATOR_H
+#define UNCANNYENGINE_TLSFALLOCATOR_H
+
+
+#include "UTools/UTypes.h"
+#include <vector>
+
+
+namespace uncanny
+{
+
+
+/// @brief FTlsfAllocator manages offsets inside range [0, size) with two-level segregated fit, it never touches
+/// managed memory, so it can sub-allocate anything (e.g. device memory blocks).
+/// @details Free regions are kept in lists segregated by size: first level is power of two, second level splits
+/// it linearly into 16 classes. Bitmaps of non-empty lists make allocation and free O(1): allocation takes the first
+/// region from the smallest class, which is guaranteed to fit, and splits remainder off. Freed region is merged with
+/// free physical neighbours right away, so there are never two adjacent free regions.
+/// Regions are nodes in a vector indexed by u32, nodes of merged regions are reused. It is not thread safe.
+class FTlsfAllocator
+{
+public:
+
+  struct FAllocation
+  {
+    u64 offset{ UUNUSED };
+    u64 size{ 0 };
+    u32 node{ UUNUSED };
+  };
+
+  void Create(u64 size);
+  void Destroy();
+
+  /// @returns allocation, its node is UUNUSED when there is no free region big enough
+  [[nodiscard]] FAllocation Allocate(u64 size, u64 alignment);
+  void Free(u32 node);
+
+  [[nodiscard]] u64 GetSize() const { return m_Size; }
+  [[nodiscard]] u64 GetUsedBytes() const { return m_UsedBytes; }
+  [[nodiscard]] u32 GetAllocationsCount() const { return m_AllocationsCount; }
+  [[nodiscard]] u32 GetFreeRegionsCount() const { return m_FreeRegionsCount; }
+  [[nodiscard]] b32 IsEmpty() const { return m_AllocationsCount == 0; }
+
+  /// @returns size of the biggest free region, it limits the biggest allocation that can succeed
+  [[nodiscard]] u64 GetLargestFreeRegion() const;
+
+private:
+
+  static constexpr u32 g_SecondLevelLog2{ 4 };
+  static constexpr u32 g_SecondLevelCount{ 1 << g_SecondLevelLog2 };
+  static constexpr u32 g_FirstLevelCount{ 64 - g_SecondLevelLog2 + 1 };
+
+  struct FNode
+  {
+    u64 offset{ 0 };
+    u64 size{ 0 };
+    u32 previousPhysical{ UUNUSED };
+    u32 nextPhysical{ UUNUSED };
+    u32 previousFree{ UUNUSED };
+    u32 nextFree{ UUNUSED };
+    b8 free{ UFALSE };
+  };
+
+  u32 CreateNode(u64 offset, u64 size);
+  void ReleaseNode(u32 node);
+
+  void InsertFreeNode(u32 node);
+  void RemoveFreeNode(u32 node);
+
+  /// @brief Splits tail of node from given size into new free node
+  void SplitTail(u32 node, u64 size);
+
+  [[nodiscard]] u32 FindFreeNode(u64 size) const;
+
+private:
+
+  std::vector<FNode> m_Nodes{};
+  std::vector<u32> m_ReleasedNodes{};
+  u32 m_FreeHeads[g_FirstLevelCount][g_SecondLevelCount]{};
+  u32 m_SecondLevelBitmaps[g_FirstLevelCount]{};
+  u64 m_FirstLevelBitmap{ 0 };
+  u64 m_Size{ 0 };
+  u64 m_UsedBytes{ 0 };
+  u32 m_AllocationsCount{ 0 };
+  u32 m_FreeRegionsCount{ 0 };
+
+};
+
+
+}
+
+
+#endif //UNCANNYENGINE_TLSFALLOCATOR_H